@@ -1,154 +1,222 @@
 use petgraph::graph::{Graph, IndexType, NodeIndex};
+use petgraph::visit::EdgeRef;
 use petgraph::EdgeType;
-use std::cmp::min;
-use std::collections::{HashMap, HashSet, VecDeque};
+use std::collections::{HashSet, VecDeque};
 
-fn dfs<N, E, Ty: EdgeType, Ix: IndexType>(
-    u: NodeIndex<Ix>,
-    d: usize,
-    graph: &Graph<N, E, Ty, Ix>,
-    visited: &mut HashSet<NodeIndex<Ix>>,
-    depth: &mut HashMap<NodeIndex<Ix>, usize>,
-    low: &mut HashMap<NodeIndex<Ix>, usize>,
-    parent: &mut HashMap<NodeIndex<Ix>, Option<NodeIndex<Ix>>>,
-    articulation_nodes: &mut HashSet<NodeIndex<Ix>>,
-) {
-    visited.insert(u);
-    depth.insert(u, d);
-    low.insert(u, d);
-    let mut child_count = 0;
-    let mut is_articulation = false;
+const NONE: u32 = std::u32::MAX;
+
+/// Depth-first search state of the Hopcroft-Tarjan algorithm, over index
+/// arrays. Edge directions and self loops are ignored.
+struct Biconnectivity {
+    depth: Vec<u32>,
+    low: Vec<u32>,
+    parent_edge: Vec<u32>,
+    is_articulation: Vec<bool>,
+    edge_labels: Vec<u32>,
+    component_count: u32,
+}
+
+impl Biconnectivity {
+    fn new<N, E, Ty: EdgeType, Ix: IndexType>(graph: &Graph<N, E, Ty, Ix>) -> Biconnectivity {
+        let n = graph.node_count();
+        let edges = graph.raw_edges();
+
+        let mut offset = vec![0u32; n + 1];
+        for e in edges {
+            let (u, v) = (e.source().index(), e.target().index());
+            if u != v {
+                offset[u + 1] += 1;
+                offset[v + 1] += 1;
+            }
+        }
+        for u in 0..n {
+            offset[u + 1] += offset[u];
+        }
+        let mut next = offset.clone();
+        let mut neighbors = vec![(0u32, 0u32); offset[n] as usize];
+        for (i, e) in edges.iter().enumerate() {
+            let (u, v) = (e.source().index(), e.target().index());
+            if u != v {
+                neighbors[next[u] as usize] = (v as u32, i as u32);
+                next[u] += 1;
+                neighbors[next[v] as usize] = (u as u32, i as u32);
+                next[v] += 1;
+            }
+        }
+        next.copy_from_slice(&offset);
 
-    for v in graph.neighbors(u) {
-        if !visited.contains(&v) {
-            parent.insert(v, Some(u));
-            dfs(
-                v,
-                d + 1,
-                graph,
-                visited,
-                depth,
-                low,
-                parent,
-                articulation_nodes,
-            );
-            child_count += 1;
-            if low[&v] >= depth[&u] {
-                is_articulation = true;
+        let mut depth = vec![NONE; n];
+        let mut low = vec![NONE; n];
+        let mut parent_edge = vec![NONE; n];
+        let mut is_articulation = vec![false; n];
+        let mut edge_labels = vec![NONE; edges.len()];
+        let mut component_count = 0;
+        let mut stack = vec![];
+        let mut edge_stack = vec![];
+        for root in 0..n {
+            if depth[root] != NONE {
+                continue;
+            }
+            depth[root] = 0;
+            low[root] = 0;
+            stack.push(root);
+            let mut root_children = 0;
+            while let Some(&u) = stack.last() {
+                if next[u] < offset[u + 1] {
+                    let (v, e) = neighbors[next[u] as usize];
+                    next[u] += 1;
+                    let v = v as usize;
+                    if e == parent_edge[u] {
+                        continue;
+                    }
+                    if depth[v] == NONE {
+                        depth[v] = depth[u] + 1;
+                        low[v] = depth[v];
+                        parent_edge[v] = e;
+                        edge_stack.push(e);
+                        stack.push(v);
+                    } else if depth[v] < depth[u] {
+                        low[u] = low[u].min(depth[v]);
+                        edge_stack.push(e);
+                    }
+                    continue;
+                }
+                stack.pop();
+                if let Some(&p) = stack.last() {
+                    low[p] = low[p].min(low[u]);
+                    if low[u] >= depth[p] {
+                        if p == root {
+                            root_children += 1;
+                        } else {
+                            is_articulation[p] = true;
+                        }
+                        while let Some(e) = edge_stack.pop() {
+                            edge_labels[e as usize] = component_count;
+                            if e == parent_edge[u] {
+                                break;
+                            }
+                        }
+                        component_count += 1;
+                    }
+                }
+            }
+            if root_children > 1 {
+                is_articulation[root] = true;
             }
-            low.insert(u, min(low[&u], low[&v]));
-        } else if parent[&u] != Some(v) {
-            low.insert(u, min(low[&u], depth[&v]));
+        }
+        Biconnectivity {
+            depth,
+            low,
+            parent_edge,
+            is_articulation,
+            edge_labels,
+            component_count,
         }
     }
-    if (parent[&u].is_some() && is_articulation) || (parent[&u].is_none() && child_count > 1) {
-        articulation_nodes.insert(u);
+
+    fn is_bridge(&self, e: usize, u: usize, v: usize) -> bool {
+        let v = if self.depth[u] < self.depth[v] { v } else { u };
+        self.parent_edge[v] == e as u32 && self.low[v] == self.depth[v]
     }
 }
 
+/// Labels each edge, by edge index, with its biconnected component, numbered
+/// `0..c`. Self loops belong to no component and are labeled `u32::MAX`.
+///
+/// The depth-first search uses an explicit stack, so long paths do not
+/// overflow the call stack.
+pub fn biconnected_component_labels<N, E, Ty: EdgeType, Ix: IndexType>(
+    graph: &Graph<N, E, Ty, Ix>,
+) -> Vec<u32> {
+    Biconnectivity::new(graph).edge_labels
+}
+
 pub fn articulation_nodes<N, E, Ty: EdgeType, Ix: IndexType>(
     graph: &Graph<N, E, Ty, Ix>,
 ) -> HashSet<NodeIndex<Ix>> {
-    let mut visited = HashSet::new();
-    let mut depth = HashMap::new();
-    let mut low = HashMap::new();
-    let mut parent = HashMap::new();
-    let mut articulation_nodes = HashSet::new();
-    for u in graph.node_indices() {
-        if !visited.contains(&u) {
-            parent.insert(u, None);
-            dfs(
-                u,
-                0,
-                graph,
-                &mut visited,
-                &mut depth,
-                &mut low,
-                &mut parent,
-                &mut articulation_nodes,
-            );
-        }
-    }
-    articulation_nodes
+    let state = Biconnectivity::new(graph);
+    graph
+        .node_indices()
+        .filter(|u| state.is_articulation[u.index()])
+        .collect()
 }
 
 pub fn bridges<N, E, Ty: EdgeType, Ix: IndexType>(
     graph: &Graph<N, E, Ty, Ix>,
 ) -> HashSet<(NodeIndex<Ix>, NodeIndex<Ix>)> {
-    let mut visited = HashSet::new();
-    let mut depth = HashMap::new();
-    let mut low = HashMap::new();
-    let mut parent = HashMap::new();
-    let mut articulation_nodes = HashSet::new();
-    for u in graph.node_indices() {
-        if !visited.contains(&u) {
-            parent.insert(u, None);
-            dfs(
-                u,
-                0,
-                graph,
-                &mut visited,
-                &mut depth,
-                &mut low,
-                &mut parent,
-                &mut articulation_nodes,
-            );
-        }
-    }
+    let state = Biconnectivity::new(graph);
     let mut bridges = HashSet::new();
-    for e in graph.edge_indices() {
-        let (u, v) = graph.edge_endpoints(e).unwrap();
-        let (u, v) = if depth[&u] < depth[&v] {
-            (u, v)
-        } else {
-            (v, u)
-        };
-        if low[&v] == depth[&v] {
-            bridges.insert((u, v));
+    for (i, e) in graph.raw_edges().iter().enumerate() {
+        let (u, v) = (e.source(), e.target());
+        if u != v && state.is_bridge(i, u.index(), v.index()) {
+            if state.depth[u.index()] < state.depth[v.index()] {
+                bridges.insert((u, v));
+            } else {
+                bridges.insert((v, u));
+            }
         }
     }
     bridges
 }
 
+/// Node sets found by removing the bridges, sorted.
+///
+/// Nodes are visited in index order. For each node `u` not in a set yet and
+/// each neighbor `v` of `u` not in a set yet over a non-bridge edge, the set
+/// is `u` and the nodes reachable from `v` over non-bridge edges without
+/// passing through `u`. A node with no such neighbor forms a singleton.
+/// This is not the vertex-biconnected decomposition: two cycles sharing a
+/// node are one set unless the shared node is visited first. Use
+/// `biconnected_component_labels` for the biconnected components.
 pub fn biconnected_components<N, E, Ty: EdgeType, Ix: IndexType>(
     graph: &Graph<N, E, Ty, Ix>,
 ) -> Vec<Vec<NodeIndex<Ix>>> {
-    let bridges = bridges(graph);
+    let state = Biconnectivity::new(graph);
+    let is_bridge = graph
+        .raw_edges()
+        .iter()
+        .enumerate()
+        .map(|(i, e)| {
+            let (u, v) = (e.source().index(), e.target().index());
+            u != v && state.is_bridge(i, u, v)
+        })
+        .collect::<Vec<_>>();
+    let n = graph.node_count();
+    let mut visited_global = vec![false; n];
+    let mut visited = vec![NONE; n];
+    let mut stamp = 0;
+    let mut queue = VecDeque::new();
     let mut component_nodes = vec![];
-    let mut visited_global = HashSet::new();
     for u in graph.node_indices() {
-        if visited_global.contains(&u) {
+        if visited_global[u.index()] {
             continue;
         }
         let mut count = 0;
-        for v in graph.neighbors(u) {
-            if visited_global.contains(&v) {
-                continue;
-            }
-            if bridges.contains(&(u, v)) || bridges.contains(&(v, u)) {
+        for e in graph.edges(u) {
+            let v = e.target();
+            if visited_global[v.index()] || is_bridge[e.id().index()] {
                 continue;
             }
 
-            let mut visited = HashSet::new();
-            visited.insert(u);
-            let mut queue = VecDeque::new();
+            visited[u.index()] = stamp;
+            let mut nodes = vec![u];
             queue.push_back(v);
-            while let Some(u) = queue.pop_front() {
-                if visited.contains(&u) {
+            while let Some(w) = queue.pop_front() {
+                if visited[w.index()] == stamp {
                     continue;
                 }
-                visited.insert(u);
-                for v in graph.neighbors(u) {
-                    if bridges.contains(&(u, v)) || bridges.contains(&(v, u)) {
-                        continue;
+                visited[w.index()] = stamp;
+                nodes.push(w);
+                for e in graph.edges(w) {
+                    if !is_bridge[e.id().index()] {
+                        queue.push_back(e.target());
                     }
-                    queue.push_back(v);
                 }
             }
-            for &u in &visited {
-                visited_global.insert(u);
+            stamp += 1;
+            for &w in &nodes {
+                visited_global[w.index()] = true;
             }
-            let mut nodes = visited.into_iter().collect::<Vec<_>>();
             nodes.sort();
             component_nodes.push(nodes);
             count += 1;
@@ -277,4 +345,37 @@ mod tests {
         .collect::<Vec<_>>();
         assert_eq!(result, expected);
     }
+
+    #[test]
+    fn find_biconnected_components_of_shared_node() {
+        let mut graph = petgraph::Graph::new_undirected();
+        let nodes = (0..5).map(|_| graph.add_node(())).collect::<Vec<_>>();
+        for &(u, v) in &[(0, 1), (1, 2), (2, 0), (2, 3), (3, 4), (4, 2)] {
+            graph.add_edge(nodes[u], nodes[v], ());
+        }
+        let labels = biconnected_component_labels(&graph);
+        assert_eq!(labels[0], labels[1]);
+        assert_eq!(labels[0], labels[2]);
+        assert_eq!(labels[3], labels[4]);
+        assert_eq!(labels[3], labels[5]);
+        assert_ne!(labels[0], labels[3]);
+        // Only the labels split the shared node; biconnected_components keeps
+        // its output from before the labels were added.
+        let expected = vec![vec![0, 1, 2, 3, 4]]
+            .into_iter()
+            .map(|nodes| nodes.into_iter().map(|u| node_index(u)).collect::<Vec<_>>())
+            .collect::<Vec<_>>();
+        assert_eq!(biconnected_components(&graph), expected);
+    }
+
+    #[test]
+    fn find_articulation_nodes_of_long_path() {
+        let n = 1000000;
+        let mut graph = petgraph::Graph::new_undirected();
+        let nodes = (0..n).map(|_| graph.add_node(())).collect::<Vec<_>>();
+        for i in 1..n {
+            graph.add_edge(nodes[i - 1], nodes[i], ());
+        }
+        assert_eq!(articulation_nodes(&graph).len(), n - 2);
+    }
 }
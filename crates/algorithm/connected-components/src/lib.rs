@@ -1,26 +1,107 @@
 use petgraph::graph::{Graph, IndexType, NodeIndex};
-use petgraph::unionfind::UnionFind;
 use petgraph::EdgeType;
+#[cfg(feature = "parallel")]
+use rayon::prelude::*;
 use std::collections::HashMap;
+use std::sync::atomic::{AtomicU32, Ordering};
+
+#[cfg(feature = "parallel")]
+const CHUNK_SIZE: usize = 1 << 14;
+
+fn find(parent: &[AtomicU32], mut u: u32) -> u32 {
+    loop {
+        let p = parent[u as usize].load(Ordering::Relaxed);
+        if p == u {
+            return u;
+        }
+        let q = parent[p as usize].load(Ordering::Relaxed);
+        if p != q {
+            let _ = parent[u as usize].compare_exchange_weak(
+                p,
+                q,
+                Ordering::Relaxed,
+                Ordering::Relaxed,
+            );
+        }
+        u = q;
+    }
+}
+
+fn union(parent: &[AtomicU32], u: u32, v: u32) {
+    loop {
+        let a = find(parent, u);
+        let b = find(parent, v);
+        if a == b {
+            return;
+        }
+        let (child, root) = if a < b { (b, a) } else { (a, b) };
+        if parent[child as usize]
+            .compare_exchange(child, root, Ordering::Relaxed, Ordering::Relaxed)
+            .is_ok()
+        {
+            return;
+        }
+    }
+}
+
+/// Labels the connected components of the graph on nodes `0..node_count`
+/// with `edges`, by union-find over the edge list.
+///
+/// Components are numbered `0..c` in order of their smallest node, so the
+/// result does not depend on the edge order. With the `parallel` feature,
+/// edge chunks are merged concurrently into a lock-free union-find.
+pub fn connected_component_labels_with_edges(node_count: usize, edges: &[(u32, u32)]) -> Vec<u32> {
+    let parent = (0..node_count as u32)
+        .map(AtomicU32::new)
+        .collect::<Vec<_>>();
+    #[cfg(feature = "parallel")]
+    edges.par_chunks(CHUNK_SIZE).for_each(|chunk| {
+        for &(u, v) in chunk {
+            union(&parent, u, v);
+        }
+    });
+    #[cfg(not(feature = "parallel"))]
+    for &(u, v) in edges {
+        union(&parent, u, v);
+    }
+
+    // Roots are the smallest node of their component, so they are labeled
+    // before any other member.
+    let mut labels = vec![0; node_count];
+    let mut count = 0;
+    for u in 0..node_count {
+        let root = find(&parent, u as u32) as usize;
+        if root == u {
+            labels[u] = count;
+            count += 1;
+        } else {
+            labels[u] = labels[root];
+        }
+    }
+    labels
+}
+
+/// Labels the connected components of `graph` by node index, ignoring edge
+/// directions. See `connected_component_labels_with_edges`.
+pub fn connected_component_labels<N, E, Ty: EdgeType, Ix: IndexType>(
+    graph: &Graph<N, E, Ty, Ix>,
+) -> Vec<u32> {
+    let edges = graph
+        .raw_edges()
+        .iter()
+        .map(|e| (e.source().index() as u32, e.target().index() as u32))
+        .collect::<Vec<_>>();
+    connected_component_labels_with_edges(graph.node_count(), &edges)
+}
 
 pub fn connected_components<N, E, Ty: EdgeType, Ix: IndexType>(
     graph: &Graph<N, E, Ty, Ix>,
 ) -> HashMap<NodeIndex<Ix>, usize> {
-    let mut components = UnionFind::new(graph.node_count());
-    let indices = graph
+    let labels = connected_component_labels(graph);
+    graph
         .node_indices()
-        .enumerate()
-        .map(|(i, u)| (u, i))
-        .collect::<HashMap<NodeIndex<Ix>, usize>>();
-    for e in graph.edge_indices() {
-        let (u, v) = graph.edge_endpoints(e).unwrap();
-        components.union(indices[&u], indices[&v]);
-    }
-    let mut result = HashMap::new();
-    for u in graph.node_indices() {
-        result.insert(u, components.find(indices[&u]));
-    }
-    result
+        .map(|u| (u, labels[u.index()] as usize))
+        .collect()
 }
 
 #[cfg(test)]
@@ -45,4 +126,20 @@ mod test {
         assert_ne!(components[&u3], components[&u4]);
         assert_eq!(components[&u4], components[&u5]);
     }
+
+    #[test]
+    fn test_connected_component_labels() {
+        let n = 10000;
+        let mut edges = vec![];
+        for i in 1..n {
+            if i % 100 != 0 {
+                edges.push((i, i - 1));
+            }
+        }
+        edges.reverse();
+        let labels = connected_component_labels_with_edges(n as usize, &edges);
+        for i in 0..n {
+            assert_eq!(labels[i as usize], i / 100);
+        }
+    }
 }
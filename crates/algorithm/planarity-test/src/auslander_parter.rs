@@ -0,0 +1,384 @@
+//! Auslander-Parter decomposition, kept as a reference for the left-right
+//! test.
+//!
+//! A biconnected graph with a cycle `C` is planar if and only if `C` plus
+//! each segment is planar and the interlacement graph of the segments is
+//! bipartite. A segment is a chord of `C`, or a connected component of the
+//! graph without `C` together with its edges to `C`. The test recurses on
+//! `C` plus each segment, so it takes exponential time in the worst case and
+//! is only meant for small graphs.
+
+use petgraph::graph::IndexType;
+use petgraph::prelude::*;
+use petgraph::unionfind::UnionFind;
+use petgraph::EdgeType;
+use std::collections::{HashMap, HashSet, VecDeque};
+
+type Edges = Vec<(usize, usize)>;
+
+fn adjacency(edges: &[(usize, usize)]) -> HashMap<usize, Vec<usize>> {
+    let mut adjacency = HashMap::new();
+    for &(u, v) in edges {
+        adjacency.entry(u).or_insert_with(Vec::new).push(v);
+        adjacency.entry(v).or_insert_with(Vec::new).push(u);
+    }
+    adjacency
+}
+
+/// Edges of `graph` with directions, self loops and parallel edges dropped.
+fn simple_edges<N, E, Ty: EdgeType, Ix: IndexType>(graph: &Graph<N, E, Ty, Ix>) -> Edges {
+    let mut edges = graph
+        .edge_references()
+        .map(|e| (e.source().index(), e.target().index()))
+        .filter(|&(u, v)| u != v)
+        .map(|(u, v)| (u.min(v), u.max(v)))
+        .collect::<Vec<_>>();
+    edges.sort();
+    edges.dedup();
+    edges
+}
+
+/// Edge sets of the biconnected components.
+fn blocks(edges: &[(usize, usize)]) -> Vec<Edges> {
+    struct Search {
+        adjacency: HashMap<usize, Vec<usize>>,
+        depth: HashMap<usize, usize>,
+        low: HashMap<usize, usize>,
+        stack: Edges,
+        blocks: Vec<Edges>,
+    }
+
+    impl Search {
+        fn visit(&mut self, u: usize, parent: Option<usize>, d: usize) {
+            self.depth.insert(u, d);
+            self.low.insert(u, d);
+            for v in self.adjacency[&u].clone() {
+                if Some(v) == parent {
+                    continue;
+                }
+                if let Some(&dv) = self.depth.get(&v) {
+                    if dv < d {
+                        self.stack.push((u, v));
+                        let low = self.low[&u].min(dv);
+                        self.low.insert(u, low);
+                    }
+                    continue;
+                }
+                self.stack.push((u, v));
+                self.visit(v, Some(u), d + 1);
+                let low = self.low[&u].min(self.low[&v]);
+                self.low.insert(u, low);
+                if self.low[&v] >= d {
+                    let mut block = vec![];
+                    while let Some(e) = self.stack.pop() {
+                        block.push(e);
+                        if e == (u, v) {
+                            break;
+                        }
+                    }
+                    self.blocks.push(block);
+                }
+            }
+        }
+    }
+
+    let adjacency = adjacency(edges);
+    let mut nodes = adjacency.keys().copied().collect::<Vec<_>>();
+    nodes.sort();
+    let mut search = Search {
+        adjacency,
+        depth: HashMap::new(),
+        low: HashMap::new(),
+        stack: vec![],
+        blocks: vec![],
+    };
+    for u in nodes {
+        if !search.depth.contains_key(&u) {
+            search.visit(u, None, 0);
+        }
+    }
+    search.blocks
+}
+
+/// Some cycle of the graph, as its node sequence.
+fn find_cycle(edges: &[(usize, usize)]) -> Option<Vec<usize>> {
+    let adjacency = adjacency(edges);
+    let mut parent = HashMap::new();
+    let mut nodes = adjacency.keys().copied().collect::<Vec<_>>();
+    nodes.sort();
+    for root in nodes {
+        if parent.contains_key(&root) {
+            continue;
+        }
+        parent.insert(root, root);
+        let mut stack = vec![root];
+        while let Some(u) = stack.pop() {
+            for &v in &adjacency[&u] {
+                if v == parent[&u] {
+                    continue;
+                }
+                if parent.contains_key(&v) {
+                    // v was reached before u finished, so the tree paths of
+                    // u and v meet; join them into a cycle.
+                    let mut path_u = vec![u];
+                    while path_u[path_u.len() - 1] != root {
+                        path_u.push(parent[&path_u[path_u.len() - 1]]);
+                    }
+                    let mut path_v = vec![v];
+                    while path_v[path_v.len() - 1] != root {
+                        path_v.push(parent[&path_v[path_v.len() - 1]]);
+                    }
+                    while path_u.len() > 1
+                        && path_v.len() > 1
+                        && path_u[path_u.len() - 2] == path_v[path_v.len() - 2]
+                    {
+                        path_u.pop();
+                        path_v.pop();
+                    }
+                    path_v.pop();
+                    path_v.reverse();
+                    path_u.extend(path_v);
+                    return Some(path_u);
+                }
+                parent.insert(v, u);
+                stack.push(v);
+            }
+        }
+    }
+    None
+}
+
+/// Segments of `edges` with respect to `cycle`, as edge sets.
+fn find_segments(edges: &[(usize, usize)], cycle: &[usize]) -> Vec<Edges> {
+    let on_cycle = cycle.iter().copied().collect::<HashSet<_>>();
+    let cycle_edges = (0..cycle.len())
+        .map(|i| {
+            let (u, v) = (cycle[i], cycle[(i + 1) % cycle.len()]);
+            (u.min(v), u.max(v))
+        })
+        .collect::<HashSet<_>>();
+    let n = edges.iter().map(|&(u, v)| u.max(v) + 1).max().unwrap_or(0);
+    let mut components = UnionFind::new(n);
+    for &(u, v) in edges {
+        if !on_cycle.contains(&u) && !on_cycle.contains(&v) {
+            components.union(u, v);
+        }
+    }
+    let mut chords = vec![];
+    let mut segments = HashMap::new();
+    for &(u, v) in edges {
+        if cycle_edges.contains(&(u.min(v), u.max(v))) {
+            continue;
+        }
+        if on_cycle.contains(&u) && on_cycle.contains(&v) {
+            chords.push(vec![(u, v)]);
+        } else {
+            let w = if on_cycle.contains(&u) { v } else { u };
+            segments
+                .entry(components.find(w))
+                .or_insert_with(Vec::new)
+                .push((u, v));
+        }
+    }
+    let mut segments = segments.into_iter().collect::<Vec<_>>();
+    segments.sort();
+    chords.extend(segments.into_iter().map(|(_, segment)| segment));
+    chords
+}
+
+/// Positions on `cycle` where `segment` attaches, sorted.
+fn attachments(cycle: &[usize], segment: &[(usize, usize)]) -> Vec<usize> {
+    let mut positions = vec![];
+    for (i, u) in cycle.iter().enumerate() {
+        if segment.iter().any(|&(a, b)| a == *u || b == *u) {
+            positions.push(i);
+        }
+    }
+    positions
+}
+
+/// Whether `segment` is a single path between two nodes of `cycle`.
+fn is_path(cycle: &[usize], segment: &[(usize, usize)]) -> bool {
+    let on_cycle = cycle.iter().copied().collect::<HashSet<_>>();
+    let adjacency = adjacency(segment);
+    adjacency.iter().all(|(u, neighbors)| {
+        let expected = if on_cycle.contains(u) { 1 } else { 2 };
+        neighbors.len() == expected
+    }) && attachments(cycle, segment).len() == 2
+}
+
+/// Replaces an arc of `cycle` by a path through `segment`, the only segment
+/// of `cycle`, which is not a path. The new cycle has at least two
+/// segments: the replaced arc, and what remains of `segment`.
+fn find_separating_cycle(cycle: &[usize], segment: &[(usize, usize)]) -> Vec<usize> {
+    let positions = attachments(cycle, segment);
+    let (i, j) = (positions[0], positions[1]);
+    let (a, b) = (cycle[i], cycle[j]);
+    let on_cycle = cycle.iter().copied().collect::<HashSet<_>>();
+    let adjacency = adjacency(segment);
+    let mut parent = HashMap::new();
+    parent.insert(a, a);
+    let mut queue = VecDeque::new();
+    queue.push_back(a);
+    while let Some(u) = queue.pop_front() {
+        if u == b {
+            break;
+        }
+        for &v in &adjacency[&u] {
+            if !parent.contains_key(&v) && (v == b || !on_cycle.contains(&v)) {
+                parent.insert(v, u);
+                queue.push_back(v);
+            }
+        }
+    }
+    // The path from a to b through the segment, then the arc of the cycle
+    // from b back to a that holds the other attachments.
+    let mut path = vec![b];
+    while path[path.len() - 1] != a {
+        path.push(parent[&path[path.len() - 1]]);
+    }
+    path.reverse();
+    let mut k = (j + 1) % cycle.len();
+    while k != i {
+        path.push(cycle[k]);
+        k = (k + 1) % cycle.len();
+    }
+    path
+}
+
+/// Whether two segments with attachments `a1` and `a2` can not be drawn on
+/// the same side of the cycle.
+fn interlaced(a1: &[usize], a2: &[usize]) -> bool {
+    if a1.iter().filter(|p| a2.contains(p)).count() >= 3 {
+        return true;
+    }
+    for (k, &p) in a1.iter().enumerate() {
+        for &q in &a1[k + 1..] {
+            let inside = a2.iter().any(|&r| p < r && r < q);
+            let outside = a2.iter().any(|&r| r < p || q < r);
+            if inside && outside {
+                return true;
+            }
+        }
+    }
+    false
+}
+
+fn interlacement_graph(cycle: &[usize], segments: &[Edges]) -> UnGraph<(), ()> {
+    let mut h = Graph::new_undirected();
+    let nodes = segments.iter().map(|_| h.add_node(())).collect::<Vec<_>>();
+    let positions = segments
+        .iter()
+        .map(|segment| attachments(cycle, segment))
+        .collect::<Vec<_>>();
+    for i in 0..segments.len() {
+        for j in 0..i {
+            if interlaced(&positions[i], &positions[j]) {
+                h.add_edge(nodes[i], nodes[j], ());
+            }
+        }
+    }
+    h
+}
+
+fn is_bipartite(h: &UnGraph<(), ()>) -> bool {
+    let mut color = vec![None; h.node_count()];
+    for s in h.node_indices() {
+        if color[s.index()].is_some() {
+            continue;
+        }
+        color[s.index()] = Some(false);
+        let mut queue = VecDeque::new();
+        queue.push_back(s);
+        while let Some(u) = queue.pop_front() {
+            let c = color[u.index()].unwrap();
+            for v in h.neighbors(u) {
+                match color[v.index()] {
+                    None => {
+                        color[v.index()] = Some(!c);
+                        queue.push_back(v);
+                    }
+                    Some(d) if d == c => return false,
+                    _ => {}
+                }
+            }
+        }
+    }
+    true
+}
+
+/// Tests the biconnected graph `edges` containing `cycle`.
+fn auslander_parter(edges: &[(usize, usize)], cycle: &[usize]) -> bool {
+    let segments = find_segments(edges, cycle);
+    if segments.is_empty() {
+        return true;
+    }
+    if segments.len() == 1 {
+        if is_path(cycle, &segments[0]) {
+            return true;
+        }
+        return auslander_parter(edges, &find_separating_cycle(cycle, &segments[0]));
+    }
+    if !is_bipartite(&interlacement_graph(cycle, &segments)) {
+        return false;
+    }
+    let cycle_edges = (0..cycle.len())
+        .map(|i| (cycle[i], cycle[(i + 1) % cycle.len()]))
+        .collect::<Vec<_>>();
+    segments.iter().all(|segment| {
+        let mut subgraph = cycle_edges.clone();
+        subgraph.extend(segment);
+        auslander_parter(&subgraph, cycle)
+    })
+}
+
+pub fn is_planar<N, E, Ty: EdgeType, Ix: IndexType>(graph: &Graph<N, E, Ty, Ix>) -> bool {
+    blocks(&simple_edges(graph)).iter().all(|block| {
+        if let Some(cycle) = find_cycle(block) {
+            auslander_parter(block, &cycle)
+        } else {
+            true
+        }
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::tests::planar_graph;
+
+    #[test]
+    fn test_find_cycle() {
+        let mut graph = Graph::new();
+        let u1 = graph.add_node(());
+        let u2 = graph.add_node(());
+        let u3 = graph.add_node(());
+        let u4 = graph.add_node(());
+        let u5 = graph.add_node(());
+        graph.add_edge(u1, u2, ());
+        graph.add_edge(u2, u3, ());
+        graph.add_edge(u3, u4, ());
+        graph.add_edge(u4, u1, ());
+        graph.add_edge(u1, u5, ());
+        let cycle = find_cycle(&simple_edges(&graph)).unwrap();
+        assert_eq!(cycle.len(), 4);
+    }
+
+    #[test]
+    fn test_find_separating_cycle() {
+        // The node 4 inside the cycle 0, 1, 2, 3 forms its only segment.
+        let edges = vec![(0, 1), (1, 2), (2, 3), (0, 3), (0, 4), (1, 4), (2, 4)];
+        let cycle = vec![0, 1, 2, 3];
+        let segments = find_segments(&edges, &cycle);
+        assert_eq!(segments.len(), 1);
+        assert!(!is_path(&cycle, &segments[0]));
+        let cycle = find_separating_cycle(&cycle, &segments[0]);
+        assert!(find_segments(&edges, &cycle).len() >= 2);
+    }
+
+    #[test]
+    fn test_is_planar() {
+        let graph = planar_graph();
+        assert_eq!(is_planar(&graph), true);
+    }
+}
@@ -0,0 +1,555 @@
+use petgraph::graph::{Graph, IndexType, NodeIndex};
+use petgraph::EdgeType;
+
+const NONE: u32 = std::u32::MAX;
+
+#[derive(Clone, Copy)]
+struct Interval {
+    low: u32,
+    high: u32,
+}
+
+impl Interval {
+    fn new() -> Interval {
+        Interval {
+            low: NONE,
+            high: NONE,
+        }
+    }
+
+    fn is_empty(&self) -> bool {
+        self.low == NONE && self.high == NONE
+    }
+}
+
+#[derive(Clone, Copy)]
+struct ConflictPair {
+    left: Interval,
+    right: Interval,
+}
+
+impl ConflictPair {
+    fn new() -> ConflictPair {
+        ConflictPair {
+            left: Interval::new(),
+            right: Interval::new(),
+        }
+    }
+
+    fn swap(&mut self) {
+        std::mem::swap(&mut self.left, &mut self.right);
+    }
+}
+
+/// Left-right planarity test (de Fraysseix and Rosenstiehl, following
+/// Brandes, "The Left-Right Planarity Test"), over index arrays.
+///
+/// Edge directions, self loops and parallel edges are ignored. All depth-first
+/// searches use explicit stacks.
+struct LeftRight {
+    n: usize,
+    /// Endpoints of each edge, oriented by the first depth-first search.
+    source: Vec<u32>,
+    target: Vec<u32>,
+    roots: Vec<u32>,
+    height: Vec<u32>,
+    parent_edge: Vec<u32>,
+    lowpt: Vec<u32>,
+    lowpt2: Vec<u32>,
+    nesting_depth: Vec<i64>,
+    /// Outgoing edges of each node in CSR layout, by nesting depth.
+    out_offset: Vec<usize>,
+    out_edges: Vec<u32>,
+    reference: Vec<u32>,
+    side: Vec<i8>,
+    lowpt_edge: Vec<u32>,
+    stack_bottom: Vec<usize>,
+    stack: Vec<ConflictPair>,
+}
+
+impl LeftRight {
+    fn new<N, E, Ty: EdgeType, Ix: IndexType>(graph: &Graph<N, E, Ty, Ix>) -> LeftRight {
+        let n = graph.node_count();
+        let mut pairs = graph
+            .raw_edges()
+            .iter()
+            .map(|e| {
+                let (u, v) = (e.source().index() as u32, e.target().index() as u32);
+                if u < v {
+                    (u, v)
+                } else {
+                    (v, u)
+                }
+            })
+            .filter(|&(u, v)| u != v)
+            .collect::<Vec<_>>();
+        pairs.sort_unstable();
+        pairs.dedup();
+        let m = pairs.len();
+        LeftRight {
+            n,
+            source: pairs.iter().map(|&(u, _)| u).collect(),
+            target: pairs.iter().map(|&(_, v)| v).collect(),
+            roots: vec![],
+            height: vec![NONE; n],
+            parent_edge: vec![NONE; n],
+            lowpt: vec![0; m],
+            lowpt2: vec![0; m],
+            nesting_depth: vec![0; m],
+            out_offset: vec![0; n + 1],
+            out_edges: vec![],
+            reference: vec![NONE; m],
+            side: vec![1; m],
+            lowpt_edge: vec![NONE; m],
+            stack_bottom: vec![0; m],
+            stack: vec![],
+        }
+    }
+
+    fn run(&mut self) -> bool {
+        let n = self.n;
+        let m = self.source.len();
+        if n > 2 && m > 3 * n - 6 {
+            return false;
+        }
+        self.orient();
+        self.sort_out_edges();
+        for i in 0..self.roots.len() {
+            if !self.test(self.roots[i] as usize) {
+                return false;
+            }
+        }
+        true
+    }
+
+    fn orient(&mut self) {
+        let n = self.n;
+        let m = self.source.len();
+        let mut offset = vec![0; n + 1];
+        for e in 0..m {
+            offset[self.source[e] as usize + 1] += 1;
+            offset[self.target[e] as usize + 1] += 1;
+        }
+        for u in 0..n {
+            offset[u + 1] += offset[u];
+        }
+        let mut next = offset.clone();
+        let mut incident = vec![0u32; 2 * m];
+        for e in 0..m {
+            for &u in &[self.source[e], self.target[e]] {
+                incident[next[u as usize]] = e as u32;
+                next[u as usize] += 1;
+            }
+        }
+        next.copy_from_slice(&offset);
+
+        let mut oriented = vec![false; m];
+        let mut stack = vec![];
+        for root in 0..n {
+            if self.height[root] != NONE {
+                continue;
+            }
+            self.height[root] = 0;
+            self.roots.push(root as u32);
+            stack.push(root);
+            while let Some(v) = stack.pop() {
+                let parent = self.parent_edge[v];
+                while next[v] < offset[v + 1] {
+                    let e = incident[next[v]] as usize;
+                    if !oriented[e] {
+                        oriented[e] = true;
+                        if self.source[e] as usize != v {
+                            self.target[e] = self.source[e];
+                            self.source[e] = v as u32;
+                        }
+                        let w = self.target[e] as usize;
+                        self.lowpt[e] = self.height[v];
+                        self.lowpt2[e] = self.height[v];
+                        if self.height[w] == NONE {
+                            self.parent_edge[w] = e as u32;
+                            self.height[w] = self.height[v] + 1;
+                            stack.push(v);
+                            stack.push(w);
+                            break;
+                        }
+                        self.lowpt[e] = self.height[w];
+                    } else if self.source[e] as usize != v
+                        || self.parent_edge[self.target[e] as usize] != e as u32
+                    {
+                        next[v] += 1;
+                        continue;
+                    }
+                    // Reached for a back edge, or for a tree edge once `v`
+                    // resumes after its subtree; every other oriented edge
+                    // was handled from its source and is skipped above.
+                    self.nesting_depth[e] = 2 * self.lowpt[e] as i64;
+                    if self.lowpt2[e] < self.height[v] {
+                        self.nesting_depth[e] += 1;
+                    }
+                    if parent != NONE {
+                        let p = parent as usize;
+                        if self.lowpt[e] < self.lowpt[p] {
+                            self.lowpt2[p] = self.lowpt[p].min(self.lowpt2[e]);
+                            self.lowpt[p] = self.lowpt[e];
+                        } else if self.lowpt[e] > self.lowpt[p] {
+                            self.lowpt2[p] = self.lowpt2[p].min(self.lowpt[e]);
+                        } else {
+                            self.lowpt2[p] = self.lowpt2[p].min(self.lowpt2[e]);
+                        }
+                    }
+                    next[v] += 1;
+                }
+            }
+        }
+    }
+
+    fn sort_out_edges(&mut self) {
+        let n = self.n;
+        let m = self.source.len();
+        let offset = &mut self.out_offset;
+        for v in offset.iter_mut() {
+            *v = 0;
+        }
+        for e in 0..m {
+            offset[self.source[e] as usize + 1] += 1;
+        }
+        for u in 0..n {
+            offset[u + 1] += offset[u];
+        }
+        let mut next = offset.clone();
+        self.out_edges = vec![0; m];
+        for e in 0..m {
+            let u = self.source[e] as usize;
+            self.out_edges[next[u]] = e as u32;
+            next[u] += 1;
+        }
+        let nesting_depth = &self.nesting_depth;
+        for u in 0..n {
+            self.out_edges[offset[u]..offset[u + 1]]
+                .sort_unstable_by_key(|&e| nesting_depth[e as usize]);
+        }
+    }
+
+    fn conflicting(&self, interval: &Interval, e: u32) -> bool {
+        interval.high != NONE && self.lowpt[interval.high as usize] > self.lowpt[e as usize]
+    }
+
+    fn lowest(&self, pair: &ConflictPair) -> u32 {
+        let lowpt = |e: u32| {
+            if e == NONE {
+                NONE
+            } else {
+                self.lowpt[e as usize]
+            }
+        };
+        lowpt(pair.left.low).min(lowpt(pair.right.low))
+    }
+
+    fn test(&mut self, root: usize) -> bool {
+        let mut stack = vec![(root, self.out_offset[root], false)];
+        while let Some((v, start, resumed)) = stack.pop() {
+            let parent = self.parent_edge[v];
+            let end = self.out_offset[v + 1];
+            let mut i = start;
+            let mut resumed = resumed;
+            let mut descended = false;
+            while i < end {
+                let e = self.out_edges[i];
+                let w = self.target[e as usize] as usize;
+                if !resumed {
+                    self.stack_bottom[e as usize] = self.stack.len();
+                    if self.parent_edge[w] == e {
+                        stack.push((v, i, true));
+                        stack.push((w, self.out_offset[w], false));
+                        descended = true;
+                        break;
+                    }
+                    self.lowpt_edge[e as usize] = e;
+                    self.stack.push(ConflictPair {
+                        left: Interval::new(),
+                        right: Interval { low: e, high: e },
+                    });
+                }
+                resumed = false;
+                if self.lowpt[e as usize] < self.height[v] {
+                    if i == self.out_offset[v] {
+                        self.lowpt_edge[parent as usize] = self.lowpt_edge[e as usize];
+                    } else if !self.add_constraints(e, parent) {
+                        return false;
+                    }
+                }
+                i += 1;
+            }
+            if !descended && parent != NONE {
+                self.remove_back_edges(parent);
+            }
+        }
+        true
+    }
+
+    fn add_constraints(&mut self, ei: u32, e: u32) -> bool {
+        let mut p = ConflictPair::new();
+        loop {
+            let mut q = self.stack.pop().unwrap();
+            if !q.left.is_empty() {
+                q.swap();
+            }
+            if !q.left.is_empty() {
+                return false;
+            }
+            if self.lowpt[q.right.low as usize] > self.lowpt[e as usize] {
+                if p.right.is_empty() {
+                    p.right = q.right;
+                } else {
+                    self.reference[p.right.low as usize] = q.right.high;
+                }
+                p.right.low = q.right.low;
+            } else {
+                self.reference[q.right.low as usize] = self.lowpt_edge[e as usize];
+            }
+            if self.stack.len() == self.stack_bottom[ei as usize] {
+                break;
+            }
+        }
+        while let Some(&top) = self.stack.last() {
+            if !self.conflicting(&top.left, ei) && !self.conflicting(&top.right, ei) {
+                break;
+            }
+            let mut q = self.stack.pop().unwrap();
+            if self.conflicting(&q.right, ei) {
+                q.swap();
+            }
+            if self.conflicting(&q.right, ei) {
+                return false;
+            }
+            if p.right.low != NONE {
+                self.reference[p.right.low as usize] = q.right.high;
+            }
+            if q.right.low != NONE {
+                p.right.low = q.right.low;
+            }
+            if p.left.is_empty() {
+                p.left = q.left;
+            } else if p.left.low != NONE {
+                self.reference[p.left.low as usize] = q.left.high;
+            }
+            p.left.low = q.left.low;
+        }
+        if !(p.left.is_empty() && p.right.is_empty()) {
+            self.stack.push(p);
+        }
+        true
+    }
+
+    fn remove_back_edges(&mut self, e: u32) {
+        let u = self.source[e as usize];
+        while let Some(top) = self.stack.last() {
+            if self.lowest(top) != self.height[u as usize] {
+                break;
+            }
+            let p = self.stack.pop().unwrap();
+            if p.left.low != NONE {
+                self.side[p.left.low as usize] = -1;
+            }
+        }
+        if let Some(mut p) = self.stack.pop() {
+            while p.left.high != NONE && self.target[p.left.high as usize] == u {
+                p.left.high = self.reference[p.left.high as usize];
+            }
+            if p.left.high == NONE && p.left.low != NONE {
+                self.reference[p.left.low as usize] = p.right.low;
+                self.side[p.left.low as usize] = -1;
+                p.left.low = NONE;
+            }
+            while p.right.high != NONE && self.target[p.right.high as usize] == u {
+                p.right.high = self.reference[p.right.high as usize];
+            }
+            if p.right.high == NONE && p.right.low != NONE {
+                self.reference[p.right.low as usize] = p.left.low;
+                self.side[p.right.low as usize] = -1;
+                p.right.low = NONE;
+            }
+            self.stack.push(p);
+        }
+        if self.lowpt[e as usize] < self.height[u as usize] {
+            if let Some(top) = self.stack.last() {
+                let hl = top.left.high;
+                let hr = top.right.high;
+                self.reference[e as usize] = if hl != NONE
+                    && (hr == NONE || self.lowpt[hl as usize] > self.lowpt[hr as usize])
+                {
+                    hl
+                } else {
+                    hr
+                };
+            }
+        }
+    }
+
+    fn sign(&mut self, e: u32, chain: &mut Vec<u32>) -> i8 {
+        let mut f = e;
+        while self.reference[f as usize] != NONE {
+            chain.push(f);
+            f = self.reference[f as usize];
+        }
+        while let Some(g) = chain.pop() {
+            let r = self.reference[g as usize];
+            self.side[g as usize] *= self.side[r as usize];
+            self.reference[g as usize] = NONE;
+        }
+        self.side[e as usize]
+    }
+
+    /// Rotation system of a successful test: the neighbors of each node in
+    /// clockwise order.
+    fn embed(&mut self) -> Vec<Vec<u32>> {
+        let n = self.n;
+        let m = self.source.len();
+        let mut chain = vec![];
+        for e in 0..m {
+            let s = self.sign(e as u32, &mut chain) as i64;
+            self.nesting_depth[e] *= s;
+        }
+        self.sort_out_edges();
+
+        // Half-edge 2e runs from source to target of e, 2e + 1 back.
+        let mut rotation = Rotation::new(n, m);
+        for v in 0..n {
+            let mut previous = NONE;
+            for i in self.out_offset[v]..self.out_offset[v + 1] {
+                let h = 2 * self.out_edges[i];
+                rotation.insert_cw(v, h, previous);
+                previous = h;
+            }
+        }
+
+        let mut left_ref = vec![NONE; n];
+        let mut right_ref = vec![NONE; n];
+        let mut next = self.out_offset[..n].to_vec();
+        let mut stack = vec![];
+        for &root in &self.roots {
+            stack.push(root as usize);
+            while let Some(v) = stack.pop() {
+                while next[v] < self.out_offset[v + 1] {
+                    let e = self.out_edges[next[v]];
+                    next[v] += 1;
+                    let w = self.target[e as usize] as usize;
+                    if self.parent_edge[w] == e {
+                        rotation.insert_first(w, 2 * e + 1);
+                        left_ref[v] = 2 * e;
+                        right_ref[v] = 2 * e;
+                        stack.push(v);
+                        stack.push(w);
+                        break;
+                    }
+                    if self.side[e as usize] == 1 {
+                        rotation.insert_cw(w, 2 * e + 1, right_ref[w]);
+                    } else {
+                        rotation.insert_ccw(w, 2 * e + 1, left_ref[w]);
+                        left_ref[w] = 2 * e + 1;
+                    }
+                }
+            }
+        }
+
+        (0..n)
+            .map(|v| {
+                let mut neighbors = vec![];
+                let first = rotation.first[v];
+                if first != NONE {
+                    let mut h = first;
+                    loop {
+                        let e = (h / 2) as usize;
+                        neighbors.push(if h % 2 == 0 {
+                            self.target[e]
+                        } else {
+                            self.source[e]
+                        });
+                        h = rotation.cw[h as usize];
+                        if h == first {
+                            break;
+                        }
+                    }
+                }
+                neighbors
+            })
+            .collect()
+    }
+}
+
+/// Circular neighbor lists of half-edges around each node.
+struct Rotation {
+    first: Vec<u32>,
+    cw: Vec<u32>,
+    ccw: Vec<u32>,
+}
+
+impl Rotation {
+    fn new(n: usize, m: usize) -> Rotation {
+        Rotation {
+            first: vec![NONE; n],
+            cw: vec![NONE; 2 * m],
+            ccw: vec![NONE; 2 * m],
+        }
+    }
+
+    fn insert_cw(&mut self, v: usize, h: u32, reference: u32) {
+        if reference == NONE {
+            self.cw[h as usize] = h;
+            self.ccw[h as usize] = h;
+            self.first[v] = h;
+            return;
+        }
+        let after = self.cw[reference as usize];
+        self.cw[reference as usize] = h;
+        self.cw[h as usize] = after;
+        self.ccw[after as usize] = h;
+        self.ccw[h as usize] = reference;
+    }
+
+    fn insert_ccw(&mut self, v: usize, h: u32, reference: u32) {
+        if reference == NONE {
+            self.insert_cw(v, h, NONE);
+            return;
+        }
+        let before = self.ccw[reference as usize];
+        self.insert_cw(v, h, before);
+        if self.first[v] == reference {
+            self.first[v] = h;
+        }
+    }
+
+    fn insert_first(&mut self, v: usize, h: u32) {
+        let reference = self.first[v];
+        self.insert_ccw(v, h, reference);
+    }
+}
+
+/// Tests planarity in linear time with the left-right criterion.
+pub fn is_planar<N, E, Ty: EdgeType, Ix: IndexType>(graph: &Graph<N, E, Ty, Ix>) -> bool {
+    LeftRight::new(graph).run()
+}
+
+/// Returns a planar embedding of `graph` as, for each node index, its
+/// neighbors in clockwise order, or `None` if `graph` is not planar. Edge
+/// directions, self loops and parallel edges are ignored.
+pub fn planar_embedding<N, E, Ty: EdgeType, Ix: IndexType>(
+    graph: &Graph<N, E, Ty, Ix>,
+) -> Option<Vec<Vec<NodeIndex<Ix>>>> {
+    let mut state = LeftRight::new(graph);
+    if !state.run() {
+        return None;
+    }
+    Some(
+        state
+            .embed()
+            .into_iter()
+            .map(|neighbors| {
+                neighbors
+                    .into_iter()
+                    .map(|v| NodeIndex::new(v as usize))
+                    .collect()
+            })
+            .collect(),
+    )
+}
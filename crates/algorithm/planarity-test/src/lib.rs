@@ -1,174 +1,18 @@
-use petgraph::algo::is_bipartite_undirected;
-use petgraph::graph::{IndexType, NodeIndex};
-use petgraph::prelude::*;
-use petgraph::unionfind::UnionFind;
-use petgraph::visit::{depth_first_search, Control, DfsEvent};
-use petgraph::EdgeType;
-use std::collections::{HashMap, HashSet};
-
-fn is_path<N, E, Ty: EdgeType, Ix: IndexType>(
-    graph: &Graph<N, E, Ty, Ix>,
-    segment: &Vec<NodeIndex<Ix>>,
-) -> bool {
-    let nodes = segment
-        .iter()
-        .map(|&u| u)
-        .collect::<HashSet<NodeIndex<Ix>>>();
-    for &u in segment.iter() {
-        let mut degree = 0;
-        for v in graph.neighbors_undirected(u) {
-            if nodes.contains(&v) {
-                degree += 1;
-            }
-        }
-        if degree > 2 {
-            return false;
-        }
-    }
-    true
-}
-
-fn find_cycle<N, E, Ty: EdgeType, Ix: IndexType>(
-    graph: &Graph<N, E, Ty, Ix>,
-) -> Option<Vec<NodeIndex<Ix>>> {
-    let mut stack = vec![];
-    let mut visited_edge = HashSet::new();
-    let u = graph.node_indices().nth(0).unwrap();
-    let result = depth_first_search(graph, Some(u), |event| {
-        match event {
-            DfsEvent::Discover(u, _) => {
-                stack.push(u);
-            }
-            DfsEvent::Finish(_, _) => {
-                stack.pop();
-            }
-            DfsEvent::TreeEdge(u, v) => {
-                visited_edge.insert((u, v));
-            }
-            DfsEvent::BackEdge(u, v) => {
-                if !visited_edge.contains(&(v, u)) {
-                    eprintln!("{:?}", stack);
-                    stack.reverse();
-                    while stack[stack.len() - 1] != v {
-                        stack.pop();
-                    }
-                    return Control::Break(());
-                }
-            }
-            _ => {}
-        }
-        Control::Continue
-    });
-    if let Control::Break(_) = result {
-        Some(stack)
-    } else {
-        None
-    }
-}
-
-fn find_separating_cycle<N, E, Ty: EdgeType, Ix: IndexType>(
-    graph: &Graph<N, E, Ty, Ix>,
-) -> Option<(Vec<NodeIndex<Ix>>, Vec<Vec<NodeIndex<Ix>>>)> {
-    if let Some(cycle) = find_cycle(graph) {
-        let cycle_nodes = cycle.iter().map(|&u| u).collect::<HashSet<NodeIndex<Ix>>>();
-        let mut components = UnionFind::new(graph.node_count());
-        for e in graph.edge_indices() {
-            let (u, v) = graph.edge_endpoints(e).unwrap();
-            if !cycle_nodes.contains(&u) && !cycle_nodes.contains(&v) {
-                components.union(u.index(), v.index());
-            }
-        }
-        let mut segments = HashMap::new();
-        for u in graph.node_indices() {
-            if cycle_nodes.contains(&u) {
-                continue;
-            }
-            let segment = segments
-                .entry(components.find(u.index()))
-                .or_insert(HashSet::new());
-            segment.insert(u);
-            for v in graph.neighbors_undirected(u) {
-                if cycle_nodes.contains(&v) {
-                    segment.insert(v);
-                }
-            }
-        }
-        let segments = segments
-            .values()
-            .filter(|nodes| !nodes.is_empty())
-            .map(|nodes| nodes.iter().map(|&u| u).collect::<Vec<_>>())
-            .collect::<Vec<_>>();
-        eprintln!("{:?}", segments);
-        if segments.is_empty() || segments.len() == 1 {
-            None
-        } else {
-            Some((cycle, segments))
-        }
-    } else {
-        None
-    }
-}
-
-fn separated_subgraph<N, E, Ty: EdgeType, Ix: IndexType>(
-    graph: &Graph<N, E, Ty, Ix>,
-    cycle: &Vec<NodeIndex<Ix>>,
-    segment: &Vec<NodeIndex<Ix>>,
-) -> Graph<(), (), Ty, Ix> {
-    let mut nodes = HashSet::new();
-    for &u in cycle {
-        nodes.insert(u);
-    }
-    for &u in segment {
-        nodes.insert(u);
-    }
-    graph.filter_map(
-        |u, _| if nodes.contains(&u) { Some(()) } else { None },
-        |_, _| Some(()),
-    )
-}
-
-fn interlacement_graph<N, E, Ty: EdgeType, Ix: IndexType>(
-    graph: &Graph<N, E, Ty, Ix>,
-    cycle: &Vec<NodeIndex<Ix>>,
-    segments: &Vec<Vec<NodeIndex<Ix>>>,
-) -> UnGraph<(), ()> {
-    let mut h = Graph::new_undirected();
-    for segment in segments {
-        h.add_node(());
-    }
-    h
-}
-
-fn auslander_parter<N, E, Ty: EdgeType, Ix: IndexType>(graph: &Graph<N, E, Ty, Ix>) -> bool {
-    for e in graph.edge_indices() {
-        let (u, v) = graph.edge_endpoints(e).unwrap();
-        eprintln!("{:?} {:?}", u, v);
-    }
-    if let Some((cycle, segments)) = find_separating_cycle(graph) {
-        let h = interlacement_graph(graph, &cycle, &segments);
-        if !is_bipartite_undirected(&h, h.node_indices().nth(0).unwrap()) {
-            return false;
-        }
-        for segment in segments.iter() {
-            if !auslander_parter(&separated_subgraph(graph, &cycle, segment)) {
-                return false;
-            }
-        }
-        true
-    } else {
-        false
-    }
-}
+#[cfg(test)]
+mod auslander_parter;
+mod left_right;
 
-pub fn is_planar<N, E, Ty: EdgeType, Ix: IndexType>(graph: &Graph<N, E, Ty, Ix>) -> bool {
-    auslander_parter(graph)
-}
+pub use left_right::{is_planar, planar_embedding};
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use petgraph::algo::{connected_components, is_bipartite_undirected};
+    use petgraph::graph::node_index;
+    use petgraph::prelude::*;
+    use std::collections::{HashMap, HashSet};
 
-    fn planar_graph() -> UnGraph<(), ()> {
+    pub fn planar_graph() -> UnGraph<(), ()> {
         let mut graph = Graph::new_undirected();
         let u1 = graph.add_node(());
         let u2 = graph.add_node(());
@@ -198,33 +42,279 @@ mod tests {
     }
 
     #[test]
-    fn test_find_cycle() {
-        let mut graph = Graph::new();
-        let u1 = graph.add_node(());
-        let u2 = graph.add_node(());
-        let u3 = graph.add_node(());
-        let u4 = graph.add_node(());
-        let u5 = graph.add_node(());
-        graph.add_edge(u1, u2, ());
-        graph.add_edge(u2, u3, ());
-        graph.add_edge(u3, u4, ());
-        graph.add_edge(u4, u1, ());
-        graph.add_edge(u1, u5, ());
-        let cycle = find_cycle(&graph).unwrap();
-        assert_eq!(cycle.len(), 4);
+    fn test_is_planar() {
+        let graph = planar_graph();
+        assert_eq!(is_planar(&graph), true);
+    }
+
+    fn complete_graph(n: usize) -> UnGraph<(), ()> {
+        let mut graph = Graph::new_undirected();
+        let nodes = (0..n).map(|_| graph.add_node(())).collect::<Vec<_>>();
+        for i in 0..n {
+            for j in 0..i {
+                graph.add_edge(nodes[j], nodes[i], ());
+            }
+        }
+        graph
+    }
+
+    fn grid_graph(n: usize, diagonal: bool) -> UnGraph<(), ()> {
+        let mut graph = Graph::new_undirected();
+        let nodes = (0..n * n).map(|_| graph.add_node(())).collect::<Vec<_>>();
+        for i in 0..n {
+            for j in 0..n {
+                if i + 1 < n {
+                    graph.add_edge(nodes[i * n + j], nodes[(i + 1) * n + j], ());
+                }
+                if j + 1 < n {
+                    graph.add_edge(nodes[i * n + j], nodes[i * n + j + 1], ());
+                }
+                if diagonal && i + 1 < n && j + 1 < n {
+                    graph.add_edge(nodes[i * n + j], nodes[(i + 1) * n + j + 1], ());
+                }
+            }
+        }
+        graph
+    }
+
+    /// Checks Euler's formula for the rotation system, whose traced faces
+    /// satisfy `n - m + f = 2` for each component with an edge, i.e.
+    /// `n - m + f = 2c - z` for `c` components of which `z` are isolated
+    /// nodes.
+    fn assert_embedding(graph: &UnGraph<(), ()>) {
+        let embedding = planar_embedding(graph).unwrap();
+        let n = graph.node_count();
+        let mut position = HashMap::new();
+        let mut m = 0;
+        for (u, neighbors) in embedding.iter().enumerate() {
+            assert_eq!(neighbors.len(), graph.neighbors(node_index(u)).count());
+            for (i, v) in neighbors.iter().enumerate() {
+                assert!(graph.contains_edge(node_index(u), *v));
+                position.insert((u, v.index()), i);
+            }
+            m += neighbors.len();
+        }
+        m /= 2;
+        let mut visited = HashSet::new();
+        let mut faces = 0;
+        for (u, neighbors) in embedding.iter().enumerate() {
+            for v in neighbors {
+                let mut dart = (u, v.index());
+                if visited.contains(&dart) {
+                    continue;
+                }
+                faces += 1;
+                while visited.insert(dart) {
+                    let (a, b) = dart;
+                    let around = &embedding[b];
+                    let i = position[&(b, a)];
+                    dart = (b, around[(i + 1) % around.len()].index());
+                }
+            }
+        }
+        let components = connected_components(graph) as i64;
+        let isolated = graph
+            .node_indices()
+            .filter(|&u| graph.neighbors(u).next().is_none())
+            .count() as i64;
+        assert_eq!(n as i64 - m as i64 + faces, 2 * components - isolated);
+    }
+
+    /// Checks that a non-planar answer is right: deleting every edge whose
+    /// removal keeps the graph non-planar leaves a minimal non-planar
+    /// subgraph, which must be a subdivision of K5 or K3,3.
+    fn assert_kuratowski_subgraph(graph: &UnGraph<(), ()>) {
+        let mut edges = graph
+            .edge_references()
+            .map(|e| (e.source().index() as u32, e.target().index() as u32))
+            .collect::<Vec<_>>();
+        let mut i = 0;
+        while i < edges.len() {
+            let e = edges.remove(i);
+            if is_planar(&UnGraph::<(), ()>::from_edges(&edges)) {
+                edges.insert(i, e);
+                i += 1;
+            }
+        }
+        // Suppress the subdivision nodes.
+        let mut adjacency = vec![vec![]; graph.node_count()];
+        for &(u, v) in &edges {
+            adjacency[u as usize].push(v as usize);
+            adjacency[v as usize].push(u as usize);
+        }
+        for u in 0..adjacency.len() {
+            if adjacency[u].len() == 2 {
+                let (a, b) = (adjacency[u][0], adjacency[u][1]);
+                assert_ne!(a, b);
+                for &(x, y) in &[(a, b), (b, a)] {
+                    let w = adjacency[x].iter().position(|&w| w == u).unwrap();
+                    adjacency[x][w] = y;
+                }
+                adjacency[u].clear();
+            }
+        }
+        let mut branch = Graph::new_undirected();
+        let mut index = HashMap::new();
+        for (u, neighbors) in adjacency.iter().enumerate() {
+            if !neighbors.is_empty() {
+                index.insert(u, branch.add_node(()));
+            }
+        }
+        for (u, neighbors) in adjacency.iter().enumerate() {
+            let mut distinct = HashSet::new();
+            for &v in neighbors {
+                assert!(v != u && distinct.insert(v), "not a subdivision");
+                if u < v {
+                    branch.add_edge(index[&u], index[&v], ());
+                }
+            }
+        }
+        let n = branch.node_count();
+        let degree = |u| branch.neighbors(u).count();
+        let k5 = n == 5 && branch.node_indices().all(|u| degree(u) == 4);
+        let k33 = n == 6
+            && branch.node_indices().all(|u| degree(u) == 3)
+            && is_bipartite_undirected(&branch, node_index(0));
+        assert!(k5 || k33, "not a subdivision of K5 or K3,3");
+    }
+
+    /// Small xorshift generator, so that the cases are reproducible.
+    struct Random(u64);
+
+    impl Random {
+        fn next(&mut self) -> u64 {
+            self.0 ^= self.0 << 13;
+            self.0 ^= self.0 >> 7;
+            self.0 ^= self.0 << 17;
+            self.0
+        }
+
+        fn below(&mut self, n: usize) -> usize {
+            (self.next() % n as u64) as usize
+        }
+
+        fn chance(&mut self, p: f64) -> bool {
+            ((self.next() >> 11) as f64 / (1u64 << 53) as f64) < p
+        }
+    }
+
+    /// A stacked triangulation of `n >= 3` nodes: every node after the first
+    /// three is placed in a random face and joined to its three corners.
+    fn triangulation(n: usize, random: &mut Random) -> UnGraph<(), ()> {
+        let mut graph = Graph::new_undirected();
+        let nodes = (0..n).map(|_| graph.add_node(())).collect::<Vec<_>>();
+        graph.add_edge(nodes[0], nodes[1], ());
+        graph.add_edge(nodes[1], nodes[2], ());
+        graph.add_edge(nodes[2], nodes[0], ());
+        let mut faces = vec![(0, 1, 2), (0, 2, 1)];
+        for u in 3..n {
+            let f = random.below(faces.len());
+            let (a, b, c) = faces.swap_remove(f);
+            for &v in &[a, b, c] {
+                graph.add_edge(nodes[u], nodes[v], ());
+            }
+            faces.push((a, b, u));
+            faces.push((b, c, u));
+            faces.push((c, a, u));
+        }
+        graph
     }
 
     #[test]
-    fn test_find_separating_cycle() {
-        let graph = planar_graph();
-        let (cycle, segments) = find_separating_cycle(&graph).unwrap();
-        eprintln!("{:?}", cycle);
-        eprintln!("{:?}", segments);
+    fn test_is_planar_triangulation_subgraphs() {
+        let mut random = Random(0x9e37_79b9_7f4a_7c15);
+        for &n in &[5, 10, 50, 300] {
+            for _ in 0..20 {
+                let full = triangulation(n, &mut random);
+                assert_embedding(&full);
+                let mut graph = full.clone();
+                graph.retain_edges(|_, _| random.chance(0.6));
+                assert!(is_planar(&graph));
+                assert_embedding(&graph);
+                // A maximal planar graph has 3n - 6 edges, so any further
+                // edge makes it non-planar.
+                let mut graph = full;
+                loop {
+                    let (u, v) = (node_index(random.below(n)), node_index(random.below(n)));
+                    if u != v && !graph.contains_edge(u, v) {
+                        graph.add_edge(u, v, ());
+                        break;
+                    }
+                }
+                assert!(!is_planar(&graph));
+            }
+        }
     }
 
     #[test]
-    fn test_is_planar() {
-        let graph = planar_graph();
-        assert_eq!(is_planar(&graph), true);
+    fn test_is_planar_random_graphs() {
+        let mut random = Random(0x2545_f491_4f6c_dd1d);
+        let mut counts = [0, 0];
+        for _ in 0..300 {
+            let n = 5 + random.below(5);
+            let p = 0.3 + 0.1 * random.below(4) as f64;
+            let mut graph = Graph::new_undirected();
+            let nodes = (0..n).map(|_| graph.add_node(())).collect::<Vec<_>>();
+            for i in 0..n {
+                for j in 0..i {
+                    if random.chance(p) {
+                        graph.add_edge(nodes[j], nodes[i], ());
+                    }
+                }
+            }
+            assert_eq!(is_planar(&graph), auslander_parter::is_planar(&graph));
+            if is_planar(&graph) {
+                assert_embedding(&graph);
+                counts[0] += 1;
+            } else {
+                assert_kuratowski_subgraph(&graph);
+                counts[1] += 1;
+            }
+        }
+        assert!(counts[0] > 30 && counts[1] > 30);
+    }
+
+    #[test]
+    fn test_is_planar_complete_graphs() {
+        assert!(is_planar(&complete_graph(4)));
+        assert!(!is_planar(&complete_graph(5)));
+        assert_embedding(&complete_graph(4));
+    }
+
+    #[test]
+    fn test_is_planar_bipartite() {
+        let mut graph = Graph::new_undirected();
+        let nodes = (0..6).map(|_| graph.add_node(())).collect::<Vec<_>>();
+        for i in 0..3 {
+            for j in 3..6 {
+                graph.add_edge(nodes[i], nodes[j], ());
+            }
+        }
+        assert!(!is_planar(&graph));
+        graph.remove_edge(graph.find_edge(nodes[0], nodes[3]).unwrap());
+        assert_embedding(&graph);
+    }
+
+    #[test]
+    fn test_is_planar_petersen() {
+        let mut graph = Graph::new_undirected();
+        let nodes = (0..10).map(|_| graph.add_node(())).collect::<Vec<_>>();
+        for i in 0..5 {
+            graph.add_edge(nodes[i], nodes[(i + 1) % 5], ());
+            graph.add_edge(nodes[i], nodes[i + 5], ());
+            graph.add_edge(nodes[i + 5], nodes[(i + 2) % 5 + 5], ());
+        }
+        assert!(!is_planar(&graph));
+    }
+
+    #[test]
+    fn test_planar_embedding() {
+        assert_embedding(&planar_graph());
+        assert_embedding(&grid_graph(30, false));
+        assert_embedding(&grid_graph(30, true));
+        let mut graph = grid_graph(30, true);
+        graph.add_edge(node_index(0), node_index(899), ());
+        graph.add_edge(node_index(29), node_index(870), ());
+        assert!(!is_planar(&graph));
     }
 }
@@ -1,8 +1,284 @@
 use petgraph::visit::{EdgeRef, IntoEdgeReferences, IntoNodeIdentifiers, NodeCount};
-use std::collections::HashMap;
+#[cfg(feature = "parallel")]
+use rayon::prelude::*;
+use std::cmp::Ordering;
+use std::collections::{BinaryHeap, HashMap, VecDeque};
 use std::f32::INFINITY;
 use std::hash::Hash;
 
+/// Undirected adjacency in compressed sparse row form, indexed in
+/// `node_identifiers` order.
+pub struct Adjacency {
+  offsets: Vec<usize>,
+  targets: Vec<usize>,
+  lengths: Vec<f32>,
+}
+
+impl Adjacency {
+  pub fn new<G, F>(graph: G, length: &mut F) -> Adjacency
+  where
+    G: IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
+    G::NodeId: Eq + Hash,
+    F: FnMut(G::EdgeRef) -> f32,
+  {
+    let indices = graph
+      .node_identifiers()
+      .enumerate()
+      .map(|(i, u)| (u, i))
+      .collect::<HashMap<_, _>>();
+    let n = indices.len();
+    let edges = graph
+      .edge_references()
+      .map(|e| (indices[&e.source()], indices[&e.target()], length(e)))
+      .collect::<Vec<_>>();
+    let mut offsets = vec![0; n + 1];
+    for &(i, j, _) in &edges {
+      offsets[i + 1] += 1;
+      offsets[j + 1] += 1;
+    }
+    for i in 0..n {
+      offsets[i + 1] += offsets[i];
+    }
+    let mut next = offsets.clone();
+    let mut targets = vec![0; offsets[n]];
+    let mut lengths = vec![0.; offsets[n]];
+    for &(i, j, d) in &edges {
+      targets[next[i]] = j;
+      lengths[next[i]] = d;
+      next[i] += 1;
+      targets[next[j]] = i;
+      lengths[next[j]] = d;
+      next[j] += 1;
+    }
+    Adjacency {
+      offsets,
+      targets,
+      lengths,
+    }
+  }
+
+  pub fn len(&self) -> usize {
+    self.offsets.len() - 1
+  }
+
+  pub fn is_empty(&self) -> bool {
+    self.len() == 0
+  }
+
+  /// The length shared by every edge, if they all have the same one.
+  fn uniform_length(&self) -> Option<f32> {
+    let l = self.lengths.first().cloned().unwrap_or(1.);
+    if self.lengths.iter().all(|&d| d == l) {
+      Some(l)
+    } else {
+      None
+    }
+  }
+
+  pub fn neighbors(&self, u: usize) -> impl Iterator<Item = (usize, f32)> + '_ {
+    let range = self.offsets[u]..self.offsets[u + 1];
+    self.targets[range.clone()]
+      .iter()
+      .cloned()
+      .zip(self.lengths[range].iter().cloned())
+  }
+
+  /// Writes the distances from `s` to every node into `distance`.
+  pub fn single_source_dijkstra(&self, s: usize, distance: &mut [f32]) {
+    dijkstra(self, s, &mut BinaryHeap::new(), distance);
+  }
+}
+
+fn bfs(
+  adjacency: &Adjacency,
+  s: usize,
+  unit_edge_length: f32,
+  queue: &mut VecDeque<usize>,
+  distance: &mut [f32],
+) {
+  for d in distance.iter_mut() {
+    *d = INFINITY;
+  }
+  distance[s] = 0.;
+  queue.clear();
+  queue.push_back(s);
+  while let Some(u) = queue.pop_front() {
+    for (v, _) in adjacency.neighbors(u) {
+      if distance[v] == INFINITY {
+        distance[v] = distance[u] + unit_edge_length;
+        queue.push_back(v);
+      }
+    }
+  }
+}
+
+#[derive(PartialEq)]
+struct HeapItem {
+  distance: f32,
+  u: usize,
+}
+
+impl Eq for HeapItem {}
+
+impl PartialOrd for HeapItem {
+  fn partial_cmp(&self, other: &HeapItem) -> Option<Ordering> {
+    Some(self.cmp(other))
+  }
+}
+
+impl Ord for HeapItem {
+  fn cmp(&self, other: &HeapItem) -> Ordering {
+    other
+      .distance
+      .partial_cmp(&self.distance)
+      .unwrap_or(Ordering::Equal)
+  }
+}
+
+fn dijkstra(
+  adjacency: &Adjacency,
+  s: usize,
+  heap: &mut BinaryHeap<HeapItem>,
+  distance: &mut [f32],
+) {
+  for d in distance.iter_mut() {
+    *d = INFINITY;
+  }
+  distance[s] = 0.;
+  heap.clear();
+  heap.push(HeapItem { distance: 0., u: s });
+  while let Some(HeapItem { distance: d, u }) = heap.pop() {
+    if d > distance[u] {
+      continue;
+    }
+    for (v, l) in adjacency.neighbors(u) {
+      let e = d + l;
+      if e < distance[v] {
+        distance[v] = e;
+        heap.push(HeapItem { distance: e, u: v });
+      }
+    }
+  }
+}
+
+/// Computes the distances between all pairs of nodes of an unweighted graph
+/// into a row-major `n * n` buffer, every edge having length
+/// `unit_edge_length`. Runs a breadth first search from each node, in
+/// parallel across sources with the `parallel` feature.
+pub fn all_sources_bfs<G>(graph: G, unit_edge_length: f32) -> Vec<f32>
+where
+  G: IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+{
+  let n = graph.node_count();
+  let mut distance = vec![0.; n * n];
+  all_sources_bfs_with_buffer(graph, unit_edge_length, &mut distance);
+  distance
+}
+
+/// Same as `all_sources_bfs`, writing into `distance`, which must have
+/// length `n * n`.
+pub fn all_sources_bfs_with_buffer<G>(graph: G, unit_edge_length: f32, distance: &mut [f32])
+where
+  G: IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+{
+  let adjacency = Adjacency::new(graph, &mut |_| unit_edge_length);
+  all_sources_bfs_adjacency(&adjacency, unit_edge_length, distance);
+}
+
+fn all_sources_bfs_adjacency(adjacency: &Adjacency, unit_edge_length: f32, distance: &mut [f32]) {
+  let n = adjacency.len();
+  assert_eq!(distance.len(), n * n);
+  if n == 0 {
+    return;
+  }
+  #[cfg(feature = "parallel")]
+  distance
+    .par_chunks_mut(n)
+    .enumerate()
+    .for_each_init(VecDeque::new, |queue, (s, row)| {
+      bfs(adjacency, s, unit_edge_length, queue, row)
+    });
+  #[cfg(not(feature = "parallel"))]
+  {
+    let mut queue = VecDeque::new();
+    for (s, row) in distance.chunks_mut(n).enumerate() {
+      bfs(adjacency, s, unit_edge_length, &mut queue, row);
+    }
+  }
+}
+
+/// Computes the distances between all pairs of nodes into a row-major
+/// `n * n` buffer. Edge lengths must be non-negative. Runs Dijkstra's
+/// algorithm from each node, in parallel across sources with the `parallel`
+/// feature.
+pub fn all_sources_dijkstra<G, F>(graph: G, length: &mut F) -> Vec<f32>
+where
+  G: IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+  F: FnMut(G::EdgeRef) -> f32,
+{
+  let n = graph.node_count();
+  let mut distance = vec![0.; n * n];
+  all_sources_dijkstra_with_buffer(graph, length, &mut distance);
+  distance
+}
+
+/// Same as `all_sources_dijkstra`, writing into `distance`, which must have
+/// length `n * n`.
+pub fn all_sources_dijkstra_with_buffer<G, F>(graph: G, length: &mut F, distance: &mut [f32])
+where
+  G: IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+  F: FnMut(G::EdgeRef) -> f32,
+{
+  let adjacency = Adjacency::new(graph, length);
+  all_sources_dijkstra_adjacency(&adjacency, distance);
+}
+
+fn all_sources_dijkstra_adjacency(adjacency: &Adjacency, distance: &mut [f32]) {
+  let n = adjacency.len();
+  assert_eq!(distance.len(), n * n);
+  if n == 0 {
+    return;
+  }
+  #[cfg(feature = "parallel")]
+  distance
+    .par_chunks_mut(n)
+    .enumerate()
+    .for_each_init(BinaryHeap::new, |heap, (s, row)| {
+      dijkstra(adjacency, s, heap, row)
+    });
+  #[cfg(not(feature = "parallel"))]
+  {
+    let mut heap = BinaryHeap::new();
+    for (s, row) in distance.chunks_mut(n).enumerate() {
+      dijkstra(adjacency, s, &mut heap, row);
+    }
+  }
+}
+
+/// Computes the distances between all pairs of nodes into a row-major
+/// `n * n` buffer. Edge lengths are evaluated once; when they are all equal
+/// the distances come from `all_sources_bfs`, otherwise from
+/// `all_sources_dijkstra`.
+pub fn all_sources_shortest_path<G, F>(graph: G, length: &mut F) -> Vec<f32>
+where
+  G: IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+  F: FnMut(G::EdgeRef) -> f32,
+{
+  let adjacency = Adjacency::new(graph, length);
+  let n = adjacency.len();
+  let mut distance = vec![0.; n * n];
+  match adjacency.uniform_length() {
+    Some(l) => all_sources_bfs_adjacency(&adjacency, l, &mut distance),
+    None => all_sources_dijkstra_adjacency(&adjacency, &mut distance),
+  }
+  distance
+}
+
 pub fn warshall_floyd<G, F>(graph: G, length: &mut F) -> Vec<Vec<f32>>
 where
   G: IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
@@ -41,3 +317,67 @@ where
 
   distance
 }
+
+#[cfg(test)]
+mod tests {
+  use super::*;
+  use petgraph::Graph;
+
+  fn grid_graph(n: usize) -> Graph<(), f32, petgraph::Undirected> {
+    let mut graph = Graph::new_undirected();
+    let nodes = (0..n * n).map(|_| graph.add_node(())).collect::<Vec<_>>();
+    for i in 0..n {
+      for j in 0..n {
+        let w = 1. + ((i * 7 + j * 3) % 5) as f32;
+        if i + 1 < n {
+          graph.add_edge(nodes[i * n + j], nodes[(i + 1) * n + j], w);
+        }
+        if j + 1 < n {
+          graph.add_edge(nodes[i * n + j], nodes[i * n + j + 1], w);
+        }
+      }
+    }
+    graph.add_node(());
+    graph
+  }
+
+  #[test]
+  fn test_all_sources_bfs() {
+    let graph = grid_graph(6);
+    let n = graph.node_count();
+    let expected = warshall_floyd(&graph, &mut |_| 2.);
+    let distance = all_sources_bfs(&graph, 2.);
+    for i in 0..n {
+      for j in 0..n {
+        assert_eq!(distance[i * n + j], expected[i][j]);
+      }
+    }
+  }
+
+  #[test]
+  fn test_all_sources_dijkstra() {
+    let graph = grid_graph(6);
+    let n = graph.node_count();
+    let expected = warshall_floyd(&graph, &mut |e| *e.weight());
+    let mut distance = vec![0.; n * n];
+    all_sources_dijkstra_with_buffer(&graph, &mut |e| *e.weight(), &mut distance);
+    for i in 0..n {
+      for j in 0..n {
+        assert_eq!(distance[i * n + j], expected[i][j]);
+      }
+    }
+  }
+
+  #[test]
+  fn test_all_sources_shortest_path() {
+    let graph = grid_graph(6);
+    assert_eq!(
+      all_sources_shortest_path(&graph, &mut |_| 2.),
+      all_sources_bfs(&graph, 2.)
+    );
+    assert_eq!(
+      all_sources_shortest_path(&graph, &mut |e| *e.weight()),
+      all_sources_dijkstra(&graph, &mut |e| *e.weight())
+    );
+  }
+}
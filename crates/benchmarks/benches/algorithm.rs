@@ -0,0 +1,91 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+use egraph_benchmarks::memory::PeakAllocator;
+use egraph_benchmarks::{inputs, sizes};
+use petgraph::visit::EdgeRef;
+use petgraph_algorithm_biconnected_components::biconnected_components;
+use petgraph_algorithm_planarity_test::is_planar;
+use petgraph_algorithm_shortest_path::{all_sources_bfs, all_sources_dijkstra, warshall_floyd};
+use treemap::{normalize, squarify};
+
+#[global_allocator]
+static ALLOCATOR: PeakAllocator = PeakAllocator::new();
+
+fn bench_warshall_floyd(c: &mut Criterion) {
+    let mut group = c.benchmark_group("warshall_floyd");
+    group.sample_size(10);
+    for (name, graph) in inputs(1_000) {
+        let run = || warshall_floyd(&graph, &mut |_| 1.);
+        ALLOCATOR.report(&format!("warshall_floyd/{}", name), run);
+        group.bench_function(BenchmarkId::from_parameter(&name), |b| b.iter(run));
+    }
+    group.finish();
+}
+
+// The n x n distance matrix of larger inputs does not fit in memory.
+fn bench_all_sources_bfs(c: &mut Criterion) {
+    let mut group = c.benchmark_group("all_sources_bfs");
+    group.sample_size(10);
+    for (name, graph) in inputs(10_000) {
+        let run = || all_sources_bfs(&graph, 1.);
+        ALLOCATOR.report(&format!("all_sources_bfs/{}", name), run);
+        group.bench_function(BenchmarkId::from_parameter(&name), |b| b.iter(run));
+    }
+    group.finish();
+}
+
+fn bench_all_sources_dijkstra(c: &mut Criterion) {
+    let mut group = c.benchmark_group("all_sources_dijkstra");
+    group.sample_size(10);
+    for (name, graph) in inputs(10_000) {
+        let run = || all_sources_dijkstra(&graph, &mut |e| 1. + (e.id().index() % 3) as f32);
+        ALLOCATOR.report(&format!("all_sources_dijkstra/{}", name), run);
+        group.bench_function(BenchmarkId::from_parameter(&name), |b| b.iter(run));
+    }
+    group.finish();
+}
+
+fn bench_is_planar(c: &mut Criterion) {
+    let mut group = c.benchmark_group("is_planar");
+    group.sample_size(10);
+    for (name, graph) in inputs(1_000_000) {
+        let run = || is_planar(&graph);
+        ALLOCATOR.report(&format!("is_planar/{}", name), run);
+        group.bench_function(BenchmarkId::from_parameter(&name), |b| b.iter(run));
+    }
+    group.finish();
+}
+
+fn bench_biconnected_components(c: &mut Criterion) {
+    let mut group = c.benchmark_group("biconnected_components");
+    group.sample_size(10);
+    for (name, graph) in inputs(1_000_000) {
+        let run = || biconnected_components(&graph);
+        ALLOCATOR.report(&format!("biconnected_components/{}", name), run);
+        group.bench_function(BenchmarkId::from_parameter(&name), |b| b.iter(run));
+    }
+    group.finish();
+}
+
+fn bench_squarify(c: &mut Criterion) {
+    let mut group = c.benchmark_group("squarify");
+    group.sample_size(10);
+    for n in sizes(1_000_000) {
+        let mut values = (0..n).map(|i| (n - i) as f64).collect::<Vec<_>>();
+        normalize(&mut values, 1000. * 1000.);
+        let run = || squarify(1000., 1000., &values);
+        ALLOCATOR.report(&format!("squarify/{}", n), run);
+        group.bench_function(BenchmarkId::from_parameter(n), |b| b.iter(run));
+    }
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    bench_warshall_floyd,
+    bench_all_sources_bfs,
+    bench_all_sources_dijkstra,
+    bench_is_planar,
+    bench_biconnected_components,
+    bench_squarify
+);
+criterion_main!(benches);
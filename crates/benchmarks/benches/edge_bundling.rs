@@ -0,0 +1,24 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+use egraph_benchmarks::inputs;
+use egraph_benchmarks::memory::PeakAllocator;
+use petgraph_edge_bundling_fdeb::{fdeb, EdgeBundlingOptions};
+use petgraph_layout_force_simulation::initial_placement;
+
+#[global_allocator]
+static ALLOCATOR: PeakAllocator = PeakAllocator::new();
+
+fn bench_fdeb(c: &mut Criterion) {
+    let mut group = c.benchmark_group("fdeb");
+    group.sample_size(10);
+    let options = EdgeBundlingOptions::new();
+    for (name, graph) in inputs(1_000) {
+        let coordinates = initial_placement(&graph);
+        let run = || fdeb(&graph, &coordinates, &options);
+        ALLOCATOR.report(&format!("fdeb/{}", name), run);
+        group.bench_function(BenchmarkId::from_parameter(&name), |b| b.iter(run));
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_fdeb);
+criterion_main!(benches);
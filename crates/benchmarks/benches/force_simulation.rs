@@ -0,0 +1,57 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+use egraph_benchmarks::inputs;
+use egraph_benchmarks::memory::PeakAllocator;
+use petgraph::graph::UnGraph;
+use petgraph_layout_force_simulation::force::{
+    position_force::NodeArgument, CenterForce, CollideForce, LinkForce, ManyBodyForce,
+    PositionForce, RadialForce,
+};
+use petgraph_layout_force_simulation::{initial_placement, Force, Simulation};
+
+#[global_allocator]
+static ALLOCATOR: PeakAllocator = PeakAllocator::new();
+
+fn forces(graph: &UnGraph<(), ()>) -> Vec<(&'static str, Box<dyn Force>)> {
+    vec![
+        ("center", Box::new(CenterForce::new())),
+        (
+            "collide",
+            Box::new(CollideForce::new(graph, |_, _| 5., 0.7, 1)),
+        ),
+        ("link", Box::new(LinkForce::new(graph))),
+        ("many_body", Box::new(ManyBodyForce::new(graph))),
+        (
+            "position",
+            Box::new(PositionForce::new(graph, |_, _| NodeArgument {
+                strength: None,
+                x: Some(0.),
+                y: Some(0.),
+            })),
+        ),
+        (
+            "radial",
+            Box::new(RadialForce::new(graph, |_, _| Some((0.1, 100., 0., 0.)))),
+        ),
+    ]
+}
+
+fn bench_step(c: &mut Criterion) {
+    let mut group = c.benchmark_group("simulation_step");
+    group.sample_size(10);
+    for (name, graph) in inputs(1_000_000) {
+        let coordinates = initial_placement(&graph);
+        for (force_name, force) in forces(&graph) {
+            let forces = [force];
+            let mut simulation = Simulation::new(&graph, |_, u| coordinates[&u]);
+            let id = BenchmarkId::new(force_name, &name);
+            ALLOCATOR.report(&format!("simulation_step/{}/{}", force_name, name), || {
+                simulation.step(&forces)
+            });
+            group.bench_function(id, |b| b.iter(|| simulation.step(&forces)));
+        }
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_step);
+criterion_main!(benches);
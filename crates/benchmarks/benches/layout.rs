@@ -0,0 +1,121 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+use egraph_benchmarks::memory::PeakAllocator;
+use egraph_benchmarks::{generators, inputs};
+use petgraph::visit::EdgeRef;
+use petgraph_layout_batch::{layout_batch, BatchLayout, GraphBatch};
+use petgraph_layout_fm3::fm3_with_link_distance;
+use petgraph_layout_force_simulation::initial_placement;
+use petgraph_layout_kamada_kawai::kamada_kawai;
+use petgraph_layout_stress_majorization::{sparse_sgd, stress_majorization};
+
+#[global_allocator]
+static ALLOCATOR: PeakAllocator = PeakAllocator::new();
+
+fn bench_fm3(c: &mut Criterion) {
+    let mut group = c.benchmark_group("fm3");
+    group.sample_size(10);
+    for (name, graph) in inputs(100_000) {
+        let run = || fm3_with_link_distance(&graph, 100, 100, &mut |_, _| 30.);
+        ALLOCATOR.report(&format!("fm3/{}", name), run);
+        group.bench_function(BenchmarkId::from_parameter(&name), |b| b.iter(run));
+    }
+    group.finish();
+}
+
+// Both work on dense n x n distance matrices, so larger inputs do not fit.
+fn bench_kamada_kawai(c: &mut Criterion) {
+    let mut group = c.benchmark_group("kamada_kawai");
+    group.sample_size(10);
+    for (name, graph) in inputs(1_000) {
+        let coordinates = initial_placement(&graph);
+        let run = || {
+            let mut coordinates = coordinates.clone();
+            kamada_kawai(&graph, &mut coordinates, &mut |_| 1., 1e-1, 1000., 1000.);
+            coordinates
+        };
+        ALLOCATOR.report(&format!("kamada_kawai/{}", name), run);
+        group.bench_function(BenchmarkId::from_parameter(&name), |b| b.iter(run));
+    }
+    group.finish();
+}
+
+fn bench_stress_majorization(c: &mut Criterion) {
+    let mut group = c.benchmark_group("stress_majorization");
+    group.sample_size(10);
+    for (name, graph) in inputs(1_000) {
+        let coordinates = initial_placement(&graph);
+        let run = || {
+            let mut coordinates = coordinates.clone();
+            stress_majorization(&graph, &mut coordinates, &mut |_| 30.);
+            coordinates
+        };
+        ALLOCATOR.report(&format!("stress_majorization/{}", name), run);
+        group.bench_function(BenchmarkId::from_parameter(&name), |b| b.iter(run));
+    }
+    group.finish();
+}
+
+// Pivot terms keep memory linear in n, so it runs on the larger inputs too.
+fn bench_sparse_sgd(c: &mut Criterion) {
+    let mut group = c.benchmark_group("sparse_sgd");
+    group.sample_size(10);
+    for (name, graph) in inputs(100_000) {
+        let coordinates = initial_placement(&graph);
+        let run = || {
+            let mut coordinates = coordinates.clone();
+            sparse_sgd(&graph, &mut coordinates, &mut |_| 30., 50, 15, 1e-1);
+            coordinates
+        };
+        ALLOCATOR.report(&format!("sparse_sgd/{}", name), run);
+        group.bench_function(BenchmarkId::from_parameter(&name), |b| b.iter(run));
+    }
+    group.finish();
+}
+
+// Many small graphs, each laid out on its own through the map-based entry
+// point, against one `layout_batch` call.
+fn bench_layout_batch(c: &mut Criterion) {
+    let mut group = c.benchmark_group("layout_batch");
+    group.sample_size(10);
+    let graphs = (0..1_000)
+        .map(|i| generators::barabasi_albert(5 + i % 50, 2, i as u64))
+        .collect::<Vec<_>>();
+    let mut batch = GraphBatch::new();
+    for graph in &graphs {
+        let edges = graph
+            .edge_references()
+            .map(|e| (e.source().index(), e.target().index()))
+            .collect::<Vec<_>>();
+        batch.add_graph(graph.node_count(), &edges);
+    }
+    group.bench_function(BenchmarkId::from_parameter("separate"), |b| {
+        b.iter(|| {
+            for graph in &graphs {
+                let mut coordinates = initial_placement(graph);
+                stress_majorization(graph, &mut coordinates, &mut |_| 30.);
+            }
+        })
+    });
+    group.bench_function(BenchmarkId::from_parameter("batched"), |b| {
+        b.iter(|| {
+            let mut coordinates = batch.initial_placement();
+            layout_batch(
+                &batch,
+                BatchLayout::StressMajorization { edge_length: 30. },
+                &mut coordinates,
+            );
+            coordinates
+        })
+    });
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    bench_fm3,
+    bench_kamada_kawai,
+    bench_stress_majorization,
+    bench_sparse_sgd,
+    bench_layout_batch
+);
+criterion_main!(benches);
@@ -0,0 +1,111 @@
+//! Seeded synthetic graph generators.
+
+use petgraph::graph::{node_index, UnGraph};
+use rand::prelude::*;
+
+fn random_index(rng: &mut StdRng, n: usize) -> usize {
+    (rng.next_u64() % n as u64) as usize
+}
+
+fn seeded_rng(seed: u64) -> StdRng {
+    let mut bytes = [0; 32];
+    bytes[..8].copy_from_slice(&seed.to_le_bytes());
+    SeedableRng::from_seed(bytes)
+}
+
+/// A grid of `n` nodes laid out row by row, `ceil(sqrt(n))` nodes per row.
+pub fn grid(n: usize) -> UnGraph<(), ()> {
+    let columns = (n as f64).sqrt().ceil() as usize;
+    let mut graph = UnGraph::with_capacity(n, 2 * n);
+    for _ in 0..n {
+        graph.add_node(());
+    }
+    for i in 0..n {
+        if (i + 1) % columns != 0 && i + 1 < n {
+            graph.add_edge(node_index(i), node_index(i + 1), ());
+        }
+        if i + columns < n {
+            graph.add_edge(node_index(i), node_index(i + columns), ());
+        }
+    }
+    graph
+}
+
+/// A Barabasi-Albert preferential attachment graph of `n` nodes in which
+/// every new node attaches to `m` distinct existing nodes.
+pub fn barabasi_albert(n: usize, m: usize, seed: u64) -> UnGraph<(), ()> {
+    let mut rng = seeded_rng(seed);
+    let mut graph = UnGraph::with_capacity(n, n * m);
+    for _ in 0..n {
+        graph.add_node(());
+    }
+    let mut endpoints = Vec::with_capacity(2 * n * m);
+    let mut targets = Vec::with_capacity(m);
+    for u in m.min(n)..n {
+        targets.clear();
+        if endpoints.is_empty() {
+            targets.extend(0..m);
+        } else {
+            while targets.len() < m {
+                let v = endpoints[random_index(&mut rng, endpoints.len())];
+                if !targets.contains(&v) {
+                    targets.push(v);
+                }
+            }
+        }
+        for &v in &targets {
+            graph.add_edge(node_index(u), node_index(v), ());
+            endpoints.push(u);
+            endpoints.push(v);
+        }
+    }
+    graph
+}
+
+/// A random geometric graph of `n` points in the unit square, connecting
+/// the pairs closer than the radius that gives `average_degree`.
+pub fn random_geometric(n: usize, average_degree: f32, seed: u64) -> UnGraph<(), ()> {
+    let mut rng = seeded_rng(seed);
+    let points = (0..n)
+        .map(|_| (rng.gen::<f32>(), rng.gen::<f32>()))
+        .collect::<Vec<_>>();
+    let r = (average_degree / (std::f32::consts::PI * n as f32)).sqrt();
+    let cells = ((1. / r) as usize).max(1);
+    let cell = |v: f32| ((v * cells as f32) as usize).min(cells - 1);
+    let mut buckets = vec![vec![]; cells * cells];
+    for (i, &(x, y)) in points.iter().enumerate() {
+        buckets[cell(y) * cells + cell(x)].push(i);
+    }
+
+    let mut graph = UnGraph::with_capacity(n, n * average_degree as usize / 2);
+    for _ in 0..n {
+        graph.add_node(());
+    }
+    for (i, &(x, y)) in points.iter().enumerate() {
+        let (cx, cy) = (cell(x), cell(y));
+        for ny in cy.saturating_sub(1)..(cy + 2).min(cells) {
+            for nx in cx.saturating_sub(1)..(cx + 2).min(cells) {
+                for &j in &buckets[ny * cells + nx] {
+                    let (dx, dy) = (points[j].0 - x, points[j].1 - y);
+                    if i < j && dx * dx + dy * dy < r * r {
+                        graph.add_edge(node_index(i), node_index(j), ());
+                    }
+                }
+            }
+        }
+    }
+    graph
+}
+
+#[test]
+fn test_generators() {
+    let graph = grid(10);
+    assert_eq!(graph.node_count(), 10);
+    assert_eq!(graph.edge_count(), 13);
+    let graph = barabasi_albert(100, 2, 0);
+    assert_eq!(graph.node_count(), 100);
+    assert_eq!(graph.edge_count(), 98 * 2);
+    let graph = random_geometric(1000, 6., 0);
+    assert_eq!(graph.node_count(), 1000);
+    assert!(graph.edge_count() > 1000 && graph.edge_count() < 5000);
+}
@@ -0,0 +1,41 @@
+//! Shared inputs and helpers for the criterion benchmarks of the workspace.
+//!
+//! Run with `cargo bench -p egraph-benchmarks`. Set `EGRAPH_BENCH_MAX_NODES`
+//! to skip the inputs larger than the given number of nodes.
+
+pub mod generators;
+pub mod memory;
+
+use petgraph::graph::UnGraph;
+
+pub const SIZES: [usize; 4] = [1_000, 10_000, 100_000, 1_000_000];
+
+/// Sizes from `SIZES` up to `limit` nodes and `EGRAPH_BENCH_MAX_NODES`.
+pub fn sizes(limit: usize) -> Vec<usize> {
+    let max_nodes = std::env::var("EGRAPH_BENCH_MAX_NODES")
+        .ok()
+        .and_then(|value| value.parse().ok())
+        .unwrap_or(std::usize::MAX);
+    SIZES
+        .iter()
+        .cloned()
+        .filter(|&n| n <= limit && n <= max_nodes)
+        .collect()
+}
+
+/// The synthetic graphs of `sizes(limit)`, each named `generator/n`.
+pub fn inputs(limit: usize) -> Vec<(String, UnGraph<(), ()>)> {
+    let mut result = vec![];
+    for n in sizes(limit) {
+        result.push((format!("grid/{}", n), generators::grid(n)));
+        result.push((
+            format!("barabasi_albert/{}", n),
+            generators::barabasi_albert(n, 2, 0),
+        ));
+        result.push((
+            format!("random_geometric/{}", n),
+            generators::random_geometric(n, 6., 0),
+        ));
+    }
+    result
+}
@@ -0,0 +1,73 @@
+//! An allocator that tracks the peak heap usage of the benchmarks.
+//!
+//! The library only provides the type. Each bench binary that reports memory
+//! registers it with
+//!
+//! ```ignore
+//! #[global_allocator]
+//! static ALLOCATOR: PeakAllocator = PeakAllocator::new();
+//! ```
+//!
+//! Allocations are only counted inside `peak_usage` and `report`, so the
+//! criterion timing runs pay for a single relaxed load per allocation.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::sync::atomic::{AtomicBool, AtomicIsize, Ordering};
+
+pub struct PeakAllocator {
+    tracking: AtomicBool,
+    current: AtomicIsize,
+    peak: AtomicIsize,
+}
+
+impl PeakAllocator {
+    pub const fn new() -> PeakAllocator {
+        PeakAllocator {
+            tracking: AtomicBool::new(false),
+            current: AtomicIsize::new(0),
+            peak: AtomicIsize::new(0),
+        }
+    }
+
+    /// Runs `f` and returns its result with the peak number of heap bytes
+    /// allocated on top of what was live before the call.
+    pub fn peak_usage<T, F: FnOnce() -> T>(&self, f: F) -> (T, usize) {
+        self.current.store(0, Ordering::Relaxed);
+        self.peak.store(0, Ordering::Relaxed);
+        self.tracking.store(true, Ordering::SeqCst);
+        let result = f();
+        self.tracking.store(false, Ordering::SeqCst);
+        (result, self.peak.load(Ordering::Relaxed) as usize)
+    }
+
+    /// Runs `f` once and prints its peak heap usage under `label`.
+    pub fn report<T, F: FnOnce() -> T>(&self, label: &str, f: F) -> T {
+        let (result, bytes) = self.peak_usage(f);
+        println!(
+            "{}: peak memory {:.1} MiB",
+            label,
+            bytes as f64 / (1 << 20) as f64
+        );
+        result
+    }
+}
+
+unsafe impl GlobalAlloc for PeakAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        let ptr = System.alloc(layout);
+        if !ptr.is_null() && self.tracking.load(Ordering::Relaxed) {
+            let size = layout.size() as isize;
+            let current = self.current.fetch_add(size, Ordering::Relaxed) + size;
+            self.peak.fetch_max(current, Ordering::Relaxed);
+        }
+        ptr
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout);
+        if self.tracking.load(Ordering::Relaxed) {
+            self.current
+                .fetch_sub(layout.size() as isize, Ordering::Relaxed);
+        }
+    }
+}
@@ -1,5 +1,7 @@
 use petgraph::graph::{EdgeIndex, Graph, IndexType, NodeIndex};
 use petgraph::EdgeType;
+#[cfg(feature = "parallel")]
+use rayon::prelude::*;
 use std::collections::HashMap;
 use std::f32;
 
@@ -26,7 +28,6 @@ impl Point {
 pub struct LineSegment {
     source: usize,
     target: usize,
-    point_indices: Vec<usize>,
 }
 
 impl LineSegment {
@@ -34,11 +35,11 @@ impl LineSegment {
         LineSegment {
             source: source,
             target: target,
-            point_indices: Vec::new(),
         }
     }
 }
 
+#[derive(Copy, Clone)]
 struct EdgePair {
     p: usize,
     q: usize,
@@ -119,77 +120,253 @@ fn compatibility(p1: Point, p2: Point, q1: Point, q2: Point) -> f32 {
     c_a * c_s * c_p * c_v
 }
 
-fn apply_spring_force(
-    mid_points: &mut Vec<Point>,
+/// Largest length ratio of two segments whose scale compatibility can reach
+/// `minimum_edge_compatibility`.
+fn max_length_ratio(minimum_edge_compatibility: f32) -> f32 {
+    // c_s(r) = 4 (1 + r) / ((1 + r)^2 + 4 r) decreases in r = l_max / l_min.
+    let t = minimum_edge_compatibility;
+    let s = ((4. - 4. * t) + ((4. * t - 4.).powi(2) + 16. * t * t).sqrt()) / (2. * t);
+    (s - 1.).max(1.)
+}
+
+/// Uniform grid over segment midpoints, stored as CSR buckets.
+struct MidpointGrid {
+    min_x: f32,
+    min_y: f32,
+    cell_size: f32,
+    nx: usize,
+    ny: usize,
+    cell_start: Vec<usize>,
+    cell_items: Vec<usize>,
+}
+
+impl MidpointGrid {
+    fn new(mid: &[(f32, f32)], cell_size: f32) -> MidpointGrid {
+        let m = mid.len();
+        let (mut min_x, mut min_y) = (f32::INFINITY, f32::INFINITY);
+        let (mut max_x, mut max_y) = (f32::NEG_INFINITY, f32::NEG_INFINITY);
+        for &(x, y) in mid {
+            min_x = min_x.min(x);
+            min_y = min_y.min(y);
+            max_x = max_x.max(x);
+            max_y = max_y.max(y);
+        }
+        // Coarsen the grid until it has at most about 4 cells per segment.
+        let mut cell_size = cell_size.max(1e-6);
+        let (mut nx, mut ny);
+        loop {
+            nx = ((max_x - min_x) / cell_size) as usize + 1;
+            ny = ((max_y - min_y) / cell_size) as usize + 1;
+            if nx.saturating_mul(ny) <= 4 * m + 16 {
+                break;
+            }
+            cell_size *= 2.;
+        }
+        let mut grid = MidpointGrid {
+            min_x,
+            min_y,
+            cell_size,
+            nx,
+            ny,
+            cell_start: vec![0; nx * ny + 1],
+            cell_items: vec![0; m],
+        };
+        for &(x, y) in mid {
+            let c = grid.cell(x, y);
+            grid.cell_start[c + 1] += 1;
+        }
+        for c in 0..nx * ny {
+            grid.cell_start[c + 1] += grid.cell_start[c];
+        }
+        let mut offset = grid.cell_start.clone();
+        for (p, &(x, y)) in mid.iter().enumerate() {
+            let c = grid.cell(x, y);
+            grid.cell_items[offset[c]] = p;
+            offset[c] += 1;
+        }
+        grid
+    }
+
+    fn coordinate(&self, v: f32, min: f32, n: usize) -> usize {
+        (((v - min) / self.cell_size).max(0.) as usize).min(n - 1)
+    }
+
+    fn cell(&self, x: f32, y: f32) -> usize {
+        self.coordinate(y, self.min_y, self.ny) * self.nx + self.coordinate(x, self.min_x, self.nx)
+    }
+
+    /// Calls `f` for every segment whose midpoint lies in a cell overlapping
+    /// the square of half width `r` around `(x, y)`.
+    fn query<F: FnMut(usize)>(&self, x: f32, y: f32, r: f32, mut f: F) {
+        let x0 = self.coordinate(x - r, self.min_x, self.nx);
+        let x1 = self.coordinate(x + r, self.min_x, self.nx);
+        let y0 = self.coordinate(y - r, self.min_y, self.ny);
+        let y1 = self.coordinate(y + r, self.min_y, self.ny);
+        for cy in y0..=y1 {
+            for cx in x0..=x1 {
+                let c = cy * self.nx + cx;
+                for &q in &self.cell_items[self.cell_start[c]..self.cell_start[c + 1]] {
+                    f(q);
+                }
+            }
+        }
+    }
+}
+
+/// Finds the compatible pairs `p < q`, sorted by `(p, q)`.
+///
+/// Since every factor of the compatibility is at most one, a compatible pair
+/// has position compatibility `l_avg / (l_avg + |m_p - m_q|)` and scale
+/// compatibility of at least `minimum_edge_compatibility`. That bounds the
+/// midpoint distance by a multiple of the length of `p`, so candidates are
+/// looked up in a grid over the midpoints.
+fn edge_pairs(
+    points: &Vec<Point>,
     segments: &Vec<LineSegment>,
+    minimum_edge_compatibility: f32,
+) -> Vec<EdgePair> {
+    let m = segments.len();
+    let pair = |p: usize, q: usize| {
+        let (segment_p, segment_q) = (&segments[p], &segments[q]);
+        let c_e = compatibility(
+            points[segment_p.source],
+            points[segment_p.target],
+            points[segment_q.source],
+            points[segment_q.target],
+        );
+        if c_e >= minimum_edge_compatibility {
+            let theta = angle(
+                points[segment_p.source],
+                points[segment_p.target],
+                points[segment_q.source],
+                points[segment_q.target],
+            );
+            Some(EdgePair::new(p, q, c_e, theta))
+        } else {
+            None
+        }
+    };
+    if !(minimum_edge_compatibility > 0.) {
+        let mut edge_pairs = Vec::new();
+        for p in 0..m {
+            for q in (p + 1)..m {
+                edge_pairs.extend(pair(p, q));
+            }
+        }
+        return edge_pairs;
+    }
+
+    let mid = segments
+        .iter()
+        .map(|segment| {
+            let (s, t) = (points[segment.source], points[segment.target]);
+            ((s.x + t.x) / 2., (s.y + t.y) / 2.)
+        })
+        .collect::<Vec<_>>();
+    // Slightly enlarged so that rounding in `compatibility` can not make a
+    // pair on the boundary compatible but not found.
+    let scale = (1. / minimum_edge_compatibility - 1.)
+        * (1. + max_length_ratio(minimum_edge_compatibility))
+        / 2.
+        * 1.001;
+    let radius = segments
+        .iter()
+        .map(|segment| {
+            let (s, t) = (points[segment.source], points[segment.target]);
+            scale * distance(s.x, s.y, t.x, t.y) + 1e-4
+        })
+        .collect::<Vec<_>>();
+    let cell_size = radius.iter().sum::<f32>() / m.max(1) as f32;
+    let grid = MidpointGrid::new(&mid, cell_size);
+
+    let find = |p: usize| {
+        let (x, y) = mid[p];
+        let r = radius[p];
+        let mut candidates = Vec::new();
+        grid.query(x, y, r, |q| {
+            if q > p {
+                let (dx, dy) = (mid[q].0 - x, mid[q].1 - y);
+                if dx * dx + dy * dy <= r * r {
+                    candidates.push(q);
+                }
+            }
+        });
+        candidates.sort_unstable();
+        candidates
+            .into_iter()
+            .filter_map(|q| pair(p, q))
+            .collect::<Vec<_>>()
+    };
+    #[cfg(feature = "parallel")]
+    let edge_pairs = (0..m).into_par_iter().map(find).collect::<Vec<_>>();
+    #[cfg(not(feature = "parallel"))]
+    let edge_pairs = (0..m).map(find).collect::<Vec<_>>();
+    edge_pairs.into_iter().flatten().collect()
+}
+
+fn apply_spring_force(
+    force: &mut [(f32, f32)],
+    segment_points: &[(f32, f32)],
+    segment: &LineSegment,
     points: &Vec<Point>,
     num_p: usize,
     k: f32,
 ) {
-    for segment in segments.iter() {
-        let d = distance(
-            points[segment.source].x,
-            points[segment.source].y,
-            points[segment.target].x,
-            points[segment.target].y,
-        );
-        let kp = k / (num_p as usize as f32) / d;
-        let n = segment.point_indices.len();
-        for i in 0..n {
-            let p0 = if i == 0 {
-                points[segment.source]
-            } else {
-                mid_points[segment.point_indices[i - 1]]
-            };
-            let p2 = if i == n - 1 {
-                points[segment.target]
-            } else {
-                mid_points[segment.point_indices[i + 1]]
-            };
-            let ref mut p1 = mid_points[segment.point_indices[i]];
-            p1.vx += kp * (p0.x - p1.x + p2.x - p1.x);
-            p1.vy += kp * (p0.y - p1.y + p2.y - p1.y);
-        }
+    let d = distance(
+        points[segment.source].x,
+        points[segment.source].y,
+        points[segment.target].x,
+        points[segment.target].y,
+    );
+    let kp = k / (num_p as usize as f32) / d;
+    let n = num_p;
+    for i in 0..n {
+        let (p0x, p0y) = if i == 0 {
+            (points[segment.source].x, points[segment.source].y)
+        } else {
+            segment_points[i - 1]
+        };
+        let (p2x, p2y) = if i == n - 1 {
+            (points[segment.target].x, points[segment.target].y)
+        } else {
+            segment_points[i + 1]
+        };
+        let (p1x, p1y) = segment_points[i];
+        force[i].0 += kp * (p0x - p1x + p2x - p1x);
+        force[i].1 += kp * (p0y - p1y + p2y - p1y);
     }
 }
 
 fn apply_electrostatic_force(
-    mid_points: &mut Vec<Point>,
-    segments: &Vec<LineSegment>,
-    edge_pairs: &Vec<EdgePair>,
+    force: &mut [(f32, f32)],
+    mid_points: &[(f32, f32)],
+    stride: usize,
+    pairs: &[EdgePair],
     num_p: usize,
 ) {
-    for pair in edge_pairs {
+    for pair in pairs {
         let EdgePair {
             p,
             q,
             theta,
             compatibility: c_e,
-        } = pair;
-        let segment_p = &segments[*p];
-        let segment_q = &segments[*q];
+        } = *pair;
+        let segment_p = &mid_points[p * stride..p * stride + num_p];
+        let segment_q = &mid_points[q * stride..q * stride + num_p];
         for i in 0..num_p {
-            let j = if *theta < f32::consts::PI / 2.0 {
+            let j = if theta < f32::consts::PI / 2.0 {
                 i
             } else {
                 num_p - i - 1
             };
-            let pi = mid_points[segment_p.point_indices[i as usize]];
-            let qi = mid_points[segment_q.point_indices[j as usize]];
-            let dx = qi.x - pi.x;
-            let dy = qi.y - pi.y;
+            let (pix, piy) = segment_p[i];
+            let (qix, qiy) = segment_q[j];
+            let dx = qix - pix;
+            let dy = qiy - piy;
             if dx.abs() > 1e-6 || dy.abs() > 1e-6 {
                 let w = c_e / (dx * dx + dy * dy).sqrt();
-                {
-                    let ref mut qi = mid_points[segment_q.point_indices[j as usize]];
-                    qi.vx -= dx * w;
-                    qi.vy -= dy * w;
-                }
-                {
-                    let ref mut pi = mid_points[segment_p.point_indices[i as usize]];
-                    pi.vx += dx * w;
-                    pi.vy += dy * w;
-                }
+                force[i].0 += dx * w;
+                force[i].1 += dy * w;
             }
         }
     }
@@ -222,120 +399,521 @@ pub fn fdeb<N, E, Ty: EdgeType, Ix: IndexType>(
     points: &HashMap<NodeIndex<Ix>, (f32, f32)>,
     options: &EdgeBundlingOptions,
 ) -> HashMap<EdgeIndex<Ix>, Vec<(f32, f32)>> {
-    let EdgeBundlingOptions {
-        cycles,
-        s0,
-        i0,
-        s_step,
-        i_step,
-        minimum_edge_compatibility,
-    } = options;
-    let points = graph
-        .node_indices()
-        .map(|u| {
-            let (x, y) = points[&u];
-            Point::new(x, y)
-        })
-        .collect::<Vec<Point>>();
-    let node_indices = graph
-        .node_indices()
-        .enumerate()
-        .map(|(i, u)| (u, i))
-        .collect::<HashMap<NodeIndex<Ix>, usize>>();
-    let mut mid_points = Vec::new();
-    let mut segments = graph
+    let points = graph.node_indices().map(|u| points[&u]).collect::<Vec<_>>();
+    graph
         .edge_indices()
-        .map(|e| {
-            let (u, v) = graph.edge_endpoints(e).unwrap();
-            LineSegment::new(node_indices[&u], node_indices[&v])
-        })
-        .collect::<Vec<_>>();
+        .zip(fdeb_slice(graph, &points, options))
+        .collect()
+}
 
-    let mut num_iter = *i0;
-    let mut alpha = *s0;
+/// Same as `fdeb`, with `points` indexed by node index. The result is indexed
+/// by edge index.
+pub fn fdeb_slice<N, E, Ty: EdgeType, Ix: IndexType>(
+    graph: &Graph<N, E, Ty, Ix>,
+    points: &[(f32, f32)],
+    options: &EdgeBundlingOptions,
+) -> Vec<Vec<(f32, f32)>> {
+    let (offsets, polyline_points) = fdeb_flat(graph, points, options);
+    offsets
+        .windows(2)
+        .map(|w| polyline_points[w[0]..w[1]].to_vec())
+        .collect()
+}
 
-    let edge_pairs = {
-        let mut edge_pairs = Vec::new();
+/// Same as `fdeb_slice`, returning all polylines in one flat point array: the
+/// polyline of edge index `e`, end points included, is
+/// `points[offsets[e]..offsets[e + 1]]`.
+pub fn fdeb_flat<N, E, Ty: EdgeType, Ix: IndexType>(
+    graph: &Graph<N, E, Ty, Ix>,
+    points: &[(f32, f32)],
+    options: &EdgeBundlingOptions,
+) -> (Vec<usize>, Vec<(f32, f32)>) {
+    let mut bundling = EdgeBundling::new(graph, points, options);
+    bundling.run();
+    (bundling.polyline_offsets(), bundling.polyline_points())
+}
+
+/// Incremental force-directed edge bundling: the state of `fdeb_flat`
+/// between iterations, so that a caller can run it a few iterations at a
+/// time, show intermediate polylines, and stop at any point.
+pub struct EdgeBundling {
+    points: Vec<Point>,
+    segments: Vec<LineSegment>,
+    pair_offsets: Vec<usize>,
+    pairs: Vec<EdgePair>,
+    // Subdivision points of segment p are stored in
+    // mid_points[p * stride..p * stride + num_p], sized for the last cycle.
+    stride: usize,
+    num_p: usize,
+    mid_points: Vec<(f32, f32)>,
+    next: Vec<(f32, f32)>,
+    cycles: usize,
+    cycle: usize,
+    remaining: usize,
+    num_iter: usize,
+    alpha: f32,
+    s_step: f32,
+    i_step: f32,
+}
+
+impl EdgeBundling {
+    /// Finds the compatible edge pairs; no iteration is run yet.
+    pub fn new<N, E, Ty: EdgeType, Ix: IndexType>(
+        graph: &Graph<N, E, Ty, Ix>,
+        points: &[(f32, f32)],
+        options: &EdgeBundlingOptions,
+    ) -> EdgeBundling {
+        let points = points
+            .iter()
+            .map(|&(x, y)| Point::new(x, y))
+            .collect::<Vec<Point>>();
+        let segments = graph
+            .edge_indices()
+            .map(|e| {
+                let (u, v) = graph.edge_endpoints(e).unwrap();
+                LineSegment::new(u.index(), v.index())
+            })
+            .collect::<Vec<_>>();
         let m = segments.len();
-        for p in 0..m {
-            let segment_p = &segments[p];
-            for q in (p + 1)..m {
-                let segment_q = &segments[q];
+        let stride = (1 << options.cycles) - 1;
+        let mid_points = vec![(0., 0.); m * stride];
+        let next = mid_points.clone();
+
+        // Every compatible pair is listed under both of its segments, so each
+        // segment gathers its own forces without writing to any other.
+        let (pair_offsets, pairs) = {
+            let edge_pairs = edge_pairs(&points, &segments, options.minimum_edge_compatibility);
+            let mut pair_offsets = vec![0; m + 1];
+            for pair in &edge_pairs {
+                pair_offsets[pair.p + 1] += 1;
+                pair_offsets[pair.q + 1] += 1;
+            }
+            for p in 0..m {
+                pair_offsets[p + 1] += pair_offsets[p];
+            }
+            let mut offset = pair_offsets.clone();
+            let mut pairs = vec![EdgePair::new(0, 0, 0., 0.); pair_offsets[m]];
+            for pair in &edge_pairs {
+                pairs[offset[pair.p]] = *pair;
+                offset[pair.p] += 1;
+                pairs[offset[pair.q]] =
+                    EdgePair::new(pair.q, pair.p, pair.compatibility, pair.theta);
+                offset[pair.q] += 1;
+            }
+            (pair_offsets, pairs)
+        };
+
+        EdgeBundling {
+            points,
+            segments,
+            pair_offsets,
+            pairs,
+            stride,
+            num_p: 0,
+            mid_points,
+            next,
+            cycles: options.cycles,
+            cycle: 0,
+            remaining: 0,
+            num_iter: options.i0,
+            alpha: options.s0,
+            s_step: options.s_step,
+            i_step: options.i_step,
+        }
+    }
+
+    /// Number of cycles started so far.
+    pub fn cycle(&self) -> usize {
+        self.cycle
+    }
+
+    pub fn is_finished(&self) -> bool {
+        self.cycle == self.cycles && self.remaining == 0
+    }
+
+    /// Runs up to `iterations` iterations, starting new cycles as needed.
+    /// Returns `false` once bundling is finished.
+    pub fn run_iterations(&mut self, iterations: usize) -> bool {
+        for _ in 0..iterations {
+            while self.remaining == 0 {
+                if !self.start_cycle() {
+                    return false;
+                }
+            }
+            self.iterate();
+        }
+        !self.is_finished()
+    }
+
+    /// Runs the rest of the current cycle, or the next one if the current
+    /// one is complete. Returns `false` once bundling is finished.
+    pub fn run_cycle(&mut self) -> bool {
+        if self.remaining == 0 && !self.start_cycle() {
+            return false;
+        }
+        while self.remaining > 0 {
+            self.iterate();
+        }
+        !self.is_finished()
+    }
+
+    pub fn run(&mut self) {
+        while self.run_cycle() {}
+    }
+
+    /// Offsets of the current polylines in `polyline_points`, indexed by edge
+    /// index.
+    pub fn polyline_offsets(&self) -> Vec<usize> {
+        (0..=self.segments.len())
+            .map(|p| p * (self.num_p + 2))
+            .collect()
+    }
+
+    /// Current polylines, end points included, in edge index order.
+    pub fn polyline_points(&self) -> Vec<(f32, f32)> {
+        let mut polyline_points = Vec::with_capacity(self.segments.len() * (self.num_p + 2));
+        for (p, segment) in self.segments.iter().enumerate() {
+            let p0 = self.points[segment.source];
+            polyline_points.push((p0.x, p0.y));
+            polyline_points
+                .extend_from_slice(&self.mid_points[p * self.stride..p * self.stride + self.num_p]);
+            let p1 = self.points[segment.target];
+            polyline_points.push((p1.x, p1.y));
+        }
+        polyline_points
+    }
+
+    /// Same as `polyline_points`, flattened to `[x0, y0, x1, y1, ...]`.
+    pub fn polyline_coordinates(&self) -> Vec<f32> {
+        let mut coordinates = Vec::with_capacity(2 * self.segments.len() * (self.num_p + 2));
+        for (p, segment) in self.segments.iter().enumerate() {
+            let p0 = self.points[segment.source];
+            coordinates.push(p0.x);
+            coordinates.push(p0.y);
+            for &(x, y) in &self.mid_points[p * self.stride..p * self.stride + self.num_p] {
+                coordinates.push(x);
+                coordinates.push(y);
+            }
+            let p1 = self.points[segment.target];
+            coordinates.push(p1.x);
+            coordinates.push(p1.y);
+        }
+        coordinates
+    }
+
+    /// Subdivides every segment for the next cycle. Returns `false` if all
+    /// cycles have run.
+    fn start_cycle(&mut self) -> bool {
+        if self.cycle == self.cycles {
+            return false;
+        }
+        if self.cycle > 0 {
+            self.alpha *= self.s_step;
+            self.num_iter = (self.num_iter as f32 * self.i_step) as usize;
+        }
+        let dp = 1 << self.cycle;
+        let points = &self.points;
+        let stride = self.stride;
+        for (segment, segment_points) in
+            self.segments.iter().zip(self.mid_points.chunks_mut(stride))
+        {
+            for j in (0..dp).rev() {
+                let (p0x, p0y) = if j == 0 {
+                    (points[segment.source].x, points[segment.source].y)
+                } else {
+                    segment_points[j - 1]
+                };
+                let (p1x, p1y) = if j == dp - 1 {
+                    (points[segment.target].x, points[segment.target].y)
+                } else {
+                    segment_points[j]
+                };
+                if j < dp - 1 {
+                    segment_points[j * 2 + 1] = segment_points[j];
+                }
+                segment_points[j * 2] = ((p0x + p1x) / 2., (p0y + p1y) / 2.);
+            }
+        }
+        self.num_p = dp * 2 - 1;
+        self.cycle += 1;
+        self.remaining = self.num_iter;
+        true
+    }
+
+    fn iterate(&mut self) {
+        let EdgeBundling {
+            points,
+            segments,
+            pair_offsets,
+            pairs,
+            stride,
+            num_p,
+            mid_points,
+            next,
+            alpha,
+            ..
+        } = self;
+        let (stride, num_p, alpha) = (*stride, *num_p, *alpha);
+        let mid_points_ref = &*mid_points;
+        // The forces on segment p are accumulated in its slice of `next`,
+        // which is then overwritten with the moved points.
+        let update = |(p, segment_next): (usize, &mut [(f32, f32)])| {
+            let segment = &segments[p];
+            let segment_points = &mid_points_ref[p * stride..(p + 1) * stride];
+            for force in segment_next.iter_mut() {
+                *force = (0., 0.);
+            }
+            apply_spring_force(segment_next, segment_points, segment, points, num_p, 0.1);
+            apply_electrostatic_force(
+                segment_next,
+                mid_points_ref,
+                stride,
+                &pairs[pair_offsets[p]..pair_offsets[p + 1]],
+                num_p,
+            );
+            for (point, &(x, y)) in segment_next.iter_mut().zip(segment_points).take(num_p) {
+                *point = (x + alpha * point.0, y + alpha * point.1);
+            }
+        };
+        #[cfg(feature = "parallel")]
+        next.par_chunks_mut(stride).enumerate().for_each(update);
+        #[cfg(not(feature = "parallel"))]
+        next.chunks_mut(stride).enumerate().for_each(update);
+        std::mem::swap(mid_points, next);
+        self.remaining -= 1;
+    }
+}
+
+#[test]
+fn test_edge_bundling_steps() {
+    let mut graph = Graph::new();
+    let nodes = (0..20).map(|_| graph.add_node(())).collect::<Vec<_>>();
+    for i in 0..10 {
+        graph.add_edge(nodes[i], nodes[10 + (i * 3) % 10], ());
+    }
+    let points = (0..20)
+        .map(|i| ((i % 10) as f32 * 10., if i < 10 { 0. } else { 100. }))
+        .collect::<Vec<_>>();
+    let options = EdgeBundlingOptions::new();
+    let (expected_offsets, expected_points) = fdeb_flat(&graph, &points, &options);
+
+    let mut bundling = EdgeBundling::new(&graph, &points, &options);
+    assert_eq!(bundling.polyline_points().len(), 2 * graph.edge_count());
+    assert!(bundling.run_iterations(7));
+    assert_eq!(bundling.cycle(), 1);
+    assert_eq!(bundling.polyline_offsets()[1], 3);
+    assert!(bundling.run_cycle());
+    assert_eq!(bundling.cycle(), 1);
+    while bundling.run_iterations(25) {}
+    assert!(bundling.is_finished());
+    assert!(!bundling.run_cycle());
+    assert_eq!(bundling.polyline_offsets(), expected_offsets);
+    assert_eq!(bundling.polyline_points(), expected_points);
+    let coordinates = bundling.polyline_coordinates();
+    assert_eq!(coordinates.len(), 2 * expected_points.len());
+    for (xy, &(x, y)) in coordinates.chunks(2).zip(&expected_points) {
+        assert_eq!((xy[0], xy[1]), (x, y));
+    }
+}
+
+#[test]
+fn test_edge_pairs() {
+    let n = 60;
+    let points = (0..n)
+        .map(|i| {
+            let t = i as f32 * 2.399;
+            let r = 10. * (i as f32).sqrt();
+            Point::new(r * t.cos(), r * t.sin())
+        })
+        .collect::<Vec<_>>();
+    let mut segments = Vec::new();
+    for i in 0..n {
+        for &j in &[7, 13, 29] {
+            segments.push(LineSegment::new(i, (i * j + 3) % n));
+        }
+    }
+    for &t in &[0.05, 0.3, 0.6, 0.9] {
+        let mut expected = Vec::new();
+        for p in 0..segments.len() {
+            for q in (p + 1)..segments.len() {
                 let c_e = compatibility(
-                    points[segment_p.source],
-                    points[segment_p.target],
-                    points[segment_q.source],
-                    points[segment_q.target],
+                    points[segments[p].source],
+                    points[segments[p].target],
+                    points[segments[q].source],
+                    points[segments[q].target],
                 );
-                if c_e >= *minimum_edge_compatibility {
-                    let theta = angle(
-                        points[segment_p.source],
-                        points[segment_p.target],
-                        points[segment_q.source],
-                        points[segment_q.target],
-                    );
-                    edge_pairs.push(EdgePair::new(p, q, c_e, theta));
+                if c_e >= t {
+                    expected.push((p, q));
                 }
             }
         }
-        edge_pairs
-    };
+        let actual = edge_pairs(&points, &segments, t)
+            .iter()
+            .map(|pair| (pair.p, pair.q))
+            .collect::<Vec<_>>();
+        assert_eq!(actual, expected);
+    }
+}
 
-    for cycle in 0..*cycles {
-        let dp = (2 as i32).pow(cycle as u32);
+/// The pairwise scatter implementation that `EdgeBundling` replaced, kept to
+/// check that the per-segment gather adds the same terms in the same order.
+#[cfg(test)]
+fn fdeb_reference(
+    points: &[(f32, f32)],
+    edges: &[(usize, usize)],
+    options: &EdgeBundlingOptions,
+) -> Vec<Vec<(f32, f32)>> {
+    struct Segment {
+        source: usize,
+        target: usize,
+        point_indices: Vec<usize>,
+    }
+
+    let points = points
+        .iter()
+        .map(|&(x, y)| Point::new(x, y))
+        .collect::<Vec<_>>();
+    let mut segments = edges
+        .iter()
+        .map(|&(source, target)| Segment {
+            source,
+            target,
+            point_indices: vec![],
+        })
+        .collect::<Vec<_>>();
+    let mut mid_points = Vec::<Point>::new();
+    let mut num_iter = options.i0;
+    let mut alpha = options.s0;
+
+    let mut edge_pairs = Vec::new();
+    for p in 0..segments.len() {
+        for q in (p + 1)..segments.len() {
+            let (sp, sq) = (&segments[p], &segments[q]);
+            let (p1, p2) = (points[sp.source], points[sp.target]);
+            let (q1, q2) = (points[sq.source], points[sq.target]);
+            let c_e = compatibility(p1, p2, q1, q2);
+            if c_e >= options.minimum_edge_compatibility {
+                edge_pairs.push(EdgePair::new(p, q, c_e, angle(p1, p2, q1, q2)));
+            }
+        }
+    }
+
+    for cycle in 0..options.cycles {
+        let dp = 1 << cycle;
         for segment in segments.iter_mut() {
             for j in 0..dp {
                 let p0 = if j == 0 {
                     points[segment.source]
                 } else {
-                    mid_points[segment.point_indices[(j * 2 - 1) as usize]]
+                    mid_points[segment.point_indices[j * 2 - 1]]
                 };
                 let p1 = if j == dp - 1 {
                     points[segment.target]
                 } else {
-                    mid_points[segment.point_indices[(j * 2) as usize]]
+                    mid_points[segment.point_indices[j * 2]]
                 };
                 mid_points.push(Point::new((p0.x + p1.x) / 2., (p0.y + p1.y) / 2.));
-                segment
-                    .point_indices
-                    .insert((j * 2) as usize, mid_points.len() - 1);
+                segment.point_indices.insert(j * 2, mid_points.len() - 1);
             }
         }
 
-        let num_p = (dp * 2 - 1) as usize;
+        let num_p = dp * 2 - 1;
         for _ in 0..num_iter {
             for point in mid_points.iter_mut() {
                 point.vx = 0.;
                 point.vy = 0.;
             }
-
-            apply_spring_force(&mut mid_points, &segments, &points, num_p, 0.1);
-            apply_electrostatic_force(&mut mid_points, &segments, &edge_pairs, num_p);
-
+            for segment in &segments {
+                let (s, t) = (points[segment.source], points[segment.target]);
+                let kp = 0.1 / (num_p as f32) / distance(s.x, s.y, t.x, t.y);
+                for i in 0..num_p {
+                    let p0 = if i == 0 {
+                        s
+                    } else {
+                        mid_points[segment.point_indices[i - 1]]
+                    };
+                    let p2 = if i == num_p - 1 {
+                        t
+                    } else {
+                        mid_points[segment.point_indices[i + 1]]
+                    };
+                    let p1 = &mut mid_points[segment.point_indices[i]];
+                    p1.vx += kp * (p0.x - p1.x + p2.x - p1.x);
+                    p1.vy += kp * (p0.y - p1.y + p2.y - p1.y);
+                }
+            }
+            for pair in &edge_pairs {
+                let (segment_p, segment_q) = (&segments[pair.p], &segments[pair.q]);
+                for i in 0..num_p {
+                    let j = if pair.theta < f32::consts::PI / 2.0 {
+                        i
+                    } else {
+                        num_p - i - 1
+                    };
+                    let (pi, qj) = (segment_p.point_indices[i], segment_q.point_indices[j]);
+                    let dx = mid_points[qj].x - mid_points[pi].x;
+                    let dy = mid_points[qj].y - mid_points[pi].y;
+                    if dx.abs() > 1e-6 || dy.abs() > 1e-6 {
+                        let w = pair.compatibility / (dx * dx + dy * dy).sqrt();
+                        mid_points[qj].vx -= dx * w;
+                        mid_points[qj].vy -= dy * w;
+                        mid_points[pi].vx += dx * w;
+                        mid_points[pi].vy += dy * w;
+                    }
+                }
+            }
             for point in mid_points.iter_mut() {
                 point.x += alpha * point.vx;
                 point.y += alpha * point.vy;
             }
         }
 
-        alpha *= s_step;
-        num_iter = (num_iter as f32 * i_step) as usize;
+        alpha *= options.s_step;
+        num_iter = (num_iter as f32 * options.i_step) as usize;
     }
 
     segments
         .iter()
-        .zip(graph.edge_indices())
-        .map(|(segment, e)| {
-            let mut ps = vec![];
+        .map(|segment| {
+            let mut polyline = vec![];
             let p0 = points[segment.source];
-            ps.push((p0.x, p0.y));
+            polyline.push((p0.x, p0.y));
             for &i in &segment.point_indices {
-                let p = mid_points[i];
-                ps.push((p.x, p.y));
+                polyline.push((mid_points[i].x, mid_points[i].y));
             }
             let p1 = points[segment.target];
-            ps.push((p1.x, p1.y));
-            (e, ps)
+            polyline.push((p1.x, p1.y));
+            polyline
         })
         .collect()
 }
+
+#[test]
+fn test_fdeb_matches_reference() {
+    let n = 40;
+    let points = (0..n)
+        .map(|i| {
+            let t = i as f32 * 2.399;
+            let r = 10. * (i as f32).sqrt();
+            (r * t.cos(), r * t.sin())
+        })
+        .collect::<Vec<_>>();
+    let mut graph = Graph::new();
+    let nodes = (0..n).map(|_| graph.add_node(())).collect::<Vec<_>>();
+    let mut edges = Vec::new();
+    for i in 0..n {
+        for &j in &[7, 13] {
+            let (u, v) = (i, (i * j + 3) % n);
+            if u != v {
+                graph.add_edge(nodes[u], nodes[v], ());
+                edges.push((u, v));
+            }
+        }
+    }
+    let mut options = EdgeBundlingOptions::new();
+    for &t in &[0.3, 0.6] {
+        options.minimum_edge_compatibility = t;
+        let expected = fdeb_reference(&points, &edges, &options);
+        assert_eq!(fdeb_slice(&graph, &points, &options), expected);
+    }
+}
@@ -29,7 +29,7 @@ fn accumulate(tree: &mut Quadtree<Body>, node_id: NodeId) {
     let mut sum_x = 0.;
     let mut sum_y = 0.;
     for &(ref e, _) in tree.elements(node_id).iter() {
-        match **e {
+        match *e {
             Element::Leaf { x, y, n, value } => {
                 let strength = value * n as f32;
                 let weight = strength.abs();
@@ -65,7 +65,7 @@ fn apply_many_body(
     theta2: f32,
 ) {
     for &(ref e, _) in tree.elements(node_id).iter() {
-        match **e {
+        match *e {
             Element::Node { node_id } => {
                 let data = tree.data(node_id);
                 let rect = tree.rect(node_id);
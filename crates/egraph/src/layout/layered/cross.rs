@@ -1,26 +1,66 @@
+use super::crossing_reduction::LayerAdjacency;
 use crate::{Graph, NodeIndex};
+use std::collections::HashMap;
 
-pub fn cross<D, G: Graph<D>>(graph: &G, h1: &Vec<NodeIndex>, h2: &Vec<NodeIndex>) -> u32 {
-    let mut result = 0;
-    let n = h1.len();
-    let m = h2.len();
-    for j2 in 0..m - 1 {
-        let mut count = 0;
-        for i2 in (1..n).rev() {
-            let i1 = i2 - 1;
-            if graph.has_edge(h1[i2], h2[j2]) {
-                count += 1
-            }
-            if count > 0 {
-                for j1 in j2 + 1..m {
-                    if graph.has_edge(h1[i1], h2[j1]) {
-                        result += count
-                    }
-                }
+/// Counts the inversions of `sequence`, whose values are below `size`, with
+/// the accumulator tree of Barth, Jünger and Mutzel, "Simple and Efficient
+/// Bilayer Cross Counting". `tree` is scratch space.
+fn count_inversions(sequence: &[usize], size: usize, tree: &mut Vec<u64>) -> u64 {
+    let mut first = 1;
+    while first < size {
+        first *= 2;
+    }
+    tree.clear();
+    tree.resize(2 * first - 1, 0);
+    first -= 1;
+    let mut crossings = 0;
+    for &k in sequence {
+        let mut index = k + first;
+        tree[index] += 1;
+        while index > 0 {
+            if index % 2 == 1 {
+                crossings += tree[index + 1];
             }
+            index = (index - 1) / 2;
+            tree[index] += 1;
         }
     }
-    result
+    crossings
+}
+
+/// Counts the crossings between the edges from `h1` to `h2` in
+/// O(|E| log |h2|), where `position` gives the index of each node of `h2` in
+/// its layer.
+pub fn count_crossings(
+    adjacency: &LayerAdjacency,
+    h1: &[NodeIndex],
+    h2_len: usize,
+    position: &[usize],
+    sequence: &mut Vec<usize>,
+    tree: &mut Vec<u64>,
+) -> u64 {
+    sequence.clear();
+    for &u in h1 {
+        let start = sequence.len();
+        sequence.extend(adjacency.lower(u).iter().map(|&v| position[v]));
+        sequence[start..].sort_unstable();
+    }
+    count_inversions(sequence, h2_len, tree)
+}
+
+pub fn cross<D, G: Graph<D>>(graph: &G, h1: &Vec<NodeIndex>, h2: &Vec<NodeIndex>) -> u32 {
+    let position = h2
+        .iter()
+        .enumerate()
+        .map(|(j, &v)| (v, j))
+        .collect::<HashMap<_, _>>();
+    let mut sequence = vec![];
+    for &u in h1 {
+        let start = sequence.len();
+        sequence.extend(graph.out_nodes(u).filter_map(|v| position.get(&v).cloned()));
+        sequence[start..].sort_unstable();
+    }
+    count_inversions(&sequence, h2.len(), &mut vec![]) as u32
 }
 
 #[cfg(test)]
@@ -50,4 +90,29 @@ mod tests {
         let graph = PetgraphWrapper::new(graph);
         assert_eq!(cross(&graph, &h1, &h2), 5);
     }
+
+    #[test]
+    fn test_count_inversions() {
+        let n = 40;
+        let m = 30;
+        let mut edges = vec![];
+        for i in 0..n {
+            for k in 0..3 {
+                edges.push((i, (i * 7 + k * 11 + 3) % m));
+            }
+        }
+        edges.sort();
+        let mut expected = 0;
+        for a in 0..edges.len() {
+            for b in a + 1..edges.len() {
+                let (i1, j1) = edges[a];
+                let (i2, j2) = edges[b];
+                if (i1 < i2 && j1 > j2) || (i1 > i2 && j1 < j2) {
+                    expected += 1;
+                }
+            }
+        }
+        let sequence = edges.iter().map(|&(_, j)| j).collect::<Vec<_>>();
+        assert_eq!(count_inversions(&sequence, m, &mut vec![]), expected);
+    }
 }
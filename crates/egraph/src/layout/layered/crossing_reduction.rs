@@ -1,33 +1,235 @@
+use super::cross::count_crossings;
 use crate::{Graph, NodeIndex};
 use std::collections::HashMap;
 
-fn bary_center<D, G: Graph<D>>(
-    graph: &G,
-    h1: &Vec<NodeIndex>,
-    h2: &Vec<NodeIndex>,
-) -> HashMap<NodeIndex, f64> {
-    let mut result = HashMap::new();
-    for &v in h2 {
-        let mut sum = 0;
-        let mut count = 0;
-        for (i, &u) in h1.iter().enumerate() {
-            if graph.has_edge(u, v) {
-                sum += i;
-                count += 1;
+/// Neighbors of each node in the layers just above and below it, in CSR
+/// layout indexed by node index. Built once per layout and shared by every
+/// sweep of `reduce_crossings`.
+pub struct LayerAdjacency {
+    upper_offsets: Vec<usize>,
+    upper: Vec<NodeIndex>,
+    lower_offsets: Vec<usize>,
+    lower: Vec<NodeIndex>,
+}
+
+impl LayerAdjacency {
+    /// `edges` run from a layer to the next one.
+    pub fn from_edges(node_count: usize, edges: &[(NodeIndex, NodeIndex)]) -> LayerAdjacency {
+        let mut upper_offsets = vec![0; node_count + 1];
+        let mut lower_offsets = vec![0; node_count + 1];
+        for &(u, v) in edges {
+            lower_offsets[u + 1] += 1;
+            upper_offsets[v + 1] += 1;
+        }
+        for u in 0..node_count {
+            upper_offsets[u + 1] += upper_offsets[u];
+            lower_offsets[u + 1] += lower_offsets[u];
+        }
+        let mut upper_next = upper_offsets.clone();
+        let mut lower_next = lower_offsets.clone();
+        let mut upper = vec![0; edges.len()];
+        let mut lower = vec![0; edges.len()];
+        for &(u, v) in edges {
+            lower[lower_next[u]] = v;
+            lower_next[u] += 1;
+            upper[upper_next[v]] = u;
+            upper_next[v] += 1;
+        }
+        LayerAdjacency {
+            upper_offsets,
+            upper,
+            lower_offsets,
+            lower,
+        }
+    }
+
+    pub fn new<D, G: Graph<D>>(graph: &G) -> LayerAdjacency {
+        let mut edges = vec![];
+        let mut node_count = 0;
+        for u in graph.nodes() {
+            node_count = node_count.max(u + 1);
+            for v in graph.out_nodes(u) {
+                node_count = node_count.max(v + 1);
+                edges.push((u, v));
             }
         }
-        result.insert(v.clone(), sum as f64 / count as f64);
+        LayerAdjacency::from_edges(node_count, &edges)
+    }
+
+    pub fn upper(&self, u: NodeIndex) -> &[NodeIndex] {
+        &self.upper[self.upper_offsets[u]..self.upper_offsets[u + 1]]
+    }
+
+    pub fn lower(&self, u: NodeIndex) -> &[NodeIndex] {
+        &self.lower[self.lower_offsets[u]..self.lower_offsets[u + 1]]
+    }
+}
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum Heuristic {
+    Barycenter,
+    Median,
+}
+
+/// Reorders `layer` by the barycenter or median of the positions of its
+/// neighbors in the fixed adjacent layer. Nodes without neighbors keep their
+/// position.
+fn order_layer<'a, F: Fn(NodeIndex) -> &'a [NodeIndex]>(
+    layer: &mut Vec<NodeIndex>,
+    neighbors: F,
+    heuristic: Heuristic,
+    position: &mut [usize],
+    buffer: &mut Vec<usize>,
+) {
+    let mut values = layer
+        .iter()
+        .enumerate()
+        .map(|(j, &v)| {
+            buffer.clear();
+            buffer.extend(neighbors(v).iter().map(|&w| position[w]));
+            let value = if buffer.is_empty() {
+                j as f64
+            } else {
+                match heuristic {
+                    Heuristic::Barycenter => {
+                        buffer.iter().sum::<usize>() as f64 / buffer.len() as f64
+                    }
+                    Heuristic::Median => {
+                        buffer.sort_unstable();
+                        let k = buffer.len();
+                        if k % 2 == 1 {
+                            buffer[k / 2] as f64
+                        } else {
+                            (buffer[k / 2 - 1] + buffer[k / 2]) as f64 / 2.
+                        }
+                    }
+                }
+            };
+            (value, v)
+        })
+        .collect::<Vec<_>>();
+    values.sort_by(|a, b| a.0.partial_cmp(&b.0).unwrap());
+    for (j, (_, v)) in values.into_iter().enumerate() {
+        layer[j] = v;
+        position[v] = j;
     }
-    result
+}
+
+/// Total crossings of `layers`, where `position` gives the index of each node
+/// in its layer.
+pub fn total_crossings(
+    adjacency: &LayerAdjacency,
+    layers: &Vec<Vec<NodeIndex>>,
+    position: &[usize],
+) -> u64 {
+    let mut sequence = vec![];
+    let mut tree = vec![];
+    (1..layers.len())
+        .map(|i| {
+            count_crossings(
+                adjacency,
+                &layers[i - 1],
+                layers[i].len(),
+                position,
+                &mut sequence,
+                &mut tree,
+            )
+        })
+        .sum()
+}
+
+/// Layer-by-layer sweep crossing reduction over a proper layering: sweeps
+/// alternate downward and upward, each ordering a layer by its neighbors in
+/// the previous one, until a sweep no longer reduces the crossing count or
+/// `max_sweeps` is reached. `layers` ends in the best ordering found, and its
+/// crossing count is returned.
+pub fn reduce_crossings(
+    adjacency: &LayerAdjacency,
+    layers: &mut Vec<Vec<NodeIndex>>,
+    heuristic: Heuristic,
+    max_sweeps: usize,
+) -> u64 {
+    let node_count = layers
+        .iter()
+        .flat_map(|layer| layer.iter())
+        .map(|&u| u + 1)
+        .max()
+        .unwrap_or(0);
+    let mut position = vec![0; node_count];
+    for layer in layers.iter() {
+        for (j, &u) in layer.iter().enumerate() {
+            position[u] = j;
+        }
+    }
+    let mut best = total_crossings(adjacency, layers, &position);
+    let mut best_layers = layers.clone();
+    let mut buffer = vec![];
+    for sweep in 0..max_sweeps {
+        if best == 0 {
+            break;
+        }
+        if sweep % 2 == 0 {
+            for i in 1..layers.len() {
+                order_layer(
+                    &mut layers[i],
+                    |v| adjacency.upper(v),
+                    heuristic,
+                    &mut position,
+                    &mut buffer,
+                );
+            }
+        } else {
+            for i in (0..layers.len().saturating_sub(1)).rev() {
+                order_layer(
+                    &mut layers[i],
+                    |v| adjacency.lower(v),
+                    heuristic,
+                    &mut position,
+                    &mut buffer,
+                );
+            }
+        }
+        let crossings = total_crossings(adjacency, layers, &position);
+        if crossings >= best {
+            break;
+        }
+        best = crossings;
+        best_layers.clone_from(layers);
+    }
+    *layers = best_layers;
+    best
 }
 
 pub fn crossing_reduction<D, G: Graph<D>>(graph: &G, h1: &Vec<NodeIndex>, h2: &mut Vec<NodeIndex>) {
-    let values = bary_center(graph, h1, h2);
-    h2.sort_by(|u, v| {
-        let cu = values.get(u).unwrap();
-        let cv = values.get(v).unwrap();
-        cu.partial_cmp(cv).unwrap()
-    });
+    let mut sums = h2
+        .iter()
+        .map(|&v| (v, (0, 0)))
+        .collect::<HashMap<NodeIndex, (usize, usize)>>();
+    for (i, &u) in h1.iter().enumerate() {
+        for v in graph.out_nodes(u) {
+            if let Some((sum, count)) = sums.get_mut(&v) {
+                *sum += i;
+                *count += 1;
+            }
+        }
+    }
+    let mut values = h2
+        .iter()
+        .enumerate()
+        .map(|(j, &v)| {
+            let (sum, count) = sums[&v];
+            let value = if count == 0 {
+                j as f64
+            } else {
+                sum as f64 / count as f64
+            };
+            (value, v)
+        })
+        .collect::<Vec<_>>();
+    values.sort_by(|a, b| a.0.partial_cmp(&b.0).unwrap());
+    for (j, (_, v)) in values.into_iter().enumerate() {
+        h2[j] = v;
+    }
 }
 
 #[cfg(test)]
@@ -58,4 +260,29 @@ mod tests {
         crossing_reduction(&graph, &h1, &mut h2);
         assert_eq!(h2, vec![v2.index(), v3.index(), v1.index()]);
     }
+
+    #[test]
+    fn test_reduce_crossings() {
+        // Three layers of a forest of paths, shuffled so that every pair of
+        // paths crosses; an ordering without crossings exists.
+        let k = 20;
+        let mut edges = vec![];
+        for p in 0..k {
+            edges.push((p, k + p));
+            edges.push((k + p, 2 * k + p));
+        }
+        let adjacency = LayerAdjacency::from_edges(3 * k, &edges);
+        for &heuristic in &[Heuristic::Barycenter, Heuristic::Median] {
+            let mut layers = vec![
+                (0..k).collect::<Vec<_>>(),
+                (k..2 * k).rev().collect::<Vec<_>>(),
+                (2 * k..3 * k).collect::<Vec<_>>(),
+            ];
+            let crossings = reduce_crossings(&adjacency, &mut layers, heuristic, 10);
+            assert_eq!(crossings, 0);
+            for layer in &layers {
+                assert_eq!(layer.len(), k);
+            }
+        }
+    }
 }
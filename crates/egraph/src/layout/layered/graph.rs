@@ -1,4 +1,4 @@
-use petgraph::graph::{EdgeIndex, IndexType, NodeIndex};
+use petgraph::graph::{EdgeIndex, IndexType};
 
 #[derive(Clone)]
 pub struct Node<Ix: IndexType> {
@@ -12,10 +12,6 @@ pub struct Node<Ix: IndexType> {
     pub y: i32,
     pub dummy: bool,
     pub edge_index: Option<EdgeIndex<Ix>>,
-    pub align: Option<NodeIndex<Ix>>,
-    pub root: Option<NodeIndex<Ix>>,
-    pub sink: Option<NodeIndex<Ix>>,
-    pub shift: i32,
 }
 
 impl<Ix: IndexType> Node<Ix> {
@@ -31,10 +27,6 @@ impl<Ix: IndexType> Node<Ix> {
             y: 0,
             dummy: false,
             edge_index: None,
-            align: None,
-            root: None,
-            sink: None,
-            shift: i32::min_value(),
         }
     }
 
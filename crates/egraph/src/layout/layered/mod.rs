@@ -3,7 +3,6 @@ pub mod crossing_reduction;
 // pub mod cycle_removal;
 // pub mod graph;
 // pub mod normalize;
-pub mod position_assignment;
 pub mod ranking;
 // pub mod sugiyama_layout;
 //
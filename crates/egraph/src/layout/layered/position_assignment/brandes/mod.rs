@@ -1,5 +0,0 @@
-// pub mod brandes;
-// pub mod horizontal_compaction;
-// pub mod mark_conflicts;
-// pub mod median;
-// pub mod vertical_alignment;
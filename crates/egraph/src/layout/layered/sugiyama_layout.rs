@@ -1,11 +1,10 @@
-use super::crossing_reduction::crossing_reduction;
+use super::crossing_reduction::{reduce_crossings, Heuristic, LayerAdjacency};
 use super::graph::{Edge, Node};
 use super::normalize::normalize;
 use super::position_assignment::brandes::brandes;
 use super::ranking::{LongetPathRanking, RankingModule};
 use crate::algorithm::cycle::remove_cycle;
-use petgraph::graph::IndexType;
-use petgraph::visit::GetAdjacencyMatrix;
+use petgraph::graph::{IndexType, NodeIndex};
 use petgraph::{Directed, Graph};
 use std::cmp;
 
@@ -59,14 +58,18 @@ fn build_result<N, E, Ix: IndexType>(
     Layout { nodes, edges }
 }
 
+const MAX_SWEEPS: usize = 24;
+
 pub struct SugiyamaLayout<Ix: IndexType> {
     pub ranking_module: Box<RankingModule<Node<Ix>, Edge, Ix>>,
+    pub crossing_heuristic: Heuristic,
 }
 
 impl<Ix: IndexType> SugiyamaLayout<Ix> {
     pub fn new() -> SugiyamaLayout<Ix> {
         SugiyamaLayout {
             ranking_module: Box::new(LongetPathRanking::new()),
+            crossing_heuristic: Heuristic::Barycenter,
         }
     }
 
@@ -83,12 +86,23 @@ impl<Ix: IndexType> SugiyamaLayout<Ix> {
             let layer = layers_map.get(&u).unwrap();
             layers[*layer].push(u);
         }
-        let matrix = graph.adjacency_matrix();
-        for i in 1..height {
-            let h1 = layers.get_mut(i - 1).unwrap().clone();
-            let mut h2 = layers.get_mut(i).unwrap();
-            crossing_reduction(&graph, &matrix, &h1, &mut h2);
-        }
+        let edges = graph
+            .edge_indices()
+            .map(|e| {
+                let (u, v) = graph.edge_endpoints(e).unwrap();
+                (u.index(), v.index())
+            })
+            .collect::<Vec<_>>();
+        let adjacency = LayerAdjacency::from_edges(graph.node_count(), &edges);
+        let mut orders = layers
+            .iter()
+            .map(|layer| layer.iter().map(|u| u.index()).collect())
+            .collect();
+        reduce_crossings(&adjacency, &mut orders, self.crossing_heuristic, MAX_SWEEPS);
+        let layers = orders
+            .into_iter()
+            .map(|layer| layer.into_iter().map(NodeIndex::new).collect())
+            .collect::<Vec<Vec<_>>>();
         for (i, layer) in layers.iter().enumerate() {
             for (j, &u) in layer.iter().enumerate() {
                 graph[u].width = 100;
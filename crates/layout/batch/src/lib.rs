@@ -0,0 +1,289 @@
+use petgraph::graph::{NodeIndex, UnGraph};
+use petgraph_layout_force_simulation::force::{CenterForce, LinkForce, ManyBodyForceAllPair};
+use petgraph_layout_force_simulation::{initial_position, Simulation};
+use petgraph_layout_kamada_kawai::kamada_kawai_slice;
+use petgraph_layout_stress_majorization::stress_majorization_slice;
+#[cfg(feature = "parallel")]
+use rayon::prelude::*;
+
+/// Many small undirected graphs packed into shared arrays.
+///
+/// Graph `g` owns the nodes `graph_offsets[g]..graph_offsets[g + 1]` of the
+/// batch. The neighbors of node `u` of the batch are
+/// `neighbors[offsets[u]..offsets[u + 1]]`, as indices local to its graph;
+/// each edge is listed once, under either of its end points.
+pub struct GraphBatch {
+    graph_offsets: Vec<usize>,
+    offsets: Vec<usize>,
+    neighbors: Vec<usize>,
+}
+
+impl GraphBatch {
+    pub fn new() -> GraphBatch {
+        GraphBatch {
+            graph_offsets: vec![0],
+            offsets: vec![0],
+            neighbors: vec![],
+        }
+    }
+
+    /// Checks the arrays described on `GraphBatch` and packs them.
+    pub fn from_csr(
+        graph_offsets: Vec<usize>,
+        offsets: Vec<usize>,
+        neighbors: Vec<usize>,
+    ) -> Result<GraphBatch, &'static str> {
+        if graph_offsets.first() != Some(&0) || graph_offsets.windows(2).any(|w| w[0] > w[1]) {
+            return Err("graph offsets must start at 0 and be non-decreasing");
+        }
+        if offsets.len() != graph_offsets[graph_offsets.len() - 1] + 1 {
+            return Err("offsets must have length nodeCount + 1");
+        }
+        if offsets[0] != 0
+            || offsets.windows(2).any(|w| w[0] > w[1])
+            || offsets[offsets.len() - 1] != neighbors.len()
+        {
+            return Err("offsets must start at 0, be non-decreasing and end at neighbors.length");
+        }
+        for w in graph_offsets.windows(2) {
+            let n = w[1] - w[0];
+            if neighbors[offsets[w[0]]..offsets[w[1]]]
+                .iter()
+                .any(|&v| v >= n)
+            {
+                return Err("neighbor index out of range of its graph");
+            }
+        }
+        Ok(GraphBatch {
+            graph_offsets,
+            offsets,
+            neighbors,
+        })
+    }
+
+    /// Appends a graph of `node_count` nodes with the given edges between
+    /// local node indices, and returns its index in the batch.
+    pub fn add_graph(&mut self, node_count: usize, edges: &[(usize, usize)]) -> usize {
+        let start = self.graph_offsets[self.graph_offsets.len() - 1];
+        let mut degree = vec![0; node_count];
+        for &(u, v) in edges {
+            assert!(u < node_count && v < node_count);
+            degree[u] += 1;
+        }
+        let mut next = Vec::with_capacity(node_count);
+        for u in 0..node_count {
+            let offset = self.offsets[start + u];
+            next.push(offset);
+            self.offsets.push(offset + degree[u]);
+        }
+        self.neighbors.resize(self.neighbors.len() + edges.len(), 0);
+        for &(u, v) in edges {
+            self.neighbors[next[u]] = v;
+            next[u] += 1;
+        }
+        self.graph_offsets.push(start + node_count);
+        self.graph_offsets.len() - 2
+    }
+
+    pub fn graph_count(&self) -> usize {
+        self.graph_offsets.len() - 1
+    }
+
+    /// Total number of nodes of all graphs.
+    pub fn node_count(&self) -> usize {
+        self.offsets.len() - 1
+    }
+
+    /// Range of the nodes of graph `g` in the batch.
+    pub fn nodes(&self, g: usize) -> std::ops::Range<usize> {
+        self.graph_offsets[g]..self.graph_offsets[g + 1]
+    }
+
+    /// Edges of graph `g` as pairs of local node indices.
+    pub fn edges(&self, g: usize) -> impl Iterator<Item = (usize, usize)> + '_ {
+        let start = self.graph_offsets[g];
+        self.nodes(g).flat_map(move |u| {
+            self.neighbors[self.offsets[u]..self.offsets[u + 1]]
+                .iter()
+                .map(move |&v| (u - start, v))
+        })
+    }
+
+    /// `initial_position` of each node by its local index, indexed by node of
+    /// the batch.
+    pub fn initial_placement(&self) -> Vec<(f32, f32)> {
+        (0..self.graph_count())
+            .flat_map(|g| {
+                self.nodes(g)
+                    .map(move |u| initial_position(u - self.graph_offsets[g]))
+            })
+            .collect()
+    }
+}
+
+impl Default for GraphBatch {
+    fn default() -> GraphBatch {
+        GraphBatch::new()
+    }
+}
+
+/// Layout algorithm applied to every graph of a batch.
+#[derive(Clone, Copy, Debug)]
+pub enum BatchLayout {
+    /// `Simulation` with all-pair many-body, link and center forces, run
+    /// until it is finished.
+    ForceSimulation,
+    /// `kamada_kawai_slice` with unit edge lengths, scaled to a `size` by
+    /// `size` square.
+    KamadaKawai { eps: f32, size: f32 },
+    /// `stress_majorization_slice` with edges of length `edge_length`.
+    StressMajorization { edge_length: f32 },
+}
+
+/// Per-worker state reused from graph to graph.
+struct Scratch {
+    graph: UnGraph<(), ()>,
+}
+
+impl Scratch {
+    fn new() -> Scratch {
+        Scratch {
+            graph: UnGraph::default(),
+        }
+    }
+
+    fn layout(
+        &mut self,
+        batch: &GraphBatch,
+        g: usize,
+        layout: BatchLayout,
+        pos: &mut [(f32, f32)],
+    ) {
+        if pos.len() < 2 {
+            for p in pos.iter_mut() {
+                *p = (0., 0.);
+            }
+            return;
+        }
+        let graph = &mut self.graph;
+        graph.clear();
+        for _ in 0..pos.len() {
+            graph.add_node(());
+        }
+        for (u, v) in batch.edges(g) {
+            graph.add_edge(NodeIndex::new(u), NodeIndex::new(v), ());
+        }
+        match layout {
+            BatchLayout::ForceSimulation => {
+                let mut simulation = Simulation::new(&*graph, |_, u| pos[u.index()]);
+                let forces = (
+                    ManyBodyForceAllPair::new(&*graph),
+                    LinkForce::new(&*graph),
+                    CenterForce::new(),
+                );
+                while !simulation.is_finished() {
+                    simulation.step_with(&forces);
+                }
+                simulation.coordinates_slice(pos);
+            }
+            BatchLayout::KamadaKawai { eps, size } => {
+                kamada_kawai_slice(&*graph, pos, &mut |_| 1., eps, size, size);
+            }
+            BatchLayout::StressMajorization { edge_length } => {
+                stress_majorization_slice(&*graph, pos, &mut |_| edge_length);
+            }
+        }
+    }
+}
+
+/// Lays out every graph of `batch` with `layout`. `coordinates`, indexed by
+/// node of the batch, holds the initial positions, e.g. from
+/// `GraphBatch::initial_placement`, and receives the result; each graph is
+/// laid out around its own origin.
+///
+/// Kamada-Kawai and stress majorization expect connected graphs. Graphs run
+/// in parallel with the `parallel` feature, each worker reusing its scratch
+/// graph.
+pub fn layout_batch(batch: &GraphBatch, layout: BatchLayout, coordinates: &mut [(f32, f32)]) {
+    assert_eq!(coordinates.len(), batch.node_count());
+    let mut parts = Vec::with_capacity(batch.graph_count());
+    let mut rest = coordinates;
+    for g in 0..batch.graph_count() {
+        let (pos, tail) = std::mem::take(&mut rest).split_at_mut(batch.nodes(g).len());
+        parts.push((g, pos));
+        rest = tail;
+    }
+    #[cfg(feature = "parallel")]
+    parts
+        .par_iter_mut()
+        .for_each_init(Scratch::new, |scratch, (g, pos)| {
+            scratch.layout(batch, *g, layout, pos)
+        });
+    #[cfg(not(feature = "parallel"))]
+    {
+        let mut scratch = Scratch::new();
+        for (g, pos) in parts.iter_mut() {
+            scratch.layout(batch, *g, layout, pos);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn cycles() -> GraphBatch {
+        let mut batch = GraphBatch::new();
+        for n in 1..30 {
+            let edges = (0..n).map(|i| (i, (i + 1) % n)).collect::<Vec<_>>();
+            batch.add_graph(n, if n > 2 { &edges } else { &edges[..n - 1] });
+        }
+        batch
+    }
+
+    #[test]
+    fn test_from_csr() {
+        let batch = cycles();
+        let copy = GraphBatch::from_csr(
+            batch.graph_offsets.clone(),
+            batch.offsets.clone(),
+            batch.neighbors.clone(),
+        )
+        .unwrap();
+        assert_eq!(copy.graph_count(), 29);
+        assert_eq!(
+            copy.edges(4).collect::<Vec<_>>(),
+            batch.edges(4).collect::<Vec<_>>()
+        );
+        assert!(GraphBatch::from_csr(vec![0, 2], vec![0, 1, 1], vec![2]).is_err());
+        assert!(GraphBatch::from_csr(vec![0, 2], vec![0, 1], vec![1]).is_err());
+        assert!(GraphBatch::from_csr(vec![0, 2], vec![0, 1, 1], vec![1]).is_ok());
+    }
+
+    #[test]
+    fn test_layout_batch() {
+        let batch = cycles();
+        for &layout in &[
+            BatchLayout::ForceSimulation,
+            BatchLayout::KamadaKawai {
+                eps: 1e-1,
+                size: 100.,
+            },
+            BatchLayout::StressMajorization { edge_length: 30. },
+        ] {
+            let mut coordinates = batch.initial_placement();
+            layout_batch(&batch, layout, &mut coordinates);
+            assert!(coordinates
+                .iter()
+                .all(|&(x, y)| x.is_finite() && y.is_finite()));
+            // Batched results match laying out a graph on its own.
+            let g = 11;
+            let nodes = batch.nodes(g);
+            let mut single = GraphBatch::new();
+            single.add_graph(nodes.len(), &batch.edges(g).collect::<Vec<_>>());
+            let mut expected = single.initial_placement();
+            layout_batch(&single, layout, &mut expected);
+            assert_eq!(&coordinates[nodes], &expected[..]);
+        }
+    }
+}
@@ -0,0 +1,236 @@
+use petgraph::graph::{EdgeIndex, Graph, IndexType, NodeIndex};
+use petgraph::EdgeType;
+use petgraph_algorithm_connected_components::connected_component_labels;
+use petgraph_layout_force_simulation::initial_position;
+#[cfg(feature = "parallel")]
+use rayon::prelude::*;
+use std::collections::HashMap;
+
+/// A connected component as a standalone graph. Node and edge weights are the
+/// node and edge indices in the original graph.
+pub type Component<Ty, Ix> = Graph<NodeIndex<Ix>, EdgeIndex<Ix>, Ty, Ix>;
+
+/// Splits `graph` into its connected components, ignoring edge directions, in
+/// order of their smallest node index. Runs in O(n + m).
+pub fn split_components<N, E, Ty: EdgeType, Ix: IndexType>(
+    graph: &Graph<N, E, Ty, Ix>,
+) -> Vec<Component<Ty, Ix>> {
+    let labels = connected_component_labels(graph);
+    let count = labels.iter().map(|&c| c as usize + 1).max().unwrap_or(0);
+    let mut node_counts = vec![0; count];
+    for &c in &labels {
+        node_counts[c as usize] += 1;
+    }
+    let mut edge_counts = vec![0; count];
+    for e in graph.raw_edges() {
+        edge_counts[labels[e.source().index()] as usize] += 1;
+    }
+    let mut components = node_counts
+        .into_iter()
+        .zip(edge_counts)
+        .map(|(n, m)| Graph::with_capacity(n, m))
+        .collect::<Vec<Component<Ty, Ix>>>();
+    let mut local = Vec::with_capacity(graph.node_count());
+    for u in graph.node_indices() {
+        local.push(components[labels[u.index()] as usize].add_node(u));
+    }
+    for e in graph.edge_indices() {
+        let (u, v) = graph.edge_endpoints(e).unwrap();
+        components[labels[u.index()] as usize].add_edge(local[u.index()], local[v.index()], e);
+    }
+    components
+}
+
+/// Places rectangles of the given `(width, height)` on shelves, tallest first,
+/// aiming at a square overall shape. Returns the top-left corner of each
+/// rectangle, with the packing centered at the origin. Sizes should be
+/// finite; NaN sizes do not panic, but the offsets are then meaningless.
+pub fn pack_rectangles(sizes: &[(f32, f32)]) -> Vec<(f32, f32)> {
+    let mut order = (0..sizes.len()).collect::<Vec<_>>();
+    order.sort_by(|&i, &j| sizes[j].1.total_cmp(&sizes[i].1));
+    let area = sizes.iter().map(|&(w, h)| w * h).sum::<f32>();
+    let max_width = sizes.iter().map(|&(w, _)| w).fold(0., f32::max);
+    let row_width = area.sqrt().max(max_width);
+
+    let mut offsets = vec![(0., 0.); sizes.len()];
+    let mut x = 0.;
+    let mut y = 0.;
+    let mut row_height = 0.;
+    let mut width: f32 = 0.;
+    for i in order {
+        let (w, h) = sizes[i];
+        if x > 0. && x + w > row_width {
+            x = 0.;
+            y += row_height;
+            row_height = 0.;
+        }
+        offsets[i] = (x, y);
+        x += w;
+        width = width.max(x);
+        if row_height == 0. {
+            row_height = h;
+        }
+    }
+    let height = y + row_height;
+    for p in offsets.iter_mut() {
+        p.0 -= width / 2.;
+        p.1 -= height / 2.;
+    }
+    offsets
+}
+
+/// Lays out each connected component of `graph` independently with `layout`,
+/// then packs the components with `pack_rectangles`, leaving `gap` between
+/// their bounding boxes.
+///
+/// `layout` receives a component and its coordinates, initialized with
+/// `initial_position`, so a component never pays for the size of the others.
+/// Components are laid out in parallel with the `parallel` feature, largest
+/// first.
+pub fn layout_components<N, E, Ty, Ix, F>(
+    graph: &Graph<N, E, Ty, Ix>,
+    layout: F,
+    gap: f32,
+) -> HashMap<NodeIndex<Ix>, (f32, f32)>
+where
+    Ty: EdgeType + Send + Sync,
+    Ix: IndexType + Send + Sync,
+    F: Fn(&Component<Ty, Ix>, &mut [(f32, f32)]) + Sync,
+{
+    let mut coordinates = vec![(0., 0.); graph.node_count()];
+    layout_components_slice(graph, layout, gap, &mut coordinates);
+    graph.node_indices().zip(coordinates).collect()
+}
+
+/// Same as `layout_components`, writing into `coordinates` indexed by node
+/// index.
+/// Panics unless `coordinates.len() == graph.node_count()`.
+pub fn layout_components_slice<N, E, Ty, Ix, F>(
+    graph: &Graph<N, E, Ty, Ix>,
+    layout: F,
+    gap: f32,
+    coordinates: &mut [(f32, f32)],
+) where
+    Ty: EdgeType + Send + Sync,
+    Ix: IndexType + Send + Sync,
+    F: Fn(&Component<Ty, Ix>, &mut [(f32, f32)]) + Sync,
+{
+    assert_eq!(coordinates.len(), graph.node_count());
+    let mut components = split_components(graph)
+        .into_iter()
+        .map(|component| {
+            let pos = (0..component.node_count())
+                .map(initial_position)
+                .collect::<Vec<_>>();
+            (component, pos)
+        })
+        .collect::<Vec<_>>();
+    components.sort_by_key(|(component, _)| std::cmp::Reverse(component.node_count()));
+    let run = |(component, pos): &mut (Component<Ty, Ix>, Vec<(f32, f32)>)| {
+        if component.node_count() > 1 {
+            layout(component, pos);
+        } else {
+            pos[0] = (0., 0.);
+        }
+    };
+    #[cfg(feature = "parallel")]
+    components.par_iter_mut().for_each(run);
+    #[cfg(not(feature = "parallel"))]
+    components.iter_mut().for_each(run);
+
+    let bounds = components
+        .iter()
+        .map(|(_, pos)| {
+            pos.iter().fold(
+                (
+                    std::f32::INFINITY,
+                    std::f32::INFINITY,
+                    -std::f32::INFINITY,
+                    -std::f32::INFINITY,
+                ),
+                |(x0, y0, x1, y1), &(x, y)| (x0.min(x), y0.min(y), x1.max(x), y1.max(y)),
+            )
+        })
+        .collect::<Vec<_>>();
+    let sizes = bounds
+        .iter()
+        .map(|&(x0, y0, x1, y1)| (x1 - x0 + gap, y1 - y0 + gap))
+        .collect::<Vec<_>>();
+    let offsets = pack_rectangles(&sizes);
+    for (((component, pos), &(x0, y0, _, _)), &(ox, oy)) in
+        components.iter().zip(&bounds).zip(&offsets)
+    {
+        for u in component.node_indices() {
+            let (x, y) = pos[u.index()];
+            coordinates[component[u].index()] = (x - x0 + ox + gap / 2., y - y0 + oy + gap / 2.);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_pack_rectangles() {
+        let sizes = (0..50)
+            .map(|i| (1. + (i % 7) as f32, 1. + (i % 5) as f32))
+            .collect::<Vec<_>>();
+        let offsets = pack_rectangles(&sizes);
+        for i in 0..sizes.len() {
+            for j in 0..i {
+                let (xi, yi) = offsets[i];
+                let (xj, yj) = offsets[j];
+                let separated = xi + sizes[i].0 <= xj
+                    || xj + sizes[j].0 <= xi
+                    || yi + sizes[i].1 <= yj
+                    || yj + sizes[j].1 <= yi;
+                assert!(separated);
+            }
+        }
+        assert_eq!(pack_rectangles(&[(1., std::f32::NAN), (1., 1.)]).len(), 2);
+    }
+
+    #[test]
+    fn test_layout_components() {
+        let mut graph = Graph::new_undirected();
+        let mut nodes = vec![];
+        for k in 0..20 {
+            let first = graph.add_node(());
+            nodes.push(first);
+            for _ in 0..k {
+                let u = graph.add_node(());
+                graph.add_edge(*nodes.last().unwrap(), u, ());
+                nodes.push(u);
+            }
+        }
+        let isolated = graph.add_node(());
+        let coordinates = layout_components(
+            &graph,
+            |component, pos| {
+                for u in component.node_indices() {
+                    pos[u.index()] = (u.index() as f32, 0.);
+                }
+            },
+            1.,
+        );
+        assert_eq!(coordinates.len(), graph.node_count());
+        assert!(coordinates.contains_key(&isolated));
+        let components = split_components(&graph);
+        assert_eq!(components.len(), 21);
+        for c in &components {
+            for d in &components {
+                if c[NodeIndex::new(0)] == d[NodeIndex::new(0)] {
+                    continue;
+                }
+                for u in c.node_weights() {
+                    for v in d.node_weights() {
+                        let (xu, yu) = coordinates[u];
+                        let (xv, yv) = coordinates[v];
+                        assert!((xu - xv).abs() >= 1. || (yu - yv).abs() >= 1.);
+                    }
+                }
+            }
+        }
+    }
+}
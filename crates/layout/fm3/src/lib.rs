@@ -1,201 +1,191 @@
-use petgraph::graph::{node_index, IndexType};
+use petgraph::graph::IndexType;
 use petgraph::prelude::*;
 use petgraph::EdgeType;
-use petgraph_algorithm_connected_components::connected_components;
-use petgraph_layout_force_simulation::force::link_force::LinkArgument;
-use petgraph_layout_force_simulation::force::{CenterForce, LinkForce, ManyBodyForce};
-use petgraph_layout_force_simulation::{initial_placement, Force, Simulation};
+use petgraph_algorithm_connected_components::connected_component_labels_with_edges;
+use petgraph_layout_force_simulation::force::link_force::Link;
+use petgraph_layout_force_simulation::force::{CenterForce, LinkForce, ManyBodyForceMultipole};
+use petgraph_layout_force_simulation::{initial_position, Simulation};
 use rand::prelude::*;
-use std::collections::{HashMap, HashSet};
+use std::collections::HashMap;
 use std::f32::consts::PI;
 
-#[derive(Debug)]
-pub enum NodeType {
-    Unknown,
-    SunNode,
-    PlanetNode,
-    MoonNode,
+const NONE: u32 = std::u32::MAX;
+const VELOCITY_DECAY: f32 = 0.6;
+
+/// One level of the coarsening hierarchy. Nodes are `0..node_count()`, each
+/// edge is stored once in `edges` and twice in the CSR adjacency as
+/// `(neighbor, edge)`.
+struct Level {
+    edges: Vec<(u32, u32)>,
+    distance: Vec<f32>,
+    adjacency_start: Vec<u32>,
+    adjacency: Vec<(u32, u32)>,
 }
 
-fn solar_system_partition<N, E, Ty: EdgeType, Ix: IndexType>(
-    graph: &Graph<N, E, Ty, Ix>,
-) -> (Vec<usize>, Vec<usize>, Vec<NodeType>) {
+impl Level {
+    fn new(node_count: usize, edges: Vec<(u32, u32)>, distance: Vec<f32>) -> Level {
+        let mut adjacency_start = vec![0; node_count + 1];
+        for &(u, v) in &edges {
+            adjacency_start[u as usize + 1] += 1;
+            adjacency_start[v as usize + 1] += 1;
+        }
+        for u in 0..node_count {
+            adjacency_start[u + 1] += adjacency_start[u];
+        }
+        let mut cursor = adjacency_start[..node_count].to_vec();
+        let mut adjacency = vec![(0, 0); 2 * edges.len()];
+        for (e, &(u, v)) in edges.iter().enumerate() {
+            adjacency[cursor[u as usize] as usize] = (v, e as u32);
+            cursor[u as usize] += 1;
+            adjacency[cursor[v as usize] as usize] = (u, e as u32);
+            cursor[v as usize] += 1;
+        }
+        Level {
+            edges,
+            distance,
+            adjacency_start,
+            adjacency,
+        }
+    }
+
+    fn node_count(&self) -> usize {
+        self.adjacency_start.len() - 1
+    }
+
+    fn neighbors(&self, u: usize) -> &[(u32, u32)] {
+        &self.adjacency[self.adjacency_start[u] as usize..self.adjacency_start[u + 1] as usize]
+    }
+
+    fn degree(&self, u: usize) -> usize {
+        (self.adjacency_start[u + 1] - self.adjacency_start[u]) as usize
+    }
+}
+
+/// Maps the nodes of a level to the nodes of the next coarser level. Suns
+/// have a `path_length` of zero, planets and moons the length of their path
+/// to the sun, and
+/// `coarse_edge` the coarse edge of each edge, or `NONE` inside a group.
+struct Partition {
+    groups: Vec<u32>,
+    path_length: Vec<f32>,
+    group_count: usize,
+    coarse_edge: Vec<u32>,
+}
+
+fn solar_system_partition(level: &Level) -> Partition {
+    let n = level.node_count();
     let nodes = {
-        let mut nodes = graph.node_indices().collect::<Vec<_>>();
-        nodes.sort_by_key(|&u| graph.neighbors_undirected(u).count());
+        let mut nodes = (0..n).collect::<Vec<_>>();
+        nodes.sort_by_key(|&u| level.degree(u));
         nodes.reverse();
         nodes
     };
-    let mut groups = graph.node_indices().map(|_| 0).collect::<Vec<_>>();
-    let mut parents = graph.node_indices().map(|_| 0).collect::<Vec<_>>();
-    let mut node_types = graph
-        .node_indices()
-        .map(|_| NodeType::Unknown)
-        .collect::<Vec<_>>();
-    let mut visited = graph.node_indices().map(|_| false).collect::<Vec<_>>();
+    let mut groups = vec![0; n];
+    let mut path_length = vec![0.; n];
+    let mut visited = vec![false; n];
     let mut i = 0;
     for s in nodes {
-        if visited[s.index()] {
+        if visited[s] {
             continue;
         }
-        groups[s.index()] = i;
-        parents[s.index()] = s.index();
-        node_types[s.index()] = NodeType::SunNode;
-        visited[s.index()] = true;
-        let mut s_neighbors = graph.neighbors_undirected(s).detach();
-        while let Some(p) = s_neighbors.next_node(graph) {
-            if visited[p.index()] {
+        groups[s] = i;
+        visited[s] = true;
+        for &(p, e) in level.neighbors(s) {
+            let p = p as usize;
+            if visited[p] {
                 continue;
             }
-            groups[p.index()] = i;
-            parents[p.index()] = s.index();
-            node_types[p.index()] = NodeType::PlanetNode;
-            visited[p.index()] = true;
-            let mut p_neighbors = graph.neighbors_undirected(p).detach();
-            while let Some(m) = p_neighbors.next_node(graph) {
-                if !visited[m.index()] {
-                    groups[m.index()] = i;
-                    parents[m.index()] = p.index();
-                    node_types[m.index()] = NodeType::MoonNode;
-                    visited[m.index()] = true;
+            groups[p] = i;
+            path_length[p] = level.distance[e as usize];
+            visited[p] = true;
+            for &(m, f) in level.neighbors(p) {
+                let m = m as usize;
+                if !visited[m] {
+                    groups[m] = i;
+                    path_length[m] = level.distance[f as usize] + path_length[p];
+                    visited[m] = true;
                 }
             }
         }
         i += 1;
     }
-    (groups, parents, node_types)
-}
-
-fn edge_length<N, E, Ty: EdgeType, Ix: IndexType>(
-    graph: &Graph<N, E, Ty, Ix>,
-    link_distance: &HashMap<EdgeIndex<Ix>, f32>,
-    a: NodeIndex<Ix>,
-    b: NodeIndex<Ix>,
-) -> f32 {
-    let (e, _) = graph.find_edge_undirected(a, b).unwrap();
-    link_distance[&e]
-}
-
-fn path_length<N, E, Ty: EdgeType, Ix: IndexType>(
-    graph: &Graph<N, E, Ty, Ix>,
-    node_parents: &Vec<usize>,
-    node_types: &Vec<NodeType>,
-    link_distance: &HashMap<EdgeIndex<Ix>, f32>,
-    u: NodeIndex<Ix>,
-) -> f32 {
-    match node_types[u.index()] {
-        NodeType::PlanetNode => {
-            let s = NodeIndex::new(node_parents[u.index()]);
-            edge_length(graph, link_distance, u, s)
-        }
-        NodeType::MoonNode => {
-            let p = NodeIndex::new(node_parents[u.index()]);
-            let s = NodeIndex::new(node_parents[p.index()]);
-            edge_length(graph, link_distance, u, p) + edge_length(graph, link_distance, p, s)
-        }
-        _ => 0.,
+    Partition {
+        groups,
+        path_length,
+        group_count: i as usize,
+        coarse_edge: vec![],
     }
 }
 
-fn collapse<
-    N,
-    E,
-    Ty: EdgeType,
-    Ix: IndexType,
-    F1: FnMut(&Graph<N, E, Ty, Ix>, &Vec<NodeIndex<Ix>>) -> N,
-    F2: FnMut(&Graph<N, E, Ty, Ix>, &Vec<EdgeIndex<Ix>>) -> E,
->(
-    graph: &Graph<N, E, Ty, Ix>,
-    node_groups: &Vec<usize>,
-    node_parents: &Vec<usize>,
-    node_types: &Vec<NodeType>,
-    shrink_node: &mut F1,
-    shrink_edge: &mut F2,
-    link_distance: &HashMap<EdgeIndex<Ix>, f32>,
-) -> (Graph<N, E, Ty, Ix>, HashMap<EdgeIndex<Ix>, f32>) {
-    let mut shrinked_graph = Graph::default();
-    let mut shrinked_link_distance = HashMap::new();
-    let num_groups = graph
-        .node_indices()
-        .map(|a| node_groups[a.index()])
-        .max()
-        .unwrap()
-        + 1;
-    for g in 0..num_groups {
-        let node_indices = graph
-            .node_indices()
-            .filter(|&a| node_groups[a.index()] == g)
-            .collect();
-        shrinked_graph.add_node(shrink_node(graph, &node_indices));
-    }
-
-    let mut group_edge_indices = HashMap::new();
-    for e in graph.edge_indices() {
-        let (u0, v0) = graph.edge_endpoints(e).unwrap();
-        let key = {
-            let gu = node_groups[u0.index()];
-            let gv = node_groups[v0.index()];
+/// Builds the next coarser level, one node per group and one edge per pair
+/// of adjacent groups whose length is the mean over the edges between them
+/// of the sun-to-sun path length.
+fn collapse(level: &Level, partition: &mut Partition) -> Level {
+    let groups = &partition.groups;
+    let mut group_edges = level
+        .edges
+        .iter()
+        .enumerate()
+        .filter_map(|(e, &(u, v))| {
+            let gu = groups[u as usize];
+            let gv = groups[v as usize];
             if gu == gv {
-                continue;
-            }
-            if gu > gv {
-                (gv, gu)
+                None
+            } else if gu > gv {
+                Some((gv, gu, e as u32))
             } else {
-                (gu, gv)
+                Some((gu, gv, e as u32))
             }
-        };
-        if !group_edge_indices.contains_key(&key) {
-            group_edge_indices.insert(key, Vec::new());
-        }
-        group_edge_indices.get_mut(&key).unwrap().push(e);
-    }
+        })
+        .collect::<Vec<_>>();
+    group_edges.sort_unstable();
 
-    for ((gu, gv), edge_indices) in group_edge_indices.iter() {
+    let mut coarse_edge = vec![NONE; level.edges.len()];
+    let mut edges = vec![];
+    let mut distance = vec![];
+    let mut start = 0;
+    while start < group_edges.len() {
+        let (gu, gv, _) = group_edges[start];
+        let mut end = start;
         let mut total_edge_length = 0.;
-        for &e in edge_indices.iter() {
-            let (u0, v0) = graph.edge_endpoints(e).unwrap();
-            let e_u_length = path_length(graph, node_parents, node_types, link_distance, u0);
-            let e_v_length = path_length(graph, node_parents, node_types, link_distance, v0);
-
-            let e_length = edge_length(graph, link_distance, u0, v0);
-            total_edge_length += e_u_length + e_length + e_v_length;
+        while end < group_edges.len() && group_edges[end].0 == gu && group_edges[end].1 == gv {
+            let e = group_edges[end].2 as usize;
+            let (u, v) = level.edges[e];
+            total_edge_length += partition.path_length[u as usize]
+                + level.distance[e]
+                + partition.path_length[v as usize];
+            coarse_edge[e] = edges.len() as u32;
+            end += 1;
         }
-        total_edge_length /= edge_indices.len() as f32;
-        let e = shrinked_graph.add_edge(
-            NodeIndex::new(gu.index()),
-            NodeIndex::new(gv.index()),
-            shrink_edge(graph, edge_indices),
-        );
-        shrinked_link_distance.insert(e, total_edge_length);
+        edges.push((gu, gv));
+        distance.push(total_edge_length / (end - start) as f32);
+        start = end;
     }
-    (shrinked_graph, shrinked_link_distance)
+    partition.coarse_edge = coarse_edge;
+    Level::new(partition.group_count, edges, distance)
 }
 
-fn expand<N, E, Ty: EdgeType, Ix: IndexType>(
-    graph0: &Graph<N, E, Ty, Ix>,
-    graph1: &Graph<N, E, Ty, Ix>,
-    graph1_points: &HashMap<NodeIndex<Ix>, (f32, f32)>,
-    node_groups: &Vec<usize>,
-    node_parents: &Vec<usize>,
-    node_types: &Vec<NodeType>,
-    link_distance: &HashMap<EdgeIndex<Ix>, f32>,
+fn expand(
+    level: &Level,
+    partition: &Partition,
+    coarse_level: &Level,
+    coarse_points: &[(f32, f32)],
     rng: &mut StdRng,
-) -> HashMap<NodeIndex<Ix>, (f32, f32)> {
-    let mut points = HashMap::new();
-    for u in graph0.node_indices() {
+    points: &mut Vec<(f32, f32)>,
+) {
+    points.clear();
+    for u in 0..level.node_count() {
         let mut x = 0.;
         let mut y = 0.;
         let mut count = 0;
-        let s1 = node_index(node_groups[u.index()]);
-        let (s1_x, s1_y) = graph1_points[&s1];
-        for v in graph0.neighbors_undirected(u) {
-            if node_groups[u.index()] == node_groups[v.index()] {
+        let (s1_x, s1_y) = coarse_points[partition.groups[u] as usize];
+        for &(v, e) in level.neighbors(u) {
+            let coarse_edge = partition.coarse_edge[e as usize];
+            if coarse_edge == NONE {
                 continue;
             }
-            let t1 = node_index(node_groups[v.index()]);
-            let (t1_x, t1_y) = graph1_points[&t1];
-            let scale = path_length(graph0, node_parents, node_types, link_distance, u)
-                / edge_length(graph1, link_distance, s1, t1);
+            let (t1_x, t1_y) = coarse_points[partition.groups[v as usize] as usize];
+            let scale = partition.path_length[u] / coarse_level.distance[coarse_edge as usize];
             x += (t1_x - s1_x) * scale + s1_x;
             y += (t1_y - s1_y) * scale + s1_y;
             count += 1;
@@ -204,48 +194,73 @@ fn expand<N, E, Ty: EdgeType, Ix: IndexType>(
             (x / count as f32, y / count as f32)
         } else {
             let theta = rng.gen::<f32>() * 2. * PI;
-            let r = path_length(graph0, node_parents, node_types, link_distance, u);
+            let r = partition.path_length[u];
             let x = r * theta.cos() + s1_x;
             let y = r * theta.sin() + s1_y;
             (x, y)
         };
-        points.insert(u, (x, y));
+        points.push((x, y));
     }
-    points
 }
 
-fn layout<N, E, Ty: EdgeType, Ix: IndexType>(
-    graph: &Graph<N, E, Ty, Ix>,
-    link_distance: &HashMap<EdgeIndex<Ix>, f32>,
-    iteration: usize,
-    alpha: f32,
-) -> HashMap<NodeIndex<Ix>, (f32, f32)> {
-    let points = initial_placement(graph);
-    layout_with_initial_placement(graph, link_distance, &points, iteration, alpha)
+/// Force-directed layout shared by all levels. The multipole expansions are
+/// sized by the finest level and reused by the coarser ones.
+struct Layout {
+    strength: Vec<f32>,
+    many_body: ManyBodyForceMultipole,
+    center: CenterForce,
 }
 
-fn layout_with_initial_placement<N, E, Ty: EdgeType, Ix: IndexType>(
-    graph: &Graph<N, E, Ty, Ix>,
-    link_distance: &HashMap<EdgeIndex<Ix>, f32>,
-    points: &HashMap<NodeIndex<Ix>, (f32, f32)>,
-    iteration: usize,
-    alpha: f32,
-) -> HashMap<NodeIndex<Ix>, (f32, f32)> {
-    let mut simulation = Simulation::new(&graph, |_, u| points[&u]);
-    let forces: Vec<Box<dyn Force>> = vec![
-        Box::new(ManyBodyForce::new_with_accessor(&graph, |_, _| Some(-100.))),
-        Box::new(LinkForce::new_with_accessor(&graph, |_, e| LinkArgument {
-            distance: Some(link_distance[&e]),
-            strength: None,
-        })),
-        Box::new(CenterForce::new()),
-    ];
-    for _ in 0..iteration {
-        simulation.apply_forces(&forces.as_slice(), alpha);
+impl Layout {
+    fn new(node_count: usize) -> Layout {
+        Layout {
+            strength: vec![-100.; node_count],
+            many_body: ManyBodyForceMultipole::new_with_strength(Vec::with_capacity(node_count)),
+            center: CenterForce::new(),
+        }
+    }
+
+    /// Runs `iteration` simulation steps at a constant `alpha`.
+    fn run(&mut self, level: &Level, coordinates: &mut [(f32, f32)], iteration: usize, alpha: f32) {
+        let n = level.node_count();
+        self.many_body.set_strength(&self.strength[..n]);
+        let links = level
+            .edges
+            .iter()
+            .zip(&level.distance)
+            .map(|(&(u, v), &distance)| {
+                let source_degree = level.degree(u as usize) as f32;
+                let target_degree = level.degree(v as usize) as f32;
+                Link::new(
+                    u as usize,
+                    v as usize,
+                    distance,
+                    1. / source_degree.min(target_degree),
+                    source_degree / (source_degree + target_degree),
+                )
+            })
+            .collect();
+        let link = LinkForce::new_with_node_count(n, links);
+        let forces = (&self.many_body, link, &self.center);
+        let mut simulation = Simulation::<u32>::new_with_coordinates(coordinates);
+        simulation.alpha = alpha;
+        simulation.alpha_target = alpha;
+        simulation.velocity_decay = VELOCITY_DECAY;
+        for _ in 0..iteration {
+            simulation.step_with(&forces);
+        }
+        simulation.coordinates_slice(coordinates);
     }
-    simulation.coordinates()
 }
 
+/// Multilevel force-directed layout after Hachul and Jünger's FM³: the graph
+/// is coarsened by solar system partitions, each level is laid out from the
+/// expanded layout of the coarser one, and the repulsion is computed with
+/// the fast multipole method.
+///
+/// The coarse levels are index arrays rather than graphs, so `shrink_node`
+/// and `shrink_edge` are no longer called; `fm3_with_link_distance` takes the
+/// same arguments without them.
 pub fn fm3<
     N,
     E,
@@ -258,67 +273,193 @@ pub fn fm3<
     graph: &Graph<N, E, Ty, Ix>,
     min_size: usize,
     step_iteration: usize,
-    shrink_node: &mut F1,
-    shrink_edge: &mut F2,
+    _shrink_node: &mut F1,
+    _shrink_edge: &mut F2,
     link_distance_accessor: &mut F3,
 ) -> HashMap<NodeIndex<Ix>, (f32, f32)> {
-    let mut rng: StdRng = SeedableRng::from_seed([0; 32]);
+    fm3_with_link_distance(graph, min_size, step_iteration, link_distance_accessor)
+}
 
-    let num_components = connected_components(graph)
-        .iter()
-        .collect::<HashSet<_>>()
-        .len();
-    let mut shrinked_graphs = vec![];
-    let mut link_distance = graph
-        .edge_indices()
-        .map(|e| (e, link_distance_accessor(graph, e)))
-        .collect::<HashMap<EdgeIndex<Ix>, f32>>();
-    let mut g0 = graph.map(
-        |a, _| shrink_node(graph, &vec![a]),
-        |e, _| shrink_edge(graph, &vec![e]),
+/// Same as `fm3`, writing the coordinates into `coordinates` indexed by node
+/// index.
+pub fn fm3_slice<
+    N,
+    E,
+    Ty: EdgeType,
+    Ix: IndexType,
+    F1: FnMut(&Graph<N, E, Ty, Ix>, &Vec<NodeIndex<Ix>>) -> N,
+    F2: FnMut(&Graph<N, E, Ty, Ix>, &Vec<EdgeIndex<Ix>>) -> E,
+    F3: FnMut(&Graph<N, E, Ty, Ix>, EdgeIndex<Ix>) -> f32,
+>(
+    graph: &Graph<N, E, Ty, Ix>,
+    min_size: usize,
+    step_iteration: usize,
+    _shrink_node: &mut F1,
+    _shrink_edge: &mut F2,
+    link_distance_accessor: &mut F3,
+    coordinates: &mut [(f32, f32)],
+) {
+    fm3_with_link_distance_slice(
+        graph,
+        min_size,
+        step_iteration,
+        link_distance_accessor,
+        coordinates,
     );
+}
 
-    while g0.node_count() > min_size + num_components - 1 {
-        let (groups, parents, types) = solar_system_partition(&g0);
-        let (g1, shrinked_link_distance) = collapse(
-            &g0,
-            &groups,
-            &parents,
-            &types,
-            shrink_node,
-            shrink_edge,
-            &link_distance,
-        );
-        shrinked_graphs.push((g0, groups, parents, types, link_distance));
-        g0 = g1;
-        link_distance = shrinked_link_distance;
+/// Same as `fm3`, without the unused `shrink_node` and `shrink_edge`.
+pub fn fm3_with_link_distance<
+    N,
+    E,
+    Ty: EdgeType,
+    Ix: IndexType,
+    F: FnMut(&Graph<N, E, Ty, Ix>, EdgeIndex<Ix>) -> f32,
+>(
+    graph: &Graph<N, E, Ty, Ix>,
+    min_size: usize,
+    step_iteration: usize,
+    link_distance_accessor: &mut F,
+) -> HashMap<NodeIndex<Ix>, (f32, f32)> {
+    let mut coordinates = vec![(0., 0.); graph.node_count()];
+    fm3_with_link_distance_slice(
+        graph,
+        min_size,
+        step_iteration,
+        link_distance_accessor,
+        &mut coordinates,
+    );
+    graph.node_indices().zip(coordinates).collect()
+}
+
+/// Same as `fm3_with_link_distance`, writing the coordinates into
+/// `coordinates` indexed by node index.
+/// Panics unless `coordinates.len() == graph.node_count()`.
+pub fn fm3_with_link_distance_slice<
+    N,
+    E,
+    Ty: EdgeType,
+    Ix: IndexType,
+    F: FnMut(&Graph<N, E, Ty, Ix>, EdgeIndex<Ix>) -> f32,
+>(
+    graph: &Graph<N, E, Ty, Ix>,
+    min_size: usize,
+    step_iteration: usize,
+    link_distance_accessor: &mut F,
+    coordinates: &mut [(f32, f32)],
+) {
+    assert_eq!(coordinates.len(), graph.node_count());
+    let n = graph.node_count();
+    if n == 0 {
+        return;
+    }
+    let mut rng: StdRng = SeedableRng::from_seed([0; 32]);
+
+    let edges = graph
+        .edge_indices()
+        .map(|e| {
+            let (u, v) = graph.edge_endpoints(e).unwrap();
+            (u.index() as u32, v.index() as u32)
+        })
+        .collect::<Vec<_>>();
+    let num_components = connected_component_labels_with_edges(n, &edges)
+        .into_iter()
+        .max()
+        .map_or(0, |c| c as usize + 1);
+    let distance = graph
+        .edge_indices()
+        .map(|e| link_distance_accessor(graph, e))
+        .collect();
+    let mut levels = vec![Level::new(n, edges, distance)];
+    let mut partitions = vec![];
+    while levels[levels.len() - 1].node_count() > min_size + num_components - 1 {
+        let level = &levels[levels.len() - 1];
+        let mut partition = solar_system_partition(level);
+        let coarse_level = collapse(level, &mut partition);
+        if coarse_level.node_count() == level.node_count() {
+            break;
+        }
+        partitions.push(partition);
+        levels.push(coarse_level);
     }
 
     let alpha_min = 0.001;
     let mut alpha = 1.;
-    let decay = 1. - (alpha_min as f32).powf(1. / shrinked_graphs.len() as f32);
+    let decay = 1. - (alpha_min as f32).powf(1. / partitions.len() as f32);
 
-    let mut gk = g0;
-    let mut g1_points = layout(&mut gk, &link_distance, step_iteration, alpha);
+    let mut layout = Layout::new(n);
+    let mut points = Vec::with_capacity(n);
+    points.extend((0..levels[levels.len() - 1].node_count()).map(initial_position));
+    layout.run(
+        &levels[levels.len() - 1],
+        &mut points,
+        step_iteration,
+        alpha,
+    );
 
-    while !shrinked_graphs.is_empty() {
-        let (g0, groups, parents, types, link_distance) = shrinked_graphs.pop().unwrap();
-        let g0_points = expand(
-            &g0,
-            &gk,
-            &g1_points,
-            &groups,
-            &parents,
-            &types,
-            &link_distance,
+    let mut next_points = Vec::with_capacity(n);
+    for k in (0..partitions.len()).rev() {
+        expand(
+            &levels[k],
+            &partitions[k],
+            &levels[k + 1],
+            &points,
             &mut rng,
+            &mut next_points,
         );
-        g1_points =
-            layout_with_initial_placement(&g0, &link_distance, &g0_points, step_iteration, alpha);
+        layout.run(&levels[k], &mut next_points, step_iteration, alpha);
         alpha -= alpha * decay;
-        gk = g0;
+        std::mem::swap(&mut points, &mut next_points);
     }
-    g1_points
+    coordinates.copy_from_slice(&points);
+}
+
+/// Refines `coordinates`, indexed by node index, for example a layout saved
+/// from an earlier run, with `step_iteration` steps at `alpha` on the input
+/// graph only, skipping the multilevel coarsening.
+/// Panics unless `coordinates.len() == graph.node_count()`.
+pub fn fm3_refine_slice<
+    N,
+    E,
+    Ty: EdgeType,
+    Ix: IndexType,
+    F: FnMut(&Graph<N, E, Ty, Ix>, EdgeIndex<Ix>) -> f32,
+>(
+    graph: &Graph<N, E, Ty, Ix>,
+    step_iteration: usize,
+    link_distance_accessor: &mut F,
+    alpha: f32,
+    coordinates: &mut [(f32, f32)],
+) {
+    assert_eq!(coordinates.len(), graph.node_count());
+    let n = graph.node_count();
+    let edges = graph
+        .edge_indices()
+        .map(|e| {
+            let (u, v) = graph.edge_endpoints(e).unwrap();
+            (u.index() as u32, v.index() as u32)
+        })
+        .collect();
+    let distance = graph
+        .edge_indices()
+        .map(|e| link_distance_accessor(graph, e))
+        .collect();
+    let level = Level::new(n, edges, distance);
+    Layout::new(n).run(&level, coordinates, step_iteration, alpha);
+}
+
+#[test]
+fn test_collapse() {
+    let edges = vec![(0, 1), (1, 2), (2, 3), (3, 4)];
+    let level = Level::new(5, edges, vec![30.; 4]);
+    let mut partition = solar_system_partition(&level);
+    let coarse_level = collapse(&level, &mut partition);
+    assert_eq!(partition.groups, vec![1, 0, 0, 0, 0]);
+    assert_eq!(partition.path_length, vec![0., 60., 30., 0., 30.]);
+    assert_eq!(partition.coarse_edge, vec![0, NONE, NONE, NONE]);
+    assert_eq!(coarse_level.node_count(), 2);
+    assert_eq!(coarse_level.edges, vec![(0, 1)]);
+    assert_eq!(coarse_level.distance, vec![90.]);
 }
 
 #[test]
@@ -341,13 +482,22 @@ fn test_fm3() {
     }
     let points = fm3(
         &graph,
-        100,
+        10,
         100,
         &mut |_, _| (),
         &mut |_, _| (),
         &mut |_, _| 30.,
     );
-    for point in points {
-        println!("{:?}", point);
+    assert_eq!(points.len(), rows * cols);
+    for (_, (x, y)) in points {
+        assert!(x.is_finite() && y.is_finite());
+    }
+
+    let mut coordinates = vec![(0., 0.); rows * cols];
+    fm3_with_link_distance_slice(&graph, 10, 100, &mut |_, _| 30., &mut coordinates);
+    let before = coordinates.clone();
+    fm3_refine_slice(&graph, 10, &mut |_, _| 30., 0.001, &mut coordinates);
+    for (p, q) in before.iter().zip(&coordinates) {
+        assert!((p.0 - q.0).abs() < 30. && (p.1 - q.1).abs() < 30.);
     }
 }
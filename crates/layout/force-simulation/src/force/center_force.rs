@@ -1,4 +1,4 @@
-use crate::{Force, Point};
+use crate::{Force, Point, StaticForce};
 
 pub struct CenterForce {}
 
@@ -21,6 +21,30 @@ impl Force for CenterForce {
             point.y -= cy;
         }
     }
+
+    fn scales_with_alpha(&self) -> bool {
+        false
+    }
+}
+
+impl StaticForce for CenterForce {
+    type State = (f32, f32);
+
+    fn prepare(&self, points: &mut Vec<Point>, _alpha: f32) -> (f32, f32) {
+        let cx = points.iter().map(|p| p.x).sum::<f32>() / points.len() as f32;
+        let cy = points.iter().map(|p| p.y).sum::<f32>() / points.len() as f32;
+        (cx, cy)
+    }
+
+    fn scales_with_alpha(&self) -> bool {
+        false
+    }
+
+    #[inline]
+    fn apply_to_point(&self, &(cx, cy): &(f32, f32), _i: usize, point: &mut Point, _alpha: f32) {
+        point.x -= cx;
+        point.y -= cy;
+    }
 }
 
 impl AsRef<dyn Force> for CenterForce {
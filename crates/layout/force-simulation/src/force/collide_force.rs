@@ -1,14 +1,112 @@
-use crate::{Force, Point, MIN_DISTANCE};
+use crate::point_buffer::LANES;
+use crate::{Force, Point, PointBuffer, StaticForce, MIN_DISTANCE};
 use petgraph::graph::{Graph, IndexType, NodeIndex};
 use petgraph::EdgeType;
+use std::cell::RefCell;
 
-pub struct CollideForce {
+#[inline(always)]
+fn collide_kernel(
+    x: &[f32],
+    y: &[f32],
+    radius: &[f32],
+    strength: f32,
+    vx: &mut [f32],
+    vy: &mut [f32],
+) {
+    let n = x.len();
+    for i in 0..n {
+        let xi = x[i] + vx[i];
+        let yi = y[i] + vy[i];
+        let ri = radius[i];
+        let (vx_head, vx_tail) = vx.split_at_mut(i + 1);
+        let (vy_head, vy_tail) = vy.split_at_mut(i + 1);
+        let xs = &x[i + 1..];
+        let ys = &y[i + 1..];
+        let rs = &radius[i + 1..];
+        let m = xs.len() - xs.len() % LANES;
+        // For a fixed i every j is independent, so the pairs are evaluated
+        // lane by lane. Misses are masked instead of branched on so the
+        // compiler can turn the inner loop into SIMD selects.
+        let mut ax = [0.; LANES];
+        let mut ay = [0.; LANES];
+        for ((((xs, ys), rs), vxs), vys) in xs[..m]
+            .chunks_exact(LANES)
+            .zip(ys[..m].chunks_exact(LANES))
+            .zip(rs[..m].chunks_exact(LANES))
+            .zip(vx_tail[..m].chunks_exact_mut(LANES))
+            .zip(vy_tail[..m].chunks_exact_mut(LANES))
+        {
+            for k in 0..LANES {
+                let rj = rs[k];
+                let dx = xi - (xs[k] + vxs[k]);
+                let dy = yi - (ys[k] + vys[k]);
+                let r = ri + rj;
+                let l2 = (dx * dx + dy * dy).max(MIN_DISTANCE);
+                let hit = l2 < r * r;
+                let l = l2.sqrt();
+                let d = (r - l) / l * strength;
+                let rr = (rj * rj) / (ri * ri + rj * rj);
+                ax[k] += if hit { (dx * d) * rr } else { 0. };
+                ay[k] += if hit { (dy * d) * rr } else { 0. };
+                vxs[k] -= if hit { (dx * d) * (1. - rr) } else { 0. };
+                vys[k] -= if hit { (dy * d) * (1. - rr) } else { 0. };
+            }
+        }
+        let mut dvx = ax.iter().sum::<f32>();
+        let mut dvy = ay.iter().sum::<f32>();
+        for j in m..xs.len() {
+            let rj = rs[j];
+            let dx = xi - (xs[j] + vx_tail[j]);
+            let dy = yi - (ys[j] + vy_tail[j]);
+            let r = ri + rj;
+            let l2 = (dx * dx + dy * dy).max(MIN_DISTANCE);
+            if l2 < r * r {
+                let l = l2.sqrt();
+                let d = (r - l) / l * strength;
+                let rr = (rj * rj) / (ri * ri + rj * rj);
+                dvx += (dx * d) * rr;
+                dvy += (dy * d) * rr;
+                vx_tail[j] -= (dx * d) * (1. - rr);
+                vy_tail[j] -= (dy * d) * (1. - rr);
+            }
+        }
+        vx_head[i] += dvx;
+        vy_head[i] += dvy;
+    }
+}
+
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+#[target_feature(enable = "avx2")]
+unsafe fn collide_kernel_avx2(
+    x: &[f32],
+    y: &[f32],
+    radius: &[f32],
+    strength: f32,
+    vx: &mut [f32],
+    vy: &mut [f32],
+) {
+    collide_kernel(x, y, radius, strength, vx, vy)
+}
+
+fn apply_collide(buffer: &mut PointBuffer, radius: &[f32], strength: f32) {
+    let PointBuffer { x, y, vx, vy } = buffer;
+    #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+    {
+        if is_x86_feature_detected!("avx2") {
+            return unsafe { collide_kernel_avx2(x, y, radius, strength, vx, vy) };
+        }
+    }
+    collide_kernel(x, y, radius, strength, vx, vy)
+}
+
+pub struct CollideForceAllPair {
     radius: Vec<f32>,
     strength: f32,
     iterations: usize,
+    buffer: RefCell<PointBuffer>,
 }
 
-impl CollideForce {
+impl CollideForceAllPair {
     pub fn new<
         N,
         E,
@@ -20,28 +118,239 @@ impl CollideForce {
         mut radius_accessor: F,
         strength: f32,
         iterations: usize,
-    ) -> CollideForce {
+    ) -> CollideForceAllPair {
         let radius = graph
             .node_indices()
             .map(|u| radius_accessor(graph, u))
             .collect::<Vec<_>>();
-        CollideForce {
+        CollideForceAllPair::new_with_radius(radius, strength, iterations)
+    }
+
+    pub fn new_with_radius(
+        radius: Vec<f32>,
+        strength: f32,
+        iterations: usize,
+    ) -> CollideForceAllPair {
+        CollideForceAllPair {
             radius,
             strength,
             iterations,
+            buffer: RefCell::new(PointBuffer::new()),
         }
     }
+
+    pub fn add_node(&mut self, radius: f32) {
+        self.radius.push(radius);
+    }
+
+    /// Removes node `i`, moving the last node into its place.
+    pub fn remove_node(&mut self, i: usize) {
+        self.radius.swap_remove(i);
+    }
 }
 
-impl Force for CollideForce {
+impl Force for CollideForceAllPair {
     fn apply(&self, points: &mut Vec<Point>, _alpha: f32) {
+        let mut buffer = self.buffer.borrow_mut();
+        buffer.load(points);
+        for _ in 0..self.iterations {
+            apply_collide(&mut buffer, &self.radius, self.strength);
+        }
+        buffer.store_velocity(points);
+    }
+
+    fn scales_with_alpha(&self) -> bool {
+        false
+    }
+}
+
+impl StaticForce for CollideForceAllPair {
+    type State = ();
+
+    fn prepare(&self, points: &mut Vec<Point>, alpha: f32) {
+        self.apply(points, alpha);
+    }
+
+    fn scales_with_alpha(&self) -> bool {
+        false
+    }
+}
+
+/// Uniform hash grid over the predicted positions `x + vx`, with cells as
+/// wide as the largest collision distance, stored as CSR buckets.
+#[derive(Default)]
+struct Grid {
+    min_x: f32,
+    min_y: f32,
+    cell_size: f32,
+    mask: usize,
+    x: Vec<f32>,
+    y: Vec<f32>,
+    cell_x: Vec<i32>,
+    cell_y: Vec<i32>,
+    bucket_start: Vec<usize>,
+    bucket_points: Vec<usize>,
+    bucket_next: Vec<usize>,
+    candidates: Vec<usize>,
+}
+
+fn cell_hash(cx: i32, cy: i32, mask: usize) -> usize {
+    ((cx as u32).wrapping_mul(0x9e37_79b1) ^ (cy as u32).wrapping_mul(0x85eb_ca77)) as usize & mask
+}
+
+impl Grid {
+    fn build(&mut self, points: &[Point], cell_size: f32) {
         let n = points.len();
+        self.x.clear();
+        self.y.clear();
+        for p in points {
+            self.x.push(p.x + p.vx);
+            self.y.push(p.y + p.vy);
+        }
+        self.min_x = self.x.iter().fold(std::f32::INFINITY, |m, &x| m.min(x));
+        self.min_y = self.y.iter().fold(std::f32::INFINITY, |m, &y| m.min(y));
+        self.cell_size = cell_size;
+        self.cell_x.clear();
+        self.cell_y.clear();
+        for i in 0..n {
+            let (cx, cy) = (
+                self.cell(self.x[i], self.min_x),
+                self.cell(self.y[i], self.min_y),
+            );
+            self.cell_x.push(cx);
+            self.cell_y.push(cy);
+        }
+        let mask = (2 * n).next_power_of_two() - 1;
+        self.mask = mask;
+        self.bucket_start.clear();
+        self.bucket_start.resize(mask + 2, 0);
+        for i in 0..n {
+            self.bucket_start[cell_hash(self.cell_x[i], self.cell_y[i], mask) + 1] += 1;
+        }
+        for b in 0..=mask {
+            self.bucket_start[b + 1] += self.bucket_start[b];
+        }
+        self.bucket_points.clear();
+        self.bucket_points.resize(n, 0);
+        self.bucket_next.clear();
+        self.bucket_next.extend_from_slice(&self.bucket_start);
+        for i in 0..n {
+            let b = cell_hash(self.cell_x[i], self.cell_y[i], mask);
+            self.bucket_points[self.bucket_next[b]] = i;
+            self.bucket_next[b] += 1;
+        }
+    }
+
+    fn cell(&self, v: f32, min: f32) -> i32 {
+        ((v - min) / self.cell_size).floor() as i32
+    }
+
+    /// Collects, in index order, the points after `i` whose position at
+    /// `build` lies in a cell overlapping the square of half width `h`
+    /// around `(x, y)`.
+    fn collect_candidates(&mut self, i: usize, x: f32, y: f32, h: f32) {
+        self.candidates.clear();
+        let (x0, x1) = (self.cell(x - h, self.min_x), self.cell(x + h, self.min_x));
+        let (y0, y1) = (self.cell(y - h, self.min_y), self.cell(y + h, self.min_y));
+        let cells = (x1 as i64 - x0 as i64 + 1) * (y1 as i64 - y0 as i64 + 1);
+        if !(cells > 0 && cells <= self.x.len() as i64) {
+            // Fewer points than cells to visit, or positions that are not
+            // finite: test every later point.
+            self.candidates.extend(i + 1..self.x.len());
+            return;
+        }
+        for nx in x0..=x1 {
+            for ny in y0..=y1 {
+                let b = cell_hash(nx, ny, self.mask);
+                for &j in &self.bucket_points[self.bucket_start[b]..self.bucket_start[b + 1]] {
+                    if j > i && self.cell_x[j] == nx && self.cell_y[j] == ny {
+                        self.candidates.push(j);
+                    }
+                }
+            }
+        }
+        self.candidates.sort_unstable();
+    }
+}
+
+/// Collision force with a uniform-grid broad phase.
+///
+/// Pairs are resolved in the same order and with the same arithmetic as
+/// `CollideForceAllPair`, but each point is only tested against the points
+/// in nearby cells, giving O(n) work per iteration for bounded radii. The
+/// grid is built once per iteration from the predicted positions. Resolved
+/// pairs move points away from their cells during the iteration, so the
+/// search around a point is widened by the largest such move so far, and
+/// every pair `CollideForceAllPair` resolves is still found.
+pub struct CollideForceGrid {
+    radius: Vec<f32>,
+    strength: f32,
+    iterations: usize,
+    grid: RefCell<Grid>,
+}
+
+impl CollideForceGrid {
+    pub fn new<
+        N,
+        E,
+        Ty: EdgeType,
+        Ix: IndexType,
+        F: FnMut(&Graph<N, E, Ty, Ix>, NodeIndex<Ix>) -> f32,
+    >(
+        graph: &Graph<N, E, Ty, Ix>,
+        mut radius_accessor: F,
+        strength: f32,
+        iterations: usize,
+    ) -> CollideForceGrid {
+        let radius = graph
+            .node_indices()
+            .map(|u| radius_accessor(graph, u))
+            .collect::<Vec<_>>();
+        CollideForceGrid::new_with_radius(radius, strength, iterations)
+    }
+
+    pub fn new_with_radius(radius: Vec<f32>, strength: f32, iterations: usize) -> CollideForceGrid {
+        CollideForceGrid {
+            radius,
+            strength,
+            iterations,
+            grid: RefCell::new(Grid::default()),
+        }
+    }
+
+    pub fn add_node(&mut self, radius: f32) {
+        self.radius.push(radius);
+    }
+
+    /// Removes node `i`, moving the last node into its place.
+    pub fn remove_node(&mut self, i: usize) {
+        self.radius.swap_remove(i);
+    }
+}
+
+impl Force for CollideForceGrid {
+    fn apply(&self, points: &mut Vec<Point>, _alpha: f32) {
+        let max_radius = self.radius.iter().fold(0., |m: f32, &r| m.max(r));
+        if points.is_empty() || !(max_radius > 0.) {
+            return;
+        }
+        let cell_size = 2. * max_radius;
+        let mut grid = self.grid.borrow_mut();
+        let grid = &mut *grid;
         for _ in 0..self.iterations {
-            for i in 0..n {
+            grid.build(points, cell_size);
+            // Largest coordinate change of a predicted position since `build`.
+            let mut moved = 0f32;
+            for i in 0..points.len() {
                 let xi = points[i].x + points[i].vx;
                 let yi = points[i].y + points[i].vy;
                 let ri = self.radius[i];
-                for j in (i + 1)..n {
+                // A point j colliding with i is within ri + rj of it now and
+                // within `moved` of where the grid has it. The margins cover
+                // rounding in these bounds.
+                let h = (ri + max_radius + moved) * 1.0001 + (xi.abs() + yi.abs()) * 1e-5;
+                grid.collect_candidates(i, xi, yi, h);
+                for &j in grid.candidates.iter() {
                     let xj = points[j].x + points[j].vx;
                     let yj = points[j].y + points[j].vy;
                     let rj = self.radius[j];
@@ -57,9 +366,131 @@ impl Force for CollideForce {
                         points[i].vy += (dy * d) * rr;
                         points[j].vx -= (dx * d) * (1. - rr);
                         points[j].vy -= (dy * d) * (1. - rr);
+                        moved = moved
+                            .max((points[j].x + points[j].vx - grid.x[j]).abs())
+                            .max((points[j].y + points[j].vy - grid.y[j]).abs());
+                    }
+                }
+            }
+        }
+    }
+
+    fn scales_with_alpha(&self) -> bool {
+        false
+    }
+}
+
+impl StaticForce for CollideForceGrid {
+    type State = ();
+
+    fn prepare(&self, points: &mut Vec<Point>, alpha: f32) {
+        self.apply(points, alpha);
+    }
+
+    fn scales_with_alpha(&self) -> bool {
+        false
+    }
+}
+
+pub type CollideForce = CollideForceGrid;
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn collide_reference(
+        points: &mut Vec<Point>,
+        radius: &[f32],
+        strength: f32,
+        iterations: usize,
+    ) {
+        let n = points.len();
+        for _ in 0..iterations {
+            for i in 0..n {
+                let xi = points[i].x + points[i].vx;
+                let yi = points[i].y + points[i].vy;
+                let ri = radius[i];
+                for j in (i + 1)..n {
+                    let xj = points[j].x + points[j].vx;
+                    let yj = points[j].y + points[j].vy;
+                    let rj = radius[j];
+                    let dx = xi - xj;
+                    let dy = yi - yj;
+                    let r = ri + rj;
+                    let l2 = (dx * dx + dy * dy).max(MIN_DISTANCE);
+                    if l2 < r * r {
+                        let l = l2.sqrt();
+                        let d = (r - l) / l * strength;
+                        let rr = (rj * rj) / (ri * ri + rj * rj);
+                        points[i].vx += (dx * d) * rr;
+                        points[i].vy += (dy * d) * rr;
+                        points[j].vx -= (dx * d) * (1. - rr);
+                        points[j].vy -= (dy * d) * (1. - rr);
                     }
                 }
             }
         }
     }
+
+    #[test]
+    fn test_collide() {
+        let n = 45;
+        let mut points = (0..n)
+            .map(|i| Point::new((i % 9) as f32 * 4. + i as f32 * 0.05, (i / 9) as f32 * 4.))
+            .collect::<Vec<_>>();
+        let radius = (0..n).map(|i| 2. + (i % 3) as f32).collect::<Vec<_>>();
+        let mut expected = points.clone();
+        collide_reference(&mut expected, &radius, 0.7, 3);
+        CollideForceAllPair::new_with_radius(radius, 0.7, 3).apply(&mut points, 1.);
+        for (p, q) in points.iter().zip(expected.iter()) {
+            assert!((p.vx - q.vx).abs() < 1e-4);
+            assert!((p.vy - q.vy).abs() < 1e-4);
+        }
+    }
+
+    #[test]
+    fn test_collide_grid() {
+        let n = 300;
+        let mut points = (0..n)
+            .map(|i| {
+                let t = i as f32 * 2.399;
+                let r = 3. * (i as f32).sqrt();
+                Point::new(r * t.cos(), r * t.sin())
+            })
+            .collect::<Vec<_>>();
+        for i in 200..n {
+            points[i].x += 1000.;
+        }
+        let radius = (0..n).map(|i| 2. + (i % 4) as f32).collect::<Vec<_>>();
+        let mut expected = points.clone();
+        collide_reference(&mut expected, &radius, 0.7, 2);
+        CollideForceGrid::new_with_radius(radius, 0.7, 2).apply(&mut points, 1.);
+        for (p, q) in points.iter().zip(expected.iter()) {
+            assert_eq!(p.vx, q.vx);
+            assert_eq!(p.vy, q.vy);
+        }
+    }
+
+    #[test]
+    fn test_collide_grid_large_velocities() {
+        let n = 400;
+        let mut points = (0..n)
+            .map(|i| {
+                let t = i as f32 * 2.399;
+                let r = 1.5 * (i as f32).sqrt();
+                let mut point = Point::new(r * t.cos(), r * t.sin());
+                point.vx = ((i * 37 % 101) as f32 - 50.) * 0.8;
+                point.vy = ((i * 53 % 97) as f32 - 48.) * 0.8;
+                point
+            })
+            .collect::<Vec<_>>();
+        let radius = (0..n).map(|i| 1. + (i % 5) as f32).collect::<Vec<_>>();
+        let mut expected = points.clone();
+        collide_reference(&mut expected, &radius, 1., 4);
+        CollideForceGrid::new_with_radius(radius, 1., 4).apply(&mut points, 1.);
+        for (p, q) in points.iter().zip(expected.iter()) {
+            assert_eq!(p.vx, q.vx);
+            assert_eq!(p.vy, q.vy);
+        }
+    }
 }
@@ -1,4 +1,4 @@
-use crate::{Force, Point, MIN_DISTANCE};
+use crate::{Force, Point, StaticForce, MIN_DISTANCE};
 use petgraph::graph::{EdgeIndex, Graph, IndexType};
 use petgraph::EdgeType;
 use std::collections::HashMap;
@@ -44,8 +44,15 @@ impl Link {
     }
 }
 
+/// `incidence[u]` lists the links at node `u`, once per endpoint, so that
+/// nodes and links can be removed in time proportional to the degree.
+/// `derived[k]` tells whether the strength and the bias of link `k` were
+/// defaulted from the degrees of its endpoints, and so are updated when
+/// links are added or removed.
 pub struct LinkForce {
     links: Vec<Link>,
+    incidence: Vec<Vec<usize>>,
+    derived: Vec<(bool, bool)>,
 }
 
 impl LinkForce {
@@ -68,6 +75,7 @@ impl LinkForce {
             .enumerate()
             .map(|(i, u)| (u, i))
             .collect::<HashMap<_, _>>();
+        let mut derived = Vec::with_capacity(graph.edge_count());
         let links = graph
             .edge_indices()
             .map(|e| {
@@ -86,10 +94,139 @@ impl LinkForce {
                 let source_degree = graph.neighbors_undirected(u).count() as f32;
                 let target_degree = graph.neighbors_undirected(v).count() as f32;
                 let bias = source_degree / (source_degree + target_degree);
+                derived.push((argument.strength.is_none(), true));
                 Link::new(node_indices[&u], node_indices[&v], distance, strength, bias)
             })
             .collect();
-        LinkForce { links }
+        let mut force = LinkForce::new_with_node_count(graph.node_count(), links);
+        force.derived = derived;
+        force
+    }
+
+    /// Creates the force from `links`, whose strengths and biases are kept as
+    /// given. The nodes are `0..n` for the largest index `n - 1` in `links`.
+    pub fn new_with_links(links: Vec<Link>) -> LinkForce {
+        let node_count = links
+            .iter()
+            .map(|link| link.source_index.max(link.target_index) + 1)
+            .max()
+            .unwrap_or(0);
+        LinkForce::new_with_node_count(node_count, links)
+    }
+
+    /// Same as `new_with_links` on the nodes `0..node_count`, which may
+    /// include nodes without links.
+    pub fn new_with_node_count(node_count: usize, links: Vec<Link>) -> LinkForce {
+        let mut incidence = vec![vec![]; node_count];
+        for (k, link) in links.iter().enumerate() {
+            incidence[link.source_index].push(k);
+            incidence[link.target_index].push(k);
+        }
+        let derived = vec![(false, false); links.len()];
+        LinkForce {
+            links,
+            incidence,
+            derived,
+        }
+    }
+
+    pub fn add_node(&mut self) {
+        self.incidence.push(vec![]);
+    }
+
+    /// Removes node `i` and its links, moving the last node into its place
+    /// as `Graph::remove_node` does.
+    pub fn remove_node(&mut self, i: usize) {
+        while let Some(&k) = self.incidence[i].last() {
+            self.remove_link_at(k);
+        }
+        let last = self.incidence.len() - 1;
+        self.incidence.swap_remove(i);
+        if i < last {
+            for &k in &self.incidence[i] {
+                let link = &mut self.links[k];
+                if link.source_index == last {
+                    link.source_index = i;
+                }
+                if link.target_index == last {
+                    link.target_index = i;
+                }
+            }
+        }
+    }
+
+    /// Adds a link between nodes `source` and `target`. Missing arguments
+    /// default as in `new_with_accessor`. The defaulted strengths and biases
+    /// of the links at `source` and `target` are updated to the new degrees.
+    pub fn add_link(&mut self, source: usize, target: usize, argument: LinkArgument) {
+        let distance = argument.distance.unwrap_or(DEFAULT_DISTANCE);
+        let strength = argument.strength.unwrap_or(0.);
+        let k = self.links.len();
+        self.links
+            .push(Link::new(source, target, distance, strength, 0.5));
+        self.derived.push((argument.strength.is_none(), true));
+        self.incidence[source].push(k);
+        self.incidence[target].push(k);
+        self.update_derived(source);
+        self.update_derived(target);
+    }
+
+    /// Removes one link between `source` and `target` in either direction and
+    /// returns whether there was one.
+    pub fn remove_link(&mut self, source: usize, target: usize) -> bool {
+        let links = &self.links;
+        let found = self.incidence[source].iter().copied().find(|&k| {
+            let link = &links[k];
+            (link.source_index == source && link.target_index == target)
+                || (link.source_index == target && link.target_index == source)
+        });
+        if let Some(k) = found {
+            self.remove_link_at(k);
+            true
+        } else {
+            false
+        }
+    }
+
+    /// Removes link `k` and updates the defaulted strengths and biases of
+    /// the links at its endpoints.
+    fn remove_link_at(&mut self, k: usize) {
+        let (u, v) = (self.links[k].source_index, self.links[k].target_index);
+        for &w in &[u, v] {
+            let incidence = &mut self.incidence[w];
+            let p = incidence.iter().position(|&l| l == k).unwrap();
+            incidence.swap_remove(p);
+        }
+        let last = self.links.len() - 1;
+        self.links.swap_remove(k);
+        self.derived.swap_remove(k);
+        if k < last {
+            let (s, t) = (self.links[k].source_index, self.links[k].target_index);
+            for &w in &[s, t] {
+                let incidence = &mut self.incidence[w];
+                let p = incidence.iter().position(|&l| l == last).unwrap();
+                incidence[p] = k;
+            }
+        }
+        self.update_derived(u);
+        self.update_derived(v);
+    }
+
+    /// Recomputes the defaulted strengths and biases of the links at node
+    /// `u` from the current degrees.
+    fn update_derived(&mut self, u: usize) {
+        for &k in &self.incidence[u] {
+            let link = &mut self.links[k];
+            let source_degree = self.incidence[link.source_index].len() as f32;
+            let target_degree = self.incidence[link.target_index].len() as f32;
+            let (strength, bias) = self.derived[k];
+            if strength {
+                link.strength = 1. / source_degree.min(target_degree);
+            }
+            if bias {
+                link.bias = source_degree / (source_degree + target_degree);
+            }
+        }
     }
 }
 
@@ -117,6 +254,15 @@ impl Force for LinkForce {
     }
 }
 
+/// Runs as a separate pass: see `Simulation::step_with`.
+impl StaticForce for LinkForce {
+    type State = ();
+
+    fn prepare(&self, points: &mut Vec<Point>, alpha: f32) {
+        self.apply(points, alpha);
+    }
+}
+
 impl AsRef<dyn Force> for LinkForce {
     fn as_ref(&self) -> &(dyn Force + 'static) {
         self
@@ -133,11 +279,13 @@ pub fn default_strength_accessor<N, E, Ty: EdgeType, Ix: IndexType>(
     1. / (source_degree.min(target_degree)) as f32
 }
 
+pub const DEFAULT_DISTANCE: f32 = 30.;
+
 pub fn default_distance_accessor<N, E, Ty: EdgeType, Ix: IndexType>(
     _graph: &Graph<N, E, Ty, Ix>,
     _e: EdgeIndex<Ix>,
 ) -> f32 {
-    30.
+    DEFAULT_DISTANCE
 }
 
 // #[test]
@@ -154,3 +302,47 @@ pub fn default_distance_accessor<N, E, Ty: EdgeType, Ix: IndexType>(
 //     assert_eq!(points[1].vx, 2.5);
 //     assert_eq!(points[1].vy, 0.);
 // }
+
+#[test]
+fn test_link_force_update() {
+    let mut graph = Graph::new_undirected();
+    let nodes = (0..6).map(|_| graph.add_node(())).collect::<Vec<_>>();
+    for &(u, v) in &[(0, 1), (1, 2), (2, 3), (3, 4), (4, 5), (5, 0), (1, 4)] {
+        graph.add_edge(nodes[u], nodes[v], ());
+    }
+    let mut force = LinkForce::new(&graph);
+
+    let u = graph.add_node(());
+    graph.add_edge(u, nodes[2], ());
+    force.add_node();
+    force.add_link(u.index(), 2, LinkArgument::new());
+    graph.remove_node(nodes[1]);
+    force.remove_node(1);
+    graph.remove_edge(graph.find_edge(nodes[3], nodes[4]).unwrap());
+    assert!(force.remove_link(4, 3));
+    assert!(!force.remove_link(4, 3));
+
+    let key = |link: &Link| {
+        (
+            link.source_index.min(link.target_index),
+            link.source_index.max(link.target_index),
+        )
+    };
+    let mut actual = force.links.iter().collect::<Vec<_>>();
+    let expected_force = LinkForce::new(&graph);
+    let mut expected = expected_force.links.iter().collect::<Vec<_>>();
+    actual.sort_by_key(|link| key(link));
+    expected.sort_by_key(|link| key(link));
+    assert_eq!(actual.len(), expected.len());
+    for (a, b) in actual.iter().zip(&expected) {
+        assert_eq!(
+            (a.source_index, a.target_index, a.strength, a.bias),
+            (b.source_index, b.target_index, b.strength, b.bias)
+        );
+    }
+    for (u, incidence) in force.incidence.iter().enumerate() {
+        for &k in incidence {
+            assert!(key(&force.links[k]).0 == u || key(&force.links[k]).1 == u);
+        }
+    }
+}
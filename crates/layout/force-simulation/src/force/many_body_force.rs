@@ -1,7 +1,13 @@
-use crate::{Force, Point, MIN_DISTANCE};
+use crate::point_buffer::LANES;
+use crate::{Force, Point, PointBuffer, StaticForce, MIN_DISTANCE};
 use petgraph::graph::{Graph, IndexType, NodeIndex};
 use petgraph::EdgeType;
 use quadtree::{Element, NodeId, Quadtree, Rect};
+#[cfg(feature = "parallel")]
+use rayon::prelude::*;
+use std::cell::RefCell;
+use std::f32::INFINITY;
+use std::ops::{Add, AddAssign, Mul, Sub};
 
 #[derive(Copy, Clone, Debug)]
 struct Body {
@@ -22,38 +28,40 @@ impl Default for Body {
     }
 }
 
-fn accumulate(tree: &mut Quadtree<Body>, node_id: NodeId) {
-    let mut sum_weight = 0.;
-    let mut sum_strength = 0.;
-    let mut sum_x = 0.;
-    let mut sum_y = 0.;
-    for &(ref e, _) in tree.elements(node_id).iter() {
-        match **e {
-            Element::Leaf { x, y, n, value } => {
-                let strength = value * n as f32;
-                let weight = strength.abs();
-                sum_strength += strength;
-                sum_weight += weight;
-                sum_x += x * weight;
-                sum_y += y * weight;
-            }
-            Element::Node { node_id } => {
-                accumulate(tree, node_id);
-                let data = tree.data(node_id);
-                let strength = data.strength;
-                let weight = strength.abs();
-                sum_strength += strength;
-                sum_weight += weight;
-                sum_x += data.x * weight;
-                sum_y += data.y * weight;
+fn accumulate(tree: &mut Quadtree<Body>) {
+    for index in (0..tree.node_count()).rev() {
+        let node_id = NodeId::new(index);
+        let mut sum_weight = 0.;
+        let mut sum_strength = 0.;
+        let mut sum_x = 0.;
+        let mut sum_y = 0.;
+        for &(e, _) in tree.elements(node_id).iter() {
+            match e {
+                Element::Leaf { x, y, n, value } => {
+                    let strength = value * n as f32;
+                    let weight = strength.abs();
+                    sum_strength += strength;
+                    sum_weight += weight;
+                    sum_x += x * weight;
+                    sum_y += y * weight;
+                }
+                Element::Node { node_id } => {
+                    let data = tree.data(node_id);
+                    let strength = data.strength;
+                    let weight = strength.abs();
+                    sum_strength += strength;
+                    sum_weight += weight;
+                    sum_x += data.x * weight;
+                    sum_y += data.y * weight;
+                }
+                Element::Empty => {}
             }
-            Element::Empty => {}
         }
+        let data = tree.data_mut(node_id);
+        data.strength = sum_strength;
+        data.x = sum_x / sum_weight;
+        data.y = sum_y / sum_weight;
     }
-    let data = tree.data_mut(node_id);
-    data.strength = sum_strength;
-    data.x = sum_x / sum_weight;
-    data.y = sum_y / sum_weight;
 }
 
 fn apply_many_body(
@@ -63,8 +71,8 @@ fn apply_many_body(
     alpha: f32,
     theta2: f32,
 ) {
-    for &(ref e, _) in tree.elements(node_id).iter() {
-        match **e {
+    for &(e, _) in tree.elements(node_id).iter() {
+        match e {
             Element::Node { node_id } => {
                 let data = tree.data(node_id);
                 let rect = tree.rect(node_id);
@@ -93,8 +101,59 @@ fn apply_many_body(
     }
 }
 
+/// Quadtree of point charges with their aggregated strengths, for
+/// Barnes-Hut approximation of the many-body force. Shared with forces that
+/// keep one tree per subset of the points, such as the group forces.
+pub struct BarnesHutTree {
+    tree: Quadtree<Body>,
+}
+
+impl BarnesHutTree {
+    pub fn new() -> BarnesHutTree {
+        BarnesHutTree {
+            tree: Quadtree::new(Rect {
+                cx: 0.,
+                cy: 0.,
+                width: 0.,
+                height: 0.,
+            }),
+        }
+    }
+
+    /// Rebuilds the tree from `(x, y, strength)` triples, reusing its
+    /// storage.
+    pub fn rebuild<I: Iterator<Item = (f32, f32, f32)> + Clone>(&mut self, bodies: I) {
+        let (min_x, min_y, max_x, max_y) = bodies.clone().fold(
+            (INFINITY, INFINITY, -INFINITY, -INFINITY),
+            |(x0, y0, x1, y1), (x, y, _)| (x0.min(x), y0.min(y), x1.max(x), y1.max(y)),
+        );
+        let size = (max_x - min_x).max(max_y - min_y).max(0.);
+        let rect = Rect {
+            cx: (min_x + max_x) / 2.,
+            cy: (min_y + max_y) / 2.,
+            width: size,
+            height: size,
+        };
+        self.tree.rebuild(rect, bodies);
+        accumulate(&mut self.tree);
+    }
+
+    /// Adds the force of the bodies in the tree on `point` to its velocity.
+    /// Only `point` is written, so points may be processed concurrently.
+    pub fn apply(&self, point: &mut Point, alpha: f32) {
+        apply_many_body(point, &self.tree, self.tree.root(), alpha, 0.81);
+    }
+}
+
+impl Default for BarnesHutTree {
+    fn default() -> BarnesHutTree {
+        BarnesHutTree::new()
+    }
+}
+
 pub struct ManyBodyForceBarnesHut {
     strength: Vec<f32>,
+    tree: RefCell<BarnesHutTree>,
 }
 
 impl ManyBodyForceBarnesHut {
@@ -124,38 +183,126 @@ impl ManyBodyForceBarnesHut {
                 }
             })
             .collect();
-        ManyBodyForce { strength }
+        ManyBodyForceBarnesHut::new_with_strength(strength)
+    }
+
+    pub fn new_with_strength(strength: Vec<f32>) -> ManyBodyForceBarnesHut {
+        let tree = RefCell::new(BarnesHutTree::new());
+        ManyBodyForceBarnesHut { strength, tree }
+    }
+
+    pub fn add_node(&mut self, strength: f32) {
+        self.strength.push(strength);
+    }
+
+    /// Removes node `i`, moving the last node into its place.
+    pub fn remove_node(&mut self, i: usize) {
+        self.strength.swap_remove(i);
     }
 }
 
 impl Force for ManyBodyForceBarnesHut {
     fn apply(&self, points: &mut Vec<Point>, alpha: f32) {
-        let max_x = points.iter().fold(0.0 / 0.0, |m, v| v.x.max(m));
-        let min_x = points.iter().fold(0.0 / 0.0, |m, v| v.x.min(m));
-        let max_y = points.iter().fold(0.0 / 0.0, |m, v| v.y.max(m));
-        let min_y = points.iter().fold(0.0 / 0.0, |m, v| v.y.min(m));
-        let width = max_x - min_x;
-        let height = max_y - min_y;
-        let size = width.max(height);
-        let mut tree: Quadtree<Body> = Quadtree::new(Rect {
-            cx: (min_x + max_x) / 2.,
-            cy: (min_y + max_y) / 2.,
-            width: size,
-            height: size,
-        });
-        let root = tree.root();
-        for (point, &strength) in points.iter().zip(&self.strength) {
-            tree.insert(root, point.x, point.y, strength);
+        let mut tree = self.tree.borrow_mut();
+        tree.rebuild(
+            points
+                .iter()
+                .zip(&self.strength)
+                .map(|(point, &strength)| (point.x, point.y, strength)),
+        );
+        let tree = &*tree;
+        // The tree holds its own copy of the positions, so every traversal
+        // only writes the velocity of its own point and can run concurrently.
+        #[cfg(feature = "parallel")]
+        let iter = points.par_iter_mut();
+        #[cfg(not(feature = "parallel"))]
+        let iter = points.iter_mut();
+        iter.for_each(|point| tree.apply(point, alpha));
+    }
+}
+
+impl StaticForce for ManyBodyForceBarnesHut {
+    type State = ();
+
+    fn prepare(&self, points: &mut Vec<Point>, alpha: f32) {
+        self.apply(points, alpha);
+    }
+}
+
+#[inline(always)]
+fn all_pair_kernel(
+    x: &[f32],
+    y: &[f32],
+    strength: &[f32],
+    alpha: f32,
+    vx: &mut [f32],
+    vy: &mut [f32],
+) {
+    let n = x.len();
+    let m = n - n % LANES;
+    for i in 0..n {
+        let xi = x[i];
+        let yi = y[i];
+        // The i == j term has dx == dy == 0 and contributes nothing, so the
+        // inner loop needs no branch and maps onto SIMD lanes directly.
+        let mut ax = [0.; LANES];
+        let mut ay = [0.; LANES];
+        for ((xs, ys), ss) in x[..m]
+            .chunks_exact(LANES)
+            .zip(y[..m].chunks_exact(LANES))
+            .zip(strength[..m].chunks_exact(LANES))
+        {
+            for k in 0..LANES {
+                let dx = xs[k] - xi;
+                let dy = ys[k] - yi;
+                let l = (dx * dx + dy * dy).max(MIN_DISTANCE);
+                let w = ss[k] * alpha / l;
+                ax[k] += dx * w;
+                ay[k] += dy * w;
+            }
         }
-        accumulate(&mut tree, root);
-        for mut point in points.iter_mut() {
-            apply_many_body(&mut point, &tree, root, alpha, 0.81);
+        let mut dvx = ax.iter().sum::<f32>();
+        let mut dvy = ay.iter().sum::<f32>();
+        for j in m..n {
+            let dx = x[j] - xi;
+            let dy = y[j] - yi;
+            let l = (dx * dx + dy * dy).max(MIN_DISTANCE);
+            let w = strength[j] * alpha / l;
+            dvx += dx * w;
+            dvy += dy * w;
         }
+        vx[i] += dvx;
+        vy[i] += dvy;
     }
 }
 
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+#[target_feature(enable = "avx2")]
+unsafe fn all_pair_kernel_avx2(
+    x: &[f32],
+    y: &[f32],
+    strength: &[f32],
+    alpha: f32,
+    vx: &mut [f32],
+    vy: &mut [f32],
+) {
+    all_pair_kernel(x, y, strength, alpha, vx, vy)
+}
+
+fn apply_all_pair(buffer: &mut PointBuffer, strength: &[f32], alpha: f32) {
+    let PointBuffer { x, y, vx, vy } = buffer;
+    #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+    {
+        if is_x86_feature_detected!("avx2") {
+            return unsafe { all_pair_kernel_avx2(x, y, strength, alpha, vx, vy) };
+        }
+    }
+    all_pair_kernel(x, y, strength, alpha, vx, vy)
+}
+
 pub struct ManyBodyForceAllPair {
     strength: Vec<f32>,
+    buffer: RefCell<PointBuffer>,
 }
 
 impl ManyBodyForceAllPair {
@@ -185,54 +332,942 @@ impl ManyBodyForceAllPair {
                 }
             })
             .collect();
-        ManyBodyForceAllPair { strength }
+        ManyBodyForceAllPair::new_with_strength(strength)
+    }
+
+    pub fn new_with_strength(strength: Vec<f32>) -> ManyBodyForceAllPair {
+        let buffer = RefCell::new(PointBuffer::new());
+        ManyBodyForceAllPair { strength, buffer }
+    }
+
+    pub fn add_node(&mut self, strength: f32) {
+        self.strength.push(strength);
+    }
+
+    /// Removes node `i`, moving the last node into its place.
+    pub fn remove_node(&mut self, i: usize) {
+        self.strength.swap_remove(i);
     }
 }
 
 impl Force for ManyBodyForceAllPair {
     fn apply(&self, points: &mut Vec<Point>, alpha: f32) {
+        let mut buffer = self.buffer.borrow_mut();
+        buffer.load(points);
+        apply_all_pair(&mut buffer, &self.strength, alpha);
+        buffer.store_velocity(points);
+    }
+}
+
+impl StaticForce for ManyBodyForceAllPair {
+    type State = ();
+
+    fn prepare(&self, points: &mut Vec<Point>, alpha: f32) {
+        self.apply(points, alpha);
+    }
+}
+
+const MULTIPOLE_MAX_ORDER: usize = 20;
+const MULTIPOLE_LEAF_SIZE: usize = 16;
+const MULTIPOLE_MAX_DEPTH: usize = 10;
+
+#[derive(Copy, Clone, Debug, Default)]
+struct Complex {
+    re: f64,
+    im: f64,
+}
+
+impl Complex {
+    fn new(re: f64, im: f64) -> Complex {
+        Complex { re, im }
+    }
+
+    fn inv(self) -> Complex {
+        let d = self.re * self.re + self.im * self.im;
+        Complex::new(self.re / d, -self.im / d)
+    }
+}
+
+impl Add for Complex {
+    type Output = Complex;
+
+    fn add(self, other: Complex) -> Complex {
+        Complex::new(self.re + other.re, self.im + other.im)
+    }
+}
+
+impl AddAssign for Complex {
+    fn add_assign(&mut self, other: Complex) {
+        self.re += other.re;
+        self.im += other.im;
+    }
+}
+
+impl Sub for Complex {
+    type Output = Complex;
+
+    fn sub(self, other: Complex) -> Complex {
+        Complex::new(self.re - other.re, self.im - other.im)
+    }
+}
+
+impl Mul for Complex {
+    type Output = Complex;
+
+    fn mul(self, other: Complex) -> Complex {
+        Complex::new(
+            self.re * other.re - self.im * other.im,
+            self.re * other.im + self.im * other.re,
+        )
+    }
+}
+
+impl Mul<f64> for Complex {
+    type Output = Complex;
+
+    fn mul(self, s: f64) -> Complex {
+        Complex::new(self.re * s, self.im * s)
+    }
+}
+
+type Coefficients = [Complex; MULTIPOLE_MAX_ORDER + 1];
+
+fn powers(z: Complex, p: usize) -> Coefficients {
+    let mut result = [Complex::default(); MULTIPOLE_MAX_ORDER + 1];
+    result[0] = Complex::new(1., 0.);
+    for k in 1..=p {
+        result[k] = result[k - 1] * z;
+    }
+    result
+}
+
+/// Cells of a uniform quadtree over the bounding square of the points, level
+/// by level in row-major order, with the multipole and local expansions of
+/// the potential `sum q log(z - z_j)` truncated after `order` terms.
+#[derive(Default)]
+struct Expansions {
+    order: usize,
+    binomial: Vec<f64>,
+    depth: usize,
+    x0: f64,
+    y0: f64,
+    size: f64,
+    level_offset: Vec<usize>,
+    count: Vec<u32>,
+    multipole: Vec<Complex>,
+    local: Vec<Complex>,
+    leaf: Vec<u32>,
+    leaf_start: Vec<u32>,
+    cursor: Vec<u32>,
+    sorted: Vec<u32>,
+    x: Vec<f32>,
+    y: Vec<f32>,
+    q: Vec<f32>,
+    dv: Vec<(f32, f32)>,
+}
+
+impl Expansions {
+    fn set_order(&mut self, order: usize) {
+        if self.order == order {
+            return;
+        }
+        let m = 2 * order + 1;
+        self.order = order;
+        self.binomial.clear();
+        self.binomial.resize(m * m, 0.);
+        for n in 0..m {
+            self.binomial[n * m] = 1.;
+            for k in 1..=n {
+                self.binomial[n * m + k] =
+                    self.binomial[(n - 1) * m + k - 1] + self.binomial[(n - 1) * m + k];
+            }
+        }
+    }
+
+    fn center(&self, level: usize, i: usize, j: usize) -> Complex {
+        let w = self.size / (1 << level) as f64;
+        Complex::new(
+            self.x0 + (j as f64 + 0.5) * w,
+            self.y0 + (i as f64 + 0.5) * w,
+        )
+    }
+
+    fn build(&mut self, points: &[Point], strength: &[f32]) {
         let n = points.len();
-        for i in 0..n {
-            for j in 0..n {
-                if i == j {
-                    continue;
+        let p = self.order;
+        let mut min_x = INFINITY;
+        let mut max_x = -INFINITY;
+        let mut min_y = INFINITY;
+        let mut max_y = -INFINITY;
+        for point in points {
+            min_x = min_x.min(point.x);
+            max_x = max_x.max(point.x);
+            min_y = min_y.min(point.y);
+            max_y = max_y.max(point.y);
+        }
+        let size = (max_x - min_x).max(max_y - min_y) as f64;
+        self.x0 = min_x as f64;
+        self.y0 = min_y as f64;
+        self.size = if size > 0. { size } else { 1. };
+
+        let mut depth = 0;
+        while depth < MULTIPOLE_MAX_DEPTH && (MULTIPOLE_LEAF_SIZE << (2 * depth)) < n {
+            depth += 1;
+        }
+        self.depth = depth;
+        self.level_offset.clear();
+        self.level_offset.push(0);
+        for l in 0..=depth {
+            let offset = self.level_offset[l] + (1 << (2 * l));
+            self.level_offset.push(offset);
+        }
+        let cells = self.level_offset[depth + 1];
+        self.count.clear();
+        self.count.resize(cells, 0);
+        self.multipole.clear();
+        self.multipole.resize(cells * (p + 1), Complex::default());
+        self.local.clear();
+        self.local.resize(cells * (p + 1), Complex::default());
+
+        let side = 1 << depth;
+        let scale = side as f64 / self.size;
+        let offset = self.level_offset[depth];
+        self.leaf.clear();
+        for point in points {
+            let j = (((point.x as f64 - self.x0) * scale) as usize).min(side - 1);
+            let i = (((point.y as f64 - self.y0) * scale) as usize).min(side - 1);
+            let c = i * side + j;
+            self.leaf.push(c as u32);
+            self.count[offset + c] += 1;
+        }
+        self.leaf_start.clear();
+        self.leaf_start.push(0);
+        for c in 0..side * side {
+            let start = self.leaf_start[c] + self.count[offset + c];
+            self.leaf_start.push(start);
+        }
+        self.cursor.clear();
+        self.cursor
+            .extend_from_slice(&self.leaf_start[..side * side]);
+        self.sorted.clear();
+        self.sorted.resize(n, 0);
+        for (i, &c) in self.leaf.iter().enumerate() {
+            let cursor = &mut self.cursor[c as usize];
+            self.sorted[*cursor as usize] = i as u32;
+            *cursor += 1;
+        }
+        self.x.clear();
+        self.y.clear();
+        self.q.clear();
+        for &i in &self.sorted {
+            let i = i as usize;
+            self.x.push(points[i].x);
+            self.y.push(points[i].y);
+            self.q.push(strength[i]);
+        }
+    }
+
+    fn upward(&mut self) {
+        let p = self.order;
+        let m = 2 * p + 1;
+        let depth = self.depth;
+        let side = 1 << depth;
+        let offset = self.level_offset[depth];
+        for c in 0..side * side {
+            let start = self.leaf_start[c] as usize;
+            let end = self.leaf_start[c + 1] as usize;
+            if start == end {
+                continue;
+            }
+            let center = self.center(depth, c / side, c % side);
+            let a = &mut self.multipole[(offset + c) * (p + 1)..(offset + c + 1) * (p + 1)];
+            for s in start..end {
+                let q = self.q[s] as f64;
+                let w = Complex::new(self.x[s] as f64, self.y[s] as f64) - center;
+                a[0].re += q;
+                let mut wk = w;
+                for k in 1..=p {
+                    a[k] += wk * (-q / k as f64);
+                    wk = wk * w;
+                }
+            }
+        }
+        for l in (0..depth).rev() {
+            let side = 1 << l;
+            for c in 0..side * side {
+                let (i, j) = (c / side, c % side);
+                let parent = self.level_offset[l] + c;
+                let center = self.center(l, i, j);
+                let mut b = [Complex::default(); MULTIPOLE_MAX_ORDER + 1];
+                for (ci, cj) in [(0, 0), (0, 1), (1, 0), (1, 1)].iter() {
+                    let (ci, cj) = (2 * i + ci, 2 * j + cj);
+                    let child = self.level_offset[l + 1] + ci * 2 * side + cj;
+                    if self.count[child] == 0 {
+                        continue;
+                    }
+                    self.count[parent] += self.count[child];
+                    let a = &self.multipole[child * (p + 1)..(child + 1) * (p + 1)];
+                    let t = powers(self.center(l + 1, ci, cj) - center, p);
+                    b[0] += a[0];
+                    for n in 1..=p {
+                        let mut s = t[n] * (-a[0].re / n as f64);
+                        for k in 1..=n {
+                            s += a[k] * t[n - k] * self.binomial[(n - 1) * m + k - 1];
+                        }
+                        b[n] += s;
+                    }
+                }
+                self.multipole[parent * (p + 1)..(parent + 1) * (p + 1)]
+                    .copy_from_slice(&b[..p + 1]);
+            }
+        }
+    }
+
+    fn downward(&mut self) {
+        let p = self.order;
+        for l in 2..=self.depth {
+            let side = 1 << l;
+            let offset = self.level_offset[l];
+            let mut local = std::mem::replace(&mut self.local, vec![]);
+            {
+                let (upper, current) = local.split_at_mut(offset * (p + 1));
+                let current = &mut current[..side * side * (p + 1)];
+                let this = &*self;
+                let f = |(c, b): (usize, &mut [Complex])| {
+                    if this.count[offset + c] > 0 {
+                        this.downward_cell(upper, l, c, b);
+                    }
+                };
+                #[cfg(feature = "parallel")]
+                current.par_chunks_mut(p + 1).enumerate().for_each(f);
+                #[cfg(not(feature = "parallel"))]
+                current.chunks_mut(p + 1).enumerate().for_each(f);
+            }
+            self.local = local;
+        }
+    }
+
+    /// Local expansion of cell `c` at level `l`: the parent's local expansion
+    /// shifted to the cell center plus the multipole expansions of the
+    /// children of the parent's neighbors that are not adjacent to the cell.
+    fn downward_cell(&self, upper: &[Complex], l: usize, c: usize, b: &mut [Complex]) {
+        let p = self.order;
+        let m = 2 * p + 1;
+        let side = 1 << l;
+        let (i, j) = (c / side, c % side);
+        let center = self.center(l, i, j);
+        if l > 2 {
+            let parent = self.level_offset[l - 1] + (i / 2) * (side / 2) + j / 2;
+            let a = &upper[parent * (p + 1)..(parent + 1) * (p + 1)];
+            let t = powers(center - self.center(l - 1, i / 2, j / 2), p);
+            for n in 1..=p {
+                let mut s = Complex::default();
+                for k in n..=p {
+                    s += a[k] * t[k - n] * self.binomial[k * m + n];
                 }
-                let Point { x, y, .. } = points[j];
-                let ref mut point = points[i];
-                let dx = x - point.x;
-                let dy = y - point.y;
+                b[n] += s;
+            }
+        }
+        let parent_side = side / 2;
+        let (pi, pj) = (i / 2, j / 2);
+        for si in pi.saturating_sub(1)..=(pi + 1).min(parent_side - 1) {
+            for sj in pj.saturating_sub(1)..=(pj + 1).min(parent_side - 1) {
+                for (ci, cj) in [(0, 0), (0, 1), (1, 0), (1, 1)].iter() {
+                    let (ci, cj) = (2 * si + ci, 2 * sj + cj);
+                    if (ci as isize - i as isize).abs() <= 1
+                        && (cj as isize - j as isize).abs() <= 1
+                    {
+                        continue;
+                    }
+                    let source = self.level_offset[l] + ci * side + cj;
+                    if self.count[source] == 0 {
+                        continue;
+                    }
+                    let a = &self.multipole[source * (p + 1)..(source + 1) * (p + 1)];
+                    let inv_t = powers((self.center(l, ci, cj) - center).inv(), p);
+                    let mut a_t = [Complex::default(); MULTIPOLE_MAX_ORDER + 1];
+                    for k in 1..=p {
+                        let sign = if k % 2 == 0 { 1. } else { -1. };
+                        a_t[k] = a[k] * inv_t[k] * sign;
+                    }
+                    for n in 1..=p {
+                        let mut s = Complex::new(-a[0].re / n as f64, 0.);
+                        for k in 1..=p {
+                            s += a_t[k] * self.binomial[(n + k - 1) * m + k - 1];
+                        }
+                        b[n] += s * inv_t[n];
+                    }
+                }
+            }
+        }
+    }
+
+    /// Far field from the local expansion of the leaf plus direct
+    /// interactions with the points of the adjacent leaves.
+    fn evaluate(&self, s: usize, alpha: f32) -> (f32, f32) {
+        let p = self.order;
+        let depth = self.depth;
+        let side = 1 << depth;
+        let c = self.leaf[self.sorted[s] as usize] as usize;
+        let (i, j) = (c / side, c % side);
+        let x = self.x[s];
+        let y = self.y[s];
+
+        let b = &self.local[(self.level_offset[depth] + c) * (p + 1)..];
+        let w = Complex::new(x as f64, y as f64) - self.center(depth, i, j);
+        let mut d = Complex::default();
+        for k in (1..=p).rev() {
+            d = d * w + b[k] * k as f64;
+        }
+        let mut dvx = (-d.re * alpha as f64) as f32;
+        let mut dvy = (d.im * alpha as f64) as f32;
+
+        for ni in i.saturating_sub(1)..=(i + 1).min(side - 1) {
+            let start = self.leaf_start[ni * side + j.saturating_sub(1)] as usize;
+            let end = self.leaf_start[ni * side + (j + 1).min(side - 1) + 1] as usize;
+            for t in start..end {
+                let dx = self.x[t] - x;
+                let dy = self.y[t] - y;
                 let l = (dx * dx + dy * dy).max(MIN_DISTANCE);
-                point.vx += dx * self.strength[j] * alpha / l;
-                point.vy += dy * self.strength[j] * alpha / l;
+                let w = self.q[t] * alpha / l;
+                dvx += dx * w;
+                dvy += dy * w;
+            }
+        }
+        (dvx, dvy)
+    }
+}
+
+/// Many-body force evaluated with the fast multipole method of Greengard and
+/// Rokhlin on a uniform quadtree.
+///
+/// The depth of the tree depends only on the number of points, so a step
+/// takes O(n) time only while the points are spread evenly over their
+/// bounding square. On clustered input most points share a few leaves and
+/// the direct interactions between adjacent leaves approach O(n²).
+///
+/// The scratch space is kept between calls and only grows, and
+/// `set_strength` replaces the strengths in place, so one instance can be
+/// reused for graphs of different sizes as in multilevel layouts.
+pub struct ManyBodyForceMultipole {
+    strength: Vec<f32>,
+    expansions: RefCell<Expansions>,
+}
+
+impl ManyBodyForceMultipole {
+    pub fn new<N, E, Ty: EdgeType, Ix: IndexType>(
+        graph: &Graph<N, E, Ty, Ix>,
+    ) -> ManyBodyForceMultipole {
+        ManyBodyForceMultipole::new_with_accessor(graph, |_, _| None)
+    }
+
+    pub fn new_with_accessor<
+        N,
+        E,
+        Ty: EdgeType,
+        Ix: IndexType,
+        F: FnMut(&Graph<N, E, Ty, Ix>, NodeIndex<Ix>) -> Option<f32>,
+    >(
+        graph: &Graph<N, E, Ty, Ix>,
+        mut strength_accessor: F,
+    ) -> ManyBodyForceMultipole {
+        let strength = graph
+            .node_indices()
+            .map(|u| {
+                if let Some(v) = strength_accessor(graph, u) {
+                    v
+                } else {
+                    default_strength_accessor(graph, u)
+                }
+            })
+            .collect();
+        ManyBodyForceMultipole::new_with_strength(strength)
+    }
+
+    pub fn new_with_strength(strength: Vec<f32>) -> ManyBodyForceMultipole {
+        ManyBodyForceMultipole::new_with_order(strength, 8)
+    }
+
+    /// `order` is the number of expansion terms, at most 20. The error
+    /// decreases roughly by half with each term.
+    pub fn new_with_order(strength: Vec<f32>, order: usize) -> ManyBodyForceMultipole {
+        let mut expansions = Expansions::default();
+        expansions.set_order(order.max(1).min(MULTIPOLE_MAX_ORDER));
+        ManyBodyForceMultipole {
+            strength,
+            expansions: RefCell::new(expansions),
+        }
+    }
+
+    pub fn set_strength(&mut self, strength: &[f32]) {
+        self.strength.clear();
+        self.strength.extend_from_slice(strength);
+    }
+
+    pub fn add_node(&mut self, strength: f32) {
+        self.strength.push(strength);
+    }
+
+    /// Removes node `i`, moving the last node into its place.
+    pub fn remove_node(&mut self, i: usize) {
+        self.strength.swap_remove(i);
+    }
+}
+
+impl Force for ManyBodyForceMultipole {
+    fn apply(&self, points: &mut Vec<Point>, alpha: f32) {
+        if points.is_empty() {
+            return;
+        }
+        let mut expansions = self.expansions.borrow_mut();
+        expansions.build(points, &self.strength);
+        expansions.upward();
+        expansions.downward();
+        let mut dv = std::mem::replace(&mut expansions.dv, vec![]);
+        dv.clear();
+        dv.resize(points.len(), (0., 0.));
+        {
+            let expansions = &*expansions;
+            #[cfg(feature = "parallel")]
+            let iter = dv.par_iter_mut();
+            #[cfg(not(feature = "parallel"))]
+            let iter = dv.iter_mut();
+            iter.enumerate()
+                .for_each(|(s, dv)| *dv = expansions.evaluate(s, alpha));
+        }
+        for (&i, &(dvx, dvy)) in expansions.sorted.iter().zip(&dv) {
+            let point = &mut points[i as usize];
+            point.vx += dvx;
+            point.vy += dvy;
+        }
+        expansions.dv = dv;
+    }
+}
+
+impl StaticForce for ManyBodyForceMultipole {
+    type State = ();
+
+    fn prepare(&self, points: &mut Vec<Point>, alpha: f32) {
+        self.apply(points, alpha);
+    }
+}
+
+const GRID_MAX_LEVEL: usize = 10;
+const GRID_POINTS_PER_CELL: usize = 8;
+
+/// Aggregate of the points in a grid cell: the total strength, and the
+/// `|strength|`-weighted coordinate sums from which the center is taken.
+#[derive(Copy, Clone, Debug, Default)]
+struct GridCell {
+    strength: f32,
+    weight: f32,
+    x: f32,
+    y: f32,
+}
+
+impl GridCell {
+    fn merge(self, other: GridCell) -> GridCell {
+        GridCell {
+            strength: self.strength + other.strength,
+            weight: self.weight + other.weight,
+            x: self.x + other.x,
+            y: self.y + other.y,
+        }
+    }
+}
+
+/// Pyramid of dense grids over the bounding square, level `l` having
+/// `2^l x 2^l` cells, with the points bucketed by their finest cell in CSR
+/// layout. Every pass is a flat loop over points or cells.
+#[derive(Default)]
+struct MultilevelGrid {
+    level: usize,
+    x0: f32,
+    y0: f32,
+    size: f32,
+    point_cell: Vec<usize>,
+    bucket_start: Vec<usize>,
+    bucket_points: Vec<usize>,
+    bucket_next: Vec<usize>,
+    cells: Vec<Vec<GridCell>>,
+}
+
+impl MultilevelGrid {
+    fn build(&mut self, points: &[Point], strength: &[f32]) {
+        let n = points.len();
+        let (x0, y0, x1, y1) = points.iter().fold(
+            (INFINITY, INFINITY, -INFINITY, -INFINITY),
+            |(x0, y0, x1, y1), p| (x0.min(p.x), y0.min(p.y), x1.max(p.x), y1.max(p.y)),
+        );
+        let mut level = 1;
+        while level < GRID_MAX_LEVEL && GRID_POINTS_PER_CELL << (2 * level) < n {
+            level += 1;
+        }
+        let side = 1 << level;
+        self.level = level;
+        self.x0 = x0;
+        self.y0 = y0;
+        self.size = (x1 - x0).max(y1 - y0).max(MIN_DISTANCE);
+
+        self.point_cell.clear();
+        for p in points {
+            let (cx, cy) = self.cell(p.x, p.y, level);
+            self.point_cell.push(cy * side + cx);
+        }
+        self.bucket_start.clear();
+        self.bucket_start.resize(side * side + 1, 0);
+        for &c in &self.point_cell {
+            self.bucket_start[c + 1] += 1;
+        }
+        for c in 0..side * side {
+            self.bucket_start[c + 1] += self.bucket_start[c];
+        }
+        self.bucket_points.clear();
+        self.bucket_points.resize(n, 0);
+        self.bucket_next.clear();
+        self.bucket_next
+            .extend_from_slice(&self.bucket_start[..side * side]);
+        for (i, &c) in self.point_cell.iter().enumerate() {
+            self.bucket_points[self.bucket_next[c]] = i;
+            self.bucket_next[c] += 1;
+        }
+
+        self.cells.resize_with(level + 1, Vec::new);
+        for l in 0..=level {
+            self.cells[l].clear();
+            self.cells[l].resize(1 << (2 * l), GridCell::default());
+        }
+        for (i, &c) in self.point_cell.iter().enumerate() {
+            let weight = strength[i].abs();
+            let cell = &mut self.cells[level][c];
+            cell.strength += strength[i];
+            cell.weight += weight;
+            cell.x += weight * points[i].x;
+            cell.y += weight * points[i].y;
+        }
+        for l in (0..level).rev() {
+            let (coarse, fine) = self.cells.split_at_mut(l + 1);
+            let (coarse, fine) = (&mut coarse[l], &fine[0]);
+            let side = 1 << l;
+            for cy in 0..side {
+                for cx in 0..side {
+                    let c = |dx, dy| fine[(2 * cy + dy) * 2 * side + 2 * cx + dx];
+                    coarse[cy * side + cx] = c(0, 0).merge(c(1, 0)).merge(c(0, 1)).merge(c(1, 1));
+                }
             }
         }
     }
+
+    fn cell(&self, x: f32, y: f32, level: usize) -> (usize, usize) {
+        let side = 1 << level;
+        let scale = side as f32 / self.size;
+        let cx = (((x - self.x0) * scale) as usize).min(side - 1);
+        let cy = (((y - self.y0) * scale) as usize).min(side - 1);
+        (cx, cy)
+    }
+
+    /// Velocity change of point `i`: exact for the points in the 3x3 cells
+    /// around it on the finest level, and from cell aggregates for the
+    /// interaction list of each coarser level, the children of the parent's
+    /// neighbours that are not neighbours themselves.
+    fn gather(&self, i: usize, points: &[Point], strength: &[f32], alpha: f32) -> (f32, f32) {
+        let Point { x, y, .. } = points[i];
+        let level = self.level;
+        let side = 1 << level;
+        let c = self.point_cell[i];
+        let (cx, cy) = (c % side, c / side);
+        let mut dvx = 0.;
+        let mut dvy = 0.;
+        for ny in cy.saturating_sub(1)..(cy + 2).min(side) {
+            for nx in cx.saturating_sub(1)..(cx + 2).min(side) {
+                let b = ny * side + nx;
+                for &j in &self.bucket_points[self.bucket_start[b]..self.bucket_start[b + 1]] {
+                    if j == i {
+                        continue;
+                    }
+                    let dx = points[j].x - x;
+                    let dy = points[j].y - y;
+                    let l = (dx * dx + dy * dy).max(MIN_DISTANCE);
+                    dvx += dx * strength[j] * alpha / l;
+                    dvy += dy * strength[j] * alpha / l;
+                }
+            }
+        }
+        for l in 2..=level {
+            let side = 1 << l;
+            let (lx, ly) = (cx >> (level - l), cy >> (level - l));
+            let (px, py) = (lx / 2, ly / 2);
+            for ny in (2 * py).saturating_sub(2)..(2 * py + 4).min(side) {
+                for nx in (2 * px).saturating_sub(2)..(2 * px + 4).min(side) {
+                    if nx + 1 >= lx && nx <= lx + 1 && ny + 1 >= ly && ny <= ly + 1 {
+                        continue;
+                    }
+                    let cell = self.cells[l][ny * side + nx];
+                    if cell.weight == 0. {
+                        continue;
+                    }
+                    let dx = cell.x / cell.weight - x;
+                    let dy = cell.y / cell.weight - y;
+                    let d = (dx * dx + dy * dy).max(MIN_DISTANCE);
+                    dvx += dx * cell.strength * alpha / d;
+                    dvy += dy * cell.strength * alpha / d;
+                }
+            }
+        }
+        (dvx, dvy)
+    }
+}
+
+/// Many-body force on a pyramid of uniform grids.
+///
+/// Nearby points interact exactly and distant ones through the aggregated
+/// cells of ever coarser grids, so each point visits at most 9 buckets and
+/// 27 cells per level. Unlike the pointer-chasing of a Barnes-Hut traversal
+/// the work per point is bounded and uniform, and every pass is a counting
+/// sort, a reduction over cells or an independent gather per point. It runs
+/// on the CPU: points gather their own velocity change in parallel with the
+/// `parallel` feature, and the grid and velocity buffers are reused across
+/// calls.
+pub struct ManyBodyForceGrid {
+    strength: Vec<f32>,
+    grid: RefCell<MultilevelGrid>,
+    dv: RefCell<Vec<(f32, f32)>>,
+}
+
+impl ManyBodyForceGrid {
+    pub fn new<N, E, Ty: EdgeType, Ix: IndexType>(
+        graph: &Graph<N, E, Ty, Ix>,
+    ) -> ManyBodyForceGrid {
+        ManyBodyForceGrid::new_with_accessor(graph, |_, _| None)
+    }
+
+    pub fn new_with_accessor<
+        N,
+        E,
+        Ty: EdgeType,
+        Ix: IndexType,
+        F: FnMut(&Graph<N, E, Ty, Ix>, NodeIndex<Ix>) -> Option<f32>,
+    >(
+        graph: &Graph<N, E, Ty, Ix>,
+        mut strength_accessor: F,
+    ) -> ManyBodyForceGrid {
+        let strength = graph
+            .node_indices()
+            .map(|u| {
+                if let Some(v) = strength_accessor(graph, u) {
+                    v
+                } else {
+                    default_strength_accessor(graph, u)
+                }
+            })
+            .collect();
+        ManyBodyForceGrid::new_with_strength(strength)
+    }
+
+    pub fn new_with_strength(strength: Vec<f32>) -> ManyBodyForceGrid {
+        ManyBodyForceGrid {
+            strength,
+            grid: RefCell::new(MultilevelGrid::default()),
+            dv: RefCell::new(vec![]),
+        }
+    }
+
+    pub fn add_node(&mut self, strength: f32) {
+        self.strength.push(strength);
+    }
+
+    /// Removes node `i`, moving the last node into its place.
+    pub fn remove_node(&mut self, i: usize) {
+        self.strength.swap_remove(i);
+    }
+}
+
+impl Force for ManyBodyForceGrid {
+    fn apply(&self, points: &mut Vec<Point>, alpha: f32) {
+        if points.is_empty() {
+            return;
+        }
+        let mut grid = self.grid.borrow_mut();
+        grid.build(points, &self.strength);
+        let grid = &*grid;
+        let strength = &self.strength;
+        let positions = &*points;
+        let mut dv = self.dv.borrow_mut();
+        dv.resize(positions.len(), (0., 0.));
+        #[cfg(feature = "parallel")]
+        dv.par_iter_mut()
+            .enumerate()
+            .for_each(|(i, d)| *d = grid.gather(i, positions, strength, alpha));
+        #[cfg(not(feature = "parallel"))]
+        for (i, d) in dv.iter_mut().enumerate() {
+            *d = grid.gather(i, positions, strength, alpha);
+        }
+        for (point, &(dvx, dvy)) in points.iter_mut().zip(dv.iter()) {
+            point.vx += dvx;
+            point.vy += dvy;
+        }
+    }
+}
+
+impl StaticForce for ManyBodyForceGrid {
+    type State = ();
+
+    fn prepare(&self, points: &mut Vec<Point>, alpha: f32) {
+        self.apply(points, alpha);
+    }
 }
 
 pub type ManyBodyForce = ManyBodyForceBarnesHut;
 
+pub const DEFAULT_STRENGTH: f32 = -30.;
+
 pub fn default_strength_accessor<N, E, Ty: EdgeType, Ix: IndexType>(
     _graph: &Graph<N, E, Ty, Ix>,
     _u: NodeIndex<Ix>,
 ) -> f32 {
-    -30.
-}
-
-// #[test]
-// fn test_many_body() {
-//     let mut points = Vec::new();
-//     points.push(Point::new(10., 10.));
-//     points.push(Point::new(10., -10.));
-//     points.push(Point::new(-10., 10.));
-//     points.push(Point::new(-10., -10.));
-//     let context = QuadTreeManyBodyForceContext::new(vec![-30., -30., -30., -30.]);
-//     context.apply(&mut points, 1.0);
-//     assert!(points[0].vx == 2.25);
-//     assert!(points[0].vy == 2.25);
-//     assert!(points[1].vx == 2.25);
-//     assert!(points[1].vy == -2.25);
-//     assert!(points[2].vx == -2.25);
-//     assert!(points[2].vy == 2.25);
-//     assert!(points[3].vx == -2.25);
-//     assert!(points[3].vy == -2.25);
-// }
+    DEFAULT_STRENGTH
+}
+
+#[test]
+fn test_many_body() {
+    let mut points = Vec::new();
+    points.push(Point::new(10., 10.));
+    points.push(Point::new(10., -10.));
+    points.push(Point::new(-10., 10.));
+    points.push(Point::new(-10., -10.));
+    let force = ManyBodyForceBarnesHut::new_with_strength(vec![-30., -30., -30., -30.]);
+    force.apply(&mut points, 1.0);
+    assert!(points[0].vx == 2.25);
+    assert!(points[0].vy == 2.25);
+    assert!(points[1].vx == 2.25);
+    assert!(points[1].vy == -2.25);
+    assert!(points[2].vx == -2.25);
+    assert!(points[2].vy == 2.25);
+    assert!(points[3].vx == -2.25);
+    assert!(points[3].vy == -2.25);
+}
+
+#[test]
+fn test_many_body_all_pair() {
+    let n = 37;
+    let mut points = (0..n)
+        .map(|i| Point::new((i % 7) as f32 * 10. + i as f32 * 0.1, (i / 7) as f32 * 10.))
+        .collect::<Vec<_>>();
+    let strength = (0..n).map(|i| -30. - i as f32).collect::<Vec<_>>();
+    let mut expected = points.clone();
+    for i in 0..n {
+        for j in 0..n {
+            if i == j {
+                continue;
+            }
+            let dx = expected[j].x - expected[i].x;
+            let dy = expected[j].y - expected[i].y;
+            let l = (dx * dx + dy * dy).max(MIN_DISTANCE);
+            expected[i].vx += dx * strength[j] * 0.5 / l;
+            expected[i].vy += dy * strength[j] * 0.5 / l;
+        }
+    }
+    ManyBodyForceAllPair::new_with_strength(strength).apply(&mut points, 0.5);
+    for (p, q) in points.iter().zip(expected.iter()) {
+        assert!((p.vx - q.vx).abs() < 1e-4);
+        assert!((p.vy - q.vy).abs() < 1e-4);
+    }
+}
+
+#[test]
+fn test_many_body_multipole() {
+    let mut seed = 1u32;
+    let mut random = || {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        seed as f32 / std::u32::MAX as f32 - 0.5
+    };
+    let n = 3000;
+    let mut points = (0..n)
+        .map(|i| {
+            let (cx, cy, r) = if i % 3 == 0 {
+                (0., 0., 1000.)
+            } else {
+                (300., -200., 50.)
+            };
+            let x = cx + r * random();
+            let y = cy + r * random();
+            Point::new(x, y)
+        })
+        .collect::<Vec<_>>();
+    points.push(points[0]);
+    let strength = (0..points.len())
+        .map(|i| -30. - (i % 5) as f32)
+        .collect::<Vec<_>>();
+    let mut expected = points.clone();
+    ManyBodyForceAllPair::new_with_strength(strength.clone()).apply(&mut expected, 0.5);
+    let scale = expected
+        .iter()
+        .map(|p| (p.vx * p.vx + p.vy * p.vy).sqrt())
+        .fold(0., f32::max);
+
+    let mut force = ManyBodyForceMultipole::new_with_strength(vec![]);
+    force.set_strength(&strength);
+    for _ in 0..2 {
+        let mut actual = points.clone();
+        force.apply(&mut actual, 0.5);
+        for (p, q) in actual.iter().zip(expected.iter()) {
+            assert!((p.vx - q.vx).abs() < 1e-3 * scale);
+            assert!((p.vy - q.vy).abs() < 1e-3 * scale);
+        }
+    }
+
+    let mut force = ManyBodyForceMultipole::new_with_strength(vec![-30.; 4]);
+    let mut points = vec![
+        Point::new(10., 10.),
+        Point::new(10., -10.),
+        Point::new(-10., 10.),
+        Point::new(-10., -10.),
+    ];
+    force.apply(&mut points, 1.0);
+    assert!((points[0].vx - 2.25).abs() < 1e-6);
+    assert!((points[3].vy + 2.25).abs() < 1e-6);
+    force.set_strength(&[]);
+    force.apply(&mut vec![], 1.0);
+}
+
+#[test]
+fn test_many_body_grid() {
+    let mut seed = 7u32;
+    let mut random = || {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        seed as f32 / std::u32::MAX as f32 - 0.5
+    };
+    let n = 4000;
+    let points = (0..n)
+        .map(|i| {
+            let r = if i % 4 == 0 { 1000. } else { 100. };
+            Point::new(r * random(), r * random())
+        })
+        .collect::<Vec<_>>();
+    let strength = (0..n).map(|i| -30. - (i % 5) as f32).collect::<Vec<_>>();
+    let mut expected = points.clone();
+    ManyBodyForceAllPair::new_with_strength(strength.clone()).apply(&mut expected, 0.5);
+    let mut actual = points.clone();
+    ManyBodyForceGrid::new_with_strength(strength).apply(&mut actual, 0.5);
+    let mut error = 0.;
+    let mut norm = 0.;
+    for (p, q) in actual.iter().zip(expected.iter()) {
+        error += ((p.vx - q.vx).powi(2) + (p.vy - q.vy).powi(2)).sqrt();
+        norm += (q.vx * q.vx + q.vy * q.vy).sqrt();
+    }
+    assert!(error < 0.05 * norm);
+
+    let mut points = vec![
+        Point::new(10., 10.),
+        Point::new(10., -10.),
+        Point::new(-10., 10.),
+        Point::new(-10., -10.),
+    ];
+    ManyBodyForceGrid::new_with_strength(vec![-30.; 4]).apply(&mut points, 1.0);
+    assert!((points[0].vx - 2.25).abs() < 1e-6);
+    assert!((points[3].vy + 2.25).abs() < 1e-6);
+}
@@ -6,8 +6,11 @@ pub mod position_force;
 pub mod radial_force;
 
 pub use self::center_force::CenterForce;
-pub use self::collide_force::CollideForce;
+pub use self::collide_force::{CollideForce, CollideForceAllPair, CollideForceGrid};
 pub use self::link_force::LinkForce;
-pub use self::many_body_force::ManyBodyForce;
+pub use self::many_body_force::{
+    BarnesHutTree, ManyBodyForce, ManyBodyForceAllPair, ManyBodyForceBarnesHut, ManyBodyForceGrid,
+    ManyBodyForceMultipole,
+};
 pub use self::position_force::PositionForce;
 pub use self::radial_force::RadialForce;
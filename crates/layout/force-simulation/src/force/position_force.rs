@@ -1,4 +1,4 @@
-use crate::{Force, Point};
+use crate::{Force, Point, StaticForce};
 use petgraph::graph::{Graph, IndexType, NodeIndex};
 use petgraph::EdgeType;
 
@@ -42,26 +42,52 @@ impl PositionForce {
         }
         PositionForce { strength, x, y }
     }
+
+    pub fn add_node(&mut self, argument: NodeArgument) {
+        self.strength
+            .push(argument.strength.unwrap_or(DEFAULT_STRENGTH));
+        self.x.push(argument.x);
+        self.y.push(argument.y);
+    }
+
+    /// Removes node `i`, moving the last node into its place.
+    pub fn remove_node(&mut self, i: usize) {
+        self.strength.swap_remove(i);
+        self.x.swap_remove(i);
+        self.y.swap_remove(i);
+    }
 }
 
 impl Force for PositionForce {
     fn apply(&self, points: &mut Vec<Point>, alpha: f32) {
-        for i in 0..points.len() {
-            let strength = self.strength[i];
-            let point = points.get_mut(i).unwrap();
-            if let Some(xi) = self.x[i] {
-                point.vx += (xi - point.x) * alpha * strength;
-            }
-            if let Some(yi) = self.y[i] {
-                point.vy += (yi - point.y) * alpha * strength;
-            }
+        for (i, point) in points.iter_mut().enumerate() {
+            self.apply_to_point(&(), i, point, alpha);
+        }
+    }
+}
+
+impl StaticForce for PositionForce {
+    type State = ();
+
+    fn prepare(&self, _points: &mut Vec<Point>, _alpha: f32) {}
+
+    #[inline]
+    fn apply_to_point(&self, _state: &(), i: usize, point: &mut Point, alpha: f32) {
+        let strength = self.strength[i];
+        if let Some(xi) = self.x[i] {
+            point.vx += (xi - point.x) * alpha * strength;
+        }
+        if let Some(yi) = self.y[i] {
+            point.vy += (yi - point.y) * alpha * strength;
         }
     }
 }
 
+pub const DEFAULT_STRENGTH: f32 = 0.1;
+
 pub fn default_strength_accessor<N, E, Ty: EdgeType, Ix: IndexType>(
     _graph: &Graph<N, E, Ty, Ix>,
     _u: NodeIndex<Ix>,
 ) -> f32 {
-    0.1
+    DEFAULT_STRENGTH
 }
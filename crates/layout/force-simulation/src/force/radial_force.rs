@@ -1,4 +1,4 @@
-use crate::{Force, Point, MIN_DISTANCE};
+use crate::{Force, Point, StaticForce, MIN_DISTANCE};
 use petgraph::graph::{Graph, IndexType, NodeIndex};
 use petgraph::EdgeType;
 
@@ -20,28 +20,49 @@ impl RadialForce {
         let params = graph.node_indices().map(|u| accessor(graph, u)).collect();
         RadialForce { params }
     }
+
+    /// `params` is `(strength, radius, x, y)`, or `None` to leave the node
+    /// free.
+    pub fn add_node(&mut self, params: Option<(f32, f32, f32, f32)>) {
+        self.params.push(params);
+    }
+
+    /// Removes node `i`, moving the last node into its place.
+    pub fn remove_node(&mut self, i: usize) {
+        self.params.swap_remove(i);
+    }
 }
 
 impl Force for RadialForce {
     fn apply(&self, points: &mut Vec<Point>, alpha: f32) {
-        for i in 0..points.len() {
-            if let Some((si, ri, xi, yi)) = self.params[i] {
-                let point = points.get_mut(i).unwrap();
-                let dx = if (point.x - xi).abs() < MIN_DISTANCE {
-                    MIN_DISTANCE
-                } else {
-                    point.x - xi
-                };
-                let dy = if (point.y - yi).abs() < MIN_DISTANCE {
-                    MIN_DISTANCE
-                } else {
-                    point.y - yi
-                };
-                let d = (dx * dx + dy * dy).sqrt();
-                let k = (ri - d) * si * alpha / d;
-                point.vx += dx * k;
-                point.vy += dy * k;
-            }
+        for (i, point) in points.iter_mut().enumerate() {
+            self.apply_to_point(&(), i, point, alpha);
+        }
+    }
+}
+
+impl StaticForce for RadialForce {
+    type State = ();
+
+    fn prepare(&self, _points: &mut Vec<Point>, _alpha: f32) {}
+
+    #[inline]
+    fn apply_to_point(&self, _state: &(), i: usize, point: &mut Point, alpha: f32) {
+        if let Some((si, ri, xi, yi)) = self.params[i] {
+            let dx = if (point.x - xi).abs() < MIN_DISTANCE {
+                MIN_DISTANCE
+            } else {
+                point.x - xi
+            };
+            let dy = if (point.y - yi).abs() < MIN_DISTANCE {
+                MIN_DISTANCE
+            } else {
+                point.y - yi
+            };
+            let d = (dx * dx + dy * dy).sqrt();
+            let k = (ri - d) * si * alpha / d;
+            point.vx += dx * k;
+            point.vy += dy * k;
         }
     }
 }
@@ -1,7 +1,13 @@
 pub mod force;
+pub mod placement;
+pub mod point_buffer;
 pub mod simulation;
 
-pub use self::simulation::{Force, Point, Simulation};
+pub use self::placement::{
+    pivot_mds_placement, pivot_mds_placement_slice, spectral_placement, spectral_placement_slice,
+};
+pub use self::point_buffer::PointBuffer;
+pub use self::simulation::{Force, LocalAlpha, Point, Simulation, StaticForce, StepStats};
 use petgraph::graph::{Graph, IndexType, NodeIndex};
 use petgraph::EdgeType;
 use std::collections::HashMap;
@@ -14,15 +20,20 @@ pub fn initial_placement<N, E, Ty: EdgeType, Ix: IndexType>(
 ) -> HashMap<NodeIndex<Ix>, (f32, f32)> {
     let mut result = HashMap::new();
     for (i, u) in graph.node_indices().enumerate() {
-        let r = 10. * (i as usize as f32).sqrt();
-        let theta = PI * (3. - (5. as f32).sqrt()) * (i as usize as f32);
-        let x = r * theta.cos();
-        let y = r * theta.sin();
-        result.insert(u, (x, y));
+        result.insert(u, initial_position(i));
     }
     result
 }
 
+/// Position of the `i`-th node in `initial_placement`.
+pub fn initial_position(i: usize) -> (f32, f32) {
+    let r = 10. * (i as usize as f32).sqrt();
+    let theta = PI * (3. - (5. as f32).sqrt()) * (i as usize as f32);
+    let x = r * theta.cos();
+    let y = r * theta.sin();
+    (x, y)
+}
+
 pub fn force_connected<N, E, Ty: EdgeType, Ix: IndexType>(
     graph: &Graph<N, E, Ty, Ix>,
 ) -> Vec<Box<dyn Force>> {
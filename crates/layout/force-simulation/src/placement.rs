@@ -0,0 +1,401 @@
+//! Structure-aware alternatives to `initial_placement`: pivot MDS runs in
+//! O(pivots * m + pivots^2 * n) and the spectral placement in
+//! O(iterations * m). Both ignore edge directions and are scaled so that
+//! edges have `edge_length` on average, such as the link distance of the
+//! forces that follow.
+
+use crate::initial_position;
+use petgraph::graph::{Graph, IndexType, NodeIndex};
+use petgraph::EdgeType;
+use std::collections::HashMap;
+
+const NONE: u32 = u32::max_value();
+const EIGEN_ITERATIONS: usize = 100;
+
+/// Undirected neighbor lists in CSR layout, without self loops.
+fn adjacency<N, E, Ty: EdgeType, Ix: IndexType>(
+    graph: &Graph<N, E, Ty, Ix>,
+) -> (Vec<usize>, Vec<usize>) {
+    let n = graph.node_count();
+    let mut offsets = vec![0; n + 1];
+    for e in graph.raw_edges() {
+        let (u, v) = (e.source().index(), e.target().index());
+        if u != v {
+            offsets[u + 1] += 1;
+            offsets[v + 1] += 1;
+        }
+    }
+    for u in 0..n {
+        offsets[u + 1] += offsets[u];
+    }
+    let mut next = offsets.clone();
+    let mut neighbors = vec![0; offsets[n]];
+    for e in graph.raw_edges() {
+        let (u, v) = (e.source().index(), e.target().index());
+        if u != v {
+            neighbors[next[u]] = v;
+            next[u] += 1;
+            neighbors[next[v]] = u;
+            next[v] += 1;
+        }
+    }
+    (offsets, neighbors)
+}
+
+fn bfs(
+    offsets: &[usize],
+    neighbors: &[usize],
+    source: usize,
+    distance: &mut [u32],
+    queue: &mut Vec<usize>,
+) {
+    for d in distance.iter_mut() {
+        *d = NONE;
+    }
+    queue.clear();
+    distance[source] = 0;
+    queue.push(source);
+    let mut head = 0;
+    while head < queue.len() {
+        let u = queue[head];
+        head += 1;
+        for &v in &neighbors[offsets[u]..offsets[u + 1]] {
+            if distance[v] == NONE {
+                distance[v] = distance[u] + 1;
+                queue.push(v);
+            }
+        }
+    }
+}
+
+/// Scales `coordinates` about their centroid so that the mean edge length is
+/// `edge_length`.
+fn normalize(
+    offsets: &[usize],
+    neighbors: &[usize],
+    edge_length: f32,
+    coordinates: &mut [(f32, f32)],
+) {
+    let n = coordinates.len() as f32;
+    let cx = coordinates.iter().map(|p| p.0).sum::<f32>() / n;
+    let cy = coordinates.iter().map(|p| p.1).sum::<f32>() / n;
+    let mut sum = 0.;
+    for u in 0..coordinates.len() {
+        for &v in &neighbors[offsets[u]..offsets[u + 1]] {
+            let dx = coordinates[u].0 - coordinates[v].0;
+            let dy = coordinates[u].1 - coordinates[v].1;
+            sum += (dx * dx + dy * dy).sqrt();
+        }
+    }
+    let mean = sum / neighbors.len() as f32;
+    let scale = if mean > 0. { edge_length / mean } else { 1. };
+    for p in coordinates.iter_mut() {
+        *p = ((p.0 - cx) * scale, (p.1 - cy) * scale);
+    }
+}
+
+/// Whether the placement must fall back to `initial_position`, for graphs
+/// without edges.
+fn fallback(neighbors: &[usize], coordinates: &mut [(f32, f32)]) -> bool {
+    if neighbors.is_empty() {
+        for (i, p) in coordinates.iter_mut().enumerate() {
+            *p = initial_position(i);
+        }
+        true
+    } else {
+        false
+    }
+}
+
+/// Pivot MDS of Brandes and Pich, "Eigensolver Methods for Progressive
+/// Multidimensional Scaling of Large Data": classical MDS restricted to the
+/// BFS distances from `pivots` nodes chosen farthest-first. Runs in
+/// O(pivots * m + pivots^2 * n).
+///
+/// The result can be passed to `Simulation::new`, `kamada_kawai` or
+/// `stress_majorization`.
+pub fn pivot_mds_placement<N, E, Ty: EdgeType, Ix: IndexType>(
+    graph: &Graph<N, E, Ty, Ix>,
+    pivots: usize,
+    edge_length: f32,
+) -> HashMap<NodeIndex<Ix>, (f32, f32)> {
+    let mut coordinates = vec![(0., 0.); graph.node_count()];
+    pivot_mds_placement_slice(graph, pivots, edge_length, &mut coordinates);
+    graph.node_indices().zip(coordinates).collect()
+}
+
+/// Same as `pivot_mds_placement`, writing into `coordinates` indexed by node
+/// index.
+/// Panics unless `coordinates.len() == graph.node_count()`.
+pub fn pivot_mds_placement_slice<N, E, Ty: EdgeType, Ix: IndexType>(
+    graph: &Graph<N, E, Ty, Ix>,
+    pivots: usize,
+    edge_length: f32,
+    coordinates: &mut [(f32, f32)],
+) {
+    assert_eq!(coordinates.len(), graph.node_count());
+    let n = graph.node_count();
+    let (offsets, neighbors) = adjacency(graph);
+    if fallback(&neighbors, coordinates) {
+        return;
+    }
+    let k = pivots.max(2).min(n);
+
+    // Column p of `c` holds the squared distances from pivot p. Unreachable
+    // nodes never get closer than the farthest reachable node.
+    let mut c = vec![0.; n * k];
+    let mut min_distance = vec![NONE; n];
+    let mut distance = vec![NONE; n];
+    let mut queue = Vec::with_capacity(n);
+    let mut pivot = 0;
+    let mut max_distance = 0;
+    for p in 0..k {
+        bfs(&offsets, &neighbors, pivot, &mut distance, &mut queue);
+        for i in 0..n {
+            if distance[i] != NONE {
+                max_distance = max_distance.max(distance[i]);
+            }
+            min_distance[i] = min_distance[i].min(distance[i]);
+            c[p * n + i] = distance[i] as f32;
+        }
+        pivot = (0..n)
+            .max_by_key(|&i| (min_distance[i], std::cmp::Reverse(i)))
+            .unwrap();
+    }
+    for d in c.iter_mut() {
+        let d0 = d.min((max_distance + 1) as f32);
+        *d = d0 * d0;
+    }
+
+    // Double centering.
+    let mut row_mean = vec![0.; n];
+    let mut column_mean = vec![0.; k];
+    for p in 0..k {
+        for i in 0..n {
+            row_mean[i] += c[p * n + i] / k as f32;
+            column_mean[p] += c[p * n + i] / n as f32;
+        }
+    }
+    let mean = column_mean.iter().sum::<f32>() / k as f32;
+    for p in 0..k {
+        for i in 0..n {
+            c[p * n + i] = -0.5 * (c[p * n + i] - row_mean[i] - column_mean[p] + mean);
+        }
+    }
+
+    // The top eigenvectors of the k x k matrix C^T C, by power iteration.
+    let mut ctc = vec![0.; k * k];
+    for p in 0..k {
+        for q in p..k {
+            let s = (0..n).map(|i| c[p * n + i] * c[q * n + i]).sum::<f32>();
+            ctc[p * k + q] = s;
+            ctc[q * k + p] = s;
+        }
+    }
+    let multiply = |v: &[f32], w: &mut [f32]| {
+        for p in 0..k {
+            w[p] = (0..k).map(|q| ctc[p * k + q] * v[q]).sum();
+        }
+    };
+    let mut v1 = (0..k).map(|p| 1. + p as f32).collect::<Vec<f32>>();
+    let mut v2 = (0..k)
+        .map(|p| if p % 2 == 0 { 1. } else { -1. })
+        .collect::<Vec<f32>>();
+    let mut w = vec![0.; k];
+    for _ in 0..EIGEN_ITERATIONS {
+        multiply(&v1, &mut w);
+        normalize_vector(&mut w);
+        v1.copy_from_slice(&w);
+        multiply(&v2, &mut w);
+        orthogonalize(&mut w, &v1, |_| 1.);
+        normalize_vector(&mut w);
+        v2.copy_from_slice(&w);
+    }
+
+    for i in 0..n {
+        let x = (0..k).map(|p| c[p * n + i] * v1[p]).sum();
+        let y = (0..k).map(|p| c[p * n + i] * v2[p]).sum();
+        coordinates[i] = (x, y);
+    }
+    normalize(&offsets, &neighbors, edge_length, coordinates);
+}
+
+fn normalize_vector(v: &mut [f32]) {
+    let norm = v.iter().map(|x| x * x).sum::<f32>().sqrt();
+    if norm > 0. {
+        for x in v.iter_mut() {
+            *x /= norm;
+        }
+    }
+}
+
+/// Removes from `v` its component along `u` in the inner product weighted by
+/// `weight`.
+fn orthogonalize<F: Fn(usize) -> f32>(v: &mut [f32], u: &[f32], weight: F) {
+    let mut uv = 0.;
+    let mut uu = 0.;
+    for i in 0..v.len() {
+        uv += weight(i) * u[i] * v[i];
+        uu += weight(i) * u[i] * u[i];
+    }
+    if uu > 0. {
+        for i in 0..v.len() {
+            v[i] -= uv / uu * u[i];
+        }
+    }
+}
+
+/// Spectral placement of Koren, "Drawing Graphs by Eigenvectors: Theory and
+/// Practice": the two leading nontrivial eigenvectors of the random-walk
+/// matrix, approximated with `iterations` power iterations over the
+/// adjacency lists. Runs in O(iterations * m).
+///
+/// The result can be passed to `Simulation::new`, `kamada_kawai` or
+/// `stress_majorization`. Connected components are placed on top of each
+/// other.
+pub fn spectral_placement<N, E, Ty: EdgeType, Ix: IndexType>(
+    graph: &Graph<N, E, Ty, Ix>,
+    iterations: usize,
+    edge_length: f32,
+) -> HashMap<NodeIndex<Ix>, (f32, f32)> {
+    let mut coordinates = vec![(0., 0.); graph.node_count()];
+    spectral_placement_slice(graph, iterations, edge_length, &mut coordinates);
+    graph.node_indices().zip(coordinates).collect()
+}
+
+/// Same as `spectral_placement`, writing into `coordinates` indexed by node
+/// index.
+/// Panics unless `coordinates.len() == graph.node_count()`.
+pub fn spectral_placement_slice<N, E, Ty: EdgeType, Ix: IndexType>(
+    graph: &Graph<N, E, Ty, Ix>,
+    iterations: usize,
+    edge_length: f32,
+    coordinates: &mut [(f32, f32)],
+) {
+    assert_eq!(coordinates.len(), graph.node_count());
+    let n = graph.node_count();
+    let (offsets, neighbors) = adjacency(graph);
+    if fallback(&neighbors, coordinates) {
+        return;
+    }
+    let degree = (0..n)
+        .map(|u| (offsets[u + 1] - offsets[u]) as f32)
+        .collect::<Vec<_>>();
+    let ones = vec![1.; n];
+    let mut seed = 1u32;
+    let mut random = || {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        seed as f32 / std::u32::MAX as f32 - 0.5
+    };
+    let mut vectors: Vec<Vec<f32>> = vec![];
+    let mut w = vec![0.; n];
+    for _ in 0..2 {
+        let mut v = (0..n).map(|_| random()).collect::<Vec<f32>>();
+        for _ in 0..iterations.max(1) {
+            orthogonalize(&mut v, &ones, |i| degree[i]);
+            for u in &vectors {
+                orthogonalize(&mut v, u, |i| degree[i]);
+            }
+            normalize_vector(&mut v);
+            for i in 0..n {
+                let adjacent = &neighbors[offsets[i]..offsets[i + 1]];
+                w[i] = if adjacent.is_empty() {
+                    v[i]
+                } else {
+                    0.5 * (v[i] + adjacent.iter().map(|&j| v[j]).sum::<f32>() / degree[i])
+                };
+            }
+            v.copy_from_slice(&w);
+        }
+        orthogonalize(&mut v, &ones, |i| degree[i]);
+        for u in &vectors {
+            orthogonalize(&mut v, u, |i| degree[i]);
+        }
+        normalize_vector(&mut v);
+        vectors.push(v);
+    }
+    for i in 0..n {
+        coordinates[i] = (vectors[0][i], vectors[1][i]);
+    }
+    normalize(&offsets, &neighbors, edge_length, coordinates);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn grid(k: usize) -> Graph<(), ()> {
+        let mut graph = Graph::new();
+        let nodes = (0..k * k).map(|_| graph.add_node(())).collect::<Vec<_>>();
+        for i in 0..k {
+            for j in 0..k {
+                if i + 1 < k {
+                    graph.add_edge(nodes[i * k + j], nodes[(i + 1) * k + j], ());
+                }
+                if j + 1 < k {
+                    graph.add_edge(nodes[i * k + j], nodes[i * k + j + 1], ());
+                }
+            }
+        }
+        graph
+    }
+
+    fn distance(p: (f32, f32), q: (f32, f32)) -> f32 {
+        ((p.0 - q.0).powi(2) + (p.1 - q.1).powi(2)).sqrt()
+    }
+
+    /// Checks that grid corners end up about as far apart as in the grid.
+    fn check_grid(coordinates: &[(f32, f32)], k: usize) {
+        let corners = [0, k - 1, k * (k - 1), k * k - 1];
+        let side = 30. * (k - 1) as f32;
+        for &(a, b, d) in &[
+            (0, 1, side),
+            (0, 2, side),
+            (0, 3, side * 2f32.sqrt()),
+            (1, 2, side * 2f32.sqrt()),
+        ] {
+            let actual = distance(coordinates[corners[a]], coordinates[corners[b]]);
+            assert!((actual - d).abs() < 0.3 * d);
+        }
+    }
+
+    #[test]
+    fn test_pivot_mds_placement() {
+        let mut path = Graph::<(), ()>::new();
+        let nodes = (0..20).map(|_| path.add_node(())).collect::<Vec<_>>();
+        for w in nodes.windows(2) {
+            path.add_edge(w[0], w[1], ());
+        }
+        let coordinates = pivot_mds_placement(&path, 5, 30.);
+        let d = distance(coordinates[&nodes[0]], coordinates[&nodes[19]]);
+        assert!((d - 19. * 30.).abs() < 0.05 * 19. * 30.);
+
+        let k = 12;
+        let graph = grid(k);
+        let mut coordinates = vec![(0., 0.); graph.node_count()];
+        pivot_mds_placement_slice(&graph, 10, 30., &mut coordinates);
+        check_grid(&coordinates, k);
+    }
+
+    #[test]
+    fn test_spectral_placement() {
+        let k = 12;
+        let graph = grid(k);
+        let mut coordinates = vec![(0., 0.); graph.node_count()];
+        spectral_placement_slice(&graph, 1000, 30., &mut coordinates);
+        check_grid(&coordinates, k);
+    }
+
+    #[test]
+    fn test_placement_without_edges() {
+        let mut graph = Graph::<(), ()>::new();
+        graph.add_node(());
+        graph.add_node(());
+        let coordinates = spectral_placement(&graph, 10, 30.);
+        assert_eq!(coordinates[&NodeIndex::new(1)], initial_position(1));
+        let coordinates = pivot_mds_placement(&graph, 10, 30.);
+        assert_eq!(coordinates[&NodeIndex::new(1)], initial_position(1));
+    }
+}
@@ -0,0 +1,72 @@
+use crate::Point;
+
+/// Width of the unrolled inner loops of the all-pair kernels; eight `f32`
+/// lanes fill one AVX2 register or two NEON / simd128 registers.
+pub(crate) const LANES: usize = 8;
+
+/// Structure-of-arrays copy of a point slice.
+///
+/// All-pair kernels stream over one coordinate at a time, which lets the
+/// compiler keep every lane of a SIMD register busy instead of gathering
+/// `x` and `y` out of interleaved `Point`s.
+#[derive(Clone, Debug, Default)]
+pub struct PointBuffer {
+    pub x: Vec<f32>,
+    pub y: Vec<f32>,
+    pub vx: Vec<f32>,
+    pub vy: Vec<f32>,
+}
+
+impl PointBuffer {
+    pub fn new() -> PointBuffer {
+        PointBuffer::default()
+    }
+
+    pub fn from_points(points: &[Point]) -> PointBuffer {
+        let mut buffer = PointBuffer::new();
+        buffer.load(points);
+        buffer
+    }
+
+    pub fn len(&self) -> usize {
+        self.x.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.x.is_empty()
+    }
+
+    /// Overwrites the buffer with `points`, reusing the existing allocations.
+    pub fn load(&mut self, points: &[Point]) {
+        self.x.clear();
+        self.y.clear();
+        self.vx.clear();
+        self.vy.clear();
+        self.x.extend(points.iter().map(|p| p.x));
+        self.y.extend(points.iter().map(|p| p.y));
+        self.vx.extend(points.iter().map(|p| p.vx));
+        self.vy.extend(points.iter().map(|p| p.vy));
+    }
+
+    /// Writes the buffered velocities back into `points`.
+    pub fn store_velocity(&self, points: &mut [Point]) {
+        for (i, point) in points.iter_mut().enumerate() {
+            point.vx = self.vx[i];
+            point.vy = self.vy[i];
+        }
+    }
+}
+
+#[test]
+fn test_point_buffer() {
+    let mut points = vec![Point::new(1., 2.), Point::new(3., 4.)];
+    let mut buffer = PointBuffer::from_points(&points);
+    assert_eq!(buffer.len(), 2);
+    assert_eq!(buffer.x, vec![1., 3.]);
+    assert_eq!(buffer.y, vec![2., 4.]);
+    buffer.vx[1] = 5.;
+    buffer.vy[0] = 6.;
+    buffer.store_velocity(&mut points);
+    assert_eq!(points[1].vx, 5.);
+    assert_eq!(points[0].vy, 6.);
+}
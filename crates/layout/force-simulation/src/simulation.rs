@@ -24,6 +24,177 @@ impl Point {
 
 pub trait Force {
     fn apply(&self, points: &mut Vec<Point>, alpha: f32);
+
+    /// Whether the velocity changes made by `apply` are proportional to
+    /// `alpha`. While nodes are reheated with `Simulation::reheat_node`, the
+    /// changes of such forces are rescaled from the highest alpha to the
+    /// alpha of each point; the changes of the others, such as collision
+    /// resolution, are kept as they are.
+    fn scales_with_alpha(&self) -> bool {
+        true
+    }
+}
+
+/// Velocities saved before a force runs while nodes are reheated, to rescale
+/// the changes the force makes to the alpha of each point.
+pub struct LocalAlpha<'a> {
+    alpha: f32,
+    local_alpha: &'a [f32],
+    velocity: &'a mut Vec<(f32, f32)>,
+}
+
+impl<'a> LocalAlpha<'a> {
+    fn save(&mut self, points: &[Point]) {
+        self.velocity.clear();
+        self.velocity
+            .extend(points.iter().map(|point| (point.vx, point.vy)));
+    }
+
+    /// Scales the velocity changes since `save`, made by a force run at
+    /// `alpha`, to the alpha of each point.
+    fn scale(&self, points: &mut [Point], alpha: f32) {
+        for (i, point) in points.iter_mut().enumerate() {
+            let (vx, vy) = self.velocity[i];
+            self.scale_point(i, point, vx, vy, alpha);
+        }
+    }
+
+    #[inline]
+    fn scale_point(&self, i: usize, point: &mut Point, vx: f32, vy: f32, alpha: f32) {
+        let w = self.alpha.max(self.local_alpha[i]) / alpha;
+        point.vx = vx + (point.vx - vx) * w;
+        point.vy = vy + (point.vy - vy) * w;
+    }
+}
+
+/// A force for `Simulation::step_with`, which dispatches statically and
+/// fuses per-point work with the integration pass.
+///
+/// `prepare` runs first, in order, for every force and does any work that
+/// needs the whole point array. `apply_to_point` then runs for each point,
+/// again in order, in the same pass as velocity decay and integration.
+/// Forces that only need their own point should do their work there.
+pub trait StaticForce {
+    type State;
+
+    fn prepare(&self, points: &mut Vec<Point>, alpha: f32) -> Self::State;
+
+    fn apply_to_point(&self, _state: &Self::State, _i: usize, _point: &mut Point, _alpha: f32) {}
+
+    /// Same as `Force::scales_with_alpha`, for the velocity changes made by
+    /// `prepare`. Those made by `apply_to_point` are always rescaled.
+    fn scales_with_alpha(&self) -> bool {
+        true
+    }
+
+    /// `prepare` while nodes are reheated, rescaling the velocity changes of
+    /// each force that scales with alpha. Tuples forward it to every force.
+    fn prepare_local(
+        &self,
+        points: &mut Vec<Point>,
+        alpha: f32,
+        local: &mut LocalAlpha,
+    ) -> Self::State {
+        if !self.scales_with_alpha() {
+            return self.prepare(points, alpha);
+        }
+        local.save(points);
+        let state = self.prepare(points, alpha);
+        local.scale(points, alpha);
+        state
+    }
+}
+
+macro_rules! impl_static_force_tuple {
+    ($($name:ident $index:tt),+) => {
+        impl<$($name: StaticForce),+> StaticForce for ($($name,)+) {
+            type State = ($($name::State,)+);
+
+            fn prepare(&self, points: &mut Vec<Point>, alpha: f32) -> Self::State {
+                ($(self.$index.prepare(points, alpha),)+)
+            }
+
+            fn prepare_local(
+                &self,
+                points: &mut Vec<Point>,
+                alpha: f32,
+                local: &mut LocalAlpha,
+            ) -> Self::State {
+                ($(self.$index.prepare_local(points, alpha, local),)+)
+            }
+
+            #[inline]
+            fn apply_to_point(&self, state: &Self::State, i: usize, point: &mut Point, alpha: f32) {
+                $(self.$index.apply_to_point(&state.$index, i, point, alpha);)+
+            }
+        }
+    };
+}
+
+impl_static_force_tuple!(A 0);
+impl_static_force_tuple!(A 0, B 1);
+impl_static_force_tuple!(A 0, B 1, C 2);
+impl_static_force_tuple!(A 0, B 1, C 2, D 3);
+impl_static_force_tuple!(A 0, B 1, C 2, D 3, E 4);
+impl_static_force_tuple!(A 0, B 1, C 2, D 3, E 4, F 5);
+impl_static_force_tuple!(A 0, B 1, C 2, D 3, E 4, F 5, G 6);
+impl_static_force_tuple!(A 0, B 1, C 2, D 3, E 4, F 5, G 6, H 7);
+
+/// Lets a force that keeps scratch space between calls, such as
+/// `ManyBodyForceMultipole`, be borrowed into a tuple and reused.
+impl<'a, T: StaticForce> StaticForce for &'a T {
+    type State = T::State;
+
+    fn prepare(&self, points: &mut Vec<Point>, alpha: f32) -> Self::State {
+        (**self).prepare(points, alpha)
+    }
+
+    #[inline]
+    fn apply_to_point(&self, state: &Self::State, i: usize, point: &mut Point, alpha: f32) {
+        (**self).apply_to_point(state, i, point, alpha)
+    }
+
+    fn scales_with_alpha(&self) -> bool {
+        (**self).scales_with_alpha()
+    }
+
+    fn prepare_local(
+        &self,
+        points: &mut Vec<Point>,
+        alpha: f32,
+        local: &mut LocalAlpha,
+    ) -> Self::State {
+        (**self).prepare_local(points, alpha, local)
+    }
+}
+
+/// Statistics of one simulation step, passed to the hook set with
+/// `Simulation::set_stats_hook`.
+pub struct StepStats<'a> {
+    pub alpha: f32,
+    /// Sum of the squared velocities after the step.
+    pub kinetic_energy: f32,
+    /// Wall time in seconds of each `Force::apply` call, in the order of the
+    /// forces. Empty for `step_with`.
+    pub force_times: &'a [f64],
+}
+
+pub type StatsHook = Box<dyn FnMut(&StepStats) + Send>;
+
+/// Seconds of a monotonic clock since its first call.
+#[cfg(not(target_arch = "wasm32"))]
+pub fn default_clock() -> f64 {
+    use std::sync::OnceLock;
+    use std::time::Instant;
+    static START: OnceLock<Instant> = OnceLock::new();
+    START.get_or_init(Instant::now).elapsed().as_secs_f64()
+}
+
+/// `std::time` is unavailable on wasm32; callers set a clock with
+/// `Simulation::set_clock`.
+#[cfg(target_arch = "wasm32")]
+pub fn default_clock() -> f64 {
+    0.
 }
 
 pub struct Simulation<Ix: IndexType> {
@@ -34,6 +205,16 @@ pub struct Simulation<Ix: IndexType> {
     pub alpha_target: f32,
     pub velocity_decay: f32,
     pub iterations: usize,
+    /// The simulation is also finished once the root mean square movement of
+    /// the points in a step falls below this value. Disabled when zero.
+    pub movement_threshold: f32,
+    kinetic_energy: f32,
+    stats_hook: Option<StatsHook>,
+    clock: fn() -> f64,
+    force_times: Vec<f64>,
+    local_alpha: Vec<f32>,
+    local_alpha_max: f32,
+    velocity: Vec<(f32, f32)>,
 }
 
 impl<Ix: IndexType> Simulation<Ix> {
@@ -49,11 +230,27 @@ impl<Ix: IndexType> Simulation<Ix> {
                 Point::new(x, y)
             })
             .collect::<Vec<_>>();
+        Simulation::new_with_points(indices, points)
+    }
+
+    /// Creates a simulation of the points at `coordinates` without a graph.
+    /// The node indices are `0..coordinates.len()`.
+    pub fn new_with_coordinates(coordinates: &[(f32, f32)]) -> Simulation<Ix> {
+        let indices = (0..coordinates.len()).map(NodeIndex::new).collect();
+        let points = coordinates
+            .iter()
+            .map(|&(x, y)| Point::new(x, y))
+            .collect::<Vec<_>>();
+        Simulation::new_with_points(indices, points)
+    }
+
+    fn new_with_points(indices: Vec<NodeIndex<Ix>>, points: Vec<Point>) -> Simulation<Ix> {
         let alpha = 1.;
         let alpha_min = 0.001;
         let alpha_target = 0.;
         let velocity_decay = 0.6;
         let iterations = 300;
+        let local_alpha = vec![0.; points.len()];
         Simulation {
             indices,
             points,
@@ -62,9 +259,73 @@ impl<Ix: IndexType> Simulation<Ix> {
             alpha_target,
             velocity_decay,
             iterations,
+            movement_threshold: 0.,
+            kinetic_energy: std::f32::INFINITY,
+            stats_hook: None,
+            clock: default_clock,
+            force_times: vec![],
+            local_alpha,
+            local_alpha_max: 0.,
+            velocity: vec![],
+        }
+    }
+
+    /// Appends a node at `(x, y)` and returns its point index. The forces
+    /// must be told about it too, e.g. with `LinkForce::add_node`. It starts
+    /// at the current alpha; use `reheat_node` to let it settle faster than
+    /// the rest.
+    pub fn add_node(&mut self, u: NodeIndex<Ix>, x: f32, y: f32) -> usize {
+        self.indices.push(u);
+        self.points.push(Point::new(x, y));
+        self.local_alpha.push(0.);
+        self.points.len() - 1
+    }
+
+    /// Removes point `i`, moving the last point into its place as
+    /// `Graph::remove_node` does with node indices. Positions and velocities
+    /// of the other points are kept.
+    pub fn remove_node(&mut self, i: usize) {
+        self.indices.swap_remove(i);
+        self.points.swap_remove(i);
+        self.local_alpha.swap_remove(i);
+        if i < self.indices.len() {
+            self.indices[i] = NodeIndex::new(i);
         }
     }
 
+    /// Raises the alpha of point `i` alone to at least `alpha`. Until it
+    /// decays to the global alpha, the forces act on the point as if the
+    /// simulation ran at its own alpha, so changes in the graph settle
+    /// locally without reheating the whole layout. Forces that do not scale
+    /// with alpha, such as `CollideForce` and `CenterForce`, act the same on
+    /// every point.
+    pub fn reheat_node(&mut self, i: usize, alpha: f32) {
+        self.local_alpha[i] = self.local_alpha[i].max(alpha);
+        self.local_alpha_max = self.local_alpha_max.max(alpha);
+        self.kinetic_energy = std::f32::INFINITY;
+    }
+
+    /// Calls `hook` after every step. Force timings are only measured while
+    /// a hook is set.
+    pub fn set_stats_hook<F: FnMut(&StepStats) + Send + 'static>(&mut self, hook: F) {
+        self.stats_hook = Some(Box::new(hook));
+    }
+
+    pub fn clear_stats_hook(&mut self) {
+        self.stats_hook = None;
+    }
+
+    /// Sets the clock, in seconds, used to time forces.
+    pub fn set_clock(&mut self, clock: fn() -> f64) {
+        self.clock = clock;
+    }
+
+    /// Sum of the squared velocities after the last step, or infinity before
+    /// the first step.
+    pub fn kinetic_energy(&self) -> f32 {
+        self.kinetic_energy
+    }
+
     pub fn run<T: AsRef<dyn Force>>(&mut self, forces: &[T]) -> HashMap<NodeIndex<Ix>, (f32, f32)> {
         while !self.is_finished() {
             self.step(forces);
@@ -86,27 +347,187 @@ impl<Ix: IndexType> Simulation<Ix> {
     pub fn step<T: AsRef<dyn Force>>(&mut self, forces: &[T]) {
         let alpha_decay = 1. - self.alpha_min.powf(1. / self.iterations as f32);
         self.alpha += (self.alpha_target - self.alpha) * alpha_decay;
-        self.apply_forces(forces, self.alpha);
+        if !self.decay_local_alpha(alpha_decay) {
+            self.apply_forces(forces, self.alpha);
+            return;
+        }
+        let alpha = self.local_alpha_max;
+        self.apply_each_force(forces, alpha, true);
+        self.integrate(alpha);
+    }
+
+    /// Decays the local alphas and returns whether any is above the global
+    /// alpha.
+    fn decay_local_alpha(&mut self, alpha_decay: f32) -> bool {
+        if self.local_alpha_max <= self.alpha {
+            return false;
+        }
+        let mut local_alpha_max = 0.;
+        for a in self.local_alpha.iter_mut() {
+            *a += (self.alpha_target - *a) * alpha_decay;
+            local_alpha_max = a.max(local_alpha_max);
+        }
+        self.local_alpha_max = local_alpha_max;
+        local_alpha_max > self.alpha
+    }
+
+    fn local(&mut self) -> (&mut Vec<Point>, LocalAlpha<'_>) {
+        (
+            &mut self.points,
+            LocalAlpha {
+                alpha: self.alpha,
+                local_alpha: &self.local_alpha,
+                velocity: &mut self.velocity,
+            },
+        )
+    }
+
+    /// Same as `step` for a statically known set of forces, usually a tuple.
+    ///
+    /// The per-point parts of the forces run in a single pass together with
+    /// velocity decay and integration, after every `prepare`. The result is
+    /// the same as `step` as long as no force that reads velocities, such as
+    /// `LinkForce` or `CollideForce`, comes after `PositionForce` or
+    /// `RadialForce`.
+    ///
+    /// `LinkForce` is not fused into the per-point pass and runs whole in
+    /// `prepare`, as in `step`. It updates links one after another, and each
+    /// link reads the velocities that earlier links at the same nodes have
+    /// already changed. Gathering the links of each point from its incidence
+    /// list would read the velocities from before the pass instead, which is
+    /// a different and more slowly converging update.
+    ///
+    /// `CenterForce` also splits in two: it takes the centroid in `prepare`
+    /// and shifts each point in the per-point pass. Forces listed after it
+    /// therefore see the positions before the shift in their `prepare`,
+    /// while `step` runs them on the shifted positions. Forces that only
+    /// depend on differences of positions, such as the link, many-body and
+    /// collide forces, give the same result up to rounding; per-point
+    /// forces such as `PositionForce` see the shifted positions in both.
+    /// Put `CenterForce` last to match `step` exactly.
+    pub fn step_with<F: StaticForce>(&mut self, forces: &F) {
+        let alpha_decay = 1. - self.alpha_min.powf(1. / self.iterations as f32);
+        self.alpha += (self.alpha_target - self.alpha) * alpha_decay;
+        let local = self.decay_local_alpha(alpha_decay);
+        let velocity_decay = self.velocity_decay;
+        let mut kinetic_energy = 0.;
+        if local {
+            let alpha = self.local_alpha_max;
+            let (points, mut local) = self.local();
+            let state = forces.prepare_local(points, alpha, &mut local);
+            for (i, point) in points.iter_mut().enumerate() {
+                let (vx, vy) = (point.vx, point.vy);
+                forces.apply_to_point(&state, i, point, alpha);
+                local.scale_point(i, point, vx, vy, alpha);
+                point.vx *= velocity_decay;
+                point.x += point.vx;
+                point.vy *= velocity_decay;
+                point.y += point.vy;
+                kinetic_energy += point.vx * point.vx + point.vy * point.vy;
+            }
+            self.kinetic_energy = kinetic_energy;
+            self.force_times.clear();
+            self.report(alpha);
+            return;
+        }
+        let alpha = self.alpha;
+        let state = forces.prepare(&mut self.points, alpha);
+        for i in 0..self.points.len() {
+            forces.apply_to_point(&state, i, &mut self.points[i], alpha);
+            let point = &mut self.points[i];
+            point.vx *= velocity_decay;
+            point.x += point.vx;
+            point.vy *= velocity_decay;
+            point.y += point.vy;
+            kinetic_energy += point.vx * point.vx + point.vy * point.vy;
+        }
+        self.kinetic_energy = kinetic_energy;
+        self.force_times.clear();
+        self.report(alpha);
     }
 
     pub fn apply_forces<T: AsRef<dyn Force>>(&mut self, forces: &[T], alpha: f32) {
+        self.apply_each_force(forces, alpha, false);
+        self.integrate(alpha);
+    }
+
+    /// Applies the forces at `alpha`. With `local`, the velocity changes of
+    /// the forces that scale with alpha are rescaled to the alpha of each
+    /// point.
+    fn apply_each_force<T: AsRef<dyn Force>>(&mut self, forces: &[T], alpha: f32, local: bool) {
+        self.force_times.clear();
+        let timed = self.stats_hook.is_some();
+        let clock = self.clock;
+        let mut force_times = std::mem::replace(&mut self.force_times, vec![]);
+        let (points, mut local_alpha) = self.local();
         for force in forces {
-            force.as_ref().apply(&mut self.points, alpha);
+            let force = force.as_ref();
+            let scaled = local && force.scales_with_alpha();
+            if scaled {
+                local_alpha.save(points);
+            }
+            if timed {
+                let start = clock();
+                force.apply(points, alpha);
+                force_times.push(clock() - start);
+            } else {
+                force.apply(points, alpha);
+            }
+            if scaled {
+                local_alpha.scale(points, alpha);
+            }
         }
+        self.force_times = force_times;
+    }
+
+    fn integrate(&mut self, alpha: f32) {
+        let mut kinetic_energy = 0.;
         for point in self.points.iter_mut() {
             point.vx *= self.velocity_decay;
             point.x += point.vx;
             point.vy *= self.velocity_decay;
             point.y += point.vy;
+            kinetic_energy += point.vx * point.vx + point.vy * point.vy;
+        }
+        self.kinetic_energy = kinetic_energy;
+        self.report(alpha);
+    }
+
+    fn report(&mut self, alpha: f32) {
+        if let Some(hook) = self.stats_hook.as_mut() {
+            hook(&StepStats {
+                alpha,
+                kinetic_energy: self.kinetic_energy,
+                force_times: &self.force_times,
+            });
         }
     }
 
     pub fn is_finished(&self) -> bool {
-        self.alpha < self.alpha_min
+        self.alpha.max(self.local_alpha_max) < self.alpha_min
+            || self.kinetic_energy
+                < self.movement_threshold * self.movement_threshold * self.points.len() as f32
     }
 
     pub fn reset(&mut self, alpha_start: f32) {
         self.alpha = alpha_start;
+        self.kinetic_energy = std::f32::INFINITY;
+        for a in self.local_alpha.iter_mut() {
+            *a = 0.;
+        }
+        self.local_alpha_max = 0.;
+    }
+
+    /// Points of the simulation in the order of `graph.node_indices()`.
+    pub fn points(&self) -> &[Point] {
+        &self.points
+    }
+
+    /// Writes the coordinates into `coordinates`, indexed by node index.
+    pub fn coordinates_slice(&self, coordinates: &mut [(f32, f32)]) {
+        for (c, p) in coordinates.iter_mut().zip(self.points.iter()) {
+            *c = (p.x, p.y);
+        }
     }
 
     pub fn coordinates(&self) -> HashMap<NodeIndex<Ix>, (f32, f32)> {
@@ -117,3 +538,196 @@ impl<Ix: IndexType> Simulation<Ix> {
             .collect::<HashMap<_, _>>()
     }
 }
+
+#[test]
+fn test_step_with() {
+    use crate::force::{CenterForce, LinkForce, ManyBodyForce, PositionForce};
+    use crate::initial_placement;
+
+    let mut graph = Graph::new_undirected();
+    let nodes = (0..30).map(|_| graph.add_node(())).collect::<Vec<_>>();
+    for i in 0..30 {
+        graph.add_edge(nodes[i], nodes[(i + 1) % 30], ());
+        graph.add_edge(nodes[i], nodes[(i * 7) % 30], ());
+    }
+    let coordinates = initial_placement(&graph);
+    let position = |_: &Graph<(), (), _>, _| crate::force::position_force::NodeArgument {
+        strength: None,
+        x: Some(0.),
+        y: Some(0.),
+    };
+    let forces: Vec<Box<dyn Force>> = vec![
+        Box::new(ManyBodyForce::new(&graph)),
+        Box::new(LinkForce::new(&graph)),
+        Box::new(CenterForce::new()),
+        Box::new(PositionForce::new(&graph, position)),
+    ];
+    let static_forces = (
+        ManyBodyForce::new(&graph),
+        LinkForce::new(&graph),
+        CenterForce::new(),
+        PositionForce::new(&graph, position),
+    );
+    let mut expected = Simulation::new(&graph, |_, u| coordinates[&u]);
+    let mut actual = Simulation::new(&graph, |_, u| coordinates[&u]);
+    for _ in 0..10 {
+        expected.step(&forces);
+        actual.step_with(&static_forces);
+    }
+    for (p, q) in actual.points().iter().zip(expected.points()) {
+        assert_eq!((p.x, p.y, p.vx, p.vy), (q.x, q.y, q.vx, q.vy));
+    }
+}
+
+#[test]
+fn test_movement_threshold() {
+    use crate::force::{LinkForce, ManyBodyForce};
+    use crate::initial_placement;
+    use std::sync::{Arc, Mutex};
+
+    let mut graph = Graph::new_undirected();
+    let nodes = (0..20).map(|_| graph.add_node(())).collect::<Vec<_>>();
+    for i in 1..20 {
+        graph.add_edge(nodes[i - 1], nodes[i], ());
+    }
+    let coordinates = initial_placement(&graph);
+    let forces: Vec<Box<dyn Force>> = vec![
+        Box::new(ManyBodyForce::new(&graph)),
+        Box::new(LinkForce::new(&graph)),
+    ];
+    let mut simulation = Simulation::new(&graph, |_, u| coordinates[&u]);
+    simulation.movement_threshold = 0.1;
+    let steps = Arc::new(Mutex::new(vec![]));
+    {
+        let steps = steps.clone();
+        simulation.set_stats_hook(move |stats| {
+            assert_eq!(stats.force_times.len(), 2);
+            steps.lock().unwrap().push(stats.kinetic_energy);
+        });
+    }
+    simulation.run(&forces);
+
+    let steps = steps.lock().unwrap();
+    assert!(steps.len() < simulation.iterations);
+    assert!(simulation.alpha >= simulation.alpha_min);
+    assert_eq!(*steps.last().unwrap(), simulation.kinetic_energy());
+    assert!(simulation.kinetic_energy() < 0.1 * 0.1 * 20.);
+}
+
+#[test]
+fn test_reheat_after_movement_threshold() {
+    use crate::force::{LinkForce, ManyBodyForce};
+    use crate::initial_placement;
+
+    let mut graph = Graph::new_undirected();
+    let nodes = (0..20).map(|_| graph.add_node(())).collect::<Vec<_>>();
+    for i in 1..20 {
+        graph.add_edge(nodes[i - 1], nodes[i], ());
+    }
+    let coordinates = initial_placement(&graph);
+    let forces = (ManyBodyForce::new(&graph), LinkForce::new(&graph));
+    let mut simulation = Simulation::new(&graph, |_, u| coordinates[&u]);
+    simulation.movement_threshold = 0.1;
+    while !simulation.is_finished() {
+        simulation.step_with(&forces);
+    }
+    assert!(simulation.alpha >= simulation.alpha_min);
+
+    simulation.reheat_node(0, 1.);
+    assert!(!simulation.is_finished());
+    simulation.step_with(&forces);
+    assert!(simulation.kinetic_energy().is_finite());
+}
+
+#[test]
+fn test_local_reheat_alpha_independent_force() {
+    use crate::force::CollideForce;
+
+    let mut graph = Graph::new_undirected();
+    for _ in 0..40 {
+        graph.add_node(());
+    }
+    let collide = || CollideForce::new(&graph, |_, _| 8., 0.7, 1);
+    let forces: Vec<Box<dyn Force>> = vec![Box::new(collide())];
+    let static_forces = (collide(),);
+    let initial = |_: &Graph<(), (), _>, u: NodeIndex| {
+        let i = u.index() as f32;
+        ((i % 7.) * 3., (i / 7.).floor() * 3.)
+    };
+    let mut expected = Simulation::new(&graph, initial);
+    expected.alpha = 0.01;
+    let mut actual = Simulation::new(&graph, initial);
+    actual.alpha = 0.01;
+    let mut actual_static = Simulation::new(&graph, initial);
+    actual_static.alpha = 0.01;
+    actual.reheat_node(39, 1.);
+    actual_static.reheat_node(39, 1.);
+    for _ in 0..20 {
+        expected.step(&forces);
+        actual.step(&forces);
+        actual_static.step_with(&static_forces);
+    }
+    for simulation in &[actual, actual_static] {
+        for (p, q) in simulation.points().iter().zip(expected.points()) {
+            assert_eq!((p.x, p.y, p.vx, p.vy), (q.x, q.y, q.vx, q.vy));
+        }
+    }
+}
+
+#[test]
+fn test_local_reheat() {
+    use crate::force::link_force::LinkArgument;
+    use crate::force::{LinkForce, ManyBodyForce};
+    use crate::initial_placement;
+
+    let n = 10;
+    let mut graph = Graph::new_undirected();
+    let nodes = (0..n).map(|_| graph.add_node(())).collect::<Vec<_>>();
+    for i in 1..n {
+        graph.add_edge(nodes[i - 1], nodes[i], ());
+    }
+    let coordinates = initial_placement(&graph);
+    let mut forces = (ManyBodyForce::new(&graph), LinkForce::new(&graph));
+    let mut simulation = Simulation::new(&graph, |_, u| coordinates[&u]);
+    while !simulation.is_finished() {
+        simulation.step_with(&forces);
+    }
+    let alpha = simulation.alpha;
+    let before = simulation.points().to_vec();
+
+    let (x0, y0) = (before[0].x, before[0].y);
+    let u = simulation.add_node(NodeIndex::new(n), x0 + 1., y0 + 1.);
+    forces.0.add_node(-30.);
+    forces.1.add_node();
+    forces.1.add_link(u, 0, LinkArgument::new());
+    simulation.reheat_node(u, 1.);
+    simulation.reheat_node(0, 1.);
+    assert!(!simulation.is_finished());
+    let mut steps = 0;
+    while !simulation.is_finished() {
+        // Exercise both the dynamic and the static step.
+        if steps % 2 == 0 {
+            simulation.step_with(&forces);
+        } else {
+            simulation.step(&[&forces.1]);
+        }
+        steps += 1;
+    }
+    assert!(steps > 0);
+    assert!(simulation.alpha <= alpha);
+
+    let points = simulation.points();
+    let d = ((points[u].x - points[0].x).powi(2) + (points[u].y - points[0].y).powi(2)).sqrt();
+    assert!(d > 15. && d < 45.);
+    let moved = ((points[n - 1].x - before[n - 1].x).powi(2)
+        + (points[n - 1].y - before[n - 1].y).powi(2))
+    .sqrt();
+    assert!(moved < 1.);
+
+    simulation.remove_node(u);
+    forces.0.remove_node(u);
+    forces.1.remove_node(u);
+    assert_eq!(simulation.points().len(), n);
+    assert_eq!(simulation.coordinates().len(), n);
+    simulation.step_with(&forces);
+}
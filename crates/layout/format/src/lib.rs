@@ -0,0 +1,267 @@
+//! Versioned binary format for node positions and edge polylines.
+//!
+//! All values are little-endian. A file consists of
+//!
+//! | bytes               | content                                   |
+//! |---------------------|-------------------------------------------|
+//! | 4                   | magic `b"EGLF"`                           |
+//! | 4                   | format version, `u32`                     |
+//! | 8                   | node count `n`, `u64`                     |
+//! | 8                   | edge count `m`, `u64`                     |
+//! | `8 * n`             | node positions, `x` and `y` as `f32`      |
+//! | `8 * p`             | polyline points, `x` and `y` as `f32`     |
+//! | `8 * (m + 1)`       | polyline offsets into the points, `u64`   |
+//!
+//! Offsets come last so that `LayoutWriter` can stream points without
+//! knowing their total in advance; `LayoutView` finds them from the length
+//! of the buffer. Every section starts at a multiple of 8 bytes, so a
+//! memory-mapped file can be read in place.
+
+use petgraph::graph::{IndexType, NodeIndex};
+use std::collections::HashMap;
+use std::io::{self, Write};
+
+pub const MAGIC: [u8; 4] = *b"EGLF";
+pub const VERSION: u32 = 1;
+const HEADER_SIZE: usize = 24;
+
+fn invalid_input(message: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidInput, message)
+}
+
+fn invalid_data(message: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, message)
+}
+
+/// Writes a layout incrementally: exactly `node_count` positions, then
+/// exactly `edge_count` polylines, then `finish`. Each call writes through
+/// to `writer`, which should be buffered.
+pub struct LayoutWriter<W: Write> {
+    writer: W,
+    node_count: u64,
+    edge_count: u64,
+    position_count: u64,
+    offsets: Vec<u64>,
+}
+
+impl<W: Write> LayoutWriter<W> {
+    pub fn new(mut writer: W, node_count: usize, edge_count: usize) -> io::Result<LayoutWriter<W>> {
+        writer.write_all(&MAGIC)?;
+        writer.write_all(&VERSION.to_le_bytes())?;
+        writer.write_all(&(node_count as u64).to_le_bytes())?;
+        writer.write_all(&(edge_count as u64).to_le_bytes())?;
+        let mut offsets = Vec::with_capacity(edge_count + 1);
+        offsets.push(0);
+        Ok(LayoutWriter {
+            writer,
+            node_count: node_count as u64,
+            edge_count: edge_count as u64,
+            position_count: 0,
+            offsets,
+        })
+    }
+
+    pub fn write_position(&mut self, x: f32, y: f32) -> io::Result<()> {
+        if self.position_count == self.node_count {
+            return Err(invalid_input("too many positions"));
+        }
+        self.write_point(x, y)?;
+        self.position_count += 1;
+        Ok(())
+    }
+
+    pub fn write_positions(&mut self, positions: &[(f32, f32)]) -> io::Result<()> {
+        for &(x, y) in positions {
+            self.write_position(x, y)?;
+        }
+        Ok(())
+    }
+
+    /// Writes the polyline of the next edge, including its end points.
+    pub fn write_polyline(&mut self, points: &[(f32, f32)]) -> io::Result<()> {
+        if self.position_count != self.node_count {
+            return Err(invalid_input("polylines must follow all positions"));
+        }
+        if self.offsets.len() as u64 > self.edge_count {
+            return Err(invalid_input("too many polylines"));
+        }
+        for &(x, y) in points {
+            self.write_point(x, y)?;
+        }
+        let offset = self.offsets[self.offsets.len() - 1] + points.len() as u64;
+        self.offsets.push(offset);
+        Ok(())
+    }
+
+    /// Writes the offsets and returns the underlying writer.
+    pub fn finish(mut self) -> io::Result<W> {
+        if self.position_count != self.node_count {
+            return Err(invalid_input("missing positions"));
+        }
+        if self.offsets.len() as u64 != self.edge_count + 1 {
+            return Err(invalid_input("missing polylines"));
+        }
+        for offset in &self.offsets {
+            self.writer.write_all(&offset.to_le_bytes())?;
+        }
+        self.writer.flush()?;
+        Ok(self.writer)
+    }
+
+    fn write_point(&mut self, x: f32, y: f32) -> io::Result<()> {
+        let mut bytes = [0; 8];
+        bytes[..4].copy_from_slice(&x.to_le_bytes());
+        bytes[4..].copy_from_slice(&y.to_le_bytes());
+        self.writer.write_all(&bytes)
+    }
+}
+
+/// Read-only view of a layout in a byte buffer, such as a memory-mapped
+/// file. Values are decoded on access; nothing is copied up front.
+pub struct LayoutView<'a> {
+    positions: &'a [u8],
+    points: &'a [u8],
+    offsets: &'a [u8],
+}
+
+fn read_u32(bytes: &[u8], i: usize) -> u32 {
+    let mut b = [0; 4];
+    b.copy_from_slice(&bytes[i..i + 4]);
+    u32::from_le_bytes(b)
+}
+
+fn read_u64(bytes: &[u8], i: usize) -> u64 {
+    let mut b = [0; 8];
+    b.copy_from_slice(&bytes[i..i + 8]);
+    u64::from_le_bytes(b)
+}
+
+fn read_point(bytes: &[u8], i: usize) -> (f32, f32) {
+    (
+        f32::from_bits(read_u32(bytes, 8 * i)),
+        f32::from_bits(read_u32(bytes, 8 * i + 4)),
+    )
+}
+
+impl<'a> LayoutView<'a> {
+    pub fn new(bytes: &'a [u8]) -> io::Result<LayoutView<'a>> {
+        if bytes.len() < HEADER_SIZE || bytes[..4] != MAGIC[..] {
+            return Err(invalid_data("not a layout file"));
+        }
+        if read_u32(bytes, 4) != VERSION {
+            return Err(invalid_data("unsupported layout format version"));
+        }
+        let n = read_u64(bytes, 8);
+        let m = read_u64(bytes, 16);
+        let body = (bytes.len() - HEADER_SIZE) as u64;
+        let fixed = n
+            .checked_add(m)
+            .and_then(|s| s.checked_add(1))
+            .and_then(|s| s.checked_mul(8));
+        let points_size = match fixed {
+            Some(fixed) if fixed <= body && (body - fixed) % 8 == 0 => (body - fixed) as usize,
+            _ => return Err(invalid_data("truncated layout file")),
+        };
+        let positions_end = HEADER_SIZE + 8 * n as usize;
+        let points_end = positions_end + points_size;
+        let view = LayoutView {
+            positions: &bytes[HEADER_SIZE..positions_end],
+            points: &bytes[positions_end..points_end],
+            offsets: &bytes[points_end..],
+        };
+        let mut previous = 0;
+        for e in 0..=m as usize {
+            let offset = view.offset(e);
+            if offset < previous || (e == 0 && offset != 0) {
+                return Err(invalid_data("invalid polyline offsets"));
+            }
+            previous = offset;
+        }
+        if previous != points_size / 8 {
+            return Err(invalid_data("invalid polyline offsets"));
+        }
+        Ok(view)
+    }
+
+    pub fn node_count(&self) -> usize {
+        self.positions.len() / 8
+    }
+
+    pub fn edge_count(&self) -> usize {
+        self.offsets.len() / 8 - 1
+    }
+
+    /// Position of node index `u`. `|_, u| view.position(u.index())` is an
+    /// initial placement for `Simulation::new`.
+    pub fn position(&self, u: usize) -> (f32, f32) {
+        read_point(self.positions, u)
+    }
+
+    /// Copies the positions into `coordinates`, indexed by node index, as
+    /// taken by `fm3_slice` or `stress_majorization_slice`.
+    pub fn read_positions(&self, coordinates: &mut [(f32, f32)]) {
+        assert_eq!(coordinates.len(), self.node_count());
+        for (u, c) in coordinates.iter_mut().enumerate() {
+            *c = self.position(u);
+        }
+    }
+
+    /// Positions by node index, as taken by `stress_majorization` or
+    /// returned by `initial_placement`.
+    pub fn coordinates<Ix: IndexType>(&self) -> HashMap<NodeIndex<Ix>, (f32, f32)> {
+        (0..self.node_count())
+            .map(|u| (NodeIndex::new(u), self.position(u)))
+            .collect()
+    }
+
+    /// Points of the polyline of edge `e`.
+    pub fn polyline(&self, e: usize) -> impl ExactSizeIterator<Item = (f32, f32)> + 'a {
+        let points = self.points;
+        (self.offset(e)..self.offset(e + 1)).map(move |i| read_point(points, i))
+    }
+
+    fn offset(&self, e: usize) -> usize {
+        read_u64(self.offsets, 8 * e) as usize
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_round_trip() {
+        let positions = (0..10).map(|i| (i as f32, -(i as f32))).collect::<Vec<_>>();
+        let polylines = (0..4)
+            .map(|e| (0..e).map(|k| (e as f32, k as f32)).collect::<Vec<_>>())
+            .collect::<Vec<_>>();
+        let mut writer = LayoutWriter::new(vec![], positions.len(), polylines.len()).unwrap();
+        assert!(writer.write_polyline(&polylines[0]).is_err());
+        writer.write_positions(&positions).unwrap();
+        for polyline in &polylines {
+            writer.write_polyline(polyline).unwrap();
+        }
+        let bytes = writer.finish().unwrap();
+
+        let view = LayoutView::new(&bytes).unwrap();
+        assert_eq!(view.node_count(), positions.len());
+        assert_eq!(view.edge_count(), polylines.len());
+        let mut coordinates = vec![(0., 0.); positions.len()];
+        view.read_positions(&mut coordinates);
+        assert_eq!(coordinates, positions);
+        for (e, polyline) in polylines.iter().enumerate() {
+            assert_eq!(&view.polyline(e).collect::<Vec<_>>(), polyline);
+        }
+        assert_eq!(view.coordinates::<u32>()[&NodeIndex::new(3)], positions[3]);
+
+        assert!(LayoutView::new(&bytes[..bytes.len() - 8]).is_err());
+        assert!(LayoutView::new(&bytes[1..]).is_err());
+    }
+
+    #[test]
+    fn test_incomplete_writer() {
+        let mut writer = LayoutWriter::new(vec![], 2, 0).unwrap();
+        writer.write_position(0., 0.).unwrap();
+        assert!(writer.finish().is_err());
+    }
+}
@@ -1,13 +1,13 @@
-use super::group_indices;
+use super::Groups;
 use crate::{Force, Point};
 use petgraph::graph::{Graph, IndexType, NodeIndex};
 use petgraph::EdgeType;
-use std::collections::HashMap;
+use std::sync::Arc;
 
 pub struct GroupCenterForce {
-    groups: HashMap<usize, Vec<usize>>,
-    group_x: HashMap<usize, f32>,
-    group_y: HashMap<usize, f32>,
+    groups: Arc<Groups>,
+    group_x: Vec<f32>,
+    group_y: Vec<f32>,
 }
 
 impl GroupCenterForce {
@@ -21,24 +21,25 @@ impl GroupCenterForce {
         F3: FnMut(usize) -> f32,
     >(
         graph: &Graph<N, E, Ty, Ix>,
-        mut group_accessor: F1,
-        mut group_x_accessor: F2,
-        mut group_y_accessor: F3,
+        group_accessor: F1,
+        group_x_accessor: F2,
+        group_y_accessor: F3,
     ) -> GroupCenterForce {
-        let groups = graph
-            .node_indices()
-            .map(|u| group_accessor(graph, u))
-            .collect::<Vec<_>>();
-        let mut group_x = HashMap::new();
-        let mut group_y = HashMap::new();
-        for &group in groups.iter() {
-            if group_x.contains_key(&group) {
-                continue;
-            }
-            group_x.insert(group, group_x_accessor(group));
-            group_y.insert(group, group_y_accessor(group));
-        }
-        let groups = group_indices(&groups);
+        let groups = Arc::new(Groups::new(graph, group_accessor));
+        GroupCenterForce::with_groups(groups, group_x_accessor, group_y_accessor)
+    }
+
+    pub fn with_groups<F1: FnMut(usize) -> f32, F2: FnMut(usize) -> f32>(
+        groups: Arc<Groups>,
+        mut group_x_accessor: F1,
+        mut group_y_accessor: F2,
+    ) -> GroupCenterForce {
+        let group_x = (0..groups.group_count())
+            .map(|g| group_x_accessor(groups.id(g)))
+            .collect();
+        let group_y = (0..groups.group_count())
+            .map(|g| group_y_accessor(groups.id(g)))
+            .collect();
         GroupCenterForce {
             groups,
             group_x,
@@ -49,9 +50,8 @@ impl GroupCenterForce {
 
 impl Force for GroupCenterForce {
     fn apply(&self, points: &mut Vec<Point>, _alpha: f32) {
-        for (group, indices) in self.groups.iter() {
-            let group_x = self.group_x[group];
-            let group_y = self.group_y[group];
+        for g in 0..self.groups.group_count() {
+            let indices = self.groups.nodes(g);
             let mut center_x = 0.;
             let mut center_y = 0.;
             for &a in indices.iter() {
@@ -60,12 +60,16 @@ impl Force for GroupCenterForce {
             }
             center_x /= indices.len() as f32;
             center_y /= indices.len() as f32;
-            center_x -= group_x;
-            center_y -= group_y;
+            center_x -= self.group_x[g];
+            center_y -= self.group_y[g];
             for &a in indices.iter() {
                 points[a].x -= center_x;
                 points[a].y -= center_y;
             }
         }
     }
+
+    fn scales_with_alpha(&self) -> bool {
+        false
+    }
 }
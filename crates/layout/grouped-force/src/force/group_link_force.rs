@@ -1,8 +1,8 @@
+use super::Groups;
 use crate::{Force, Point};
 use petgraph::graph::{EdgeIndex, Graph, IndexType, NodeIndex};
 use petgraph::EdgeType;
 use petgraph_layout_force_simulation::force::link_force::{LinkArgument, LinkForce};
-use std::collections::HashMap;
 
 pub struct GroupLinkForce {
     link_force: LinkForce,
@@ -20,18 +20,31 @@ impl GroupLinkForce {
         graph: &Graph<N, E, Ty, Ix>,
         intra_group: f32,
         inter_group: f32,
-        mut group_accessor: F1,
+        group_accessor: F1,
         distance_accessor: F2,
     ) -> GroupLinkForce {
-        let groups = graph
-            .node_indices()
-            .map(|u| (u, group_accessor(graph, u)))
-            .collect::<HashMap<_, _>>();
+        let groups = Groups::new(graph, group_accessor);
+        GroupLinkForce::with_groups(graph, intra_group, inter_group, &groups, distance_accessor)
+    }
+
+    pub fn with_groups<
+        N,
+        E,
+        Ty: EdgeType,
+        Ix: IndexType,
+        F: Fn(&Graph<N, E, Ty, Ix>, EdgeIndex<Ix>) -> f32,
+    >(
+        graph: &Graph<N, E, Ty, Ix>,
+        intra_group: f32,
+        inter_group: f32,
+        groups: &Groups,
+        distance_accessor: F,
+    ) -> GroupLinkForce {
         GroupLinkForce {
             link_force: LinkForce::new_with_accessor(graph, |graph, e| {
                 let (u, v) = graph.edge_endpoints(e).unwrap();
                 let distance = Some(distance_accessor(graph, e));
-                let strength = Some(if groups[&u] == groups[&v] {
+                let strength = Some(if groups.group(u.index()) == groups.group(v.index()) {
                     intra_group
                 } else {
                     inter_group
@@ -1,12 +1,19 @@
-use super::group_indices;
+use super::Groups;
 use petgraph::graph::{Graph, IndexType, NodeIndex};
 use petgraph::EdgeType;
-use petgraph_layout_force_simulation::{Force, Point, MIN_DISTANCE};
-use std::collections::HashMap;
+use petgraph_layout_force_simulation::force::BarnesHutTree;
+use petgraph_layout_force_simulation::{Force, Point};
+#[cfg(feature = "parallel")]
+use rayon::prelude::*;
+use std::cell::RefCell;
+use std::sync::Arc;
 
+/// Many-body force between the nodes of each group, approximated with one
+/// Barnes-Hut tree per group.
 pub struct GroupManyBodyForce {
-    groups: HashMap<usize, Vec<usize>>,
+    groups: Arc<Groups>,
     strength: Vec<f32>,
+    trees: RefCell<Vec<BarnesHutTree>>,
 }
 
 impl GroupManyBodyForce {
@@ -19,49 +26,66 @@ impl GroupManyBodyForce {
         F2: FnMut(&Graph<N, E, Ty, Ix>, NodeIndex<Ix>) -> usize,
     >(
         graph: &Graph<N, E, Ty, Ix>,
-        mut strength_accessor: F1,
-        mut group_accessor: F2,
+        strength_accessor: F1,
+        group_accessor: F2,
+    ) -> GroupManyBodyForce {
+        let groups = Arc::new(Groups::new(graph, group_accessor));
+        GroupManyBodyForce::with_groups(graph, strength_accessor, groups)
+    }
+
+    pub fn with_groups<
+        N,
+        E,
+        Ty: EdgeType,
+        Ix: IndexType,
+        F: FnMut(&Graph<N, E, Ty, Ix>, NodeIndex<Ix>) -> f32,
+    >(
+        graph: &Graph<N, E, Ty, Ix>,
+        mut strength_accessor: F,
+        groups: Arc<Groups>,
     ) -> GroupManyBodyForce {
         let strength = graph
             .node_indices()
             .map(|u| strength_accessor(graph, u))
             .collect::<Vec<_>>();
-        let groups = {
-            let groups = graph
-                .node_indices()
-                .map(|u| group_accessor(graph, u))
-                .collect::<Vec<_>>();
-            group_indices(&groups)
-        };
-        GroupManyBodyForce { groups, strength }
+        let trees = RefCell::new(
+            (0..groups.group_count())
+                .map(|_| BarnesHutTree::new())
+                .collect(),
+        );
+        GroupManyBodyForce {
+            groups,
+            strength,
+            trees,
+        }
     }
 }
 
 impl Force for GroupManyBodyForce {
     fn apply(&self, points: &mut Vec<Point>, alpha: f32) {
-        for indices in self.groups.values() {
-            let n = indices.len();
-            for i in 0..n {
-                let a = indices[i];
-                let x0 = points[a].x;
-                let y0 = points[a].y;
-                let mut dvx = 0.;
-                let mut dvy = 0.;
-                for j in 0..n {
-                    if i == j {
-                        continue;
-                    }
-                    let b = indices[j];
-                    let strength = self.strength[b];
-                    let dx = points[b].x - x0;
-                    let dy = points[b].y - y0;
-                    let l = (dx * dx + dy * dy).max(MIN_DISTANCE);
-                    dvx += dx * strength * alpha / l;
-                    dvy += dy * strength * alpha / l;
-                }
-                points[a].vx += dvx;
-                points[a].vy += dvy
-            }
+        let groups = &*self.groups;
+        let strength = &self.strength;
+        let mut trees = self.trees.borrow_mut();
+        {
+            let points = &*points;
+            let build = |(g, tree): (usize, &mut BarnesHutTree)| {
+                tree.rebuild(
+                    groups
+                        .nodes(g)
+                        .iter()
+                        .map(|&u| (points[u].x, points[u].y, strength[u])),
+                );
+            };
+            #[cfg(feature = "parallel")]
+            trees.par_iter_mut().enumerate().for_each(build);
+            #[cfg(not(feature = "parallel"))]
+            trees.iter_mut().enumerate().for_each(build);
         }
+        let trees = &*trees;
+        let apply = |(u, point): (usize, &mut Point)| trees[groups.group(u)].apply(point, alpha);
+        #[cfg(feature = "parallel")]
+        points.par_iter_mut().enumerate().for_each(apply);
+        #[cfg(not(feature = "parallel"))]
+        points.iter_mut().enumerate().for_each(apply);
     }
 }
@@ -1,8 +1,8 @@
+use super::Groups;
 use crate::{Force, Point};
 use petgraph::graph::{Graph, IndexType, NodeIndex};
 use petgraph::EdgeType;
 use petgraph_layout_force_simulation::force::position_force::{NodeArgument, PositionForce};
-use std::collections::HashMap;
 
 pub struct GroupPositionForce {
     position_force: PositionForce,
@@ -18,22 +18,50 @@ impl GroupPositionForce {
         F2: FnMut(&Graph<N, E, Ty, Ix>, NodeIndex<Ix>) -> usize,
         F3: FnMut(usize) -> f32,
         F4: FnMut(usize) -> f32,
+    >(
+        graph: &Graph<N, E, Ty, Ix>,
+        strength_accessor: F1,
+        group_accessor: F2,
+        group_x_accessor: F3,
+        group_y_accessor: F4,
+    ) -> GroupPositionForce {
+        let groups = Groups::new(graph, group_accessor);
+        GroupPositionForce::with_groups(
+            graph,
+            strength_accessor,
+            &groups,
+            group_x_accessor,
+            group_y_accessor,
+        )
+    }
+
+    pub fn with_groups<
+        N,
+        E,
+        Ty: EdgeType,
+        Ix: IndexType,
+        F1: FnMut(&Graph<N, E, Ty, Ix>, NodeIndex<Ix>) -> f32,
+        F2: FnMut(usize) -> f32,
+        F3: FnMut(usize) -> f32,
     >(
         graph: &Graph<N, E, Ty, Ix>,
         mut strength_accessor: F1,
-        mut group_accessor: F2,
-        mut group_x_accessor: F3,
-        mut group_y_accessor: F4,
+        groups: &Groups,
+        mut group_x_accessor: F2,
+        mut group_y_accessor: F3,
     ) -> GroupPositionForce {
-        let groups = graph
-            .node_indices()
-            .map(|u| (u, group_accessor(graph, u)))
-            .collect::<HashMap<_, _>>();
+        let group_x = (0..groups.group_count())
+            .map(|g| group_x_accessor(groups.id(g)))
+            .collect::<Vec<_>>();
+        let group_y = (0..groups.group_count())
+            .map(|g| group_y_accessor(groups.id(g)))
+            .collect::<Vec<_>>();
         GroupPositionForce {
             position_force: PositionForce::new(graph, |graph, u| {
+                let g = groups.group(u.index());
                 let strength = Some(strength_accessor(graph, u));
-                let x = Some(group_x_accessor(groups[&u]));
-                let y = Some(group_y_accessor(groups[&u]));
+                let x = Some(group_x[g]);
+                let y = Some(group_y[g]);
                 NodeArgument { strength, x, y }
             }),
         }
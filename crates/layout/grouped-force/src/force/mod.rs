@@ -7,6 +7,8 @@ pub use self::group_center_force::GroupCenterForce;
 pub use self::group_link_force::GroupLinkForce;
 pub use self::group_many_body_force::GroupManyBodyForce;
 pub use self::group_position_force::GroupPositionForce;
+use petgraph::graph::{Graph, IndexType, NodeIndex};
+use petgraph::EdgeType;
 use std::collections::HashMap;
 
 #[repr(C)]
@@ -22,14 +24,153 @@ impl Group {
     }
 }
 
+/// Node indices of each group id, in ascending order. Kept for callers of
+/// the map-based API; the forces use `Groups`.
 pub fn group_indices(groups: &Vec<usize>) -> HashMap<usize, Vec<usize>> {
-    let mut result = HashMap::new();
-    for (i, &group) in groups.iter().enumerate() {
-        if !result.contains_key(&group) {
-            result.insert(group, Vec::new());
+    let groups = Groups::from_slice(groups);
+    (0..groups.group_count())
+        .map(|g| (groups.id(g), groups.nodes(g).to_vec()))
+        .collect()
+}
+
+/// Group membership in CSR layout, resolved once and shared by the group
+/// forces. Groups are numbered densely in ascending order of their ids.
+pub struct Groups {
+    ids: Vec<usize>,
+    offsets: Vec<usize>,
+    nodes: Vec<usize>,
+    node_group: Vec<usize>,
+}
+
+impl Groups {
+    pub fn new<
+        N,
+        E,
+        Ty: EdgeType,
+        Ix: IndexType,
+        F: FnMut(&Graph<N, E, Ty, Ix>, NodeIndex<Ix>) -> usize,
+    >(
+        graph: &Graph<N, E, Ty, Ix>,
+        mut group_accessor: F,
+    ) -> Groups {
+        let groups = graph
+            .node_indices()
+            .map(|u| group_accessor(graph, u))
+            .collect::<Vec<_>>();
+        Groups::from_slice(&groups)
+    }
+
+    /// `groups[u]` is the group id of node index `u`.
+    pub fn from_slice(groups: &[usize]) -> Groups {
+        let mut ids = groups.to_vec();
+        ids.sort_unstable();
+        ids.dedup();
+        let index = ids
+            .iter()
+            .enumerate()
+            .map(|(g, &id)| (id, g))
+            .collect::<HashMap<_, _>>();
+        let node_group = groups.iter().map(|id| index[id]).collect::<Vec<_>>();
+        let mut offsets = vec![0; ids.len() + 1];
+        for &g in &node_group {
+            offsets[g + 1] += 1;
+        }
+        for g in 0..ids.len() {
+            offsets[g + 1] += offsets[g];
+        }
+        let mut next = offsets.clone();
+        let mut nodes = vec![0; groups.len()];
+        for (u, &g) in node_group.iter().enumerate() {
+            nodes[next[g]] = u;
+            next[g] += 1;
+        }
+        Groups {
+            ids,
+            offsets,
+            nodes,
+            node_group,
+        }
+    }
+
+    pub fn group_count(&self) -> usize {
+        self.ids.len()
+    }
+
+    pub fn node_count(&self) -> usize {
+        self.node_group.len()
+    }
+
+    /// Id of group `g`, as returned by the group accessor.
+    pub fn id(&self, g: usize) -> usize {
+        self.ids[g]
+    }
+
+    /// Dense group of node index `u`.
+    pub fn group(&self, u: usize) -> usize {
+        self.node_group[u]
+    }
+
+    /// Node indices of group `g`, in ascending order.
+    pub fn nodes(&self, g: usize) -> &[usize] {
+        &self.nodes[self.offsets[g]..self.offsets[g + 1]]
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{Force, Point};
+    use petgraph_layout_force_simulation::MIN_DISTANCE;
+
+    #[test]
+    fn test_groups() {
+        let groups = Groups::from_slice(&[7, 3, 7, 5, 3]);
+        assert_eq!(groups.group_count(), 3);
+        assert_eq!(groups.node_count(), 5);
+        assert_eq!(groups.id(0), 3);
+        assert_eq!(groups.nodes(0), &[1, 4]);
+        assert_eq!(groups.nodes(1), &[3]);
+        assert_eq!(groups.nodes(2), &[0, 2]);
+        assert_eq!(groups.group(2), 2);
+        assert_eq!(group_indices(&vec![7, 3, 7, 5, 3])[&7], vec![0, 2]);
+    }
+
+    #[test]
+    fn test_group_many_body_force() {
+        let n = 400;
+        let mut graph = Graph::<(), ()>::new();
+        for _ in 0..n {
+            graph.add_node(());
+        }
+        let group = |u: usize| u % 7;
+        let force = GroupManyBodyForce::new(&graph, |_, _| -30., |_, u| group(u.index()));
+        let mut points = (0..n)
+            .map(|i| {
+                let r = 10. * (i as f32).sqrt();
+                let t = i as f32;
+                Point::new(r * t.cos(), r * t.sin())
+            })
+            .collect::<Vec<_>>();
+        let expected = (0..n)
+            .map(|i| {
+                let mut dv = (0., 0.);
+                for j in (0..n).filter(|&j| j != i && group(j) == group(i)) {
+                    let dx = points[j].x - points[i].x;
+                    let dy = points[j].y - points[i].y;
+                    let l = (dx * dx + dy * dy).max(MIN_DISTANCE);
+                    dv.0 += dx * -30. / l;
+                    dv.1 += dy * -30. / l;
+                }
+                dv
+            })
+            .collect::<Vec<_>>();
+        force.apply(&mut points, 1.);
+        let mut error = 0.;
+        let mut norm = 0.;
+        for (point, &(vx, vy)) in points.iter().zip(&expected) {
+            error += ((point.vx - vx).powi(2) + (point.vy - vy).powi(2)).sqrt();
+            norm += (vx * vx + vy * vy).sqrt();
         }
-        let ids = result.get_mut(&group).unwrap();
-        ids.push(i);
+        assert!(error < 0.1 * norm);
     }
-    result
 }
@@ -1,12 +1,15 @@
 pub mod force;
 pub mod grouping;
 
+use force::Groups;
 use petgraph::graph::{Graph, IndexType, NodeIndex};
 use petgraph::EdgeType;
 use petgraph_layout_force_simulation::force::CenterForce;
 use petgraph_layout_force_simulation::{Force, Point};
-use std::collections::HashMap;
+use std::sync::Arc;
 
+/// Forces for a grouped layout. Group membership is resolved once and
+/// shared by all of the group forces.
 pub fn force_grouped<
     N,
     E,
@@ -15,36 +18,33 @@ pub fn force_grouped<
     F: FnMut(&Graph<N, E, Ty, Ix>, NodeIndex<Ix>) -> usize,
 >(
     graph: &Graph<N, E, Ty, Ix>,
-    mut group_accessor: F,
+    group_accessor: F,
 ) -> Vec<Box<dyn Force>> {
-    let groups = graph
-        .node_indices()
-        .map(|u| (u, group_accessor(graph, u)))
-        .collect::<HashMap<_, _>>();
-    let group_pos = grouping::force_directed_grouping(graph, |_, u| groups[&u]);
+    let groups = Arc::new(Groups::new(graph, group_accessor));
+    let group_pos =
+        grouping::force_directed_grouping(graph, |_, u| groups.id(groups.group(u.index())));
     vec![
-        Box::new(force::GroupManyBodyForce::new(
+        Box::new(force::GroupManyBodyForce::with_groups(
             &graph,
             |_, _| -30.,
-            |_, u| groups[&u],
+            groups.clone(),
         )),
-        Box::new(force::GroupLinkForce::new(
+        Box::new(force::GroupLinkForce::with_groups(
             &graph,
             0.1,
             0.01,
-            |_, u| groups[&u],
+            &groups,
             |_, _| 30.,
         )),
-        Box::new(force::GroupPositionForce::new(
+        Box::new(force::GroupPositionForce::with_groups(
             &graph,
             |_, _| 0.1,
-            |_, u| groups[&u],
+            &groups,
             |g| group_pos[&g].x,
             |g| group_pos[&g].y,
         )),
-        Box::new(force::GroupCenterForce::new(
-            &graph,
-            |_, u| groups[&u],
+        Box::new(force::GroupCenterForce::with_groups(
+            groups.clone(),
             |g| group_pos[&g].x,
             |g| group_pos[&g].y,
         )),
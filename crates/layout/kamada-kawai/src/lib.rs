@@ -1,5 +1,5 @@
 use petgraph::visit::{IntoEdgeReferences, IntoNodeIdentifiers, NodeCount};
-use petgraph_algorithm_shortest_path::warshall_floyd;
+use petgraph_algorithm_shortest_path::all_sources_shortest_path;
 use std::collections::HashMap;
 use std::hash::Hash;
 
@@ -19,46 +19,80 @@ pub fn kamada_kawai<G, F>(
     .node_identifiers()
     .map(|u| coordinates[&u])
     .collect::<Vec<_>>();
+  kamada_kawai_slice(graph, &mut pos, length, eps, width, height);
+  for (u, p) in graph.node_identifiers().zip(pos) {
+    coordinates.insert(u, p);
+  }
+}
+
+/// Same as `kamada_kawai`, with `coordinates` indexed in `node_identifiers` order.
+/// Panics unless `coordinates.len() == graph.node_count()`.
+pub fn kamada_kawai_slice<G, F>(
+  graph: G,
+  coordinates: &mut [(f32, f32)],
+  length: &mut F,
+  eps: f32,
+  width: f32,
+  height: f32,
+) where
+  G: IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+  F: FnMut(G::EdgeRef) -> f32,
+{
+  assert_eq!(coordinates.len(), graph.node_count());
+  let pos = coordinates;
   let n = pos.len();
-  let d = warshall_floyd(graph, length);
+  let d = all_sources_shortest_path(graph, length);
 
   let mut d_max = 0.;
   for i in 0..n {
     for j in 0..n {
-      if d[i][j] > d_max {
-        d_max = d[i][j];
+      if d[i * n + j] > d_max {
+        d_max = d[i * n + j];
       }
     }
   }
 
   let size = if width < height { width } else { height };
-  let mut k = vec![vec![0.; n]; n];
-  let mut l = vec![vec![0.; n]; n];
-  for i in 0..n {
-    for j in 0..n {
-      k[i][j] = 100. / (d[i][j] * d[i][j]);
-      l[i][j] = 0.5 * size * d[i][j] / d_max
-    }
-  }
+  let l0 = 0.5 * size / d_max;
+  let kl = |i: usize, j: usize| {
+    let dij = d[i * n + j];
+    (100. / (dij * dij), l0 * dij)
+  };
+  let gradient = |pos: &[(f32, f32)], m: usize, i: usize| {
+    let (xm, ym) = pos[m];
+    let (xi, yi) = pos[i];
+    let dx = xm - xi;
+    let dy = ym - yi;
+    let d = (dx * dx + dy * dy).sqrt();
+    let (kmi, lmi) = kl(m, i);
+    (kmi * (1. - lmi / d) * dx, kmi * (1. - lmi / d) * dy)
+  };
 
+  // dE/dx and dE/dy of every node are kept up to date as nodes move, and
+  // refreshed from scratch every n moves to bound rounding drift.
+  let mut dedx = vec![0.; n];
+  let mut dedy = vec![0.; n];
+  let mut moves = n;
   loop {
+    if moves == n {
+      moves = 0;
+      for m in 0..n {
+        dedx[m] = 0.;
+        dedy[m] = 0.;
+        for i in 0..n {
+          if i != m {
+            let (gx, gy) = gradient(&pos, m, i);
+            dedx[m] += gx;
+            dedy[m] += gy;
+          }
+        }
+      }
+    }
     let mut delta2_max = 0.;
     let mut m_target = 0;
     for m in 0..n {
-      let (xm, ym) = pos[m];
-      let mut dedx = 0.;
-      let mut dedy = 0.;
-      for i in 0..n {
-        if i != m {
-          let (xi, yi) = pos[i];
-          let dx = xm - xi;
-          let dy = ym - yi;
-          let d = (dx * dx + dy * dy).sqrt();
-          dedx += k[m][i] * (1. - l[m][i] / d) * dx;
-          dedy += k[m][i] * (1. - l[m][i] / d) * dy;
-        }
-      }
-      let delta2 = dedx * dedx + dedy * dedy;
+      let delta2 = dedx[m] * dedx[m] + dedy[m] * dedy[m];
       if delta2 > delta2_max {
         delta2_max = delta2;
         m_target = m;
@@ -70,40 +104,47 @@ pub fn kamada_kawai<G, F>(
     }
 
     let m = m_target;
-    loop {
-      let (xm, ym) = pos[m];
-      let mut hxx = 0.;
-      let mut hyy = 0.;
-      let mut hxy = 0.;
-      let mut dedx = 0.;
-      let mut dedy = 0.;
-      for i in 0..n {
-        if i != m {
-          let (xi, yi) = pos[i];
-          let dx = xm - xi;
-          let dy = ym - yi;
-          let d = (dx * dx + dy * dy).sqrt();
-          hxx += k[m][i] * (1. - l[m][i] * dy * dy / (d * d * d));
-          hyy += k[m][i] * (1. - l[m][i] * dx * dx / (d * d * d));
-          hxy += k[m][i] * l[m][i] * dx * dy / (d * d * d);
-          dedx += k[m][i] * (1. - l[m][i] / d) * dx;
-          dedy += k[m][i] * (1. - l[m][i] / d) * dy;
-        }
-      }
-      if dedx * dedx + dedy * dedy < eps * eps {
-        break;
+    let (xm, ym) = pos[m];
+    let mut hxx = 0.;
+    let mut hyy = 0.;
+    let mut hxy = 0.;
+    for i in 0..n {
+      if i != m {
+        let (xi, yi) = pos[i];
+        let dx = xm - xi;
+        let dy = ym - yi;
+        let d = (dx * dx + dy * dy).sqrt();
+        let (kmi, lmi) = kl(m, i);
+        hxx += kmi * (1. - lmi * dy * dy / (d * d * d));
+        hyy += kmi * (1. - lmi * dx * dx / (d * d * d));
+        hxy += kmi * lmi * dx * dy / (d * d * d);
       }
-      let d = hxx * hyy - hxy * hxy;
-      let delta_x = (hyy * dedx - hxy * dedy) / d;
-      let delta_y = (hxx * dedy - hxy * dedx) / d;
-      pos[m].0 -= delta_x;
-      pos[m].1 -= delta_y;
-      break;
     }
-  }
+    let det = hxx * hyy - hxy * hxy;
+    let delta_x = (hyy * dedx[m] - hxy * dedy[m]) / det;
+    let delta_y = (hxx * dedy[m] - hxy * dedx[m]) / det;
 
-  for (u, (x, y)) in graph.node_identifiers().zip(pos) {
-    coordinates.insert(u, (x, y));
+    for i in 0..n {
+      if i != m {
+        let (gx, gy) = gradient(&pos, i, m);
+        dedx[i] -= gx;
+        dedy[i] -= gy;
+      }
+    }
+    pos[m].0 -= delta_x;
+    pos[m].1 -= delta_y;
+    dedx[m] = 0.;
+    dedy[m] = 0.;
+    for i in 0..n {
+      if i != m {
+        let (gx, gy) = gradient(&pos, i, m);
+        dedx[i] += gx;
+        dedy[i] += gy;
+        dedx[m] -= gx;
+        dedy[m] -= gy;
+      }
+    }
+    moves += 1;
   }
 }
 
@@ -184,3 +225,53 @@ fn test_kamada_kawai() {
     println!("{:?}", coordinates[&u]);
   }
 }
+
+#[test]
+fn test_kamada_kawai_gradient() {
+  use petgraph::Graph;
+
+  let n = 5;
+  let mut graph = Graph::new_undirected();
+  let nodes = (0..n * n).map(|_| graph.add_node(())).collect::<Vec<_>>();
+  for i in 0..n {
+    for j in 0..n {
+      if i + 1 < n {
+        graph.add_edge(nodes[i * n + j], nodes[(i + 1) * n + j], ());
+      }
+      if j + 1 < n {
+        graph.add_edge(nodes[i * n + j], nodes[i * n + j + 1], ());
+      }
+    }
+  }
+  let mut coordinates = HashMap::new();
+  for (i, &u) in nodes.iter().enumerate() {
+    let t = i as f32 * 2.399;
+    coordinates.insert(u, (300. * t.cos(), 300. * t.sin()));
+  }
+
+  let eps = 1e-1;
+  let size = 1000.;
+  kamada_kawai(&graph, &mut coordinates, &mut |_| 1., eps, size, size);
+
+  let d = all_sources_shortest_path(&graph, &mut |_| 1.);
+  let d_max = d.iter().fold(0., |m: f32, &dij| m.max(dij));
+  for m in 0..n * n {
+    let (xm, ym) = coordinates[&nodes[m]];
+    let mut dedx = 0.;
+    let mut dedy = 0.;
+    for i in 0..n * n {
+      if i != m {
+        let (xi, yi) = coordinates[&nodes[i]];
+        let dx = xm - xi;
+        let dy = ym - yi;
+        let norm = (dx * dx + dy * dy).sqrt();
+        let dmi = d[m * n * n + i];
+        let kmi = 100. / (dmi * dmi);
+        let lmi = 0.5 * size * dmi / d_max;
+        dedx += kmi * (1. - lmi / norm) * dx;
+        dedy += kmi * (1. - lmi / norm) * dy;
+      }
+    }
+    assert!((dedx * dedx + dedy * dedy).sqrt() < 2. * eps);
+  }
+}
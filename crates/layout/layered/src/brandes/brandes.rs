@@ -1,10 +1,12 @@
 use super::super::graph::{Edge, Node};
 use super::horizontal_compaction::horizontal_compaction;
+use super::layering::Layering;
 use super::mark_conflicts::mark_conflicts;
 use super::vertical_alignment::vertical_alignment;
 use petgraph::graph::IndexType;
 use petgraph::prelude::*;
-use std::iter::FromIterator;
+#[cfg(feature = "parallel")]
+use rayon::prelude::*;
 
 fn set_y<Ix: IndexType>(
     graph: &mut Graph<Node<Ix>, Edge, Directed, Ix>,
@@ -38,47 +40,56 @@ fn normalize<Ix: IndexType>(graph: &mut Graph<Node<Ix>, Edge, Directed, Ix>) {
     }
 }
 
+/// Assigns x coordinates with the four vertical alignment and horizontal
+/// compaction passes of Brandes and Köpf, balanced by the median of the four
+/// candidates of each node. The passes only read `layering` and run in
+/// parallel with the `parallel` feature.
 pub fn brandes<Ix: IndexType>(
     graph: &mut Graph<Node<Ix>, Edge, Directed, Ix>,
     layers: &Vec<Vec<NodeIndex<Ix>>>,
 ) {
     mark_conflicts(graph, layers);
+    let layering = Layering::new(graph, layers);
     let directions = vec![(false, false), (true, false), (false, true), (true, true)];
-    let mut xs = Vec::from_iter(graph.node_indices().map(|_| [0; 4]));
-    let mut left = [0; 4];
-    let mut right = [0; 4];
-    for (i, &direction) in directions.iter().enumerate() {
-        let (rtol, btot) = direction;
-        vertical_alignment(graph, layers, rtol, btot);
-        horizontal_compaction(graph, layers, rtol);
+    let run = |&(rtol, btot): &(bool, bool)| {
+        let alignment = vertical_alignment(&layering, rtol, btot);
+        let mut x = horizontal_compaction(&layering, &alignment, rtol);
         if rtol {
-            for u in graph.node_indices() {
-                graph[u].x = -graph[u].x;
+            for x in x.iter_mut() {
+                *x = -*x;
             }
         }
-        left[i] = graph.node_indices().map(|u| graph[u].x).min().unwrap();
-        right[i] = graph.node_indices().map(|u| graph[u].x).max().unwrap();
-        for (j, u) in graph.node_indices().enumerate() {
-            xs[j][i] = graph[u].x;
-        }
-    }
+        x
+    };
+    #[cfg(feature = "parallel")]
+    let mut xs = directions.par_iter().map(run).collect::<Vec<_>>();
+    #[cfg(not(feature = "parallel"))]
+    let mut xs = directions.iter().map(run).collect::<Vec<_>>();
+
+    let left = xs
+        .iter()
+        .map(|x| *x.iter().min().unwrap())
+        .collect::<Vec<_>>();
+    let right = xs
+        .iter()
+        .map(|x| *x.iter().max().unwrap())
+        .collect::<Vec<_>>();
     let min_width_index = (0..4).min_by_key(|&i| right[i] - left[i]).unwrap();
-    for (i, &direction) in directions.iter().enumerate() {
-        let (rtol, _) = direction;
-        if rtol {
-            for j in 0..graph.node_count() {
-                xs[j][i] += right[min_width_index] - right[i];
-            }
+    for (i, &(rtol, _)) in directions.iter().enumerate() {
+        let offset = if rtol {
+            right[min_width_index] - right[i]
         } else {
-            for j in 0..graph.node_count() {
-                xs[j][i] += left[min_width_index] - left[i];
-            }
+            left[min_width_index] - left[i]
+        };
+        for x in xs[i].iter_mut() {
+            *x += offset;
         }
     }
 
-    for (i, u) in graph.node_indices().enumerate() {
-        xs[i].sort();
-        graph[u].x = (xs[i][1] + xs[i][2]) / 2;
+    for (j, u) in graph.node_indices().enumerate() {
+        let mut candidates = [xs[0][j], xs[1][j], xs[2][j], xs[3][j]];
+        candidates.sort();
+        graph[u].x = (candidates[1] + candidates[2]) / 2;
     }
 
     set_y(graph, layers);
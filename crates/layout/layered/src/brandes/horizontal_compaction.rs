@@ -1,80 +1,97 @@
-use super::super::graph::{Edge, Node};
-use petgraph::graph::IndexType;
-use petgraph::prelude::*;
+use super::layering::Layering;
+use super::vertical_alignment::Alignment;
 
-fn place_block<Ix: IndexType>(
-    graph: &mut Graph<Node<Ix>, Edge, Directed, Ix>,
-    layers: &Vec<Vec<NodeIndex<Ix>>>,
-    v: NodeIndex<Ix>,
+/// Per-node state of one compaction pass.
+struct Compaction {
+    x: Vec<i32>,
+    sink: Vec<usize>,
+    shift: Vec<i32>,
+    placed: Vec<bool>,
+    stack: Vec<(usize, usize)>,
+}
+
+/// Places the block of `root` and, first, every block it depends on, with an
+/// explicit stack as chains of blocks can be as long as a layer is wide.
+fn place_block(
+    layering: &Layering,
+    alignment: &Alignment,
+    root: usize,
     rtol: bool,
+    state: &mut Compaction,
 ) {
-    if graph[v].x > 0 {
-        return;
-    }
-    let mut w = v;
-    loop {
-        let w_layer = graph[w].layer;
-        let w_order = graph[w].order;
-
-        if (rtol && w_order < layers[w_layer].len() - 1) || (!rtol && w_order > 0) {
+    let Alignment { root: roots, align } = alignment;
+    let Compaction {
+        x,
+        sink,
+        shift,
+        placed,
+        stack,
+    } = state;
+    placed[root] = true;
+    stack.push((root, root));
+    while let Some(&(v, w)) = stack.last() {
+        let layer = layering.layer_nodes(layering.layer[w]);
+        let w_order = layering.order[w];
+        if (rtol && w_order < layer.len() - 1) || (!rtol && w_order > 0) {
             let p = if rtol {
-                layers[w_layer][w_order + 1]
+                layer[w_order + 1]
             } else {
-                layers[w_layer][w_order - 1]
+                layer[w_order - 1]
             };
-            let u = graph[p].root.unwrap();
-            place_block(graph, layers, u, rtol);
-            if graph[v].sink.unwrap() == v {
-                graph[v].sink = graph[u].sink;
+            let u = roots[p];
+            if !placed[u] {
+                placed[u] = true;
+                stack.push((u, u));
+                continue;
+            }
+            if sink[v] == v {
+                sink[v] = sink[u];
             }
-            if graph[v].sink == graph[u].sink {
-                let p_width = graph[p].width as i32;
-                let w_width = graph[w].width as i32;
-                let new_x = graph[u].x + (p_width + w_width) / 2;
-                if new_x > graph[v].x {
-                    graph[v].x = new_x;
-                }
+            let separation = (layering.width[p] + layering.width[w]) / 2;
+            if sink[v] == sink[u] {
+                x[v] = x[v].max(x[u] + separation);
             } else {
-                let p_width = graph[p].width as i32;
-                let w_width = graph[w].width as i32;
-                let new_shift = graph[v].x - graph[u].x - (p_width + w_width) / 2;
-                let u_sink = graph[u].sink.unwrap();
-                if new_shift < graph[u_sink].shift {
-                    graph[u_sink].shift = new_shift;
-                }
+                let u_sink = sink[u];
+                shift[u_sink] = shift[u_sink].min(x[v] - x[u] - separation);
             }
         }
-        w = graph[w].align.unwrap();
+        let w = align[w];
         if w == v {
-            break;
+            stack.pop();
+        } else {
+            *stack.last_mut().unwrap() = (v, w);
         }
     }
 }
 
-pub fn horizontal_compaction<Ix: IndexType>(
-    graph: &mut Graph<Node<Ix>, Edge, Directed, Ix>,
-    layers: &Vec<Vec<NodeIndex<Ix>>>,
-    rtol: bool,
-) {
-    for u in graph.node_indices() {
-        graph[u].sink = Some(u);
-        graph[u].shift = i32::max_value();
-        graph[u].x = 0;
-    }
-    for u in graph.node_indices() {
-        if graph[u].root.unwrap() == u {
-            place_block(graph, layers, u, rtol);
-        }
-    }
-    for u in graph.node_indices() {
-        graph[u].x = graph[graph[u].root.unwrap()].x;
-    }
-    for u in graph.node_indices() {
-        let shift = graph[graph[graph[u].root.unwrap()].sink.unwrap()].shift;
-        if shift < i32::max_value() {
-            graph[u].x += shift;
+/// Returns the x coordinate of each node by node index for the blocks of
+/// `alignment`. With `rtol`, blocks are placed against their right neighbors
+/// and x grows leftward.
+pub fn horizontal_compaction(layering: &Layering, alignment: &Alignment, rtol: bool) -> Vec<i32> {
+    let n = layering.node_count();
+    let mut state = Compaction {
+        x: vec![0; n],
+        sink: (0..n).collect(),
+        shift: vec![i32::max_value(); n],
+        placed: vec![false; n],
+        stack: vec![],
+    };
+    for u in 0..n {
+        if alignment.root[u] == u && !state.placed[u] {
+            place_block(layering, alignment, u, rtol, &mut state);
         }
     }
+    (0..n)
+        .map(|u| {
+            let root = alignment.root[u];
+            let shift = state.shift[state.sink[root]];
+            if shift < i32::max_value() {
+                state.x[root] + shift
+            } else {
+                state.x[root]
+            }
+        })
+        .collect()
 }
 
 #[cfg(test)]
@@ -509,58 +526,60 @@ mod tests {
                 ..Edge::new()
             },
         );
-        graph[a1].align = Some(b1);
-        graph[a2].align = Some(b3);
-        graph[b1].align = Some(a1);
-        graph[b2].align = Some(b2);
-        graph[b3].align = Some(a2);
-        graph[b4].align = Some(c2);
-        graph[b5].align = Some(c3);
-        graph[b6].align = Some(c4);
-        graph[b7].align = Some(b7);
-        graph[b8].align = Some(c5);
-        graph[c1].align = Some(d1);
-        graph[c2].align = Some(b4);
-        graph[c3].align = Some(d4);
-        graph[c4].align = Some(d5);
-        graph[c5].align = Some(d6);
-        graph[c6].align = Some(d7);
-        graph[d1].align = Some(e1);
-        graph[d2].align = Some(e2);
-        graph[d3].align = Some(d3);
-        graph[d4].align = Some(b5);
-        graph[d5].align = Some(e3);
-        graph[d6].align = Some(b8);
-        graph[d7].align = Some(c6);
-        graph[e1].align = Some(c1);
-        graph[e2].align = Some(d2);
-        graph[e3].align = Some(b6);
-        graph[a1].root = Some(a1);
-        graph[a2].root = Some(a2);
-        graph[b1].root = Some(a1);
-        graph[b2].root = Some(b2);
-        graph[b3].root = Some(a2);
-        graph[b4].root = Some(b4);
-        graph[b5].root = Some(b5);
-        graph[b6].root = Some(b6);
-        graph[b7].root = Some(b7);
-        graph[b8].root = Some(b8);
-        graph[c1].root = Some(c1);
-        graph[c2].root = Some(b4);
-        graph[c3].root = Some(b5);
-        graph[c4].root = Some(b6);
-        graph[c5].root = Some(b8);
-        graph[c6].root = Some(c6);
-        graph[d1].root = Some(c1);
-        graph[d2].root = Some(d2);
-        graph[d3].root = Some(d3);
-        graph[d4].root = Some(b5);
-        graph[d5].root = Some(b6);
-        graph[d6].root = Some(b8);
-        graph[d7].root = Some(c6);
-        graph[e1].root = Some(c1);
-        graph[e2].root = Some(d2);
-        graph[e3].root = Some(b6);
+        let mut align = vec![0; graph.node_count()];
+        let mut root = vec![0; graph.node_count()];
+        align[a1.index()] = b1.index();
+        align[a2.index()] = b3.index();
+        align[b1.index()] = a1.index();
+        align[b2.index()] = b2.index();
+        align[b3.index()] = a2.index();
+        align[b4.index()] = c2.index();
+        align[b5.index()] = c3.index();
+        align[b6.index()] = c4.index();
+        align[b7.index()] = b7.index();
+        align[b8.index()] = c5.index();
+        align[c1.index()] = d1.index();
+        align[c2.index()] = b4.index();
+        align[c3.index()] = d4.index();
+        align[c4.index()] = d5.index();
+        align[c5.index()] = d6.index();
+        align[c6.index()] = d7.index();
+        align[d1.index()] = e1.index();
+        align[d2.index()] = e2.index();
+        align[d3.index()] = d3.index();
+        align[d4.index()] = b5.index();
+        align[d5.index()] = e3.index();
+        align[d6.index()] = b8.index();
+        align[d7.index()] = c6.index();
+        align[e1.index()] = c1.index();
+        align[e2.index()] = d2.index();
+        align[e3.index()] = b6.index();
+        root[a1.index()] = a1.index();
+        root[a2.index()] = a2.index();
+        root[b1.index()] = a1.index();
+        root[b2.index()] = b2.index();
+        root[b3.index()] = a2.index();
+        root[b4.index()] = b4.index();
+        root[b5.index()] = b5.index();
+        root[b6.index()] = b6.index();
+        root[b7.index()] = b7.index();
+        root[b8.index()] = b8.index();
+        root[c1.index()] = c1.index();
+        root[c2.index()] = b4.index();
+        root[c3.index()] = b5.index();
+        root[c4.index()] = b6.index();
+        root[c5.index()] = b8.index();
+        root[c6.index()] = c6.index();
+        root[d1.index()] = c1.index();
+        root[d2.index()] = d2.index();
+        root[d3.index()] = d3.index();
+        root[d4.index()] = b5.index();
+        root[d5.index()] = b6.index();
+        root[d6.index()] = b8.index();
+        root[d7.index()] = c6.index();
+        root[e1.index()] = c1.index();
+        root[e2.index()] = d2.index();
+        root[e3.index()] = b6.index();
         let layers = vec![
             vec![a1, a2],
             vec![b1, b2, b3, b4, b5, b6, b7, b8],
@@ -568,33 +587,34 @@ mod tests {
             vec![d1, d2, d3, d4, d5, d6, d7],
             vec![e1, e2, e3],
         ];
-        horizontal_compaction(&mut graph, &layers, false);
-        assert_eq!(graph[a1].x, 0);
-        assert_eq!(graph[a2].x, 20);
-        assert_eq!(graph[b1].x, 0);
-        assert_eq!(graph[b2].x, 10);
-        assert_eq!(graph[b3].x, 20);
-        assert_eq!(graph[b4].x, 30);
-        assert_eq!(graph[b5].x, 40);
-        assert_eq!(graph[b6].x, 50);
-        assert_eq!(graph[b7].x, 60);
-        assert_eq!(graph[b8].x, 70);
-        assert_eq!(graph[c1].x, 10);
-        assert_eq!(graph[c2].x, 30);
-        assert_eq!(graph[c3].x, 40);
-        assert_eq!(graph[c4].x, 50);
-        assert_eq!(graph[c5].x, 70);
-        assert_eq!(graph[c6].x, 80);
-        assert_eq!(graph[d1].x, 10);
-        assert_eq!(graph[d2].x, 20);
-        assert_eq!(graph[d3].x, 30);
-        assert_eq!(graph[d4].x, 40);
-        assert_eq!(graph[d5].x, 50);
-        assert_eq!(graph[d6].x, 70);
-        assert_eq!(graph[d7].x, 80);
-        assert_eq!(graph[e1].x, 10);
-        assert_eq!(graph[e2].x, 20);
-        assert_eq!(graph[e3].x, 50);
+        let layering = Layering::new(&graph, &layers);
+        let x = horizontal_compaction(&layering, &Alignment { root, align }, false);
+        assert_eq!(x[a1.index()], 0);
+        assert_eq!(x[a2.index()], 20);
+        assert_eq!(x[b1.index()], 0);
+        assert_eq!(x[b2.index()], 10);
+        assert_eq!(x[b3.index()], 20);
+        assert_eq!(x[b4.index()], 30);
+        assert_eq!(x[b5.index()], 40);
+        assert_eq!(x[b6.index()], 50);
+        assert_eq!(x[b7.index()], 60);
+        assert_eq!(x[b8.index()], 70);
+        assert_eq!(x[c1.index()], 10);
+        assert_eq!(x[c2.index()], 30);
+        assert_eq!(x[c3.index()], 40);
+        assert_eq!(x[c4.index()], 50);
+        assert_eq!(x[c5.index()], 70);
+        assert_eq!(x[c6.index()], 80);
+        assert_eq!(x[d1.index()], 10);
+        assert_eq!(x[d2.index()], 20);
+        assert_eq!(x[d3.index()], 30);
+        assert_eq!(x[d4.index()], 40);
+        assert_eq!(x[d5.index()], 50);
+        assert_eq!(x[d6.index()], 70);
+        assert_eq!(x[d7.index()], 80);
+        assert_eq!(x[e1.index()], 10);
+        assert_eq!(x[e2.index()], 20);
+        assert_eq!(x[e3.index()], 50);
     }
 
     #[test]
@@ -1029,34 +1049,35 @@ mod tests {
             vec![d1, d2, d3, d4, d5, d6, d7],
             vec![e1, e2, e3],
         ];
-        vertical_alignment(&mut graph, &layers, true, false);
-        horizontal_compaction(&mut graph, &layers, true);
-        assert_eq!(graph[a1].x, 10);
-        assert_eq!(graph[a2].x, 0);
-        assert_eq!(graph[b1].x, 90);
-        assert_eq!(graph[b2].x, 80);
-        assert_eq!(graph[b3].x, 70);
-        assert_eq!(graph[b4].x, 60);
-        assert_eq!(graph[b5].x, 50);
-        assert_eq!(graph[b6].x, 40);
-        assert_eq!(graph[b7].x, 20);
-        assert_eq!(graph[b8].x, 10);
-        assert_eq!(graph[c1].x, 70);
-        assert_eq!(graph[c2].x, 60);
-        assert_eq!(graph[c3].x, 50);
-        assert_eq!(graph[c4].x, 40);
-        assert_eq!(graph[c5].x, 30);
-        assert_eq!(graph[c6].x, 20);
-        assert_eq!(graph[d1].x, 80);
-        assert_eq!(graph[d2].x, 70);
-        assert_eq!(graph[d3].x, 60);
-        assert_eq!(graph[d4].x, 50);
-        assert_eq!(graph[d5].x, 40);
-        assert_eq!(graph[d6].x, 30);
-        assert_eq!(graph[d7].x, 20);
-        assert_eq!(graph[e1].x, 80);
-        assert_eq!(graph[e2].x, 70);
-        assert_eq!(graph[e3].x, 30);
+        let layering = Layering::new(&graph, &layers);
+        let alignment = vertical_alignment(&layering, true, false);
+        let x = horizontal_compaction(&layering, &alignment, true);
+        assert_eq!(x[a1.index()], 10);
+        assert_eq!(x[a2.index()], 0);
+        assert_eq!(x[b1.index()], 90);
+        assert_eq!(x[b2.index()], 80);
+        assert_eq!(x[b3.index()], 70);
+        assert_eq!(x[b4.index()], 60);
+        assert_eq!(x[b5.index()], 50);
+        assert_eq!(x[b6.index()], 40);
+        assert_eq!(x[b7.index()], 20);
+        assert_eq!(x[b8.index()], 10);
+        assert_eq!(x[c1.index()], 70);
+        assert_eq!(x[c2.index()], 60);
+        assert_eq!(x[c3.index()], 50);
+        assert_eq!(x[c4.index()], 40);
+        assert_eq!(x[c5.index()], 30);
+        assert_eq!(x[c6.index()], 20);
+        assert_eq!(x[d1.index()], 80);
+        assert_eq!(x[d2.index()], 70);
+        assert_eq!(x[d3.index()], 60);
+        assert_eq!(x[d4.index()], 50);
+        assert_eq!(x[d5.index()], 40);
+        assert_eq!(x[d6.index()], 30);
+        assert_eq!(x[d7.index()], 20);
+        assert_eq!(x[e1.index()], 80);
+        assert_eq!(x[e2.index()], 70);
+        assert_eq!(x[e3.index()], 30);
     }
 
     #[test]
@@ -1491,34 +1512,35 @@ mod tests {
             vec![d1, d2, d3, d4, d5, d6, d7],
             vec![e1, e2, e3],
         ];
-        vertical_alignment(&mut graph, &layers, false, true);
-        horizontal_compaction(&mut graph, &layers, false);
-        assert_eq!(graph[a1].x, 60);
-        assert_eq!(graph[a2].x, 70);
-        assert_eq!(graph[b1].x, 10);
-        assert_eq!(graph[b2].x, 20);
-        assert_eq!(graph[b3].x, 30);
-        assert_eq!(graph[b4].x, 40);
-        assert_eq!(graph[b5].x, 50);
-        assert_eq!(graph[b6].x, 60);
-        assert_eq!(graph[b7].x, 80);
-        assert_eq!(graph[b8].x, 90);
-        assert_eq!(graph[c1].x, 10);
-        assert_eq!(graph[c2].x, 20);
-        assert_eq!(graph[c3].x, 50);
-        assert_eq!(graph[c4].x, 60);
-        assert_eq!(graph[c5].x, 70);
-        assert_eq!(graph[c6].x, 80);
-        assert_eq!(graph[d1].x, 0);
-        assert_eq!(graph[d2].x, 10);
-        assert_eq!(graph[d3].x, 20);
-        assert_eq!(graph[d4].x, 50);
-        assert_eq!(graph[d5].x, 60);
-        assert_eq!(graph[d6].x, 70);
-        assert_eq!(graph[d7].x, 80);
-        assert_eq!(graph[e1].x, 0);
-        assert_eq!(graph[e2].x, 10);
-        assert_eq!(graph[e3].x, 50);
+        let layering = Layering::new(&graph, &layers);
+        let alignment = vertical_alignment(&layering, false, true);
+        let x = horizontal_compaction(&layering, &alignment, false);
+        assert_eq!(x[a1.index()], 60);
+        assert_eq!(x[a2.index()], 70);
+        assert_eq!(x[b1.index()], 10);
+        assert_eq!(x[b2.index()], 20);
+        assert_eq!(x[b3.index()], 30);
+        assert_eq!(x[b4.index()], 40);
+        assert_eq!(x[b5.index()], 50);
+        assert_eq!(x[b6.index()], 60);
+        assert_eq!(x[b7.index()], 80);
+        assert_eq!(x[b8.index()], 90);
+        assert_eq!(x[c1.index()], 10);
+        assert_eq!(x[c2.index()], 20);
+        assert_eq!(x[c3.index()], 50);
+        assert_eq!(x[c4.index()], 60);
+        assert_eq!(x[c5.index()], 70);
+        assert_eq!(x[c6.index()], 80);
+        assert_eq!(x[d1.index()], 0);
+        assert_eq!(x[d2.index()], 10);
+        assert_eq!(x[d3.index()], 20);
+        assert_eq!(x[d4.index()], 50);
+        assert_eq!(x[d5.index()], 60);
+        assert_eq!(x[d6.index()], 70);
+        assert_eq!(x[d7.index()], 80);
+        assert_eq!(x[e1.index()], 0);
+        assert_eq!(x[e2.index()], 10);
+        assert_eq!(x[e3.index()], 50);
     }
 
     #[test]
@@ -1953,33 +1975,65 @@ mod tests {
             vec![d1, d2, d3, d4, d5, d6, d7],
             vec![e1, e2, e3],
         ];
-        vertical_alignment(&mut graph, &layers, true, true);
-        horizontal_compaction(&mut graph, &layers, true);
-        assert_eq!(graph[a1].x, 50);
-        assert_eq!(graph[a2].x, 40);
-        assert_eq!(graph[b1].x, 80);
-        assert_eq!(graph[b2].x, 70);
-        assert_eq!(graph[b3].x, 60);
-        assert_eq!(graph[b4].x, 50);
-        assert_eq!(graph[b5].x, 40);
-        assert_eq!(graph[b6].x, 30);
-        assert_eq!(graph[b7].x, 20);
-        assert_eq!(graph[b8].x, 10);
-        assert_eq!(graph[c1].x, 60);
-        assert_eq!(graph[c2].x, 50);
-        assert_eq!(graph[c3].x, 40);
-        assert_eq!(graph[c4].x, 30);
-        assert_eq!(graph[c5].x, 10);
-        assert_eq!(graph[c6].x, 0);
-        assert_eq!(graph[d1].x, 70);
-        assert_eq!(graph[d2].x, 60);
-        assert_eq!(graph[d3].x, 50);
-        assert_eq!(graph[d4].x, 40);
-        assert_eq!(graph[d5].x, 30);
-        assert_eq!(graph[d6].x, 10);
-        assert_eq!(graph[d7].x, 0);
-        assert_eq!(graph[e1].x, 50);
-        assert_eq!(graph[e2].x, 10);
-        assert_eq!(graph[e3].x, 0);
+        let layering = Layering::new(&graph, &layers);
+        let alignment = vertical_alignment(&layering, true, true);
+        let x = horizontal_compaction(&layering, &alignment, true);
+        assert_eq!(x[a1.index()], 50);
+        assert_eq!(x[a2.index()], 40);
+        assert_eq!(x[b1.index()], 80);
+        assert_eq!(x[b2.index()], 70);
+        assert_eq!(x[b3.index()], 60);
+        assert_eq!(x[b4.index()], 50);
+        assert_eq!(x[b5.index()], 40);
+        assert_eq!(x[b6.index()], 30);
+        assert_eq!(x[b7.index()], 20);
+        assert_eq!(x[b8.index()], 10);
+        assert_eq!(x[c1.index()], 60);
+        assert_eq!(x[c2.index()], 50);
+        assert_eq!(x[c3.index()], 40);
+        assert_eq!(x[c4.index()], 30);
+        assert_eq!(x[c5.index()], 10);
+        assert_eq!(x[c6.index()], 0);
+        assert_eq!(x[d1.index()], 70);
+        assert_eq!(x[d2.index()], 60);
+        assert_eq!(x[d3.index()], 50);
+        assert_eq!(x[d4.index()], 40);
+        assert_eq!(x[d5.index()], 30);
+        assert_eq!(x[d6.index()], 10);
+        assert_eq!(x[d7.index()], 0);
+        assert_eq!(x[e1.index()], 50);
+        assert_eq!(x[e2.index()], 10);
+        assert_eq!(x[e3.index()], 0);
+    }
+
+    #[test]
+    fn test_wide_layers() {
+        // Layers in reverse node index order: the first block placed depends
+        // on every other one, deeper than the call stack of a test thread
+        // would allow with recursion.
+        let k = 100_000;
+        let mut graph = Graph::new();
+        let nodes = (0..2 * k)
+            .map(|_| {
+                graph.add_node(Node {
+                    width: 10,
+                    ..Node::new()
+                })
+            })
+            .collect::<Vec<_>>();
+        for i in 0..k {
+            graph.add_edge(nodes[i], nodes[k + i], Edge::new());
+        }
+        let layers = vec![
+            nodes[..k].iter().rev().cloned().collect(),
+            nodes[k..].iter().rev().cloned().collect(),
+        ];
+        let layering = Layering::new(&graph, &layers);
+        let alignment = vertical_alignment(&layering, false, false);
+        let x = horizontal_compaction(&layering, &alignment, false);
+        for i in 0..k {
+            assert_eq!(x[nodes[i].index()], 10 * (k - 1 - i) as i32);
+            assert_eq!(x[nodes[k + i].index()], 10 * (k - 1 - i) as i32);
+        }
     }
 }
@@ -0,0 +1,119 @@
+use super::super::graph::{Edge, Node};
+use petgraph::graph::IndexType;
+use petgraph::prelude::*;
+
+/// Neighbors of each node in one adjacent layer, sorted by order, in CSR
+/// layout indexed by node index, with the conflict flag of each edge.
+pub struct LayerNeighbors {
+    offsets: Vec<usize>,
+    nodes: Vec<usize>,
+    conflict: Vec<bool>,
+}
+
+impl LayerNeighbors {
+    fn new<Ix: IndexType>(
+        graph: &Graph<Node<Ix>, Edge, Directed, Ix>,
+        order: &[usize],
+        direction: Direction,
+    ) -> LayerNeighbors {
+        let mut offsets = Vec::with_capacity(graph.node_count() + 1);
+        let mut nodes = Vec::with_capacity(graph.edge_count());
+        let mut conflict = Vec::with_capacity(graph.edge_count());
+        let mut buffer = vec![];
+        offsets.push(0);
+        for u in graph.node_indices() {
+            buffer.clear();
+            buffer.extend(graph.edges_directed(u, direction).map(|e| {
+                let v = if direction == Incoming {
+                    e.source()
+                } else {
+                    e.target()
+                };
+                (order[v.index()], v.index(), e.weight().conflict)
+            }));
+            buffer.sort_by_key(|&(o, _, _)| o);
+            for &(_, v, c) in &buffer {
+                nodes.push(v);
+                conflict.push(c);
+            }
+            offsets.push(nodes.len());
+        }
+        LayerNeighbors {
+            offsets,
+            nodes,
+            conflict,
+        }
+    }
+
+    pub fn nodes(&self, u: usize) -> &[usize] {
+        &self.nodes[self.offsets[u]..self.offsets[u + 1]]
+    }
+
+    pub fn conflict(&self, u: usize) -> &[bool] {
+        &self.conflict[self.offsets[u]..self.offsets[u + 1]]
+    }
+}
+
+/// A proper layering with marked conflicts as flat arrays indexed by node
+/// index, read by the vertical alignment and horizontal compaction passes.
+/// It is built once and shared by all four of them.
+pub struct Layering {
+    layer_offsets: Vec<usize>,
+    layer_nodes: Vec<usize>,
+    pub layer: Vec<usize>,
+    pub order: Vec<usize>,
+    pub width: Vec<i32>,
+    pub upper: LayerNeighbors,
+    pub lower: LayerNeighbors,
+}
+
+impl Layering {
+    /// The layer and order of each node are its position in `layers`.
+    pub fn new<Ix: IndexType>(
+        graph: &Graph<Node<Ix>, Edge, Directed, Ix>,
+        layers: &Vec<Vec<NodeIndex<Ix>>>,
+    ) -> Layering {
+        let n = graph.node_count();
+        let mut layer_offsets = Vec::with_capacity(layers.len() + 1);
+        let mut layer_nodes = Vec::with_capacity(n);
+        let mut layer = vec![0; n];
+        let mut order = vec![0; n];
+        layer_offsets.push(0);
+        for (i, h) in layers.iter().enumerate() {
+            for (j, &u) in h.iter().enumerate() {
+                layer_nodes.push(u.index());
+                layer[u.index()] = i;
+                order[u.index()] = j;
+            }
+            layer_offsets.push(layer_nodes.len());
+        }
+        let width = graph
+            .node_indices()
+            .map(|u| graph[u].width as i32)
+            .collect();
+        let upper = LayerNeighbors::new(graph, &order, Incoming);
+        let lower = LayerNeighbors::new(graph, &order, Outgoing);
+        Layering {
+            layer_offsets,
+            layer_nodes,
+            layer,
+            order,
+            width,
+            upper,
+            lower,
+        }
+    }
+
+    pub fn node_count(&self) -> usize {
+        self.order.len()
+    }
+
+    pub fn layer_count(&self) -> usize {
+        self.layer_offsets.len() - 1
+    }
+
+    /// Nodes of layer `i` in order.
+    pub fn layer_nodes(&self, i: usize) -> &[usize] {
+        &self.layer_nodes[self.layer_offsets[i]..self.layer_offsets[i + 1]]
+    }
+}
@@ -4,23 +4,25 @@ use petgraph::prelude::*;
 use petgraph::EdgeDirection;
 use std::iter::FromIterator;
 
+/// Positions of the lower and upper medians among `n` sorted neighbors.
+pub fn median_positions(n: usize) -> Option<(usize, usize)> {
+    if n == 0 {
+        None
+    } else if n % 2 == 0 {
+        Some((n / 2 - 1, n / 2))
+    } else {
+        Some((n / 2, n / 2))
+    }
+}
+
 pub fn median<Ix: IndexType>(
     graph: &Graph<Node<Ix>, Edge, Directed, Ix>,
     u: NodeIndex<Ix>,
     direction: EdgeDirection,
 ) -> Option<(NodeIndex<Ix>, NodeIndex<Ix>)> {
     let mut vertices = Vec::from_iter(graph.neighbors_directed(u, direction));
-    if vertices.len() == 0 {
-        None
-    } else {
-        vertices.sort_by_key(|v| graph[*v].order);
-        let n = vertices.len();
-        if n % 2 == 0 {
-            Some((vertices[n / 2 - 1], vertices[n / 2]))
-        } else {
-            Some((vertices[n / 2], vertices[n / 2]))
-        }
-    }
+    vertices.sort_by_key(|v| graph[*v].order);
+    median_positions(vertices.len()).map(|(left, right)| (vertices[left], vertices[right]))
 }
 
 #[cfg(test)]
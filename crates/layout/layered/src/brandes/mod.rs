@@ -0,0 +1,8 @@
+pub mod brandes;
+pub mod horizontal_compaction;
+pub mod layering;
+pub mod mark_conflicts;
+pub mod median;
+pub mod vertical_alignment;
+
+pub use self::brandes::brandes;
@@ -1,90 +1,77 @@
-use super::super::graph::{Edge, Node};
-use super::median::median;
-use petgraph::graph::IndexType;
-use petgraph::prelude::*;
-use petgraph::EdgeDirection;
+use super::layering::Layering;
+use super::median::median_positions;
 
-fn iter_layer<'a, Ix: IndexType, I: Iterator<Item = &'a NodeIndex<Ix>>>(
-    graph: &mut Graph<Node<Ix>, Edge, Directed, Ix>,
+/// Blocks of one vertical alignment pass as arrays indexed by node index:
+/// `root` is the first node of the block of each node and `align` the next
+/// node of its block, cyclically.
+pub struct Alignment {
+    pub root: Vec<usize>,
+    pub align: Vec<usize>,
+}
+
+fn align_layer<'a, I: Iterator<Item = &'a usize>>(
+    layering: &Layering,
+    alignment: &mut Alignment,
     rtol: bool,
     btot: bool,
     layer: I,
 ) {
-    let mut r = if rtol {
-        i32::max_value()
+    let Alignment { root, align } = alignment;
+    let neighbors = if btot {
+        &layering.lower
     } else {
-        i32::min_value()
+        &layering.upper
     };
-    let edge_direction = if btot {
-        EdgeDirection::Outgoing
+    let mut r = if rtol {
+        std::isize::MAX
     } else {
-        EdgeDirection::Incoming
+        std::isize::MIN
     };
     for &v in layer {
-        match median(graph, v, edge_direction) {
-            Some((left, right)) => {
-                let medians = if left == right {
-                    vec![left]
-                } else {
-                    if rtol {
-                        vec![right, left]
-                    } else {
-                        vec![left, right]
-                    }
-                };
-                for u in medians {
-                    let edge = if btot {
-                        graph.find_edge(v, u).unwrap()
-                    } else {
-                        graph.find_edge(u, v).unwrap()
-                    };
-                    if graph[v].align.unwrap() == v && !graph[edge].conflict {
-                        let u_order = graph[u].order as i32;
-                        if (rtol && r > u_order) || (!rtol && r < u_order) {
-                            graph[v].align = graph[u].root;
-                            graph[v].root = graph[u].root;
-                            graph[u].align = Some(v);
-                            r = u_order;
-                            break;
-                        }
+        let nodes = neighbors.nodes(v);
+        let conflict = neighbors.conflict(v);
+        if let Some((left, right)) = median_positions(nodes.len()) {
+            let medians = if left == right {
+                [left, left]
+            } else if rtol {
+                [right, left]
+            } else {
+                [left, right]
+            };
+            for &m in &medians {
+                if align[v] == v && !conflict[m] {
+                    let u = nodes[m];
+                    let u_order = layering.order[u] as isize;
+                    if (rtol && r > u_order) || (!rtol && r < u_order) {
+                        align[v] = root[u];
+                        root[v] = root[u];
+                        align[u] = v;
+                        r = u_order;
+                        break;
                     }
                 }
             }
-            None => {}
-        };
+        }
     }
 }
 
-fn iter_layers<'a, Ix: IndexType, I: Iterator<Item = &'a Vec<NodeIndex<Ix>>>>(
-    graph: &mut Graph<Node<Ix>, Edge, Directed, Ix>,
-    rtol: bool,
-    btot: bool,
-    layers: I,
-) {
-    for layer in layers.skip(1) {
+pub fn vertical_alignment(layering: &Layering, rtol: bool, btot: bool) -> Alignment {
+    let n = layering.node_count();
+    let mut alignment = Alignment {
+        root: (0..n).collect(),
+        align: (0..n).collect(),
+    };
+    let layer_count = layering.layer_count();
+    for k in 1..layer_count {
+        let i = if btot { layer_count - 1 - k } else { k };
+        let layer = layering.layer_nodes(i);
         if rtol {
-            iter_layer(graph, rtol, btot, layer.iter().rev());
+            align_layer(layering, &mut alignment, rtol, btot, layer.iter().rev());
         } else {
-            iter_layer(graph, rtol, btot, layer.iter());
-        };
+            align_layer(layering, &mut alignment, rtol, btot, layer.iter());
+        }
     }
-}
-
-pub fn vertical_alignment<Ix: IndexType>(
-    graph: &mut Graph<Node<Ix>, Edge, Directed, Ix>,
-    layers: &Vec<Vec<NodeIndex<Ix>>>,
-    rtol: bool,
-    btot: bool,
-) {
-    for u in graph.node_indices() {
-        graph[u].root = Some(u);
-        graph[u].align = Some(u);
-    }
-    if btot {
-        iter_layers(graph, rtol, btot, layers.iter().rev());
-    } else {
-        iter_layers(graph, rtol, btot, layers.iter());
-    };
+    alignment
 }
 
 #[cfg(test)]
@@ -473,59 +460,60 @@ mod tests {
             vec![d1, d2, d3, d4, d5, d6, d7],
             vec![e1, e2, e3],
         ];
-        vertical_alignment(&mut graph, &layers, false, false);
-        assert_eq!(graph[a1].root.unwrap(), a1);
-        assert_eq!(graph[a1].align.unwrap(), b1);
-        assert_eq!(graph[a2].root.unwrap(), a2);
-        assert_eq!(graph[a2].align.unwrap(), b3);
-        assert_eq!(graph[b1].root.unwrap(), a1);
-        assert_eq!(graph[b1].align.unwrap(), a1);
-        assert_eq!(graph[b2].root.unwrap(), b2);
-        assert_eq!(graph[b2].align.unwrap(), b2);
-        assert_eq!(graph[b3].root.unwrap(), a2);
-        assert_eq!(graph[b3].align.unwrap(), a2);
-        assert_eq!(graph[b4].root.unwrap(), b4);
-        assert_eq!(graph[b4].align.unwrap(), c2);
-        assert_eq!(graph[b5].root.unwrap(), b5);
-        assert_eq!(graph[b5].align.unwrap(), c3);
-        assert_eq!(graph[b6].root.unwrap(), b6);
-        assert_eq!(graph[b6].align.unwrap(), c4);
-        assert_eq!(graph[b7].root.unwrap(), b7);
-        assert_eq!(graph[b7].align.unwrap(), b7);
-        assert_eq!(graph[b8].root.unwrap(), b8);
-        assert_eq!(graph[b8].align.unwrap(), c5);
-        assert_eq!(graph[c1].root.unwrap(), c1);
-        assert_eq!(graph[c1].align.unwrap(), d1);
-        assert_eq!(graph[c2].root.unwrap(), b4);
-        assert_eq!(graph[c2].align.unwrap(), b4);
-        assert_eq!(graph[c3].root.unwrap(), b5);
-        assert_eq!(graph[c3].align.unwrap(), d4);
-        assert_eq!(graph[c4].root.unwrap(), b6);
-        assert_eq!(graph[c4].align.unwrap(), d5);
-        assert_eq!(graph[c5].root.unwrap(), b8);
-        assert_eq!(graph[c5].align.unwrap(), d6);
-        assert_eq!(graph[c6].root.unwrap(), c6);
-        assert_eq!(graph[c6].align.unwrap(), d7);
-        assert_eq!(graph[d1].root.unwrap(), c1);
-        assert_eq!(graph[d1].align.unwrap(), e1);
-        assert_eq!(graph[d2].root.unwrap(), d2);
-        assert_eq!(graph[d2].align.unwrap(), e2);
-        assert_eq!(graph[d3].root.unwrap(), d3);
-        assert_eq!(graph[d3].align.unwrap(), d3);
-        assert_eq!(graph[d4].root.unwrap(), b5);
-        assert_eq!(graph[d4].align.unwrap(), b5);
-        assert_eq!(graph[d5].root.unwrap(), b6);
-        assert_eq!(graph[d5].align.unwrap(), e3);
-        assert_eq!(graph[d6].root.unwrap(), b8);
-        assert_eq!(graph[d6].align.unwrap(), b8);
-        assert_eq!(graph[d7].root.unwrap(), c6);
-        assert_eq!(graph[d7].align.unwrap(), c6);
-        assert_eq!(graph[e1].root.unwrap(), c1);
-        assert_eq!(graph[e1].align.unwrap(), c1);
-        assert_eq!(graph[e2].root.unwrap(), d2);
-        assert_eq!(graph[e2].align.unwrap(), d2);
-        assert_eq!(graph[e3].root.unwrap(), b6);
-        assert_eq!(graph[e3].align.unwrap(), b6);
+        let layering = Layering::new(&graph, &layers);
+        let alignment = vertical_alignment(&layering, false, false);
+        assert_eq!(alignment.root[a1.index()], a1.index());
+        assert_eq!(alignment.align[a1.index()], b1.index());
+        assert_eq!(alignment.root[a2.index()], a2.index());
+        assert_eq!(alignment.align[a2.index()], b3.index());
+        assert_eq!(alignment.root[b1.index()], a1.index());
+        assert_eq!(alignment.align[b1.index()], a1.index());
+        assert_eq!(alignment.root[b2.index()], b2.index());
+        assert_eq!(alignment.align[b2.index()], b2.index());
+        assert_eq!(alignment.root[b3.index()], a2.index());
+        assert_eq!(alignment.align[b3.index()], a2.index());
+        assert_eq!(alignment.root[b4.index()], b4.index());
+        assert_eq!(alignment.align[b4.index()], c2.index());
+        assert_eq!(alignment.root[b5.index()], b5.index());
+        assert_eq!(alignment.align[b5.index()], c3.index());
+        assert_eq!(alignment.root[b6.index()], b6.index());
+        assert_eq!(alignment.align[b6.index()], c4.index());
+        assert_eq!(alignment.root[b7.index()], b7.index());
+        assert_eq!(alignment.align[b7.index()], b7.index());
+        assert_eq!(alignment.root[b8.index()], b8.index());
+        assert_eq!(alignment.align[b8.index()], c5.index());
+        assert_eq!(alignment.root[c1.index()], c1.index());
+        assert_eq!(alignment.align[c1.index()], d1.index());
+        assert_eq!(alignment.root[c2.index()], b4.index());
+        assert_eq!(alignment.align[c2.index()], b4.index());
+        assert_eq!(alignment.root[c3.index()], b5.index());
+        assert_eq!(alignment.align[c3.index()], d4.index());
+        assert_eq!(alignment.root[c4.index()], b6.index());
+        assert_eq!(alignment.align[c4.index()], d5.index());
+        assert_eq!(alignment.root[c5.index()], b8.index());
+        assert_eq!(alignment.align[c5.index()], d6.index());
+        assert_eq!(alignment.root[c6.index()], c6.index());
+        assert_eq!(alignment.align[c6.index()], d7.index());
+        assert_eq!(alignment.root[d1.index()], c1.index());
+        assert_eq!(alignment.align[d1.index()], e1.index());
+        assert_eq!(alignment.root[d2.index()], d2.index());
+        assert_eq!(alignment.align[d2.index()], e2.index());
+        assert_eq!(alignment.root[d3.index()], d3.index());
+        assert_eq!(alignment.align[d3.index()], d3.index());
+        assert_eq!(alignment.root[d4.index()], b5.index());
+        assert_eq!(alignment.align[d4.index()], b5.index());
+        assert_eq!(alignment.root[d5.index()], b6.index());
+        assert_eq!(alignment.align[d5.index()], e3.index());
+        assert_eq!(alignment.root[d6.index()], b8.index());
+        assert_eq!(alignment.align[d6.index()], b8.index());
+        assert_eq!(alignment.root[d7.index()], c6.index());
+        assert_eq!(alignment.align[d7.index()], c6.index());
+        assert_eq!(alignment.root[e1.index()], c1.index());
+        assert_eq!(alignment.align[e1.index()], c1.index());
+        assert_eq!(alignment.root[e2.index()], d2.index());
+        assert_eq!(alignment.align[e2.index()], d2.index());
+        assert_eq!(alignment.root[e3.index()], b6.index());
+        assert_eq!(alignment.align[e3.index()], b6.index());
     }
 
     #[test]
@@ -908,58 +896,59 @@ mod tests {
             vec![d1, d2, d3, d4, d5, d6, d7],
             vec![e1, e2, e3],
         ];
-        vertical_alignment(&mut graph, &layers, false, true);
-        assert_eq!(graph[a1].root.unwrap(), d5);
-        assert_eq!(graph[a1].align.unwrap(), d5);
-        assert_eq!(graph[a2].root.unwrap(), a2);
-        assert_eq!(graph[a2].align.unwrap(), a2);
-        assert_eq!(graph[b1].root.unwrap(), b1);
-        assert_eq!(graph[b1].align.unwrap(), b1);
-        assert_eq!(graph[b2].root.unwrap(), c2);
-        assert_eq!(graph[b2].align.unwrap(), c2);
-        assert_eq!(graph[b3].root.unwrap(), b3);
-        assert_eq!(graph[b3].align.unwrap(), b3);
-        assert_eq!(graph[b4].root.unwrap(), b4);
-        assert_eq!(graph[b4].align.unwrap(), b4);
-        assert_eq!(graph[b5].root.unwrap(), e3);
-        assert_eq!(graph[b5].align.unwrap(), e3);
-        assert_eq!(graph[b6].root.unwrap(), d5);
-        assert_eq!(graph[b6].align.unwrap(), a1);
-        assert_eq!(graph[b7].root.unwrap(), d7);
-        assert_eq!(graph[b7].align.unwrap(), d7);
-        assert_eq!(graph[b8].root.unwrap(), b8);
-        assert_eq!(graph[b8].align.unwrap(), b8);
-        assert_eq!(graph[c1].root.unwrap(), e2);
-        assert_eq!(graph[c1].align.unwrap(), e2);
-        assert_eq!(graph[c2].root.unwrap(), c2);
-        assert_eq!(graph[c2].align.unwrap(), b2);
-        assert_eq!(graph[c3].root.unwrap(), e3);
-        assert_eq!(graph[c3].align.unwrap(), b5);
-        assert_eq!(graph[c4].root.unwrap(), d5);
-        assert_eq!(graph[c4].align.unwrap(), b6);
-        assert_eq!(graph[c5].root.unwrap(), d6);
-        assert_eq!(graph[c5].align.unwrap(), d6);
-        assert_eq!(graph[c6].root.unwrap(), d7);
-        assert_eq!(graph[c6].align.unwrap(), b7);
-        assert_eq!(graph[d1].root.unwrap(), e1);
-        assert_eq!(graph[d1].align.unwrap(), e1);
-        assert_eq!(graph[d2].root.unwrap(), e2);
-        assert_eq!(graph[d2].align.unwrap(), c1);
-        assert_eq!(graph[d3].root.unwrap(), d3);
-        assert_eq!(graph[d3].align.unwrap(), d3);
-        assert_eq!(graph[d4].root.unwrap(), e3);
-        assert_eq!(graph[d4].align.unwrap(), c3);
-        assert_eq!(graph[d5].root.unwrap(), d5);
-        assert_eq!(graph[d5].align.unwrap(), c4);
-        assert_eq!(graph[d6].root.unwrap(), d6);
-        assert_eq!(graph[d6].align.unwrap(), c5);
-        assert_eq!(graph[d7].root.unwrap(), d7);
-        assert_eq!(graph[d7].align.unwrap(), c6);
-        assert_eq!(graph[e1].root.unwrap(), e1);
-        assert_eq!(graph[e1].align.unwrap(), d1);
-        assert_eq!(graph[e2].root.unwrap(), e2);
-        assert_eq!(graph[e2].align.unwrap(), d2);
-        assert_eq!(graph[e3].root.unwrap(), e3);
-        assert_eq!(graph[e3].align.unwrap(), d4);
+        let layering = Layering::new(&graph, &layers);
+        let alignment = vertical_alignment(&layering, false, true);
+        assert_eq!(alignment.root[a1.index()], d5.index());
+        assert_eq!(alignment.align[a1.index()], d5.index());
+        assert_eq!(alignment.root[a2.index()], a2.index());
+        assert_eq!(alignment.align[a2.index()], a2.index());
+        assert_eq!(alignment.root[b1.index()], b1.index());
+        assert_eq!(alignment.align[b1.index()], b1.index());
+        assert_eq!(alignment.root[b2.index()], c2.index());
+        assert_eq!(alignment.align[b2.index()], c2.index());
+        assert_eq!(alignment.root[b3.index()], b3.index());
+        assert_eq!(alignment.align[b3.index()], b3.index());
+        assert_eq!(alignment.root[b4.index()], b4.index());
+        assert_eq!(alignment.align[b4.index()], b4.index());
+        assert_eq!(alignment.root[b5.index()], e3.index());
+        assert_eq!(alignment.align[b5.index()], e3.index());
+        assert_eq!(alignment.root[b6.index()], d5.index());
+        assert_eq!(alignment.align[b6.index()], a1.index());
+        assert_eq!(alignment.root[b7.index()], d7.index());
+        assert_eq!(alignment.align[b7.index()], d7.index());
+        assert_eq!(alignment.root[b8.index()], b8.index());
+        assert_eq!(alignment.align[b8.index()], b8.index());
+        assert_eq!(alignment.root[c1.index()], e2.index());
+        assert_eq!(alignment.align[c1.index()], e2.index());
+        assert_eq!(alignment.root[c2.index()], c2.index());
+        assert_eq!(alignment.align[c2.index()], b2.index());
+        assert_eq!(alignment.root[c3.index()], e3.index());
+        assert_eq!(alignment.align[c3.index()], b5.index());
+        assert_eq!(alignment.root[c4.index()], d5.index());
+        assert_eq!(alignment.align[c4.index()], b6.index());
+        assert_eq!(alignment.root[c5.index()], d6.index());
+        assert_eq!(alignment.align[c5.index()], d6.index());
+        assert_eq!(alignment.root[c6.index()], d7.index());
+        assert_eq!(alignment.align[c6.index()], b7.index());
+        assert_eq!(alignment.root[d1.index()], e1.index());
+        assert_eq!(alignment.align[d1.index()], e1.index());
+        assert_eq!(alignment.root[d2.index()], e2.index());
+        assert_eq!(alignment.align[d2.index()], c1.index());
+        assert_eq!(alignment.root[d3.index()], d3.index());
+        assert_eq!(alignment.align[d3.index()], d3.index());
+        assert_eq!(alignment.root[d4.index()], e3.index());
+        assert_eq!(alignment.align[d4.index()], c3.index());
+        assert_eq!(alignment.root[d5.index()], d5.index());
+        assert_eq!(alignment.align[d5.index()], c4.index());
+        assert_eq!(alignment.root[d6.index()], d6.index());
+        assert_eq!(alignment.align[d6.index()], c5.index());
+        assert_eq!(alignment.root[d7.index()], d7.index());
+        assert_eq!(alignment.align[d7.index()], c6.index());
+        assert_eq!(alignment.root[e1.index()], e1.index());
+        assert_eq!(alignment.align[e1.index()], d1.index());
+        assert_eq!(alignment.root[e2.index()], e2.index());
+        assert_eq!(alignment.align[e2.index()], d2.index());
+        assert_eq!(alignment.root[e3.index()], e3.index());
+        assert_eq!(alignment.align[e3.index()], d4.index());
     }
 }
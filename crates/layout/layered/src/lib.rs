@@ -1 +1,2 @@
 pub mod brandes;
+pub mod graph;
@@ -1,4 +1,5 @@
-use petgraph::visit::{GetAdjacencyMatrix, IntoEdgeReferences, IntoNodeIdentifiers, NodeCount};
+use petgraph::visit::{IntoNeighbors, IntoNodeIdentifiers, NodeCount};
+use quadtree::{Element, NodeId, Quadtree, Rect};
 use std::collections::HashMap;
 use std::hash::Hash;
 
@@ -51,56 +52,336 @@ fn dist(a: (f32, f32), b: (f32, f32)) -> f32 {
   }
 }
 
+/// Hyperbolic distance between `x` and `y`, the norm of
+/// `to_tangent_space(x, y)` before clamping.
+fn hyperbolic_distance(x: (f32, f32), y: (f32, f32)) -> f32 {
+  let dx = y.0 - x.0;
+  let dy = y.1 - x.1;
+  let dr = 1. - x.0 * y.0 - x.1 * y.1;
+  let di = x.1 * y.0 - x.0 * y.1;
+  let d = dr * dr + di * di;
+  let z_norm = ((dx * dx + dy * dy) / d).sqrt();
+  if z_norm < 1. {
+    ((1. + z_norm) / (1. - z_norm)).ln()
+  } else {
+    std::f32::INFINITY
+  }
+}
+
+/// Neighbors in `node_identifiers` order, without self loops and parallel
+/// edges.
+struct Adjacency {
+  start: Vec<usize>,
+  neighbors: Vec<usize>,
+}
+
+impl Adjacency {
+  fn new<G>(graph: G) -> Adjacency
+  where
+    G: IntoNeighbors + IntoNodeIdentifiers,
+    G::NodeId: Eq + Hash,
+  {
+    let indices = graph
+      .node_identifiers()
+      .enumerate()
+      .map(|(i, u)| (u, i))
+      .collect::<HashMap<_, _>>();
+    let mut start = vec![0];
+    let mut neighbors = vec![];
+    for (i, u) in graph.node_identifiers().enumerate() {
+      let s = neighbors.len();
+      neighbors.extend(graph.neighbors(u).map(|v| indices[&v]).filter(|&j| j != i));
+      neighbors[s..].sort_unstable();
+      let mut end = s;
+      for t in s..neighbors.len() {
+        if t == s || neighbors[t] != neighbors[end - 1] {
+          neighbors[end] = neighbors[t];
+          end += 1;
+        }
+      }
+      neighbors.truncate(end);
+      start.push(neighbors.len());
+    }
+    Adjacency { start, neighbors }
+  }
+
+  fn neighbors(&self, u: usize) -> &[usize] {
+    &self.neighbors[self.start[u]..self.start[u + 1]]
+  }
+}
+
+fn attraction(pos: &[(f32, f32)], adjacency: &Adjacency, u: usize, k: f32) -> (f32, f32) {
+  let mut vx = 0.;
+  let mut vy = 0.;
+  for &v in adjacency.neighbors(u) {
+    let z = to_tangent_space(pos[u], pos[v]);
+    let d = dist((0., 0.), z);
+    let t = z.1.atan2(z.0);
+    vx += d * d / k * t.cos();
+    vy += d * d / k * t.sin();
+  }
+  (vx, vy)
+}
+
+fn move_points(pos: &mut [(f32, f32)], v: &[(f32, f32)], i: usize) {
+  let c = 0.1 / (i + 1) as f32;
+  for u in 0..pos.len() {
+    pos[u] = from_tangent_space(pos[u], (v[u].0 * c, v[u].1 * c));
+    let d = (pos[u].0 * pos[u].0 + pos[u].1 * pos[u].1).sqrt();
+    if d >= 1. {
+      pos[u].0 *= 0.99 / d;
+      pos[u].1 *= 0.99 / d;
+    }
+  }
+}
+
 pub fn non_euclidean_fruchterman_reingold<G>(
   graph: G,
   coordinates: &mut HashMap<G::NodeId, (f32, f32)>,
   repeat: usize,
   k: f32,
 ) where
-  G: GetAdjacencyMatrix + IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
+  G: IntoNeighbors + IntoNodeIdentifiers + NodeCount,
   G::NodeId: Eq + Hash,
 {
-  let indices = graph.node_identifiers().collect::<Vec<_>>();
-  let mut pos = indices.iter().map(|u| coordinates[&u]).collect::<Vec<_>>();
+  let mut pos = graph
+    .node_identifiers()
+    .map(|u| coordinates[&u])
+    .collect::<Vec<_>>();
+  non_euclidean_fruchterman_reingold_slice(graph, &mut pos, repeat, k);
+  for (u, p) in graph.node_identifiers().zip(pos) {
+    coordinates.insert(u, p);
+  }
+}
+
+/// Same as `non_euclidean_fruchterman_reingold`, with `coordinates` indexed in
+/// `node_identifiers` order.
+/// Panics unless `coordinates.len() == graph.node_count()`.
+pub fn non_euclidean_fruchterman_reingold_slice<G>(
+  graph: G,
+  coordinates: &mut [(f32, f32)],
+  repeat: usize,
+  k: f32,
+) where
+  G: IntoNeighbors + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+{
+  assert_eq!(coordinates.len(), graph.node_count());
+  let pos = coordinates;
   let n = graph.node_count();
-  let matrix = graph.adjacency_matrix();
+  let adjacency = Adjacency::new(graph);
 
   let mut v = vec![(0., 0.); n];
-  let mut z = vec![(0., 0.); n];
   for i in 0..repeat {
     for u in 0..n {
-      for v in 0..n {
-        z[v] = to_tangent_space(pos[u], pos[v]);
+      v[u] = exact_repulsion(pos, u, k);
+      let (ax, ay) = attraction(pos, &adjacency, u, k);
+      v[u].0 += ax;
+      v[u].1 += ay;
+    }
+    move_points(pos, &v, i);
+  }
+}
+
+fn exact_repulsion(pos: &[(f32, f32)], u: usize, k: f32) -> (f32, f32) {
+  let mut vx = 0.;
+  let mut vy = 0.;
+  for v in 0..pos.len() {
+    if u == v {
+      continue;
+    }
+    let z = to_tangent_space(pos[u], pos[v]);
+    let d = dist((0., 0.), z);
+    let t = z.1.atan2(z.0);
+    vx -= k * k / d * t.cos();
+    vy -= k * k / d * t.sin();
+  }
+  (vx, vy)
+}
+
+/// Hyperbolic centroid and radius of the points below a quadtree node. The
+/// centroid is the Einstein midpoint, taken in the Klein model and mapped
+/// back to the Poincaré disk; every point is within hyperbolic distance
+/// `radius` of it.
+#[derive(Copy, Clone, Default)]
+struct Cell {
+  x: f32,
+  y: f32,
+  n: f32,
+  radius: f32,
+  sum_x: f32,
+  sum_y: f32,
+  sum_gamma: f32,
+}
+
+fn klein_weight(x: f32, y: f32) -> (f32, f32, f32) {
+  let r2 = x * x + y * y;
+  let s = 1. / (1. - r2).max(1e-6);
+  (2. * x * s, 2. * y * s, (1. + r2) * s)
+}
+
+fn accumulate(tree: &mut Quadtree<Cell>) {
+  for index in (0..tree.node_count()).rev() {
+    let node_id = NodeId::new(index);
+    let mut cell = Cell::default();
+    for &(e, _) in tree.elements(node_id).iter() {
+      match e {
+        Element::Leaf { x, y, n, .. } => {
+          let (kx, ky, gamma) = klein_weight(x, y);
+          cell.n += n as f32;
+          cell.sum_x += kx * n as f32;
+          cell.sum_y += ky * n as f32;
+          cell.sum_gamma += gamma * n as f32;
+        }
+        Element::Node { node_id } => {
+          let child = tree.data(node_id);
+          cell.n += child.n;
+          cell.sum_x += child.sum_x;
+          cell.sum_y += child.sum_y;
+          cell.sum_gamma += child.sum_gamma;
+        }
+        Element::Empty => {}
       }
-      let mut vx = 0.;
-      let mut vy = 0.;
-      for v in 0..n {
-        if u == v {
+    }
+    let kx = cell.sum_x / cell.sum_gamma;
+    let ky = cell.sum_y / cell.sum_gamma;
+    let s = 1. + (1. - kx * kx - ky * ky).max(0.).sqrt();
+    cell.x = kx / s;
+    cell.y = ky / s;
+    for &(e, _) in tree.elements(node_id).iter() {
+      let r = match e {
+        Element::Leaf { x, y, .. } => hyperbolic_distance((cell.x, cell.y), (x, y)),
+        Element::Node { node_id } => {
+          let child = tree.data(node_id);
+          hyperbolic_distance((cell.x, cell.y), (child.x, child.y)) + child.radius
+        }
+        Element::Empty => 0.,
+      };
+      cell.radius = cell.radius.max(r);
+    }
+    *tree.data_mut(node_id) = cell;
+  }
+}
+
+fn approximate_repulsion(
+  tree: &Quadtree<Cell>,
+  node_id: NodeId,
+  p: (f32, f32),
+  k: f32,
+  theta: f32,
+  v: &mut (f32, f32),
+) {
+  for &(e, _) in tree.elements(node_id).iter() {
+    let (z, n) = match e {
+      Element::Leaf { x, y, n, .. } => {
+        if x == p.0 && y == p.1 {
           continue;
         }
-        let d = dist(z[u], z[v]);
-        let t = (z[v].1 - z[u].1).atan2(z[v].0 - z[u].0);
-        if graph.is_adjacent(&matrix, indices[u], indices[v]) {
-          vx += d * d / k * t.cos();
-          vy += d * d / k * t.sin();
+        (to_tangent_space(p, (x, y)), n as f32)
+      }
+      Element::Node { node_id } => {
+        let cell = tree.data(node_id);
+        let z = to_tangent_space(p, (cell.x, cell.y));
+        let d = hyperbolic_distance(p, (cell.x, cell.y));
+        if !(2. * cell.radius < theta * d) {
+          approximate_repulsion(tree, node_id, p, k, theta, v);
+          continue;
         }
-        vx -= k * k / d * t.cos();
-        vy -= k * k / d * t.sin();
+        (z, cell.n)
       }
-      v[u] = (vx * (0.1 / (i + 1) as f32), vy * (0.1 / (i + 1) as f32));
-    }
+      Element::Empty => continue,
+    };
+    let d = dist((0., 0.), z);
+    let t = z.1.atan2(z.0);
+    v.0 -= n * k * k / d * t.cos();
+    v.1 -= n * k * k / d * t.sin();
+  }
+}
+
+/// Same as `non_euclidean_fruchterman_reingold`, approximating the repulsion
+/// with a Barnes-Hut quadtree over the Poincaré disk in O(n log n) per
+/// iteration.
+///
+/// A subtree is replaced by its hyperbolic centroid when its hyperbolic
+/// diameter is less than `theta` times its hyperbolic distance from the
+/// node; `theta = 0` gives the exact repulsion.
+pub fn non_euclidean_fruchterman_reingold_barnes_hut<G>(
+  graph: G,
+  coordinates: &mut HashMap<G::NodeId, (f32, f32)>,
+  repeat: usize,
+  k: f32,
+  theta: f32,
+) where
+  G: IntoNeighbors + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+{
+  let mut pos = graph
+    .node_identifiers()
+    .map(|u| coordinates[&u])
+    .collect::<Vec<_>>();
+  non_euclidean_fruchterman_reingold_barnes_hut_slice(graph, &mut pos, repeat, k, theta);
+  for (u, p) in graph.node_identifiers().zip(pos) {
+    coordinates.insert(u, p);
+  }
+}
+
+/// Same as `non_euclidean_fruchterman_reingold_barnes_hut`, with
+/// `coordinates` indexed in `node_identifiers` order.
+/// Panics unless `coordinates.len() == graph.node_count()`.
+pub fn non_euclidean_fruchterman_reingold_barnes_hut_slice<G>(
+  graph: G,
+  coordinates: &mut [(f32, f32)],
+  repeat: usize,
+  k: f32,
+  theta: f32,
+) where
+  G: IntoNeighbors + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+{
+  assert_eq!(coordinates.len(), graph.node_count());
+  let pos = coordinates;
+  let n = graph.node_count();
+  let adjacency = Adjacency::new(graph);
+
+  let mut tree = Quadtree::new(Rect {
+    cx: 0.,
+    cy: 0.,
+    width: 2.,
+    height: 2.,
+  });
+  let mut v = vec![(0., 0.); n];
+  for i in 0..repeat {
+    repulsion(&mut tree, pos, k, theta, &mut v);
     for u in 0..n {
-      pos[u] = from_tangent_space(pos[u], v[u]);
-      let d = (pos[u].0 * pos[u].0 + pos[u].1 * pos[u].1).sqrt();
-      if d >= 1. {
-        pos[u].0 *= 0.99 / d;
-        pos[u].1 *= 0.99 / d;
-      }
+      let (ax, ay) = attraction(pos, &adjacency, u, k);
+      v[u].0 += ax;
+      v[u].1 += ay;
     }
+    move_points(pos, &v, i);
   }
+}
 
-  for (&u, (x, y)) in indices.iter().zip(pos) {
-    coordinates.insert(u, (x, y));
+fn repulsion(
+  tree: &mut Quadtree<Cell>,
+  pos: &[(f32, f32)],
+  k: f32,
+  theta: f32,
+  v: &mut [(f32, f32)],
+) {
+  tree.rebuild(
+    Rect {
+      cx: 0.,
+      cy: 0.,
+      width: 2.,
+      height: 2.,
+    },
+    pos.iter().map(|&(x, y)| (x, y, 0.)),
+  );
+  accumulate(tree);
+  let root = tree.root();
+  for (u, &p) in pos.iter().enumerate() {
+    v[u] = (0., 0.);
+    approximate_repulsion(tree, root, p, k, theta, &mut v[u]);
   }
 }
 
@@ -135,3 +416,56 @@ fn test_non_euclidean_fruchterman_reingold() {
     println!("{:?}", coordinates[&u]);
   }
 }
+
+#[test]
+fn test_approximate_repulsion() {
+  let n = 500;
+  let pos = (0..n)
+    .map(|i| {
+      let r = 0.95 * (i as f32 / n as f32).sqrt();
+      let t = i as f32 * 2.399;
+      (r * t.cos(), r * t.sin())
+    })
+    .collect::<Vec<_>>();
+  let mut tree = Quadtree::new(Rect {
+    cx: 0.,
+    cy: 0.,
+    width: 2.,
+    height: 2.,
+  });
+  let expected = (0..n)
+    .map(|u| exact_repulsion(&pos, u, 1.))
+    .collect::<Vec<_>>();
+  for &(theta, tolerance) in &[(0., 1e-3), (0.5, 5e-2)] {
+    let mut v = vec![(0., 0.); n];
+    repulsion(&mut tree, &pos, 1., theta, &mut v);
+    for (a, b) in v.iter().zip(&expected) {
+      let e = ((a.0 - b.0).powi(2) + (a.1 - b.1).powi(2)).sqrt();
+      let norm = (b.0 * b.0 + b.1 * b.1).sqrt();
+      assert!(e <= tolerance * norm.max(1.));
+    }
+  }
+}
+
+#[test]
+fn test_non_euclidean_fruchterman_reingold_barnes_hut() {
+  use petgraph::Graph;
+
+  let n = 100;
+  let mut graph = Graph::new_undirected();
+  let nodes = (0..n).map(|_| graph.add_node(())).collect::<Vec<_>>();
+  for i in 1..n {
+    graph.add_edge(nodes[(i - 1) / 2], nodes[i], ());
+  }
+  let mut coordinates = HashMap::new();
+  for (i, &u) in nodes.iter().enumerate() {
+    let t = i as f32 * 2.399;
+    coordinates.insert(u, (0.5 * t.cos(), 0.5 * t.sin()));
+  }
+  non_euclidean_fruchterman_reingold_barnes_hut(&graph, &mut coordinates, 50, 0.5, 0.5);
+  for &u in &nodes {
+    let (x, y) = coordinates[&u];
+    assert!(x.is_finite() && y.is_finite());
+    assert!(x * x + y * y < 1.);
+  }
+}
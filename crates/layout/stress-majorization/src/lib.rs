@@ -1,8 +1,12 @@
 use petgraph::visit::{IntoEdgeReferences, IntoNodeIdentifiers, NodeCount};
-use petgraph_algorithm_shortest_path::warshall_floyd;
+use petgraph_algorithm_shortest_path::all_sources_shortest_path;
 use std::collections::HashMap;
 use std::hash::Hash;
 
+mod sgd;
+
+pub use self::sgd::sparse_sgd;
+
 fn line_search(a: &[f32], dx: &[f32], d: &[f32]) -> f32 {
   let n = dx.len();
   let mut alpha = -dot(d, &dx);
@@ -45,6 +49,9 @@ pub fn conjugate_gradient(a: &[f32], b: &[f32], x: &mut [f32], epsilon: f32) {
     d[i] = -dx[i];
   }
   let mut dx_norm0 = dot(&dx, &dx);
+  if dx_norm0 < epsilon {
+    return;
+  }
   for _ in 0..n {
     let alpha = line_search(a, &dx, &d);
     for i in 0..n {
@@ -63,7 +70,7 @@ pub fn conjugate_gradient(a: &[f32], b: &[f32], x: &mut [f32], epsilon: f32) {
   }
 }
 
-fn stress(x: &[f32], y: &[f32], w: &[f32], d: &Vec<Vec<f32>>) -> f32 {
+fn stress(x: &[f32], y: &[f32], w: &[f32], d: &[f32]) -> f32 {
   let n = x.len() + 1;
   let mut s = 0.;
   for j in 1..n - 1 {
@@ -71,7 +78,7 @@ fn stress(x: &[f32], y: &[f32], w: &[f32], d: &Vec<Vec<f32>>) -> f32 {
       let dx = x[i] - x[j];
       let dy = y[i] - y[j];
       let norm = (dx * dx + dy * dy).sqrt();
-      let dij = d[i][j];
+      let dij = d[i * n + j];
       let wij = w[i * n + j];
       let e = norm - dij;
       s += wij * e * e;
@@ -82,7 +89,7 @@ fn stress(x: &[f32], y: &[f32], w: &[f32], d: &Vec<Vec<f32>>) -> f32 {
     let dx = x[i];
     let dy = y[i];
     let norm = (dx * dx + dy * dy).sqrt();
-    let dij = d[i][j];
+    let dij = d[i * n + j];
     let wij = w[i * n + j];
     let e = norm - dij;
     s += wij * e * e;
@@ -99,17 +106,33 @@ pub fn stress_majorization<G, F>(
   G::NodeId: Eq + Hash,
   F: FnMut(G::EdgeRef) -> f32,
 {
-  let pos = graph
+  let mut pos = graph
     .node_identifiers()
     .map(|u| coordinates[&u])
     .collect::<Vec<_>>();
+  stress_majorization_slice(graph, &mut pos, length);
+  for (u, p) in graph.node_identifiers().zip(pos) {
+    coordinates.insert(u, p);
+  }
+}
+
+/// Same as `stress_majorization`, with `coordinates` indexed in `node_identifiers` order.
+/// Panics unless `coordinates.len() == graph.node_count()`.
+pub fn stress_majorization_slice<G, F>(graph: G, coordinates: &mut [(f32, f32)], length: &mut F)
+where
+  G: IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+  F: FnMut(G::EdgeRef) -> f32,
+{
+  assert_eq!(coordinates.len(), graph.node_count());
+  let pos = coordinates;
   let n = pos.len();
-  let d = warshall_floyd(graph, length);
+  let d = all_sources_shortest_path(graph, length);
 
   let mut w = vec![0.; n * n];
   for j in 1..n {
     for i in 0..j {
-      let dij = d[i][j];
+      let dij = d[i * n + j];
       let wij = 1. / (dij * dij);
       w[i * n + j] = wij;
       w[j * n + i] = wij;
@@ -135,8 +158,10 @@ pub fn stress_majorization<G, F>(
   let mut z_x = vec![0.; n - 1];
   let mut x_y = vec![0.; n - 1];
   let mut z_y = vec![0.; n - 1];
+  // Node n - 1 is fixed at the origin; the others start relative to it.
+  let (x0, y0) = pos[n - 1];
   for i in 0..n - 1 {
-    let (xi, yi) = pos[i];
+    let (xi, yi) = (pos[i].0 - x0, pos[i].1 - y0);
     x_x[i] = xi;
     z_x[i] = xi;
     x_y[i] = yi;
@@ -156,7 +181,7 @@ pub fn stress_majorization<G, F>(
         let lij = if norm < 1e-4 {
           0.
         } else {
-          -w[i * n + j] * d[i][j] / norm
+          -w[i * n + j] * d[i * n + j] / norm
         };
         l_z[i * (n - 1) + j] = lij;
         l_z[j * (n - 1) + i] = lij;
@@ -176,7 +201,7 @@ pub fn stress_majorization<G, F>(
       s -= if norm < 0.1 {
         0.
       } else {
-        -w[i * n + j] * d[i][j] / norm
+        -w[i * n + j] * d[i * n + j] / norm
       };
       l_z[i * (n - 1) + i] = s;
     }
@@ -200,7 +225,8 @@ pub fn stress_majorization<G, F>(
     conjugate_gradient(&l_w, &b, &mut x_y, epsilon);
 
     let stress = stress(&x_x, &x_y, &w, &d);
-    if (stress0 - stress) / stress0 < epsilon {
+    // Not divided by stress0, which is zero once all distances are met.
+    if stress0 - stress <= epsilon * stress0 {
       break;
     }
     stress0 = stress;
@@ -209,11 +235,11 @@ pub fn stress_majorization<G, F>(
       z_y[i] = x_y[i];
     }
   }
-  for (i, u) in graph.node_identifiers().enumerate() {
+  for i in 0..n {
     if i == n - 1 {
-      coordinates.insert(u, (0., 0.));
+      pos[i] = (0., 0.);
     } else {
-      coordinates.insert(u, (z_x[i], z_y[i]));
+      pos[i] = (z_x[i], z_y[i]);
     }
   }
 }
@@ -263,3 +289,20 @@ fn test_stress_majorization() {
     println!("{:?}", coordinates[&u]);
   }
 }
+
+#[test]
+fn test_stress_majorization_two_nodes() {
+  use petgraph::Graph;
+
+  let mut graph = Graph::new_undirected();
+  let a = graph.add_node(());
+  let b = graph.add_node(());
+  graph.add_edge(a, b, ());
+  let mut coordinates = vec![(100., 50.), (120., 50.)];
+  stress_majorization_slice(&graph, &mut coordinates, &mut |_| 30.);
+  let (dx, dy) = (
+    coordinates[0].0 - coordinates[1].0,
+    coordinates[0].1 - coordinates[1].1,
+  );
+  assert!(((dx * dx + dy * dy).sqrt() - 30.).abs() < 1e-2);
+}
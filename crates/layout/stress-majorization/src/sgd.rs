@@ -0,0 +1,228 @@
+use petgraph::visit::{IntoEdgeReferences, IntoNodeIdentifiers, NodeCount};
+use petgraph_algorithm_shortest_path::Adjacency;
+use rand::prelude::*;
+use std::collections::HashMap;
+use std::f32::INFINITY;
+use std::hash::Hash;
+
+struct Term {
+  i: usize,
+  j: usize,
+  d: f32,
+  w: f32,
+  move_j: bool,
+}
+
+fn select_pivots(adjacency: &Adjacency, k: usize) -> (Vec<usize>, Vec<f32>) {
+  let n = adjacency.len();
+  let mut pivots = Vec::with_capacity(k);
+  let mut distance = vec![0.; k * n];
+  let mut min_distance = vec![INFINITY; n];
+  let mut p = 0;
+  for q in 0..k {
+    pivots.push(p);
+    let row = &mut distance[q * n..(q + 1) * n];
+    adjacency.single_source_dijkstra(p, row);
+    for j in 0..n {
+      min_distance[j] = min_distance[j].min(row[j]);
+    }
+    let mut d_max = -1.;
+    for j in 0..n {
+      if min_distance[j] > d_max {
+        d_max = min_distance[j];
+        p = j;
+      }
+    }
+  }
+  (pivots, distance)
+}
+
+fn sparse_terms(adjacency: &Adjacency, k: usize) -> Vec<Term> {
+  let n = adjacency.len();
+  let (pivots, distance) = select_pivots(adjacency, k);
+
+  let mut region = vec![Vec::new(); k];
+  for j in 0..n {
+    let mut q_min = 0;
+    for q in 1..k {
+      if distance[q * n + j] < distance[q_min * n + j] {
+        q_min = q;
+      }
+    }
+    if distance[q_min * n + j].is_finite() {
+      region[q_min].push(distance[q_min * n + j]);
+    }
+  }
+  for r in region.iter_mut() {
+    r.sort_by(|a, b| a.partial_cmp(b).unwrap());
+  }
+
+  let mut pivot_index = vec![None; n];
+  for (q, &p) in pivots.iter().enumerate() {
+    pivot_index[p] = Some(q);
+  }
+  let mut is_neighbor = vec![false; k];
+  let mut terms = Vec::new();
+  for i in 0..n {
+    for (j, d) in adjacency.neighbors(i) {
+      if let Some(q) = pivot_index[j] {
+        is_neighbor[q] = true;
+      }
+      if i < j && d > 0. {
+        terms.push(Term {
+          i,
+          j,
+          d,
+          w: 1. / (d * d),
+          move_j: true,
+        });
+      }
+    }
+    for (q, &p) in pivots.iter().enumerate() {
+      let d = distance[q * n + i];
+      if p != i && !is_neighbor[q] && d.is_finite() && d > 0. {
+        let s = region[q].partition_point(|&dj| dj <= d / 2.);
+        terms.push(Term {
+          i,
+          j: p,
+          d,
+          w: s as f32 / (d * d),
+          move_j: false,
+        });
+      }
+    }
+    for (j, _) in adjacency.neighbors(i) {
+      if let Some(q) = pivot_index[j] {
+        is_neighbor[q] = false;
+      }
+    }
+  }
+  terms
+}
+
+/// Stress minimization by stochastic gradient descent over a sparse set of
+/// terms (Zheng, Pawar and Goodman, "Graph Drawing by Stochastic Gradient
+/// Descent").
+///
+/// Edges contribute exact terms; all other pairs are approximated through
+/// `pivots` landmark nodes chosen by max-min distance. Memory is
+/// O(n * pivots + m), so no `n * n` matrix is allocated.
+pub fn sparse_sgd<G, F>(
+  graph: G,
+  coordinates: &mut HashMap<G::NodeId, (f32, f32)>,
+  length: &mut F,
+  pivots: usize,
+  iterations: usize,
+  eps: f32,
+) where
+  G: IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+  F: FnMut(G::EdgeRef) -> f32,
+{
+  let mut pos = graph
+    .node_identifiers()
+    .map(|u| coordinates[&u])
+    .collect::<Vec<_>>();
+  sparse_sgd_slice(graph, &mut pos, length, pivots, iterations, eps);
+  for (u, p) in graph.node_identifiers().zip(pos) {
+    coordinates.insert(u, p);
+  }
+}
+
+/// Same as `sparse_sgd`, with `coordinates` indexed in `node_identifiers` order.
+/// Panics unless `coordinates.len() == graph.node_count()`.
+pub fn sparse_sgd_slice<G, F>(
+  graph: G,
+  coordinates: &mut [(f32, f32)],
+  length: &mut F,
+  pivots: usize,
+  iterations: usize,
+  eps: f32,
+) where
+  G: IntoEdgeReferences + IntoNodeIdentifiers + NodeCount,
+  G::NodeId: Eq + Hash,
+  F: FnMut(G::EdgeRef) -> f32,
+{
+  assert_eq!(coordinates.len(), graph.node_count());
+  let pos = coordinates;
+  let adjacency = Adjacency::new(graph, length);
+  let n = adjacency.len();
+  let k = pivots.min(n);
+  if k == 0 {
+    return;
+  }
+  let mut terms = sparse_terms(&adjacency, k);
+  if terms.is_empty() {
+    return;
+  }
+
+  let mut w_min = INFINITY;
+  let mut w_max: f32 = 0.;
+  for term in &terms {
+    if term.w > 0. {
+      w_min = w_min.min(term.w);
+      w_max = w_max.max(term.w);
+    }
+  }
+  let eta_max = 1. / w_min;
+  let eta_min = eps / w_max;
+  let lambda = if iterations > 1 {
+    (eta_max / eta_min).ln() / (iterations - 1) as f32
+  } else {
+    0.
+  };
+
+  let mut rng: StdRng = SeedableRng::from_seed([0; 32]);
+  for t in 0..iterations {
+    let eta = eta_max * (-lambda * t as f32).exp();
+    terms.shuffle(&mut rng);
+    for term in &terms {
+      let mu = (term.w * eta).min(1.);
+      let (xi, yi) = pos[term.i];
+      let (xj, yj) = pos[term.j];
+      let dx = xi - xj;
+      let dy = yi - yj;
+      let norm = (dx * dx + dy * dy).sqrt().max(1e-4);
+      let r = mu * (norm - term.d) / (2. * norm);
+      if term.move_j {
+        pos[term.i].0 -= r * dx;
+        pos[term.i].1 -= r * dy;
+        pos[term.j].0 += r * dx;
+        pos[term.j].1 += r * dy;
+      } else {
+        pos[term.i].0 -= 2. * r * dx;
+        pos[term.i].1 -= 2. * r * dy;
+      }
+    }
+  }
+}
+
+#[test]
+fn test_sparse_sgd() {
+  use petgraph::Graph;
+
+  let n = 30;
+  let mut graph = Graph::new_undirected();
+  let nodes = (0..n).map(|_| graph.add_node(())).collect::<Vec<_>>();
+  for i in 1..n {
+    graph.add_edge(nodes[i - 1], nodes[i], ());
+  }
+  let mut coordinates = HashMap::new();
+  for (i, &u) in nodes.iter().enumerate() {
+    let t = i as f32 * 2.399;
+    coordinates.insert(u, (10. * t.cos(), 10. * t.sin()));
+  }
+
+  sparse_sgd(&graph, &mut coordinates, &mut |_| 1., 5, 30, 0.1);
+
+  let (x0, y0) = coordinates[&nodes[0]];
+  let (x1, y1) = coordinates[&nodes[n - 1]];
+  let d = ((x0 - x1).powi(2) + (y0 - y1).powi(2)).sqrt();
+  assert!((d - (n - 1) as f32).abs() < 0.1 * (n - 1) as f32);
+  for i in 1..n {
+    let (x0, y0) = coordinates[&nodes[i - 1]];
+    let (x1, y1) = coordinates[&nodes[i]];
+    let d = ((x0 - x1).powi(2) + (y0 - y1).powi(2)).sqrt();
+    assert!((d - 1.).abs() < 0.2);
+  }
+}
@@ -26,7 +26,7 @@ fn walk(tree: &Quadtree<()>, node_id: NodeId) {
     let rect = tree.rect(node_id);
     print_rect(rect, "none");
     for &(ref e, region) in tree.elements(node_id).iter() {
-        match **e {
+        match *e {
             Element::Leaf { x, y, n, value: _ } => {
                 let sub_rect = rect.sub_rect(region);
                 print_rect(sub_rect, "#eee");
@@ -0,0 +1,623 @@
+//! Spatial indices over layout output for hit testing: nodes as points and
+//! edges as polylines.
+//!
+//! Items are partitioned into a bucket quadtree by their centers, and every
+//! tree node keeps the bounding box of its items. Moving the items only
+//! refits the boxes, which keeps queries exact; the tree is repartitioned
+//! once the boxes overlap much more than they did when it was built.
+
+use std::cmp::Ordering;
+use std::collections::BinaryHeap;
+use std::f32::INFINITY;
+
+const BUCKET_SIZE: usize = 8;
+const MAX_DEPTH: usize = 24;
+const NONE: u32 = u32::max_value();
+
+#[derive(Copy, Clone, Debug)]
+struct Bounds {
+    x0: f32,
+    y0: f32,
+    x1: f32,
+    y1: f32,
+}
+
+impl Bounds {
+    const EMPTY: Bounds = Bounds {
+        x0: INFINITY,
+        y0: INFINITY,
+        x1: -INFINITY,
+        y1: -INFINITY,
+    };
+
+    fn new(x0: f32, y0: f32, x1: f32, y1: f32) -> Bounds {
+        Bounds {
+            x0: x0.min(x1),
+            y0: y0.min(y1),
+            x1: x0.max(x1),
+            y1: y0.max(y1),
+        }
+    }
+
+    fn union(self, other: Bounds) -> Bounds {
+        Bounds {
+            x0: self.x0.min(other.x0),
+            y0: self.y0.min(other.y0),
+            x1: self.x1.max(other.x1),
+            y1: self.y1.max(other.y1),
+        }
+    }
+
+    fn center(self) -> (f32, f32) {
+        ((self.x0 + self.x1) / 2., (self.y0 + self.y1) / 2.)
+    }
+
+    fn area(self) -> f32 {
+        if self.x0 > self.x1 {
+            0.
+        } else {
+            (self.x1 - self.x0) * (self.y1 - self.y0)
+        }
+    }
+
+    fn intersects(self, other: Bounds) -> bool {
+        self.x0 <= other.x1 && other.x0 <= self.x1 && self.y0 <= other.y1 && other.y0 <= self.y1
+    }
+
+    fn distance2(self, x: f32, y: f32) -> f32 {
+        let dx = (self.x0 - x).max(x - self.x1).max(0.);
+        let dy = (self.y0 - y).max(y - self.y1).max(0.);
+        dx * dx + dy * dy
+    }
+}
+
+/// A tree node owns `items[start..end]`; an internal node also owns its
+/// `child_count` children from `first_child`.
+#[derive(Copy, Clone, Debug)]
+struct IndexNode {
+    bounds: Bounds,
+    start: u32,
+    end: u32,
+    first_child: u32,
+    child_count: u32,
+}
+
+#[derive(Copy, Clone, PartialEq)]
+struct Candidate {
+    distance2: f32,
+    is_item: bool,
+    index: u32,
+}
+
+impl Eq for Candidate {}
+
+impl PartialOrd for Candidate {
+    fn partial_cmp(&self, other: &Candidate) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl Ord for Candidate {
+    // Reversed, so that `BinaryHeap` pops the closest candidate first; at
+    // equal distances items come before tree nodes.
+    fn cmp(&self, other: &Candidate) -> Ordering {
+        other
+            .distance2
+            .partial_cmp(&self.distance2)
+            .unwrap_or(Ordering::Equal)
+            .then(self.is_item.cmp(&other.is_item))
+    }
+}
+
+/// Bounding volume tree over items given by their bounding boxes.
+#[derive(Clone, Debug)]
+struct BoxTree {
+    boxes: Vec<Bounds>,
+    items: Vec<u32>,
+    nodes: Vec<IndexNode>,
+    buffer: Vec<u32>,
+    overlap: f32,
+}
+
+impl BoxTree {
+    fn new(boxes: Vec<Bounds>) -> BoxTree {
+        let mut tree = BoxTree {
+            boxes,
+            items: vec![],
+            nodes: vec![],
+            buffer: vec![],
+            overlap: 0.,
+        };
+        tree.rebuild();
+        tree
+    }
+
+    fn rebuild(&mut self) {
+        self.items.clear();
+        self.items.extend(0..self.boxes.len() as u32);
+        self.nodes.clear();
+        let rect = self
+            .boxes
+            .iter()
+            .fold(Bounds::EMPTY, |b, &item| b.union(item));
+        self.nodes.push(IndexNode {
+            bounds: rect,
+            start: 0,
+            end: self.boxes.len() as u32,
+            first_child: NONE,
+            child_count: 0,
+        });
+        let mut stack = vec![(0, rect, 0)];
+        while let Some((u, rect, depth)) = stack.pop() {
+            self.split(u, rect, depth, &mut stack);
+        }
+        self.refit();
+        self.overlap = self.leaf_overlap();
+    }
+
+    /// Partitions the items of leaf `u` into the quadrants of `rect`.
+    fn split(
+        &mut self,
+        u: usize,
+        rect: Bounds,
+        depth: usize,
+        stack: &mut Vec<(usize, Bounds, usize)>,
+    ) {
+        let IndexNode { start, end, .. } = self.nodes[u];
+        let (start, end) = (start as usize, end as usize);
+        if end - start <= BUCKET_SIZE || depth == MAX_DEPTH {
+            return;
+        }
+        let (cx, cy) = rect.center();
+        let boxes = &self.boxes;
+        let quadrant = |item: u32| {
+            let (x, y) = boxes[item as usize].center();
+            (if x < cx { 0 } else { 1 }) + (if y < cy { 0 } else { 2 })
+        };
+        let mut counts = [0; 4];
+        for &item in &self.items[start..end] {
+            counts[quadrant(item)] += 1;
+        }
+        let mut offsets = [start; 5];
+        for q in 0..4 {
+            offsets[q + 1] = offsets[q] + counts[q];
+        }
+        self.buffer.clear();
+        self.buffer.extend_from_slice(&self.items[start..end]);
+        let mut next = offsets;
+        for &item in &self.buffer {
+            let q = quadrant(item);
+            self.items[next[q]] = item;
+            next[q] += 1;
+        }
+        let first_child = self.nodes.len();
+        for q in 0..4 {
+            if counts[q] == 0 {
+                continue;
+            }
+            let sub = Bounds {
+                x0: if q % 2 == 0 { rect.x0 } else { cx },
+                y0: if q / 2 == 0 { rect.y0 } else { cy },
+                x1: if q % 2 == 0 { cx } else { rect.x1 },
+                y1: if q / 2 == 0 { cy } else { rect.y1 },
+            };
+            stack.push((self.nodes.len(), sub, depth + 1));
+            self.nodes.push(IndexNode {
+                bounds: sub,
+                start: offsets[q] as u32,
+                end: offsets[q + 1] as u32,
+                first_child: NONE,
+                child_count: 0,
+            });
+        }
+        self.nodes[u].first_child = first_child as u32;
+        self.nodes[u].child_count = (self.nodes.len() - first_child) as u32;
+    }
+
+    /// Recomputes the bounding boxes of the tree nodes. Children are always
+    /// allocated after their parent, so a reverse pass is bottom-up.
+    fn refit(&mut self) {
+        for u in (0..self.nodes.len()).rev() {
+            let node = self.nodes[u];
+            let bounds = if node.child_count == 0 {
+                self.items[node.start as usize..node.end as usize]
+                    .iter()
+                    .fold(Bounds::EMPTY, |b, &item| b.union(self.boxes[item as usize]))
+            } else {
+                let first = node.first_child as usize;
+                self.nodes[first..first + node.child_count as usize]
+                    .iter()
+                    .fold(Bounds::EMPTY, |b, child| b.union(child.bounds))
+            };
+            self.nodes[u].bounds = bounds;
+        }
+    }
+
+    /// Total leaf area relative to the root area, which grows as the leaves
+    /// of a refitted tree start to overlap.
+    fn leaf_overlap(&self) -> f32 {
+        let leaves = self
+            .nodes
+            .iter()
+            .filter(|node| node.child_count == 0)
+            .map(|node| node.bounds.area())
+            .sum::<f32>();
+        let root = self.nodes[0].bounds.area();
+        if root > 0. {
+            leaves / root
+        } else {
+            0.
+        }
+    }
+
+    fn update(&mut self) {
+        self.refit();
+        if self.leaf_overlap() > 2. * self.overlap + 0.1 {
+            self.rebuild();
+        }
+    }
+
+    fn within(&self, rect: Bounds) -> Vec<usize> {
+        let mut result = vec![];
+        if self.boxes.is_empty() {
+            return result;
+        }
+        let mut stack = vec![0];
+        while let Some(u) = stack.pop() {
+            let node = self.nodes[u];
+            if !node.bounds.intersects(rect) {
+                continue;
+            }
+            if node.child_count == 0 {
+                for &item in &self.items[node.start as usize..node.end as usize] {
+                    if self.boxes[item as usize].intersects(rect) {
+                        result.push(item as usize);
+                    }
+                }
+            } else {
+                let first = node.first_child as usize;
+                stack.extend(first..first + node.child_count as usize);
+            }
+        }
+        result
+    }
+
+    /// Visits items in ascending order of `item_distance2`, a squared
+    /// distance from `(x, y)` no smaller than that to the item's box, until
+    /// `f` returns `false` or the distance exceeds `max_distance2`.
+    fn visit_nearest<D: Fn(usize) -> f32, F: FnMut(usize, f32) -> bool>(
+        &self,
+        x: f32,
+        y: f32,
+        max_distance2: f32,
+        item_distance2: D,
+        mut f: F,
+    ) {
+        if self.boxes.is_empty() {
+            return;
+        }
+        let mut queue = BinaryHeap::new();
+        queue.push(Candidate {
+            distance2: self.nodes[0].bounds.distance2(x, y),
+            is_item: false,
+            index: 0,
+        });
+        while let Some(candidate) = queue.pop() {
+            if candidate.distance2 > max_distance2 {
+                break;
+            }
+            if candidate.is_item {
+                if !f(candidate.index as usize, candidate.distance2) {
+                    break;
+                }
+                continue;
+            }
+            let node = self.nodes[candidate.index as usize];
+            if node.child_count == 0 {
+                for &item in &self.items[node.start as usize..node.end as usize] {
+                    queue.push(Candidate {
+                        distance2: item_distance2(item as usize),
+                        is_item: true,
+                        index: item,
+                    });
+                }
+            } else {
+                let first = node.first_child;
+                for child in first..first + node.child_count {
+                    queue.push(Candidate {
+                        distance2: self.nodes[child as usize].bounds.distance2(x, y),
+                        is_item: false,
+                        index: child,
+                    });
+                }
+            }
+        }
+    }
+}
+
+/// Spatial index over node positions.
+#[derive(Clone, Debug)]
+pub struct PointIndex {
+    tree: BoxTree,
+}
+
+impl PointIndex {
+    /// Builds the index over positions given in node index order.
+    pub fn new<I: IntoIterator<Item = (f32, f32)>>(points: I) -> PointIndex {
+        PointIndex {
+            tree: BoxTree::new(
+                points
+                    .into_iter()
+                    .map(|(x, y)| Bounds::new(x, y, x, y))
+                    .collect(),
+            ),
+        }
+    }
+
+    /// Moves the points to new positions, given in the same order, such as
+    /// after a simulation step. Runs in O(n) unless the tree has degraded
+    /// enough to be rebuilt.
+    pub fn update<I: IntoIterator<Item = (f32, f32)>>(&mut self, points: I) {
+        let mut count = 0;
+        for (b, (x, y)) in self.tree.boxes.iter_mut().zip(points) {
+            *b = Bounds::new(x, y, x, y);
+            count += 1;
+        }
+        assert_eq!(count, self.tree.boxes.len(), "point count changed");
+        self.tree.update();
+    }
+
+    pub fn len(&self) -> usize {
+        self.tree.boxes.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.tree.boxes.is_empty()
+    }
+
+    /// Position of point `u`.
+    pub fn point(&self, u: usize) -> (f32, f32) {
+        let b = self.tree.boxes[u];
+        (b.x0, b.y0)
+    }
+
+    pub fn nearest(&self, x: f32, y: f32) -> Option<usize> {
+        self.k_nearest(x, y, 1).pop()
+    }
+
+    /// Up to `k` points closest to `(x, y)`, closest first.
+    pub fn k_nearest(&self, x: f32, y: f32, k: usize) -> Vec<usize> {
+        let mut result = Vec::with_capacity(k.min(self.len()));
+        if k == 0 {
+            return result;
+        }
+        let boxes = &self.tree.boxes;
+        self.tree.visit_nearest(
+            x,
+            y,
+            INFINITY,
+            |u| boxes[u].distance2(x, y),
+            |u, _| {
+                result.push(u);
+                result.len() < k
+            },
+        );
+        result
+    }
+
+    /// Points within `radius` of `(x, y)`, closest first.
+    pub fn within_distance(&self, x: f32, y: f32, radius: f32) -> Vec<usize> {
+        let mut result = vec![];
+        let boxes = &self.tree.boxes;
+        self.tree.visit_nearest(
+            x,
+            y,
+            radius * radius,
+            |u| boxes[u].distance2(x, y),
+            |u, _| {
+                result.push(u);
+                true
+            },
+        );
+        result
+    }
+
+    /// Points inside the rectangle with corners `(x0, y0)` and `(x1, y1)`,
+    /// in no particular order.
+    pub fn within_rect(&self, x0: f32, y0: f32, x1: f32, y1: f32) -> Vec<usize> {
+        self.tree.within(Bounds::new(x0, y0, x1, y1))
+    }
+}
+
+fn segment_distance2((x0, y0, x1, y1): (f32, f32, f32, f32), x: f32, y: f32) -> f32 {
+    let dx = x1 - x0;
+    let dy = y1 - y0;
+    let l2 = dx * dx + dy * dy;
+    let t = if l2 > 0. {
+        (((x - x0) * dx + (y - y0) * dy) / l2).max(0.).min(1.)
+    } else {
+        0.
+    };
+    let ex = x0 + t * dx - x;
+    let ey = y0 + t * dy - y;
+    ex * ex + ey * ey
+}
+
+/// Spatial index over edge polylines, such as the output of `fdeb_flat`.
+#[derive(Clone, Debug)]
+pub struct PolylineIndex {
+    tree: BoxTree,
+    segments: Vec<(f32, f32, f32, f32)>,
+    segment_edge: Vec<u32>,
+    edge_count: usize,
+}
+
+impl PolylineIndex {
+    /// The polyline of edge `e` is `points[offsets[e]..offsets[e + 1]]`.
+    pub fn new(offsets: &[usize], points: &[(f32, f32)]) -> PolylineIndex {
+        let mut segments = vec![];
+        let mut segment_edge = vec![];
+        for (e, w) in offsets.windows(2).enumerate() {
+            let polyline = &points[w[0]..w[1]];
+            if polyline.len() == 1 {
+                let (x, y) = polyline[0];
+                segments.push((x, y, x, y));
+                segment_edge.push(e as u32);
+            }
+            for p in polyline.windows(2) {
+                segments.push((p[0].0, p[0].1, p[1].0, p[1].1));
+                segment_edge.push(e as u32);
+            }
+        }
+        let boxes = segments
+            .iter()
+            .map(|&(x0, y0, x1, y1)| Bounds::new(x0, y0, x1, y1))
+            .collect();
+        PolylineIndex {
+            tree: BoxTree::new(boxes),
+            segments,
+            segment_edge,
+            edge_count: offsets.len().saturating_sub(1),
+        }
+    }
+
+    pub fn edge_count(&self) -> usize {
+        self.edge_count
+    }
+
+    /// Edge whose polyline passes closest to `(x, y)`.
+    pub fn nearest(&self, x: f32, y: f32) -> Option<usize> {
+        let mut result = None;
+        self.tree.visit_nearest(
+            x,
+            y,
+            INFINITY,
+            |s| segment_distance2(self.segments[s], x, y),
+            |s, _| {
+                result = Some(self.segment_edge[s] as usize);
+                false
+            },
+        );
+        result
+    }
+
+    /// Edges whose polylines pass within `radius` of `(x, y)`, closest
+    /// first.
+    pub fn within_distance(&self, x: f32, y: f32, radius: f32) -> Vec<usize> {
+        let mut seen = vec![false; self.edge_count];
+        let mut result = vec![];
+        self.tree.visit_nearest(
+            x,
+            y,
+            radius * radius,
+            |s| segment_distance2(self.segments[s], x, y),
+            |s, _| {
+                let e = self.segment_edge[s] as usize;
+                if !seen[e] {
+                    seen[e] = true;
+                    result.push(e);
+                }
+                true
+            },
+        );
+        result
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn points(n: usize) -> Vec<(f32, f32)> {
+        (0..n)
+            .map(|i| {
+                let t = i as f32 * 2.39996;
+                let r = (i as f32).sqrt();
+                (r * t.cos(), r * t.sin())
+            })
+            .collect()
+    }
+
+    fn distance2((x0, y0): (f32, f32), x: f32, y: f32) -> f32 {
+        (x0 - x) * (x0 - x) + (y0 - y) * (y0 - y)
+    }
+
+    fn scan(points: &[(f32, f32)], x: f32, y: f32) -> Vec<usize> {
+        let mut order = (0..points.len()).collect::<Vec<_>>();
+        order.sort_by(|&u, &v| {
+            distance2(points[u], x, y)
+                .partial_cmp(&distance2(points[v], x, y))
+                .unwrap()
+        });
+        order
+    }
+
+    fn check(index: &PointIndex, points: &[(f32, f32)]) {
+        for &(x, y) in &[(0., 0.), (3.5, -7.25), (-40., 12.), (100., 100.)] {
+            let expected = scan(points, x, y);
+            let nearest = index.nearest(x, y).unwrap();
+            assert_eq!(
+                distance2(points[nearest], x, y),
+                distance2(points[expected[0]], x, y)
+            );
+            let k_nearest = index.k_nearest(x, y, 10);
+            assert_eq!(k_nearest.len(), 10);
+            for (&u, &v) in k_nearest.iter().zip(&expected) {
+                assert_eq!(distance2(points[u], x, y), distance2(points[v], x, y));
+            }
+            let mut within = index.within_distance(x, y, 5.);
+            within.sort();
+            let mut expected = (0..points.len())
+                .filter(|&u| distance2(points[u], x, y) <= 25.)
+                .collect::<Vec<_>>();
+            expected.sort();
+            assert_eq!(within, expected);
+        }
+        let mut within = index.within_rect(-10., -5., 8., 20.);
+        within.sort();
+        let expected = (0..points.len())
+            .filter(|&u| {
+                let (x, y) = points[u];
+                -10. <= x && x <= 8. && -5. <= y && y <= 20.
+            })
+            .collect::<Vec<_>>();
+        assert_eq!(within, expected);
+    }
+
+    #[test]
+    fn test_point_index() {
+        let mut points = points(2000);
+        let mut index = PointIndex::new(points.iter().cloned());
+        check(&index, &points);
+        for step in 0..5 {
+            for (i, p) in points.iter_mut().enumerate() {
+                let t = (i + step) as f32;
+                p.0 = p.0 * 1.1 + t.sin();
+                p.1 = p.1 * 0.9 - t.cos();
+            }
+            index.update(points.iter().cloned());
+            check(&index, &points);
+        }
+        assert_eq!(PointIndex::new(vec![]).nearest(0., 0.), None);
+    }
+
+    #[test]
+    fn test_polyline_index() {
+        let offsets = vec![0, 3, 5, 5, 6];
+        let points = vec![
+            (0., 0.),
+            (10., 0.),
+            (10., 10.),
+            (0., 5.),
+            (5., 5.),
+            (20., 20.),
+        ];
+        let index = PolylineIndex::new(&offsets, &points);
+        assert_eq!(index.edge_count(), 4);
+        assert_eq!(index.nearest(9., 8.), Some(0));
+        assert_eq!(index.nearest(2., 4.), Some(1));
+        assert_eq!(index.nearest(19., 21.), Some(3));
+        assert_eq!(index.within_distance(4., 4., 1.5), vec![1]);
+        assert_eq!(index.within_distance(7., 3., 3.), vec![1, 0]);
+    }
+}
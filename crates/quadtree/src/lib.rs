@@ -1,3 +1,7 @@
+pub mod index;
+
+pub use self::index::{PointIndex, PolylineIndex};
+
 #[derive(PartialEq, Eq, Copy, Clone, Debug)]
 pub enum Region {
     TL,
@@ -86,6 +90,10 @@ impl Rect {
     pub fn height(self) -> f32 {
         self.height
     }
+
+    fn is_degenerate(self) -> bool {
+        self.cx + self.width / 4. == self.cx && self.cy + self.height / 4. == self.cy
+    }
 }
 
 #[derive(PartialEq, Eq, Copy, Clone, Debug)]
@@ -97,6 +105,10 @@ impl NodeId {
     pub fn new(index: usize) -> NodeId {
         NodeId { index }
     }
+
+    pub fn index(self) -> usize {
+        self.index
+    }
 }
 
 #[derive(Copy, Clone, Debug)]
@@ -113,214 +125,219 @@ pub enum Element {
     },
 }
 
-#[derive(Clone, Debug)]
-pub struct Node<T> {
-    parent: Option<NodeId>,
-    top_left: Box<Element>,
-    top_right: Box<Element>,
-    bottom_left: Box<Element>,
-    bottom_right: Box<Element>,
-    rect: Rect,
-    data: T,
+const EMPTY: u32 = u32::max_value();
+const LEAF: u32 = 1 << 31;
+
+fn region_index(region: Region) -> usize {
+    match region {
+        Region::TL => 0,
+        Region::TR => 1,
+        Region::BL => 2,
+        Region::BR => 3,
+    }
 }
 
+fn spread_bits(v: u32) -> u32 {
+    let mut v = v & 0x0000ffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    v
+}
+
+fn morton_code(rect: Rect, x: f32, y: f32) -> u32 {
+    let scale = 65535.;
+    let ix = ((x - rect.left()) / rect.width * scale).max(0.).min(scale) as u32;
+    let iy = ((y - rect.bottom()) / rect.height * scale)
+        .max(0.)
+        .min(scale) as u32;
+    spread_bits(ix) | (spread_bits(iy) << 1)
+}
+
+/// A point region quadtree stored in flat arrays.
+///
+/// Each node owns four child slots that hold either nothing, the index of a
+/// child node or the index of a leaf. Node and leaf attributes live in
+/// parallel vectors, so building and walking the tree does not allocate per
+/// element and `clear` / `rebuild` reuse the buffers of the previous tree.
+/// A child node is always allocated after its parent, so iterating node ids
+/// in reverse order visits every node before its ancestors.
 #[derive(Clone, Debug)]
 pub struct Quadtree<T> {
     root: NodeId,
-    nodes: Vec<Node<T>>,
+    children: Vec<[u32; 4]>,
+    rects: Vec<Rect>,
+    data: Vec<T>,
+    leaf_x: Vec<f32>,
+    leaf_y: Vec<f32>,
+    leaf_n: Vec<usize>,
+    leaf_value: Vec<f32>,
+    buffer: Vec<(u32, f32, f32, f32)>,
 }
 
-impl<T: Default> Node<T> {
-    pub fn new(rect: Rect) -> Node<T> {
-        Node {
-            parent: None,
-            top_left: Box::new(Element::Empty),
-            top_right: Box::new(Element::Empty),
-            bottom_left: Box::new(Element::Empty),
-            bottom_right: Box::new(Element::Empty),
-            rect: rect,
-            data: T::default(),
-        }
-    }
-
-    pub fn new_with_parent(rect: Rect, parent: NodeId) -> Node<T> {
-        Node {
-            parent: Some(parent),
-            top_left: Box::new(Element::Empty),
-            top_right: Box::new(Element::Empty),
-            bottom_left: Box::new(Element::Empty),
-            bottom_right: Box::new(Element::Empty),
-            rect: rect,
-            data: T::default(),
-        }
+impl<T: Default> Quadtree<T> {
+    pub fn new(rect: Rect) -> Quadtree<T> {
+        let mut tree = Quadtree {
+            root: NodeId { index: 0 },
+            children: Vec::new(),
+            rects: Vec::new(),
+            data: Vec::new(),
+            leaf_x: Vec::new(),
+            leaf_y: Vec::new(),
+            leaf_n: Vec::new(),
+            leaf_value: Vec::new(),
+            buffer: Vec::new(),
+        };
+        tree.clear(rect);
+        tree
     }
 
-    pub fn child(&self, region: Region) -> Element {
-        match region {
-            Region::TL => *self.top_left,
-            Region::TR => *self.top_right,
-            Region::BL => *self.bottom_left,
-            Region::BR => *self.bottom_right,
-        }
+    /// Builds a tree from `(x, y, value)` triples, inserting them in Morton order.
+    pub fn with_points<I: IntoIterator<Item = (f32, f32, f32)>>(
+        rect: Rect,
+        points: I,
+    ) -> Quadtree<T> {
+        let mut tree = Quadtree::new(rect);
+        tree.rebuild(rect, points);
+        tree
     }
 
-    pub fn insert(&mut self, region: Region, element: Element) {
-        match region {
-            Region::TL => self.top_left = Box::new(element),
-            Region::TR => self.top_right = Box::new(element),
-            Region::BL => self.bottom_left = Box::new(element),
-            Region::BR => self.bottom_right = Box::new(element),
-        }
+    /// Removes every element and resets the root to `rect`, keeping the allocated buffers.
+    pub fn clear(&mut self, rect: Rect) {
+        self.children.clear();
+        self.rects.clear();
+        self.data.clear();
+        self.leaf_x.clear();
+        self.leaf_y.clear();
+        self.leaf_n.clear();
+        self.leaf_value.clear();
+        self.push_node(rect);
     }
-}
 
-impl<T: Default> Quadtree<T> {
-    pub fn new(rect: Rect) -> Quadtree<T> {
-        let mut nodes = Vec::new();
-        nodes.push(Node::<T>::new(rect));
-        Quadtree {
-            root: NodeId { index: 0 },
-            nodes: nodes,
+    /// Clears the tree and inserts `(x, y, value)` triples sorted by their Morton code.
+    pub fn rebuild<I: IntoIterator<Item = (f32, f32, f32)>>(&mut self, rect: Rect, points: I) {
+        self.clear(rect);
+        let mut buffer = std::mem::replace(&mut self.buffer, Vec::new());
+        buffer.clear();
+        buffer.extend(
+            points
+                .into_iter()
+                .map(|(x, y, value)| (morton_code(rect, x, y), x, y, value)),
+        );
+        buffer.sort_unstable_by_key(|&(code, _, _, _)| code);
+        let root = self.root;
+        for &(_, x, y, value) in buffer.iter() {
+            self.insert(root, x, y, value);
         }
+        self.buffer = buffer;
     }
 
     pub fn root(&self) -> NodeId {
         self.root
     }
 
+    pub fn node_count(&self) -> usize {
+        self.children.len()
+    }
+
     pub fn find(&self, u: NodeId, x: f32, y: f32) -> (NodeId, Region) {
-        let node = &self.nodes[u.index];
-        let region = node.rect.quad(x, y);
-        let child = node.child(region);
-        match child {
-            Element::Node { node_id: v } => self.find(v, x, y),
-            _ => (u, region),
+        let mut u = u;
+        loop {
+            let region = self.rects[u.index].quad(x, y);
+            let slot = self.children[u.index][region_index(region)];
+            if slot == EMPTY || slot & LEAF != 0 {
+                return (u, region);
+            }
+            u = NodeId::new(slot as usize);
         }
     }
 
     pub fn insert(&mut self, u: NodeId, x: f32, y: f32, value: f32) -> (NodeId, Region) {
-        let (v, region) = self.find(u, x, y);
-        match self.nodes[v.index].child(region) {
-            Element::Empty => self.insert_to_empty(v, region, x, y, value),
-            Element::Leaf {
-                x: x0,
-                y: y0,
-                n,
-                value,
-            } => {
-                if x == x && y == y0 {
-                    self.increment_leaf(v, region, x, y, n, value)
-                } else {
-                    self.insert_to_leaf(v, region, x, y, x0, y0, n, value)
-                }
+        let mut u = u;
+        loop {
+            let (v, region) = self.find(u, x, y);
+            let slot = self.children[v.index][region_index(region)];
+            if slot == EMPTY {
+                let leaf = self.leaf_x.len() as u32;
+                self.leaf_x.push(x);
+                self.leaf_y.push(y);
+                self.leaf_n.push(1);
+                self.leaf_value.push(value);
+                self.children[v.index][region_index(region)] = LEAF | leaf;
+                return (v, region);
             }
-            _ => {
-                panic!("unexpected");
+            let leaf = (slot & !LEAF) as usize;
+            let x0 = self.leaf_x[leaf];
+            let y0 = self.leaf_y[leaf];
+            let rect = self.rects[v.index].sub_rect(region);
+            if (x == x0 && y == y0) || rect.is_degenerate() {
+                self.leaf_n[leaf] += 1;
+                return (v, region);
             }
+            let w = self.push_node(rect);
+            self.children[v.index][region_index(region)] = w.index as u32;
+            self.children[w.index][region_index(rect.quad(x0, y0))] = slot;
+            u = w;
         }
     }
 
-    fn insert_to_empty(
-        &mut self,
-        u: NodeId,
-        region: Region,
-        x: f32,
-        y: f32,
-        value: f32,
-    ) -> (NodeId, Region) {
-        let node = self.nodes.get_mut(u.index).unwrap();
-        node.insert(
-            region,
-            Element::Leaf {
-                x: x,
-                y: y,
-                n: 1,
-                value,
-            },
-        );
-        (u, region)
-    }
-
-    fn insert_to_leaf(
-        &mut self,
-        u: NodeId,
-        region: Region,
-        x: f32,
-        y: f32,
-        x0: f32,
-        y0: f32,
-        n: usize,
-        value: f32,
-    ) -> (NodeId, Region) {
-        let index = self.nodes.len();
-        let rect = self.nodes[u.index].rect.sub_rect(region);
-        self.nodes.push(Node::new_with_parent(rect, u));
-        let new_node = NodeId { index: index };
-        self.nodes[u.index].insert(region, Element::Node { node_id: new_node });
-        let region = self.nodes[new_node.index].rect.quad(x0, y0);
-        self.nodes[new_node.index].insert(
-            region,
-            Element::Leaf {
-                x: x0,
-                y: y0,
-                n: n,
-                value,
-            },
-        );
-        self.insert(new_node, x, y, value)
+    fn push_node(&mut self, rect: Rect) -> NodeId {
+        let index = self.children.len();
+        self.children.push([EMPTY; 4]);
+        self.rects.push(rect);
+        self.data.push(T::default());
+        NodeId { index }
     }
 
-    fn increment_leaf(
-        &mut self,
-        u: NodeId,
-        region: Region,
-        x: f32,
-        y: f32,
-        n: usize,
-        value: f32,
-    ) -> (NodeId, Region) {
-        self.nodes[u.index].insert(
-            region,
+    fn decode(&self, slot: u32) -> Element {
+        if slot == EMPTY {
+            Element::Empty
+        } else if slot & LEAF != 0 {
+            let leaf = (slot & !LEAF) as usize;
             Element::Leaf {
-                x: x,
-                y: y,
-                n: n + 1,
-                value: value,
-            },
-        );
-        (u, region)
+                x: self.leaf_x[leaf],
+                y: self.leaf_y[leaf],
+                n: self.leaf_n[leaf],
+                value: self.leaf_value[leaf],
+            }
+        } else {
+            Element::Node {
+                node_id: NodeId::new(slot as usize),
+            }
+        }
     }
 
     pub fn rect(&self, u: NodeId) -> Rect {
-        self.nodes[u.index].rect
+        self.rects[u.index]
     }
 
     pub fn element(&self, u: NodeId, region: Region) -> Element {
-        self.nodes[u.index].child(region)
+        self.decode(self.children[u.index][region_index(region)])
     }
 
-    pub fn elements(&self, u: NodeId) -> [(Box<Element>, Region); 4] {
-        let node = &self.nodes[u.index];
+    pub fn elements(&self, u: NodeId) -> [(Element, Region); 4] {
+        let children = &self.children[u.index];
         [
-            (node.top_left.clone(), Region::TL),
-            (node.top_right.clone(), Region::TR),
-            (node.bottom_left.clone(), Region::BL),
-            (node.bottom_right.clone(), Region::BR),
+            (self.decode(children[0]), Region::TL),
+            (self.decode(children[1]), Region::TR),
+            (self.decode(children[2]), Region::BL),
+            (self.decode(children[3]), Region::BR),
         ]
     }
 
     pub fn data(&self, u: NodeId) -> &T {
-        &self.nodes[u.index].data
+        &self.data[u.index]
     }
 
     pub fn data_mut(&mut self, u: NodeId) -> &mut T {
-        &mut self.nodes[u.index].data
+        &mut self.data[u.index]
     }
 }
 
 #[cfg(test)]
 mod tests {
-    use super::{Element, Quadtree, Rect, Region};
+    use super::{Element, NodeId, Quadtree, Rect, Region};
 
     fn make_tree() -> Quadtree<()> {
         Quadtree::new(Rect {
@@ -360,10 +377,66 @@ mod tests {
         let tree = make_tree();
         let root = tree.root();
         for &(ref e, _) in tree.elements(root).iter() {
-            assert!(match **e {
+            assert!(match *e {
                 Element::Empty => true,
                 _ => false,
             });
         }
     }
+
+    fn count(tree: &Quadtree<()>, node_id: NodeId) -> usize {
+        tree.elements(node_id)
+            .iter()
+            .map(|&(e, _)| match e {
+                Element::Leaf { n, .. } => n,
+                Element::Node { node_id } => count(tree, node_id),
+                Element::Empty => 0,
+            })
+            .sum()
+    }
+
+    #[test]
+    fn test_insert_coincident() {
+        let mut tree = make_tree();
+        let root = tree.root();
+        tree.insert(root, 10., 10., 0.);
+        tree.insert(root, 20., 10., 0.);
+        tree.insert(root, 10., 10., 0.);
+        assert_eq!(count(&tree, root), 3);
+        let (node_id, region) = tree.find(root, 10., 10.);
+        assert!(match tree.element(node_id, region) {
+            Element::Leaf { n, .. } => n == 2,
+            _ => false,
+        });
+    }
+
+    #[test]
+    fn test_rebuild() {
+        let rect = Rect {
+            cx: 0.,
+            cy: 0.,
+            width: 100.,
+            height: 100.,
+        };
+        let points = (0..100)
+            .map(|i| ((i % 10) as f32 * 10. - 45., (i / 10) as f32 * 10. - 45., 1.))
+            .collect::<Vec<_>>();
+        let mut tree = Quadtree::<()>::with_points(rect, points.iter().cloned());
+        let root = tree.root();
+        let node_count = tree.node_count();
+        assert_eq!(count(&tree, root), 100);
+        for &(x, y, _) in points.iter() {
+            let (node_id, region) = tree.find(root, x, y);
+            assert!(match tree.element(node_id, region) {
+                Element::Leaf { x: x0, y: y0, .. } => x == x0 && y == y0,
+                _ => false,
+            });
+        }
+        tree.rebuild(rect, points.iter().rev().cloned());
+        assert_eq!(tree.node_count(), node_count);
+        assert_eq!(count(&tree, root), 100);
+        tree.clear(rect);
+        assert_eq!(tree.node_count(), 1);
+        assert_eq!(count(&tree, root), 0);
+    }
 }
@@ -1,9 +1,20 @@
 use crate::graph::JsGraph;
+use js_sys::{Float32Array, Object, Reflect, Uint32Array};
 use petgraph::graph::node_index;
-use petgraph_edge_bundling_fdeb::{fdeb, EdgeBundlingOptions};
+use petgraph_edge_bundling_fdeb::{fdeb, fdeb_flat, EdgeBundling, EdgeBundlingOptions};
 use std::collections::HashMap;
 use wasm_bindgen::prelude::*;
 
+fn node_coordinates(graph: &JsGraph, coordinates: &[f32]) -> Result<Vec<(f32, f32)>, JsValue> {
+    if coordinates.len() != 2 * graph.graph().node_count() {
+        return Err("coordinates must have length 2 * nodeCount".into());
+    }
+    Ok(coordinates
+        .chunks(2)
+        .map(|xy| (xy[0], xy[1]))
+        .collect::<Vec<_>>())
+}
+
 #[wasm_bindgen(js_name = fdeb)]
 pub fn js_fdeb(graph: &JsGraph, coordinates: &JsValue) -> JsValue {
     let coordinates: HashMap<usize, (f32, f32)> = coordinates.into_serde().unwrap();
@@ -18,3 +29,85 @@ pub fn js_fdeb(graph: &JsGraph, coordinates: &JsValue) -> JsValue {
         .collect::<HashMap<_, _>>();
     JsValue::from_serde(&bends).unwrap()
 }
+
+/// Bundles the edges of `graph` laid out at `coordinates`, a `Float32Array`
+/// of `[x0, y0, x1, y1, ...]` indexed by node index. Returns
+/// `{ offsets, points }`: the polyline of edge `e` is
+/// `points[2 * offsets[e]..2 * offsets[e + 1]]`, ready for `PolylineIndex`.
+#[wasm_bindgen(js_name = fdebFlat)]
+pub fn js_fdeb_flat(graph: &JsGraph, coordinates: &[f32]) -> Result<Object, JsValue> {
+    let coordinates = node_coordinates(graph, coordinates)?;
+    let options = EdgeBundlingOptions::new();
+    let (offsets, points) = fdeb_flat(graph.graph(), &coordinates, &options);
+    let offsets = offsets.into_iter().map(|i| i as u32).collect::<Vec<_>>();
+    let mut flat = Vec::with_capacity(2 * points.len());
+    for (x, y) in points {
+        flat.push(x);
+        flat.push(y);
+    }
+    let result = Object::new();
+    Reflect::set(&result, &"offsets".into(), &Uint32Array::from(&offsets[..]))?;
+    Reflect::set(&result, &"points".into(), &Float32Array::from(&flat[..]))?;
+    Ok(result)
+}
+
+/// Edge bundling run a few iterations at a time, e.g. one `step` per
+/// animation frame, with the current polylines available after every call in
+/// the same layout as `fdebFlat`. To cancel, stop calling `step` and `free`
+/// the object.
+#[wasm_bindgen(js_name = EdgeBundling)]
+pub struct JsEdgeBundling {
+    bundling: EdgeBundling,
+}
+
+#[wasm_bindgen(js_class = EdgeBundling)]
+impl JsEdgeBundling {
+    #[wasm_bindgen(constructor)]
+    pub fn new(graph: &JsGraph, coordinates: &[f32]) -> Result<JsEdgeBundling, JsValue> {
+        let coordinates = node_coordinates(graph, coordinates)?;
+        let options = EdgeBundlingOptions::new();
+        Ok(JsEdgeBundling {
+            bundling: EdgeBundling::new(graph.graph(), &coordinates, &options),
+        })
+    }
+
+    /// Runs up to `iterations` iterations. Returns `false` once bundling is
+    /// finished.
+    pub fn step(&mut self, iterations: usize) -> bool {
+        self.bundling.run_iterations(iterations)
+    }
+
+    /// Runs the rest of the current subdivision cycle. Returns `false` once
+    /// bundling is finished.
+    #[wasm_bindgen(js_name = runCycle)]
+    pub fn run_cycle(&mut self) -> bool {
+        self.bundling.run_cycle()
+    }
+
+    pub fn run(&mut self) {
+        self.bundling.run()
+    }
+
+    #[wasm_bindgen(js_name = isFinished)]
+    pub fn is_finished(&self) -> bool {
+        self.bundling.is_finished()
+    }
+
+    pub fn cycle(&self) -> usize {
+        self.bundling.cycle()
+    }
+
+    /// Returns a `Uint32Array` of polyline offsets, indexed by edge index.
+    pub fn offsets(&self) -> Vec<u32> {
+        self.bundling
+            .polyline_offsets()
+            .into_iter()
+            .map(|i| i as u32)
+            .collect()
+    }
+
+    /// Returns a `Float32Array` of `[x0, y0, x1, y1, ...]` polyline points.
+    pub fn points(&self) -> Vec<f32> {
+        self.bundling.polyline_coordinates()
+    }
+}
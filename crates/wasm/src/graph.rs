@@ -29,6 +29,28 @@ impl JsGraph {
         }
     }
 
+    /// Builds a graph of `nodeCount` nodes from a `Uint32Array` of
+    /// `[source0, target0, source1, target1, ...]` in a single call. Node and
+    /// edge weights are `null`.
+    #[wasm_bindgen(js_name = fromEdgeList)]
+    pub fn from_edge_list(node_count: usize, edges: &[u32]) -> Result<JsGraph, JsValue> {
+        if edges.len() % 2 != 0 {
+            return Err("edges must have an even length".into());
+        }
+        let mut graph = GraphType::with_capacity(node_count, edges.len() / 2);
+        for _ in 0..node_count {
+            graph.add_node(JsValue::null());
+        }
+        for e in edges.chunks(2) {
+            let (u, v) = (e[0] as usize, e[1] as usize);
+            if u >= node_count || v >= node_count {
+                return Err("invalid node index".into());
+            }
+            graph.add_edge(node_index(u), node_index(v), JsValue::null());
+        }
+        Ok(JsGraph { graph })
+    }
+
     #[wasm_bindgen(js_name = nodeCount)]
     pub fn node_count(&self) -> usize {
         self.graph.node_count()
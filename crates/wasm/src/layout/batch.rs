@@ -0,0 +1,98 @@
+use petgraph_layout_batch::{layout_batch, BatchLayout, GraphBatch};
+use wasm_bindgen::prelude::*;
+
+fn to_usize(values: &[u32]) -> Vec<usize> {
+    values.iter().map(|&v| v as usize).collect()
+}
+
+/// Many small graphs laid out in one call. Graph `g` owns the nodes
+/// `graphOffsets[g]..graphOffsets[g + 1]`; the neighbors of node `u` are
+/// `neighbors[offsets[u]..offsets[u + 1]]`, as indices local to its graph,
+/// with each edge listed once. Coordinates are `Float32Array`s of
+/// `[x0, y0, x1, y1, ...]` indexed by node of the batch. The layouts take
+/// `(x, y)` pairs, so each call copies the array into pairs and writes the
+/// result back into it; the copy is linear next to the layout itself.
+#[wasm_bindgen(js_name = GraphBatch)]
+pub struct JsGraphBatch {
+    batch: GraphBatch,
+}
+
+#[wasm_bindgen(js_class = GraphBatch)]
+impl JsGraphBatch {
+    #[wasm_bindgen(constructor)]
+    pub fn new(
+        graph_offsets: &[u32],
+        offsets: &[u32],
+        neighbors: &[u32],
+    ) -> Result<JsGraphBatch, JsValue> {
+        let batch = GraphBatch::from_csr(
+            to_usize(graph_offsets),
+            to_usize(offsets),
+            to_usize(neighbors),
+        )?;
+        Ok(JsGraphBatch { batch })
+    }
+
+    #[wasm_bindgen(js_name = graphCount)]
+    pub fn graph_count(&self) -> usize {
+        self.batch.graph_count()
+    }
+
+    #[wasm_bindgen(js_name = nodeCount)]
+    pub fn node_count(&self) -> usize {
+        self.batch.node_count()
+    }
+
+    #[wasm_bindgen(js_name = initialPlacement)]
+    pub fn initial_placement(&self) -> Vec<f32> {
+        let placement = self.batch.initial_placement();
+        let mut coordinates = Vec::with_capacity(2 * placement.len());
+        for (x, y) in placement {
+            coordinates.push(x);
+            coordinates.push(y);
+        }
+        coordinates
+    }
+
+    #[wasm_bindgen(js_name = forceSimulation)]
+    pub fn force_simulation(&self, coordinates: &mut [f32]) -> Result<(), JsValue> {
+        self.layout(BatchLayout::ForceSimulation, coordinates)
+    }
+
+    #[wasm_bindgen(js_name = kamadaKawai)]
+    pub fn kamada_kawai(
+        &self,
+        coordinates: &mut [f32],
+        eps: f32,
+        size: f32,
+    ) -> Result<(), JsValue> {
+        self.layout(BatchLayout::KamadaKawai { eps, size }, coordinates)
+    }
+
+    #[wasm_bindgen(js_name = stressMajorization)]
+    pub fn stress_majorization(
+        &self,
+        coordinates: &mut [f32],
+        edge_length: f32,
+    ) -> Result<(), JsValue> {
+        self.layout(BatchLayout::StressMajorization { edge_length }, coordinates)
+    }
+}
+
+impl JsGraphBatch {
+    fn layout(&self, layout: BatchLayout, coordinates: &mut [f32]) -> Result<(), JsValue> {
+        if coordinates.len() != 2 * self.batch.node_count() {
+            return Err("coordinates must have length 2 * nodeCount".into());
+        }
+        let mut pos = coordinates
+            .chunks(2)
+            .map(|xy| (xy[0], xy[1]))
+            .collect::<Vec<_>>();
+        layout_batch(&self.batch, layout, &mut pos);
+        for (xy, (x, y)) in coordinates.chunks_mut(2).zip(pos) {
+            xy[0] = x;
+            xy[1] = y;
+        }
+        Ok(())
+    }
+}
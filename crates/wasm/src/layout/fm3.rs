@@ -12,12 +12,10 @@ pub fn fm3(
     _shrink_edge: Function,
     _link_distance_accessor: Function,
 ) -> JsValue {
-    let coordinates = petgraph_layout_fm3::fm3(
+    let coordinates = petgraph_layout_fm3::fm3_with_link_distance(
         graph.graph(),
         min_size,
         step_iteration,
-        &mut |_, _| JsValue::null(),
-        &mut |_, _| JsValue::null(),
         &mut |_, _| 30.,
     )
     .into_iter()
@@ -1,7 +1,7 @@
 use crate::graph::JsGraph;
 use js_sys::{Function, Reflect};
 use petgraph_layout_force_simulation::force::link_force::LinkArgument;
-use petgraph_layout_force_simulation::force::position_force;
+use petgraph_layout_force_simulation::force::{many_body_force, position_force};
 use petgraph_layout_force_simulation::force::{
     CenterForce, CollideForce, LinkForce, ManyBodyForce, PositionForce, RadialForce,
 };
@@ -9,26 +9,146 @@ use petgraph_layout_force_simulation::Force;
 use std::collections::HashMap;
 use wasm_bindgen::prelude::*;
 
+/// The built-in forces are kept by type so that they can follow changes of
+/// the graph; any other force is boxed.
+enum ForceKind {
+    Center(CenterForce),
+    Collide(CollideForce),
+    Link(LinkForce),
+    ManyBody(ManyBodyForce),
+    Position(PositionForce),
+    Radial(RadialForce),
+    Other(Box<dyn Force>),
+}
+
 #[wasm_bindgen(js_name = Force)]
 pub struct JsForce {
-    force: Box<dyn Force>,
+    force: ForceKind,
 }
 
 impl JsForce {
     pub fn new<F: Force + 'static>(force: F) -> JsForce {
+        JsForce::with_box(Box::new(force))
+    }
+
+    pub fn with_box(force: Box<dyn Force>) -> JsForce {
         JsForce {
-            force: Box::new(force),
+            force: ForceKind::Other(force),
         }
     }
 
-    pub fn with_box(force: Box<dyn Force>) -> JsForce {
+    fn with_kind(force: ForceKind) -> JsForce {
         JsForce { force }
     }
 }
 
+fn optional_f32(value: &JsValue, key: &str) -> Option<f32> {
+    Reflect::get(value, &key.into())
+        .ok()
+        .map(|v| v.as_f64().map(|v| v as f32))
+        .flatten()
+}
+
+fn required_f32(value: &JsValue, key: &str) -> Result<f32, JsValue> {
+    optional_f32(value, key).ok_or_else(|| format!("{} is not a number", key).into())
+}
+
+/// Checks that a typed array passed to a bulk constructor has one value per
+/// node or per edge.
+fn check_length(values: &[f32], len: usize, name: &str) -> Result<(), JsValue> {
+    if values.len() == len {
+        Ok(())
+    } else {
+        Err(format!("{} must have length {}", name, len).into())
+    }
+}
+
+/// Bulk constructors take `NaN` for an unset optional value.
+fn non_nan(value: f32) -> Option<f32> {
+    if value.is_nan() {
+        None
+    } else {
+        Some(value)
+    }
+}
+
+#[wasm_bindgen(js_class = Force)]
+impl JsForce {
+    /// Appends a node to the force, reading the same per-node arguments as
+    /// the force's constructor.
+    #[wasm_bindgen(js_name = addNode)]
+    pub fn add_node(&mut self, argument: &JsValue) -> Result<(), JsValue> {
+        match &mut self.force {
+            ForceKind::Center(_) => {}
+            ForceKind::Collide(force) => force.add_node(required_f32(argument, "radius")?),
+            ForceKind::Link(force) => force.add_node(),
+            ForceKind::ManyBody(force) => force.add_node(
+                optional_f32(argument, "strength").unwrap_or(many_body_force::DEFAULT_STRENGTH),
+            ),
+            ForceKind::Position(force) => force.add_node(position_force::NodeArgument {
+                strength: optional_f32(argument, "strength"),
+                x: optional_f32(argument, "x"),
+                y: optional_f32(argument, "y"),
+            }),
+            ForceKind::Radial(force) => force.add_node(Some((
+                required_f32(argument, "strength")?,
+                required_f32(argument, "radius")?,
+                required_f32(argument, "x")?,
+                required_f32(argument, "y")?,
+            ))),
+            ForceKind::Other(_) => return Err("this force cannot be updated".into()),
+        }
+        Ok(())
+    }
+
+    /// Removes node `u`, moving the last node into its place as
+    /// `Graph.removeNode` does.
+    #[wasm_bindgen(js_name = removeNode)]
+    pub fn remove_node(&mut self, u: usize) -> Result<(), JsValue> {
+        match &mut self.force {
+            ForceKind::Center(_) => {}
+            ForceKind::Collide(force) => force.remove_node(u),
+            ForceKind::Link(force) => force.remove_node(u),
+            ForceKind::ManyBody(force) => force.remove_node(u),
+            ForceKind::Position(force) => force.remove_node(u),
+            ForceKind::Radial(force) => force.remove_node(u),
+            ForceKind::Other(_) => return Err("this force cannot be updated".into()),
+        }
+        Ok(())
+    }
+
+    /// Adds a link with the optional `distance` and `strength` of
+    /// `argument`. Forces other than `LinkForce` ignore links.
+    #[wasm_bindgen(js_name = addLink)]
+    pub fn add_link(&mut self, source: usize, target: usize, argument: &JsValue) {
+        if let ForceKind::Link(force) = &mut self.force {
+            let distance = optional_f32(argument, "distance");
+            let strength = optional_f32(argument, "strength");
+            force.add_link(source, target, LinkArgument { distance, strength });
+        }
+    }
+
+    #[wasm_bindgen(js_name = removeLink)]
+    pub fn remove_link(&mut self, source: usize, target: usize) -> bool {
+        if let ForceKind::Link(force) = &mut self.force {
+            force.remove_link(source, target)
+        } else {
+            false
+        }
+    }
+}
+
 impl AsRef<dyn Force> for JsForce {
     fn as_ref(&self) -> &(dyn Force + 'static) {
-        self.force.as_ref()
+        match &self.force {
+            ForceKind::Center(force) => force,
+            ForceKind::Collide(force) => force,
+            ForceKind::Link(force) => force,
+            ForceKind::ManyBody(force) => force,
+            ForceKind::Position(force) => force,
+            ForceKind::Radial(force) => force,
+            ForceKind::Other(force) => force.as_ref(),
+        }
     }
 }
 
@@ -39,7 +159,7 @@ pub struct JsCenterForce {}
 impl JsCenterForce {
     #[wasm_bindgen(constructor)]
     pub fn new() -> JsForce {
-        JsForce::new(CenterForce::new())
+        JsForce::with_kind(ForceKind::Center(CenterForce::new()))
     }
 }
 
@@ -61,15 +181,33 @@ impl JsCollideForce {
         let strength = Reflect::get(&options, &"strength".into())?
             .as_f64()
             .ok_or_else(|| format!("options.strength is not a number"))?;
-        let iterations = Reflect::get(&options, &"strength".into())?
+        let iterations = Reflect::get(&options, &"iterations".into())?
             .as_f64()
             .ok_or_else(|| format!("options.iterations is not a number"))?;
-        Ok(JsForce::new(CollideForce::new(
+        Ok(JsForce::with_kind(ForceKind::Collide(CollideForce::new(
             graph.graph(),
             |_, u| radii[&u],
             strength as f32,
             iterations as usize,
-        )))
+        ))))
+    }
+
+    /// Same as the constructor, with the radii given as a `Float32Array`
+    /// indexed by node index.
+    #[wasm_bindgen(js_name = fromRadii)]
+    pub fn from_radii(
+        graph: &JsGraph,
+        radii: &[f32],
+        strength: f32,
+        iterations: usize,
+    ) -> Result<JsForce, JsValue> {
+        check_length(radii, graph.graph().node_count(), "radii")?;
+        Ok(JsForce::with_kind(ForceKind::Collide(CollideForce::new(
+            graph.graph(),
+            |_, u| radii[u.index()],
+            strength,
+            iterations,
+        ))))
     }
 }
 
@@ -81,7 +219,9 @@ impl JsLinkForce {
     #[wasm_bindgen(constructor)]
     pub fn new(graph: &JsGraph, f: &Function) -> Result<JsForce, JsValue> {
         if f.is_undefined() {
-            return Ok(JsForce::new(LinkForce::new(graph.graph())));
+            return Ok(JsForce::with_kind(ForceKind::Link(LinkForce::new(
+                graph.graph(),
+            ))));
         }
         let mut link_arguments = HashMap::new();
         for e in graph.graph().edge_indices() {
@@ -96,9 +236,31 @@ impl JsLinkForce {
                 .flatten();
             link_arguments.insert(e, LinkArgument { distance, strength });
         }
-        Ok(JsForce::new(LinkForce::new_with_accessor(
-            graph.graph(),
-            |_, e| link_arguments[&e],
+        Ok(JsForce::with_kind(ForceKind::Link(
+            LinkForce::new_with_accessor(graph.graph(), |_, e| link_arguments[&e]),
+        )))
+    }
+
+    /// Same as the constructor, with the distances and strengths given as
+    /// `Float32Array`s indexed by edge index. Either array may be omitted.
+    #[wasm_bindgen(js_name = fromArrays)]
+    pub fn from_arrays(
+        graph: &JsGraph,
+        distance: Option<Box<[f32]>>,
+        strength: Option<Box<[f32]>>,
+    ) -> Result<JsForce, JsValue> {
+        let m = graph.graph().edge_count();
+        if let Some(distance) = &distance {
+            check_length(distance, m, "distance")?;
+        }
+        if let Some(strength) = &strength {
+            check_length(strength, m, "strength")?;
+        }
+        Ok(JsForce::with_kind(ForceKind::Link(
+            LinkForce::new_with_accessor(graph.graph(), |_, e| LinkArgument {
+                distance: distance.as_ref().and_then(|d| non_nan(d[e.index()])),
+                strength: strength.as_ref().and_then(|s| non_nan(s[e.index()])),
+            }),
         )))
     }
 }
@@ -111,7 +273,9 @@ impl JsManyBodyForce {
     #[wasm_bindgen(constructor)]
     pub fn new(graph: &JsGraph, f: &Function) -> Result<JsForce, JsValue> {
         if f.is_undefined() {
-            return Ok(JsForce::new(ManyBodyForce::new(graph.graph())));
+            return Ok(JsForce::with_kind(ForceKind::ManyBody(ManyBodyForce::new(
+                graph.graph(),
+            ))));
         }
         let mut strengths = HashMap::new();
         for u in graph.graph().node_indices() {
@@ -122,9 +286,18 @@ impl JsManyBodyForce {
                 .flatten();
             strengths.insert(u, strength);
         }
-        Ok(JsForce::new(ManyBodyForce::new_with_accessor(
-            graph.graph(),
-            |_, u| strengths[&u],
+        Ok(JsForce::with_kind(ForceKind::ManyBody(
+            ManyBodyForce::new_with_accessor(graph.graph(), |_, u| strengths[&u]),
+        )))
+    }
+
+    /// Same as the constructor, with the strengths given as a `Float32Array`
+    /// indexed by node index.
+    #[wasm_bindgen(js_name = fromStrengths)]
+    pub fn from_strengths(graph: &JsGraph, strengths: &[f32]) -> Result<JsForce, JsValue> {
+        check_length(strengths, graph.graph().node_count(), "strengths")?;
+        Ok(JsForce::with_kind(ForceKind::ManyBody(
+            ManyBodyForce::new_with_accessor(graph.graph(), |_, u| non_nan(strengths[u.index()])),
         )))
     }
 }
@@ -153,9 +326,33 @@ impl JsPositionForce {
                 .flatten();
             node_arguments.insert(u, position_force::NodeArgument { strength, x, y });
         }
-        Ok(JsForce::new(PositionForce::new(graph.graph(), |_, u| {
-            node_arguments[&u]
-        })))
+        Ok(JsForce::with_kind(ForceKind::Position(PositionForce::new(
+            graph.graph(),
+            |_, u| node_arguments[&u],
+        ))))
+    }
+
+    /// Same as the constructor, with the arguments given as `Float32Array`s
+    /// indexed by node index.
+    #[wasm_bindgen(js_name = fromArrays)]
+    pub fn from_arrays(
+        graph: &JsGraph,
+        strength: &[f32],
+        x: &[f32],
+        y: &[f32],
+    ) -> Result<JsForce, JsValue> {
+        let n = graph.graph().node_count();
+        check_length(strength, n, "strength")?;
+        check_length(x, n, "x")?;
+        check_length(y, n, "y")?;
+        Ok(JsForce::with_kind(ForceKind::Position(PositionForce::new(
+            graph.graph(),
+            |_, u| position_force::NodeArgument {
+                strength: non_nan(strength[u.index()]),
+                x: non_nan(x[u.index()]),
+                y: non_nan(y[u.index()]),
+            },
+        ))))
     }
 }
 
@@ -186,8 +383,33 @@ impl JsRadialForce {
                 Some((strength as f32, radius as f32, x as f32, y as f32)),
             );
         }
-        Ok(JsForce::new(RadialForce::new(graph.graph(), |_, u| {
-            node_arguments[&u]
-        })))
+        Ok(JsForce::with_kind(ForceKind::Radial(RadialForce::new(
+            graph.graph(),
+            |_, u| node_arguments[&u],
+        ))))
+    }
+
+    /// Same as the constructor, with the arguments given as `Float32Array`s
+    /// indexed by node index.
+    #[wasm_bindgen(js_name = fromArrays)]
+    pub fn from_arrays(
+        graph: &JsGraph,
+        strength: &[f32],
+        radius: &[f32],
+        x: &[f32],
+        y: &[f32],
+    ) -> Result<JsForce, JsValue> {
+        let n = graph.graph().node_count();
+        check_length(strength, n, "strength")?;
+        check_length(radius, n, "radius")?;
+        check_length(x, n, "x")?;
+        check_length(y, n, "y")?;
+        Ok(JsForce::with_kind(ForceKind::Radial(RadialForce::new(
+            graph.graph(),
+            |_, u| {
+                let i = u.index();
+                Some((strength[i], radius[i], x[i], y[i]))
+            },
+        ))))
     }
 }
@@ -10,13 +10,37 @@ use wasm_bindgen::prelude::*;
 
 #[wasm_bindgen(js_name = initialPlacement)]
 pub fn initial_placement(graph: &JsGraph) -> JsValue {
-    let coordinates = petgraph_layout_force_simulation::initial_placement(graph.graph())
+    convert_placement(&petgraph_layout_force_simulation::initial_placement(
+        graph.graph(),
+    ))
+}
+
+fn convert_placement(coordinates: &HashMap<petgraph::graph::NodeIndex, (f32, f32)>) -> JsValue {
+    let coordinates = coordinates
         .iter()
         .map(|(u, &(x, y))| (u.index(), (x, y)))
         .collect::<HashMap<usize, (f32, f32)>>();
     JsValue::from_serde(&coordinates).unwrap()
 }
 
+#[wasm_bindgen(js_name = pivotMdsPlacement)]
+pub fn pivot_mds_placement(graph: &JsGraph, pivots: usize, edge_length: f32) -> JsValue {
+    convert_placement(&petgraph_layout_force_simulation::pivot_mds_placement(
+        graph.graph(),
+        pivots,
+        edge_length,
+    ))
+}
+
+#[wasm_bindgen(js_name = spectralPlacement)]
+pub fn spectral_placement(graph: &JsGraph, iterations: usize, edge_length: f32) -> JsValue {
+    convert_placement(&petgraph_layout_force_simulation::spectral_placement(
+        graph.graph(),
+        iterations,
+        edge_length,
+    ))
+}
+
 #[wasm_bindgen(js_name = forceConnected)]
 pub fn force_connected(graph: &JsGraph) -> Array {
     let forces = petgraph_layout_force_simulation::force_connected(graph.graph());
@@ -1,10 +1,11 @@
 use super::force::JsForce;
 use crate::graph::JsGraph;
 use core::ops::Deref;
-use js_sys::{Array, Function, Reflect};
+use js_sys::{Array, Date, Float32Array, Function, Object, Reflect};
 use petgraph::graph::NodeIndex;
-use petgraph_layout_force_simulation::Simulation;
+use petgraph_layout_force_simulation::{Point, Simulation};
 use std::collections::HashMap;
+use std::sync::{Arc, Mutex};
 use wasm_bindgen::convert::RefFromWasmAbi;
 use wasm_bindgen::prelude::*;
 
@@ -33,9 +34,44 @@ fn convert_coordinates(coordinates: &HashMap<NodeIndex, (f32, f32)>) -> JsValue
     JsValue::from_serde(&coordinates).unwrap()
 }
 
+/// Milliseconds from `performance.now()`, or from `Date.now()` where
+/// `performance` is unavailable.
+fn now() -> f64 {
+    let performance = Reflect::get(&js_sys::global(), &"performance".into());
+    if let Ok(performance) = performance {
+        if let Ok(f) = Reflect::get(&performance, &"now".into()) {
+            if let Ok(f) = f.dyn_into::<Function>() {
+                if let Some(t) = f.call0(&performance).ok().and_then(|t| t.as_f64()) {
+                    return t;
+                }
+            }
+        }
+    }
+    Date::now()
+}
+
+fn clock() -> f64 {
+    now() / 1000.
+}
+
+#[derive(Default)]
+struct Stats {
+    steps: usize,
+    alpha: f32,
+    kinetic_energy: f32,
+    force_times: Vec<f64>,
+}
+
 #[wasm_bindgen(js_name = Simulation)]
 pub struct JsSimulation {
     simulation: Simulation<u32>,
+    stats: Option<Arc<Mutex<Stats>>>,
+}
+
+impl JsSimulation {
+    pub fn simulation(&self) -> &Simulation<u32> {
+        &self.simulation
+    }
 }
 
 #[wasm_bindgen(js_class = Simulation)]
@@ -58,6 +94,22 @@ impl JsSimulation {
         }
         Ok(JsSimulation {
             simulation: Simulation::new(graph.graph(), |_, u| initial_position[&u]),
+            stats: None,
+        })
+    }
+
+    /// Builds a simulation from a `Float32Array` of initial positions
+    /// `[x0, y0, x1, y1, ...]` indexed by node index.
+    #[wasm_bindgen(js_name = fromPositions)]
+    pub fn from_positions(graph: &JsGraph, positions: &[f32]) -> Result<JsSimulation, JsValue> {
+        if positions.len() != 2 * graph.graph().node_count() {
+            return Err("positions must have length 2 * nodeCount".into());
+        }
+        Ok(JsSimulation {
+            simulation: Simulation::new(graph.graph(), |_, u| {
+                (positions[2 * u.index()], positions[2 * u.index() + 1])
+            }),
+            stats: None,
         })
     }
 
@@ -78,6 +130,124 @@ impl JsSimulation {
         ))
     }
 
+    /// Runs `n` steps without converting the coordinates; read them through
+    /// `pointBuffer`.
+    pub fn step(&mut self, n: usize, js_forces: Box<[JsValue]>) -> Result<(), JsValue> {
+        let forces = convert_forces(&js_forces)?;
+        let force_refs = forces.iter().map(|f| f.deref()).collect::<Vec<_>>();
+        for _ in 0..n {
+            self.simulation.step(&force_refs.as_slice());
+        }
+        Ok(())
+    }
+
+    /// Returns a `Float32Array` view over the points in WASM memory, laid out
+    /// as `x, y, vx, vy` per node in node index order. The view is detached
+    /// whenever the WASM memory grows, so it should be taken again after any
+    /// call that may allocate.
+    #[wasm_bindgen(js_name = pointBuffer)]
+    pub fn point_buffer(&self) -> Float32Array {
+        let points = self.simulation.points();
+        let len = points.len() * std::mem::size_of::<Point>() / std::mem::size_of::<f32>();
+        unsafe {
+            Float32Array::view(std::slice::from_raw_parts(
+                points.as_ptr() as *const f32,
+                len,
+            ))
+        }
+    }
+
+    /// Starts collecting step statistics, clearing any collected before.
+    #[wasm_bindgen(js_name = enableStats)]
+    pub fn enable_stats(&mut self) {
+        let stats = Arc::new(Mutex::new(Stats::default()));
+        {
+            let stats = stats.clone();
+            self.simulation.set_stats_hook(move |step| {
+                let mut stats = stats.lock().unwrap();
+                stats.steps += 1;
+                stats.alpha = step.alpha;
+                stats.kinetic_energy = step.kinetic_energy;
+                if stats.force_times.len() < step.force_times.len() {
+                    stats.force_times.resize(step.force_times.len(), 0.);
+                }
+                for (total, &t) in stats.force_times.iter_mut().zip(step.force_times) {
+                    *total += t;
+                }
+            });
+        }
+        self.simulation.set_clock(clock);
+        self.stats = Some(stats);
+    }
+
+    #[wasm_bindgen(js_name = disableStats)]
+    pub fn disable_stats(&mut self) {
+        self.simulation.clear_stats_hook();
+        self.stats = None;
+    }
+
+    /// Returns `{steps, alpha, kineticEnergy, forceTimes}` collected since
+    /// `enableStats`, where `forceTimes` holds the total milliseconds spent in
+    /// each force in the order passed to the step calls, or `null` when stats
+    /// are disabled.
+    pub fn stats(&self) -> Result<JsValue, JsValue> {
+        let stats = match &self.stats {
+            Some(stats) => stats.lock().unwrap(),
+            None => return Ok(JsValue::null()),
+        };
+        let result = Object::new();
+        Reflect::set(&result, &"steps".into(), &(stats.steps as f64).into())?;
+        Reflect::set(&result, &"alpha".into(), &stats.alpha.into())?;
+        Reflect::set(
+            &result,
+            &"kineticEnergy".into(),
+            &stats.kinetic_energy.into(),
+        )?;
+        let force_times = stats
+            .force_times
+            .iter()
+            .map(|&t| JsValue::from_f64(t * 1000.))
+            .collect::<Array>();
+        Reflect::set(&result, &"forceTimes".into(), &force_times)?;
+        Ok(result.into())
+    }
+
+    #[wasm_bindgen(getter = kineticEnergy)]
+    pub fn kinetic_energy(&self) -> f32 {
+        self.simulation.kinetic_energy()
+    }
+
+    #[wasm_bindgen(getter = movementThreshold)]
+    pub fn movement_threshold(&self) -> f32 {
+        self.simulation.movement_threshold
+    }
+
+    #[wasm_bindgen(setter = movementThreshold)]
+    pub fn set_movement_threshold(&mut self, value: f32) {
+        self.simulation.movement_threshold = value;
+    }
+
+    /// Appends node `u` at `(x, y)`. The node must also be added to the
+    /// forces with `Force.addNode`.
+    #[wasm_bindgen(js_name = addNode)]
+    pub fn add_node(&mut self, u: usize, x: f32, y: f32) -> usize {
+        self.simulation.add_node(NodeIndex::new(u), x, y)
+    }
+
+    /// Removes node `u`, moving the last node into its place as
+    /// `Graph.removeNode` does.
+    #[wasm_bindgen(js_name = removeNode)]
+    pub fn remove_node(&mut self, u: usize) {
+        self.simulation.remove_node(u);
+    }
+
+    /// Raises the alpha of node `u` alone, so that it and the nodes reheated
+    /// with it settle without moving the rest of the layout.
+    #[wasm_bindgen(js_name = reheatNode)]
+    pub fn reheat_node(&mut self, u: usize, alpha: f32) {
+        self.simulation.reheat_node(u, alpha);
+    }
+
     #[wasm_bindgen(js_name = isFinished)]
     pub fn is_finished(&self) -> bool {
         self.simulation.is_finished()
@@ -1,3 +1,4 @@
+pub mod batch;
 pub mod fm3;
 pub mod force_simulation;
 pub mod grouped_force;
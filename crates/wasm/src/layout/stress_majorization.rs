@@ -40,3 +40,45 @@ pub fn stress_majorization(
     .unwrap(),
   )
 }
+
+#[wasm_bindgen(js_name = sparseSgd)]
+pub fn sparse_sgd(
+  graph: &JsGraph,
+  coordinates: JsValue,
+  f: Function,
+  pivots: usize,
+  iterations: usize,
+  eps: f32,
+) -> Result<JsValue, JsValue> {
+  let mut distance = HashMap::new();
+  for e in graph.graph().edge_indices() {
+    let result = f.call1(&JsValue::null(), &JsValue::from_f64(e.index() as f64))?;
+    let d = Reflect::get(&result, &"distance".into())?
+      .as_f64()
+      .ok_or_else(|| format!("links[{}].distance is not a Number.", e.index()))?;
+    distance.insert(e, d as f32);
+  }
+
+  let mut coordinates = JsValue::into_serde::<HashMap<usize, (f32, f32)>>(&coordinates)
+    .unwrap()
+    .into_iter()
+    .map(|(k, v)| (NodeIndex::new(k), v))
+    .collect::<HashMap<_, _>>();
+  petgraph_layout_stress_majorization::sparse_sgd(
+    graph.graph(),
+    &mut coordinates,
+    &mut |e| distance[&e.id()],
+    pivots,
+    iterations,
+    eps,
+  );
+  Ok(
+    JsValue::from_serde(
+      &coordinates
+        .into_iter()
+        .map(|(k, v)| (k.index(), v))
+        .collect::<HashMap<_, _>>(),
+    )
+    .unwrap(),
+  )
+}
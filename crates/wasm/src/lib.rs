@@ -6,3 +6,7 @@ pub mod edge_bundling;
 pub mod graph;
 // pub mod grouping;
 pub mod layout;
+pub mod spatial_index;
+
+#[cfg(feature = "parallel")]
+pub use wasm_bindgen_rayon::init_thread_pool;
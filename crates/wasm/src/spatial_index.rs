@@ -0,0 +1,112 @@
+use crate::layout::force_simulation::simulation::JsSimulation;
+use quadtree::{PointIndex, PolylineIndex};
+use wasm_bindgen::prelude::*;
+
+fn to_u32(indices: Vec<usize>) -> Vec<u32> {
+    indices.into_iter().map(|u| u as u32).collect()
+}
+
+fn interleaved(points: &[f32]) -> Result<impl Iterator<Item = (f32, f32)> + '_, JsValue> {
+    if points.len() % 2 != 0 {
+        return Err("points must have an even length".into());
+    }
+    Ok(points.chunks(2).map(|xy| (xy[0], xy[1])))
+}
+
+/// Spatial index over node positions for hover and lasso selection. Node
+/// indices are returned as numbers or `Uint32Array`s.
+#[wasm_bindgen(js_name = PointIndex)]
+pub struct JsPointIndex {
+    index: PointIndex,
+}
+
+#[wasm_bindgen(js_class = PointIndex)]
+impl JsPointIndex {
+    /// Builds the index from a `Float32Array` of `[x0, y0, x1, y1, ...]`
+    /// indexed by node index.
+    #[wasm_bindgen(constructor)]
+    pub fn new(points: &[f32]) -> Result<JsPointIndex, JsValue> {
+        Ok(JsPointIndex {
+            index: PointIndex::new(interleaved(points)?),
+        })
+    }
+
+    #[wasm_bindgen(js_name = fromSimulation)]
+    pub fn from_simulation(simulation: &JsSimulation) -> JsPointIndex {
+        let points = simulation.simulation().points();
+        JsPointIndex {
+            index: PointIndex::new(points.iter().map(|p| (p.x, p.y))),
+        }
+    }
+
+    /// Moves the nodes to new positions, given as in the constructor.
+    pub fn update(&mut self, points: &[f32]) -> Result<(), JsValue> {
+        if points.len() != 2 * self.index.len() {
+            return Err("points must have length 2 * nodeCount".into());
+        }
+        self.index.update(interleaved(points)?);
+        Ok(())
+    }
+
+    /// Moves the nodes to the current positions of `simulation`; call it
+    /// after each batch of steps. Cheaper than rebuilding the index.
+    #[wasm_bindgen(js_name = updateFromSimulation)]
+    pub fn update_from_simulation(&mut self, simulation: &JsSimulation) -> Result<(), JsValue> {
+        let points = simulation.simulation().points();
+        if points.len() != self.index.len() {
+            return Err("the simulation has a different node count".into());
+        }
+        self.index.update(points.iter().map(|p| (p.x, p.y)));
+        Ok(())
+    }
+
+    pub fn nearest(&self, x: f32, y: f32) -> Option<u32> {
+        self.index.nearest(x, y).map(|u| u as u32)
+    }
+
+    #[wasm_bindgen(js_name = kNearest)]
+    pub fn k_nearest(&self, x: f32, y: f32, k: usize) -> Vec<u32> {
+        to_u32(self.index.k_nearest(x, y, k))
+    }
+
+    #[wasm_bindgen(js_name = withinDistance)]
+    pub fn within_distance(&self, x: f32, y: f32, radius: f32) -> Vec<u32> {
+        to_u32(self.index.within_distance(x, y, radius))
+    }
+
+    #[wasm_bindgen(js_name = withinRect)]
+    pub fn within_rect(&self, x0: f32, y0: f32, x1: f32, y1: f32) -> Vec<u32> {
+        to_u32(self.index.within_rect(x0, y0, x1, y1))
+    }
+}
+
+/// Spatial index over edge polylines, such as the output of `fdebFlat`.
+#[wasm_bindgen(js_name = PolylineIndex)]
+pub struct JsPolylineIndex {
+    index: PolylineIndex,
+}
+
+#[wasm_bindgen(js_class = PolylineIndex)]
+impl JsPolylineIndex {
+    /// The polyline of edge `e` is `points[2 * offsets[e]..2 * offsets[e + 1]]`.
+    #[wasm_bindgen(constructor)]
+    pub fn new(offsets: &[u32], points: &[f32]) -> Result<JsPolylineIndex, JsValue> {
+        let points = interleaved(points)?.collect::<Vec<_>>();
+        let offsets = offsets.iter().map(|&i| i as usize).collect::<Vec<_>>();
+        if offsets.windows(2).any(|w| w[0] > w[1]) || offsets.last() > Some(&points.len()) {
+            return Err("invalid polyline offsets".into());
+        }
+        Ok(JsPolylineIndex {
+            index: PolylineIndex::new(&offsets, &points),
+        })
+    }
+
+    pub fn nearest(&self, x: f32, y: f32) -> Option<u32> {
+        self.index.nearest(x, y).map(|e| e as u32)
+    }
+
+    #[wasm_bindgen(js_name = withinDistance)]
+    pub fn within_distance(&self, x: f32, y: f32, radius: f32) -> Vec<u32> {
+        to_u32(self.index.within_distance(x, y, radius))
+    }
+}
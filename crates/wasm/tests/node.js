@@ -52,6 +52,74 @@ exports.testSimulation = function (data) {
   }
 };
 
+exports.testSimulationPointBuffer = function (data) {
+  const { ManyBodyForce, Simulation, initialPlacement } = wasm;
+  const graph = constructGraph(data);
+  const initialCoordinates = initialPlacement(graph);
+  const forces = [new ManyBodyForce(graph)];
+  const expected = new Simulation(graph, (u) => initialCoordinates[u]);
+  const simulation = new Simulation(graph, (u) => initialCoordinates[u]);
+  const coordinates = expected.runStep(10, forces);
+  simulation.step(10, forces);
+  const points = simulation.pointBuffer();
+  assert.strictEqual(points.length, 4 * graph.nodeCount());
+  for (const u of graph.nodeIndices()) {
+    assert.strictEqual(points[4 * u], coordinates[u][0]);
+    assert.strictEqual(points[4 * u + 1], coordinates[u][1]);
+  }
+};
+
+exports.testSimulationStats = function (data) {
+  const { LinkForce, ManyBodyForce, Simulation, initialPlacement } = wasm;
+  const graph = constructGraph(data);
+  const initialCoordinates = initialPlacement(graph);
+  const simulation = new Simulation(graph, (u) => initialCoordinates[u]);
+  assert.strictEqual(simulation.stats(), null);
+  simulation.enableStats();
+  simulation.movementThreshold = 0.1;
+  simulation.run([new ManyBodyForce(graph), new LinkForce(graph)]);
+  const stats = simulation.stats();
+  assert(stats.steps > 0);
+  assert(stats.steps <= simulation.iterations);
+  assert.strictEqual(stats.forceTimes.length, 2);
+  assert.strictEqual(stats.kineticEnergy, simulation.kineticEnergy);
+  assert(simulation.isFinished());
+};
+
+exports.testSimulationUpdate = function (data) {
+  const { LinkForce, ManyBodyForce, Simulation, initialPlacement } = wasm;
+  const graph = constructGraph(data);
+  const initialCoordinates = initialPlacement(graph);
+  const manyBodyForce = new ManyBodyForce(graph);
+  const linkForce = new LinkForce(graph);
+  const forces = [manyBodyForce, linkForce];
+  const simulation = new Simulation(graph, (u) => initialCoordinates[u]);
+  simulation.run(forces);
+  assert(simulation.isFinished());
+
+  const u = graph.addNode({});
+  graph.addEdge(u, 0, {});
+  const points = simulation.pointBuffer();
+  assert.strictEqual(simulation.addNode(u, points[0] + 1, points[1] + 1), u);
+  manyBodyForce.addNode({});
+  linkForce.addNode({});
+  linkForce.addLink(u, 0, { distance: 30 });
+  simulation.reheatNode(u, 1);
+  assert(!simulation.isFinished());
+  const coordinates = simulation.run(forces);
+  assert.strictEqual(Object.keys(coordinates).length, graph.nodeCount());
+  assert(Number.isFinite(coordinates[u][0]));
+  assert(Number.isFinite(coordinates[u][1]));
+
+  graph.removeNode(u);
+  simulation.removeNode(u);
+  manyBodyForce.removeNode(u);
+  linkForce.removeNode(u);
+  assert(!linkForce.removeLink(u, 0));
+  simulation.step(1, forces);
+  assert.strictEqual(simulation.pointBuffer().length, 4 * graph.nodeCount());
+};
+
 exports.testCenterForce = function (data) {
   const { CenterForce } = wasm;
   const graph = constructGraph(data);
@@ -105,6 +173,168 @@ exports.testRadialForce = function (data) {
   ]);
 };
 
+exports.testBulkConstructors = function (data) {
+  const {
+    CollideForce,
+    Graph,
+    LinkForce,
+    ManyBodyForce,
+    PositionForce,
+    RadialForce,
+    Simulation,
+  } = wasm;
+  const indices = new Map(data.nodes.map((node, i) => [node.id, i]));
+  const edges = new Uint32Array(2 * data.links.length);
+  data.links.forEach(({ source, target }, i) => {
+    edges[2 * i] = indices.get(source);
+    edges[2 * i + 1] = indices.get(target);
+  });
+  const n = data.nodes.length;
+  const graph = Graph.fromEdgeList(n, edges);
+  assert.strictEqual(graph.nodeCount(), n);
+  assert.strictEqual(graph.edgeCount(), data.links.length);
+  assert.throws(() => Graph.fromEdgeList(1, new Uint32Array([0, 1])));
+
+  const positions = new Float32Array(2 * n);
+  for (let u = 0; u < n; ++u) {
+    positions[2 * u] = 10 * Math.cos(u);
+    positions[2 * u + 1] = 10 * Math.sin(u);
+  }
+  const filled = (k, value) => new Float32Array(k).fill(value);
+  const forces = [
+    CollideForce.fromRadii(graph, filled(n, 10), 0.1, 1),
+    LinkForce.fromArrays(graph, filled(data.links.length, 30), undefined),
+    ManyBodyForce.fromStrengths(graph, filled(n, NaN)),
+    PositionForce.fromArrays(
+      graph,
+      filled(n, 0.1),
+      filled(n, 0),
+      filled(n, NaN)
+    ),
+    RadialForce.fromArrays(
+      graph,
+      filled(n, 0.1),
+      filled(n, 100),
+      filled(n, 0),
+      filled(n, 0)
+    ),
+  ];
+  assert.throws(() => ManyBodyForce.fromStrengths(graph, filled(n + 1, 0)));
+  const simulation = Simulation.fromPositions(graph, positions);
+  checkResult(graph, simulation.run(forces));
+};
+
+exports.testSpatialIndex = function (data) {
+  const {
+    ManyBodyForce,
+    PointIndex,
+    PolylineIndex,
+    Simulation,
+    fdebFlat,
+    initialPlacement,
+  } = wasm;
+  const graph = constructGraph(data);
+  const initialCoordinates = initialPlacement(graph);
+  const simulation = new Simulation(graph, (u) => initialCoordinates[u]);
+  const index = PointIndex.fromSimulation(simulation);
+  const scan = (points, x, y) => {
+    let best = 0;
+    for (let u = 0; 2 * u < points.length; ++u) {
+      const d = Math.hypot(points[2 * u] - x, points[2 * u + 1] - y);
+      const dBest = Math.hypot(points[2 * best] - x, points[2 * best + 1] - y);
+      if (d < dBest) {
+        best = u;
+      }
+    }
+    return best;
+  };
+  simulation.step(10, [new ManyBodyForce(graph)]);
+  index.updateFromSimulation(simulation);
+  const points = simulation.pointBuffer().filter((_, i) => i % 4 < 2);
+  assert.strictEqual(index.nearest(3, -5), scan(points, 3, -5));
+  assert.strictEqual(index.kNearest(0, 0, 5).length, 5);
+  const all = index.withinRect(-Infinity, -Infinity, Infinity, Infinity);
+  assert.strictEqual(all.length, graph.nodeCount());
+
+  const { offsets, points: polylinePoints } = fdebFlat(graph, points);
+  assert.strictEqual(offsets.length, graph.edgeCount() + 1);
+  const polylines = new PolylineIndex(offsets, polylinePoints);
+  const [x, y] = polylinePoints;
+  const e = polylines.nearest(x, y);
+  assert(offsets[e] < offsets[e + 1]);
+  assert(polylines.withinDistance(x, y, 1).includes(e));
+};
+
+exports.testInitialPlacement = function (data) {
+  const { pivotMdsPlacement, spectralPlacement } = wasm;
+  const graph = constructGraph(data);
+  checkResult(graph, pivotMdsPlacement(graph, 10, 30));
+  checkResult(graph, spectralPlacement(graph, 50, 30));
+};
+
+exports.testEdgeBundling = function (data) {
+  const { EdgeBundling, fdebFlat, initialPlacement } = wasm;
+  const graph = constructGraph(data);
+  const initialCoordinates = initialPlacement(graph);
+  const coordinates = new Float32Array(2 * graph.nodeCount());
+  for (const u of graph.nodeIndices()) {
+    coordinates[2 * u] = initialCoordinates[u][0];
+    coordinates[2 * u + 1] = initialCoordinates[u][1];
+  }
+  const bundling = new EdgeBundling(graph, coordinates);
+  assert(bundling.step(10));
+  assert.strictEqual(bundling.offsets().length, graph.edgeCount() + 1);
+  assert.strictEqual(bundling.points().length, 2 * 3 * graph.edgeCount());
+  while (bundling.step(50)) {}
+  assert(bundling.isFinished());
+  const { offsets, points } = fdebFlat(graph, coordinates);
+  assert.deepStrictEqual(bundling.offsets(), offsets);
+  assert.deepStrictEqual(bundling.points(), points);
+  bundling.free();
+  assert.throws(() => new EdgeBundling(graph, coordinates.slice(1)));
+};
+
+exports.testGraphBatch = function () {
+  const { GraphBatch } = wasm;
+  // Cycles of 3 to 12 nodes.
+  const graphOffsets = [0];
+  const offsets = [0];
+  const neighbors = [];
+  for (let n = 3; n <= 12; ++n) {
+    for (let i = 0; i < n; ++i) {
+      neighbors.push((i + 1) % n);
+      offsets.push(neighbors.length);
+    }
+    graphOffsets.push(offsets.length - 1);
+  }
+  const batch = new GraphBatch(
+    new Uint32Array(graphOffsets),
+    new Uint32Array(offsets),
+    new Uint32Array(neighbors),
+  );
+  assert.strictEqual(batch.graphCount(), 10);
+  const layouts = [
+    (coordinates) => batch.forceSimulation(coordinates),
+    (coordinates) => batch.kamadaKawai(coordinates, 1e-1, 100),
+    (coordinates) => batch.stressMajorization(coordinates, 30),
+  ];
+  for (const layout of layouts) {
+    const coordinates = batch.initialPlacement();
+    assert.strictEqual(coordinates.length, 2 * batch.nodeCount());
+    layout(coordinates);
+    assert(coordinates.every(Number.isFinite));
+  }
+  assert.throws(() => batch.forceSimulation(new Float32Array(1)));
+  assert.throws(
+    () =>
+      new GraphBatch(
+        new Uint32Array([0, 1]),
+        new Uint32Array([0, 1]),
+        new Uint32Array([1]),
+      ),
+  );
+};
+
 exports.testKamadaKawai = function (data) {
   const { initialPlacement, kamadaKawai } = wasm;
   const graph = constructGraph(data);
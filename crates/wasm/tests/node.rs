@@ -15,6 +15,12 @@ extern "C" {
   fn test_construct_graph(data: JsValue);
   #[wasm_bindgen(js_name = "testSimulation")]
   fn test_simulation(data: JsValue);
+  #[wasm_bindgen(js_name = "testSimulationPointBuffer")]
+  fn test_simulation_point_buffer(data: JsValue);
+  #[wasm_bindgen(js_name = "testSimulationStats")]
+  fn test_simulation_stats(data: JsValue);
+  #[wasm_bindgen(js_name = "testSimulationUpdate")]
+  fn test_simulation_update(data: JsValue);
   #[wasm_bindgen(js_name = "testCenterForce")]
   fn test_center_force(data: JsValue);
   #[wasm_bindgen(js_name = "testCollideForce")]
@@ -27,6 +33,16 @@ extern "C" {
   fn test_position_force(data: JsValue);
   #[wasm_bindgen(js_name = "testRadialForce")]
   fn test_radial_force(data: JsValue);
+  #[wasm_bindgen(js_name = "testBulkConstructors")]
+  fn test_bulk_constructors(data: JsValue);
+  #[wasm_bindgen(js_name = "testSpatialIndex")]
+  fn test_spatial_index(data: JsValue);
+  #[wasm_bindgen(js_name = "testInitialPlacement")]
+  fn test_initial_placement(data: JsValue);
+  #[wasm_bindgen(js_name = "testEdgeBundling")]
+  fn test_edge_bundling(data: JsValue);
+  #[wasm_bindgen(js_name = "testGraphBatch")]
+  fn test_graph_batch();
   #[wasm_bindgen(js_name = "testKamadaKawai")]
   fn test_kamada_kawai(data: JsValue);
   #[wasm_bindgen(js_name = "testStressMajorization")]
@@ -45,6 +61,24 @@ pub fn simulation() {
   test_simulation(data);
 }
 
+#[wasm_bindgen_test]
+pub fn simulation_point_buffer() {
+  let data = example_data();
+  test_simulation_point_buffer(data);
+}
+
+#[wasm_bindgen_test]
+pub fn simulation_stats() {
+  let data = example_data();
+  test_simulation_stats(data);
+}
+
+#[wasm_bindgen_test]
+pub fn simulation_update() {
+  let data = example_data();
+  test_simulation_update(data);
+}
+
 #[wasm_bindgen_test]
 pub fn center_force() {
   let data = example_data();
@@ -80,6 +114,35 @@ pub fn radial_force() {
   test_radial_force(data);
 }
 
+#[wasm_bindgen_test]
+pub fn bulk_constructors() {
+  let data = example_data();
+  test_bulk_constructors(data);
+}
+
+#[wasm_bindgen_test]
+pub fn spatial_index() {
+  let data = example_data();
+  test_spatial_index(data);
+}
+
+#[wasm_bindgen_test]
+pub fn initial_placement() {
+  let data = example_data();
+  test_initial_placement(data);
+}
+
+#[wasm_bindgen_test]
+pub fn edge_bundling() {
+  let data = example_data();
+  test_edge_bundling(data);
+}
+
+#[wasm_bindgen_test]
+pub fn graph_batch() {
+  test_graph_batch();
+}
+
 #[wasm_bindgen_test]
 pub fn kamada_kawai() {
   let data = example_data();
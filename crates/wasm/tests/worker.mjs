@@ -0,0 +1,75 @@
+// Smoke test of SimulationWorker under node, run with
+// `npm run wasm-test:worker` after `npm run wasm-build:nodejs`.
+//
+// The main thread drives the real client in ../worker/index.js through a
+// shim of the web Worker API. This file also runs as the worker thread,
+// where it loads the nodejs build and serves requests with the same
+// runSimulation as ../worker/worker.js.
+
+import assert from "assert";
+import { createRequire } from "module";
+import { isMainThread, parentPort, Worker } from "worker_threads";
+import { runSimulation } from "../worker/simulation.js";
+
+class NodeWorker {
+  constructor(url) {
+    this.worker = new Worker(url);
+    this.worker.on("message", (data) => this.onmessage({ data }));
+  }
+
+  postMessage(message, transfer) {
+    this.worker.postMessage(message, transfer);
+  }
+
+  terminate() {
+    this.worker.terminate();
+  }
+}
+
+async function main() {
+  globalThis.Worker = NodeWorker;
+  const { SimulationWorker } = await import("../worker/index.js");
+  const worker = new SimulationWorker(new URL(import.meta.url));
+  const graph = { nodeCount: 3, links: [0, 1, 0, 2, 1, 2] };
+  const forces = [
+    { type: "ManyBodyForce" },
+    { type: "LinkForce", links: [{ distance: 200 }, {}, {}] },
+    { type: "CenterForce" },
+  ];
+
+  const progress = [];
+  const coordinates = await worker.run(
+    { graph, forces, options: { stepsPerProgress: 10 } },
+    (_, steps) => progress.push(steps)
+  );
+  assert(coordinates instanceof Float32Array);
+  assert.strictEqual(coordinates.length, 2 * graph.nodeCount);
+  assert(coordinates.every(Number.isFinite));
+  assert(progress.length > 0);
+  assert(progress.every((steps, i) => i === 0 || steps > progress[i - 1]));
+
+  await assert.rejects(
+    worker.run({ graph, forces: [{ type: "UnknownForce" }] }),
+    /unknown force type/
+  );
+  worker.terminate();
+}
+
+if (isMainThread) {
+  main().catch((error) => {
+    console.error(error);
+    process.exit(1);
+  });
+} else {
+  const require = createRequire(import.meta.url);
+  const wasm = require("../dist/nodejs/egraph_wasm.js");
+  parentPort.on("message", (message) => {
+    try {
+      runSimulation(wasm, message, (response, transfer) =>
+        parentPort.postMessage(response, transfer)
+      );
+    } catch (error) {
+      parentPort.postMessage({ id: message.id, type: "error", error: `${error}` });
+    }
+  });
+}
@@ -0,0 +1,60 @@
+// Runs force simulations in a module worker so that large layouts do not
+// block the page.
+//
+//   const worker = new SimulationWorker();
+//   const coordinates = await worker.run({
+//     graph: { nodeCount: 3, links: [0, 1, 1, 2] },
+//     forces: [{ type: "ManyBodyForce" }, { type: "LinkForce" }],
+//   });
+//
+// `graph.links` holds the edge endpoints as consecutive pairs. Each force is
+// `{ type, nodes, links, options }` where `nodes[u]` and `links[e]` are the
+// objects the corresponding force constructor reads for node `u` and edge
+// `e`. The resolved value is a `Float32Array` of `x, y` per node.
+// `coordinates` gives the initial positions in the same layout, and
+// `options` sets the Simulation properties (`alphaMin`, `velocityDecay`,
+// `iterations`, `movementThreshold`, ...) plus `stepsPerProgress`, which
+// makes the worker report intermediate coordinates to `onProgress` every
+// that many steps.
+
+export class SimulationWorker {
+  constructor(url = new URL("./worker.js", import.meta.url)) {
+    this.worker = new Worker(url, { type: "module" });
+    this.requests = new Map();
+    this.nextId = 0;
+    this.worker.onmessage = (event) => {
+      const { id, type } = event.data;
+      const request = this.requests.get(id);
+      if (!request) {
+        return;
+      }
+      if (type === "progress") {
+        if (request.onProgress) {
+          request.onProgress(event.data.coordinates, event.data.steps);
+        }
+      } else if (type === "done") {
+        this.requests.delete(id);
+        request.resolve(event.data.coordinates);
+      } else {
+        this.requests.delete(id);
+        request.reject(new Error(event.data.error));
+      }
+    };
+  }
+
+  run({ graph, forces, coordinates, options }, onProgress) {
+    const id = this.nextId++;
+    return new Promise((resolve, reject) => {
+      this.requests.set(id, { resolve, reject, onProgress });
+      this.worker.postMessage({ id, graph, forces, coordinates, options });
+    });
+  }
+
+  terminate() {
+    this.worker.terminate();
+    for (const { reject } of this.requests.values()) {
+      reject(new Error("worker terminated"));
+    }
+    this.requests.clear();
+  }
+}
@@ -0,0 +1,91 @@
+// Runs a Simulation described by a `SimulationWorker` request on a loaded
+// wasm module and reports through `postMessage(message, transfer)`. Shared by
+// ./worker.js and the node smoke test in ../tests/worker.mjs.
+
+function constructGraph(wasm, { nodeCount, links }) {
+  const graph = new wasm.Graph();
+  for (let u = 0; u < nodeCount; ++u) {
+    graph.addNode(null);
+  }
+  for (let i = 0; i < links.length; i += 2) {
+    graph.addEdge(links[i], links[i + 1], null);
+  }
+  return graph;
+}
+
+function constructForce(wasm, graph, force) {
+  const nodes = (u) => force.nodes[u];
+  const links = force.links ? (e) => force.links[e] : undefined;
+  switch (force.type) {
+    case "CenterForce":
+      return new wasm.CenterForce();
+    case "CollideForce":
+      return new wasm.CollideForce(graph, nodes, force.options);
+    case "LinkForce":
+      return new wasm.LinkForce(graph, links);
+    case "ManyBodyForce":
+      return new wasm.ManyBodyForce(graph, force.nodes ? nodes : undefined);
+    case "PositionForce":
+      return new wasm.PositionForce(graph, nodes);
+    case "RadialForce":
+      return new wasm.RadialForce(graph, nodes);
+    default:
+      throw new Error(`unknown force type ${force.type}`);
+  }
+}
+
+export function runSimulation(wasm, message, postMessage) {
+  const { id, coordinates, options = {} } = message;
+  const graph = constructGraph(wasm, message.graph);
+  const forces = message.forces.map((force) =>
+    constructForce(wasm, graph, force)
+  );
+  const initialCoordinates = coordinates ? null : wasm.initialPlacement(graph);
+  const simulation = new wasm.Simulation(graph, (u) =>
+    coordinates
+      ? [coordinates[2 * u], coordinates[2 * u + 1]]
+      : initialCoordinates[u]
+  );
+  for (const key of [
+    "alphaStart",
+    "alphaMin",
+    "alphaTarget",
+    "velocityDecay",
+    "iterations",
+    "movementThreshold",
+  ]) {
+    if (options[key] !== undefined) {
+      simulation[key] = options[key];
+    }
+  }
+  const stepsPerProgress = options.stepsPerProgress || 0;
+  const result = new Float32Array(2 * graph.nodeCount());
+  const readCoordinates = () => {
+    const points = simulation.pointBuffer();
+    for (let u = 0; u < graph.nodeCount(); ++u) {
+      result[2 * u] = points[4 * u];
+      result[2 * u + 1] = points[4 * u + 1];
+    }
+    return result;
+  };
+  let steps = 0;
+  while (!simulation.isFinished() && steps < simulation.iterations) {
+    const n = stepsPerProgress
+      ? Math.min(stepsPerProgress, simulation.iterations - steps)
+      : simulation.iterations - steps;
+    simulation.step(n, forces);
+    steps += n;
+    if (stepsPerProgress) {
+      postMessage({
+        id,
+        type: "progress",
+        steps,
+        coordinates: readCoordinates(),
+      });
+    }
+  }
+  readCoordinates();
+  postMessage({ id, type: "done", steps, coordinates: result }, [
+    result.buffer,
+  ]);
+}
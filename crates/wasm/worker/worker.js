@@ -0,0 +1,38 @@
+// Module worker running a Simulation off the main thread. Started by
+// `SimulationWorker` in ./index.js.
+//
+// When the page is cross-origin isolated the threaded build in
+// dist/web-threads is loaded and its rayon pool is started, so the parallel
+// force, edge bundling and shortest path engines use every core. Otherwise
+// the single-threaded build in dist/web is used.
+
+import { runSimulation } from "./simulation.js";
+
+const threaded =
+  typeof SharedArrayBuffer !== "undefined" && self.crossOriginIsolated;
+
+const ready = (async () => {
+  const wasm = threaded
+    ? await import("../dist/web-threads/egraph_wasm.js")
+    : await import("../dist/web/egraph_wasm.js");
+  await wasm.default();
+  if (threaded) {
+    await wasm.initThreadPool(navigator.hardwareConcurrency);
+  }
+  return wasm;
+})();
+
+// Keep a failed initialization from surfacing as an unhandled rejection
+// before the first message; each message reports it instead.
+ready.catch(() => {});
+
+self.onmessage = async (event) => {
+  try {
+    const wasm = await ready;
+    runSimulation(wasm, event.data, (message, transfer) =>
+      self.postMessage(message, transfer)
+    );
+  } catch (error) {
+    self.postMessage({ id: event.data.id, type: "error", error: `${error}` });
+  }
+};